@@ -45,17 +45,17 @@ namespace HoloHands
       _quadRenderer = std::make_unique<QuadRenderer>(_deviceResources);
       _crosshairRenderer = std::make_unique<CrosshairRenderer>(_deviceResources);
 
-      //Create hand detector.
-      _handDetector = std::make_unique<HoloHands::HandDetector>();
+      //Create hand tracking pipeline, it starts once the sensors are running.
+      _handTrackingPipeline = std::make_unique<HandTrackingPipeline>();
       _depthTexture = std::make_unique<DepthTexture>(_deviceResources);
-      _handDetector->ShowDebugInfo(_showDebugInfo);
+      _handTrackingPipeline->ShowDebugInfo(_showDebugInfo);
    }
 
    void AppMain::OnSpatialInput(SpatialInteractionSourceState^ pointerState)
    {
       bool isClosed = pointerState->IsPressed;
 
-      _handDetector->SetIsClosed(isClosed);
+      _handTrackingPipeline->SetIsClosed(isClosed);
       _selectedCubeIndex = SelectCube(isClosed);
 
       //Choose crosshair color.
@@ -91,21 +91,25 @@ namespace HoloHands
          return;
       }
 
-      //Get image from depth sensor.
-      HoloLensForCV::SensorFrame^ latestFrame =
-         _holoLensMediaFrameSourceGroup->GetLatestSensorFrame(HoloLensForCV::SensorType::ShortThrowToFDepth);
+      if (!_handTrackingPipeline->IsRunning())
+      {
+         //Process depth frames off the render thread.
+         _handTrackingPipeline->Start(_holoLensMediaFrameSourceGroup);
+      }
 
-      if (latestFrame == nullptr ||
-         _latestSelectedCameraTimestamp.UniversalTime == latestFrame->Timestamp.UniversalTime)
+      //Get the latest hand tracking result, without waiting for the pipeline.
+      if (!_handTrackingPipeline->Update())
       {
          return;
       }
 
-      _latestSelectedCameraTimestamp = latestFrame->Timestamp;
-
+      HandTrackingResult& result = _handTrackingPipeline->GetLatestResult();
+      _handFound = result.HandFound;
 
-      if (GetHandPositionFromFrame(latestFrame, _handPosition))
+      if (result.HasHandPosition)
       {
+         _handPosition = result.HandPosition;
+
          //Move cube to hand position.
          if (_selectedCubeIndex != -1)
          {
@@ -122,7 +126,11 @@ namespace HoloHands
          _quadRenderer->UpdatePosition(pose);
          _quadRenderer->Update();
 
-         _depthTexture->CopyFrom(_handDetector->GetDebugImage());
+         if (!result.DebugImage.empty())
+         {
+            _depthTexture->CopyFrom(result.DebugImage);
+         }
+
          _crosshairRenderer->SetPosition(_handPosition);
          _crosshairRenderer->Update();
       }
@@ -157,6 +165,8 @@ namespace HoloHands
 
    void AppMain::OnDeviceLost()
    {
+      _handTrackingPipeline->Stop();
+
       _cubeRenderer->ReleaseDeviceDependentResources();
       _axisRenderer->ReleaseDeviceDependentResources();
       _quadRenderer->ReleaseDeviceDependentResources();
@@ -201,59 +211,6 @@ namespace HoloHands
       return -1;
    }
 
-   bool AppMain::GetHandPositionFromFrame(HoloLensForCV::SensorFrame^ frame, float3& handPosition)
-   {
-      cv::Mat image;
-      rmcv::WrapHoloLensSensorFrameWithCvMat(frame, image);
-
-      //Detect 2D hand position and depth from OpenCV Mat.
-      _handFound = _handDetector->Process(image);
-      float depth = _handDetector->GetHandDepth();
-      cv::Point position2D = _handDetector->GetHandPosition2D();
-
-      if (_handFound == false || depth < 200 || depth > 1000)
-      {
-         //Invalid hand position detected.
-         return false;
-      }
-
-      //Calculate transforms.
-      float4x4 viewToFrame;
-      invert(frame->CameraViewTransform, &viewToFrame);
-
-      Eigen::Matrix4f camToOrigin = MathsUtils::Convert(viewToFrame * frame->FrameToOrigin);
-
-      //Convert from UV space to XY direction.
-      Point uv(
-         static_cast<float>(position2D.x),
-         static_cast<float>(position2D.y));
-
-      Point xy;
-      frame->SensorStreamingCameraIntrinsics->MapImagePointToCameraUnitPlane(uv, &xy);
-
-      //Add depth to direction.
-      Eigen::Vector3f direction;
-      direction[0] = -xy.X;
-      direction[1] = -xy.Y;
-      direction[2] = -1.0f;
-
-      const float depthScale = 0.001f;
-      direction.normalize();
-      direction *= depth * depthScale;
-
-      //Transform into world space.
-      Eigen::Vector4f worldPosition =
-         camToOrigin.transpose() *
-         Eigen::Vector4f(direction.x(), direction.y(), direction.z(), 1);
-
-      handPosition = float3(
-         worldPosition.x(),
-         worldPosition.y(),
-         worldPosition.z());
-
-      return true;
-   }
-
    void AppMain::StartHoloLensMediaFrameSourceGroup()
    {
       _sensorFrameStreamer =
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "CV/HandDetector.h"
+#include "HandTrackingPipeline.h"
 #include "Rendering/AxisRenderer.h"
 #include "Rendering/CubeRenderer.h"
 #include "Rendering/QuadRenderer.h"
@@ -33,12 +33,6 @@ namespace HoloHands
       virtual void OnRender() override;
 
    private:
-      // Get a 3D hand position in world space from a given frame.
-      // Returns false if hand is not found and the position as an out parameter.
-      bool GetHandPositionFromFrame(
-         HoloLensForCV::SensorFrame^ frame,
-         Windows::Foundation::Numerics::float3& handPosition);
-
       // Select a cube at the current hand position.
       // Returns -1 if no cube is found at the position.
       int SelectCube(bool handIsClosed);
@@ -50,7 +44,7 @@ namespace HoloHands
       std::unique_ptr<QuadRenderer> _quadRenderer;
       std::unique_ptr<CrosshairRenderer> _crosshairRenderer;
 
-      std::unique_ptr<HandDetector> _handDetector;
+      std::unique_ptr<HandTrackingPipeline> _handTrackingPipeline;
       std::unique_ptr<DepthTexture> _depthTexture;
 
       Windows::Foundation::Numerics::float3 _handPosition;
@@ -65,6 +59,5 @@ namespace HoloHands
       HoloLensForCV::MediaFrameSourceGroup^ _holoLensMediaFrameSourceGroup;
       bool _holoLensMediaFrameSourceGroupStarted;
       HoloLensForCV::SensorFrameStreamer^ _sensorFrameStreamer;
-      Windows::Foundation::DateTime _latestSelectedCameraTimestamp;
    };
 }
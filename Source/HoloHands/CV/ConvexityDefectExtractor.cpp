@@ -4,9 +4,24 @@
 
 #include "Defect.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
 using namespace HoloHands;
 using namespace cv;
 
+namespace
+{
+   // Twice the signed area of the triangle abc, positive when c lies to the left of
+   // the line from a to b.
+   int64_t Cross(const Point& a, const Point& b, const Point& c)
+   {
+      return
+         static_cast<int64_t>(b.x - a.x) * (c.y - a.y) -
+         static_cast<int64_t>(b.y - a.y) * (c.x - a.x);
+   }
+}
 
 ConvexityDefectExtractor::ConvexityDefectExtractor()
    :
@@ -18,35 +33,58 @@ bool ConvexityDefectExtractor::FindDefect(
    const std::vector<Point>& contour,
    Defect& outDefect)
 {
-   std::vector<Point>hull;
-   std::vector<int>hullIndices;
+   //As with convexityDefects, a contour of three points or fewer has no defects.
+   if (contour.size() <= 3)
+   {
+      return false;
+   }
 
-   convexHull(Mat(contour), hull);
-   convexHull(Mat(contour), hullIndices, false, false);
+   FindHullIndices(contour);
 
-   //Calculate defects for each hull.
-   std::vector<Vec4i> defects;
-   convexityDefects(contour, hullIndices, defects);
+   int hullCount = static_cast<int>(_hullIndices.size());
+   if (hullCount < 3)
+   {
+      return false;
+   }
 
    Defect defectCandidate;
    double highestScore = 0;
+   bool isFirstDefect = true;
 
-   //Select the defect with the highest score.
-   for (size_t d = 1; d < defects.size(); d++) //Ignore the first defect.
+   //Walk the hull edges in the order convexityDefects returns their defects: first the
+   //edge that wraps around the end of the contour, then the others in contour order.
+   int start = _hullIndices[hullCount - 1];
+   for (int i = 0; i < hullCount; i++)
    {
-      Defect defect = GetDefectFromContour(contour, defects[d]);
-      if (defect.Depth > MIN_DEFECT_DEPTH)
-      {
-         //Discard smaller contours.
+      int end = _hullIndices[i];
+
+      double depth = 0;
+      int far = FindDeepestPoint(contour, start, end, depth);
 
-         double score = CalculateDefectScore(defect);
+      if (far >= 0)
+      {
+         int fixedPointDepth = cvRound(depth * 256);
 
-         if (score > highestScore)
+         if (isFirstDefect)
          {
-            highestScore = score;
-            defectCandidate = defect;
+            //Ignore the first defect.
+            isFirstDefect = false;
+         }
+         else if (fixedPointDepth / 256.0f > MIN_DEFECT_DEPTH)
+         {
+            //Only larger defects are built and scored.
+            Defect defect = GetDefectFromContour(contour, Vec4i(start, end, far, fixedPointDepth));
+            double score = CalculateDefectScore(defect);
+
+            if (score > highestScore)
+            {
+               highestScore = score;
+               defectCandidate = defect;
+            }
          }
       }
+
+      start = end;
    }
 
    if (highestScore > 0)
@@ -98,3 +136,127 @@ Defect ConvexityDefectExtractor::GetDefectFromContour(
 
    return defect;
 }
+
+void ConvexityDefectExtractor::FindHullIndices(const std::vector<Point>& contour)
+{
+   int count = static_cast<int>(contour.size());
+
+   int minX = contour[0].x;
+   int maxX = contour[0].x;
+   for (int i = 1; i < count; i++)
+   {
+      minX = std::min(minX, contour[i].x);
+      maxX = std::max(maxX, contour[i].x);
+   }
+
+   //Only the highest and lowest point of each column can be on the hull. Of points
+   //that are the same, the first is used.
+   int columnCount = maxX - minX + 1;
+   _columnTops.assign(columnCount, -1);
+   _columnBottoms.assign(columnCount, -1);
+
+   for (int i = 0; i < count; i++)
+   {
+      int column = contour[i].x - minX;
+      int& top = _columnTops[column];
+      int& bottom = _columnBottoms[column];
+
+      if (top < 0 || contour[i].y <= contour[top].y)
+      {
+         top = i;
+      }
+
+      if (bottom < 0 || contour[i].y >= contour[bottom].y)
+      {
+         bottom = i;
+      }
+   }
+
+   //The column extremes, sorted by x and then y.
+   _sortedIndices.clear();
+   for (int column = 0; column < columnCount; column++)
+   {
+      if (_columnTops[column] >= 0)
+      {
+         _sortedIndices.push_back(_columnTops[column]);
+
+         if (contour[_columnBottoms[column]].y != contour[_columnTops[column]].y)
+         {
+            _sortedIndices.push_back(_columnBottoms[column]);
+         }
+      }
+   }
+
+   _hullIndices.clear();
+
+   if (_sortedIndices.size() < 2)
+   {
+      _hullIndices.assign(_sortedIndices.begin(), _sortedIndices.end());
+      return;
+   }
+
+   //Andrew's monotone chain, one half of the hull forwards and the other backwards,
+   //dropping collinear points.
+   size_t sortedCount = _sortedIndices.size();
+   for (size_t pass = 0; pass < 2; pass++)
+   {
+      size_t chainStart = _hullIndices.size();
+
+      for (size_t i = 0; i < sortedCount; i++)
+      {
+         int index = _sortedIndices[pass == 0 ? i : sortedCount - 1 - i];
+
+         while (_hullIndices.size() >= chainStart + 2 &&
+            Cross(
+               contour[_hullIndices[_hullIndices.size() - 2]],
+               contour[_hullIndices.back()],
+               contour[index]) <= 0)
+         {
+            _hullIndices.pop_back();
+         }
+
+         _hullIndices.push_back(index);
+      }
+
+      //The last point of each half is the first of the other.
+      _hullIndices.pop_back();
+   }
+
+   std::sort(_hullIndices.begin(), _hullIndices.end());
+}
+
+int ConvexityDefectExtractor::FindDeepestPoint(
+   const std::vector<Point>& contour,
+   int start,
+   int end,
+   double& depth)
+{
+   const Point& edgeStart = contour[start];
+   const Point& edgeEnd = contour[end];
+
+   int count = static_cast<int>(contour.size());
+   int deepestIndex = -1;
+   int64_t deepestDistance = 0;
+
+   //The distances to the edge are all scaled by its length, so the deepest point is
+   //found with integer arithmetic and only its distance is scaled.
+   for (int i = start + 1 < count ? start + 1 : 0; i != end; i = i + 1 < count ? i + 1 : 0)
+   {
+      int64_t distance = std::abs(Cross(edgeStart, edgeEnd, contour[i]));
+
+      if (distance > deepestDistance)
+      {
+         deepestDistance = distance;
+         deepestIndex = i;
+      }
+   }
+
+   if (deepestIndex >= 0)
+   {
+      double dx = edgeEnd.x - edgeStart.x;
+      double dy = edgeEnd.y - edgeStart.y;
+      depth = deepestDistance * (1. / std::sqrt(dx * dx + dy * dy));
+   }
+
+   return deepestIndex;
+}
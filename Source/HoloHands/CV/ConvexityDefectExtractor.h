@@ -10,6 +10,9 @@ namespace HoloHands
       ConvexityDefectExtractor();
 
       // Finds the most suitable defect for a given set of contours.
+      // The contour's convex hull is found once, as indices, and defects are scored
+      // while walking the hull, so defects are never collected. The hull and defects
+      // are those OpenCV's convexHull and convexityDefects would return.
       bool FindDefect(
          const std::vector<cv::Point>& contour,
          Defect& outDefect);
@@ -26,6 +29,25 @@ namespace HoloHands
       cv::Size _imageSize;
       bool _showDebugInfo;
 
+      //Per frame buffers, reused between calls to avoid allocations.
+      std::vector<int> _hullIndices;
+      std::vector<int> _columnTops;
+      std::vector<int> _columnBottoms;
+      std::vector<int> _sortedIndices;
+
+      // Finds the contour's convex hull in time linear in the contour's length and
+      // width. The hull indices are stored in ascending order, without collinear points.
+      void FindHullIndices(const std::vector<cv::Point>& contour);
+
+      // Finds the contour point furthest from the hull edge between two indices,
+      // walking the contour from start to end. Returns the index of the point, or
+      // -1 if no point lies off the edge.
+      static int FindDeepestPoint(
+         const std::vector<cv::Point>& contour,
+         int start,
+         int end,
+         double& depth);
+
       // Calculates a score for a given defect.
       // The higher to score, to more suitable the defect.
       double CalculateDefectScore(const Defect& defect);
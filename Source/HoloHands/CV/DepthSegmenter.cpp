@@ -0,0 +1,240 @@
+#include "pch.h"
+
+#include "DepthSegmenter.h"
+
+#include <numeric>
+
+#if defined(__AVX2__)
+#define HOLOHANDS_DEPTH_SEGMENTER_AVX2 1
+#include <immintrin.h>
+#elif defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define HOLOHANDS_DEPTH_SEGMENTER_SSE2 1
+#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define HOLOHANDS_DEPTH_SEGMENTER_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace HoloHands;
+using namespace cv;
+
+namespace
+{
+   const int DEPTH_VALUE_COUNT = 65536;
+
+#if HOLOHANDS_DEPTH_SEGMENTER_SSE2 || HOLOHANDS_DEPTH_SEGMENTER_AVX2
+   // Scales eight 16 bit depths, rounding half to even like OpenCV's convertTo.
+   // The result is saturated to the signed 16 bit range.
+   inline __m128i ScaleDepthSse2(__m128i depth, __m128 scale)
+   {
+      const __m128i zero = _mm_setzero_si128();
+
+      __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(depth, zero));
+      __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(depth, zero));
+
+      return _mm_packs_epi32(
+         _mm_cvtps_epi32(_mm_mul_ps(low, scale)),
+         _mm_cvtps_epi32(_mm_mul_ps(high, scale)));
+   }
+#endif
+}
+
+DepthSegmenter::DepthSegmenter()
+   :
+   _maxImageDepth(0),
+   _detectionThreshold(0),
+   _scale(0),
+   _foregroundLimit(0),
+   _isVectorized(false)
+{
+}
+
+void DepthSegmenter::Configure(float maxImageDepth, float detectionThreshold)
+{
+   _maxImageDepth = maxImageDepth;
+   _detectionThreshold = detectionThreshold;
+
+   //Matches the scale OpenCV derives from "input / maxImageDepth * 255.0".
+   _scale = static_cast<float>(1.0 / maxImageDepth * 255.0);
+
+   //Matches the integer threshold OpenCV uses for 8 bit images.
+   _foregroundLimit = saturate_cast<uint8_t>(cvFloor(detectionThreshold));
+
+   //The scale OpenCV's convertTo applies, in float, rounded half to even and saturated.
+   //Tests/DepthSegmenterTest checks this against ProcessReference for every depth.
+   _scaleTable.resize(DEPTH_VALUE_COUNT);
+   for (int i = 0; i < DEPTH_VALUE_COUNT; i++)
+   {
+      _scaleTable[i] = saturate_cast<uint8_t>(cvRound(static_cast<float>(i) * _scale));
+   }
+
+#if HOLOHANDS_DEPTH_SEGMENTER_AVX2 || HOLOHANDS_DEPTH_SEGMENTER_SSE2 || HOLOHANDS_DEPTH_SEGMENTER_NEON
+   //Only use the vectorized kernel when it matches the table for every depth. Unlike
+   //the reference chain, this check is a single fast pass.
+   std::vector<uint16_t> ramp(DEPTH_VALUE_COUNT);
+   std::iota(ramp.begin(), ramp.end(), static_cast<uint16_t>(0));
+
+   std::vector<uint8_t> scaled(DEPTH_VALUE_COUNT);
+   std::vector<uint8_t> foreground(DEPTH_VALUE_COUNT);
+   std::vector<uint8_t> expectedScaled(DEPTH_VALUE_COUNT);
+   std::vector<uint8_t> expectedForeground(DEPTH_VALUE_COUNT);
+   ProcessRowVectorized(ramp.data(), scaled.data(), foreground.data(), DEPTH_VALUE_COUNT);
+   ProcessRowScalar(ramp.data(), expectedScaled.data(), expectedForeground.data(), DEPTH_VALUE_COUNT);
+
+   _isVectorized = scaled == expectedScaled && foreground == expectedForeground;
+#else
+   _isVectorized = false;
+#endif
+}
+
+void DepthSegmenter::Process(const Mat& depth, Mat& scaled, Mat& foreground) const
+{
+   CV_Assert(depth.type() == CV_16UC1);
+
+   //Reallocates only when the image size changes.
+   scaled.create(depth.size(), CV_8UC1);
+   foreground.create(depth.size(), CV_8UC1);
+
+   int rows = depth.rows;
+   int width = depth.cols;
+
+   if (depth.isContinuous() && scaled.isContinuous() && foreground.isContinuous())
+   {
+      //Treat the whole image as one long row.
+      width *= rows;
+      rows = 1;
+   }
+
+   for (int y = 0; y < rows; y++)
+   {
+      const uint16_t* depthRow = depth.ptr<uint16_t>(y);
+      uint8_t* scaledRow = scaled.ptr<uint8_t>(y);
+      uint8_t* foregroundRow = foreground.ptr<uint8_t>(y);
+
+      if (_isVectorized)
+      {
+         ProcessRowVectorized(depthRow, scaledRow, foregroundRow, width);
+      }
+      else
+      {
+         ProcessRowScalar(depthRow, scaledRow, foregroundRow, width);
+      }
+   }
+}
+
+void DepthSegmenter::ProcessReference(const Mat& depth, Mat& scaled, Mat& foreground) const
+{
+   scaled = depth / _maxImageDepth * 255.0; //Scale to within 8bit range.
+   scaled.convertTo(scaled, CV_8UC1); //Make correct format for OpenCV.
+
+   //Create background mask.
+   Mat mask;
+   threshold(scaled, mask, _detectionThreshold, 255, THRESH_BINARY);
+   mask = 255 - mask; //Invert.
+
+   //Discard background information.
+   foreground.release();
+   scaled.copyTo(foreground, mask);
+}
+
+void DepthSegmenter::ProcessRowScalar(
+   const uint16_t* depth,
+   uint8_t* scaled,
+   uint8_t* foreground,
+   int width) const
+{
+   const uint8_t* table = _scaleTable.data();
+
+   for (int x = 0; x < width; x++)
+   {
+      uint8_t value = table[depth[x]];
+
+      scaled[x] = value;
+      foreground[x] = value <= _foregroundLimit ? value : 0;
+   }
+}
+
+void DepthSegmenter::ProcessRowVectorized(
+   const uint16_t* depth,
+   uint8_t* scaled,
+   uint8_t* foreground,
+   int width) const
+{
+   int x = 0;
+
+#if HOLOHANDS_DEPTH_SEGMENTER_AVX2
+   const __m256 scale256 = _mm256_set1_ps(_scale);
+   const __m256i limit256 = _mm256_set1_epi8(static_cast<char>(_foregroundLimit));
+
+   for (; x <= width - 32; x += 32)
+   {
+      __m256i depth0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(depth + x));
+      __m256i depth1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(depth + x + 16));
+
+      __m256i value0 = _mm256_packs_epi32(
+         _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(depth0))), scale256)),
+         _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(depth0, 1))), scale256)));
+
+      __m256i value1 = _mm256_packs_epi32(
+         _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(depth1))), scale256)),
+         _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(depth1, 1))), scale256)));
+
+      //The 256 bit packs work per 128 bit lane, restore the pixel order afterwards.
+      __m256i packed = _mm256_packus_epi16(
+         _mm256_permute4x64_epi64(value0, _MM_SHUFFLE(3, 1, 2, 0)),
+         _mm256_permute4x64_epi64(value1, _MM_SHUFFLE(3, 1, 2, 0)));
+      packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+
+      __m256i isForeground = _mm256_cmpeq_epi8(_mm256_min_epu8(packed, limit256), packed);
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(scaled + x), packed);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(foreground + x), _mm256_and_si256(packed, isForeground));
+   }
+#endif
+
+#if HOLOHANDS_DEPTH_SEGMENTER_SSE2 || HOLOHANDS_DEPTH_SEGMENTER_AVX2
+   const __m128 scale = _mm_set1_ps(_scale);
+   const __m128i limit = _mm_set1_epi8(static_cast<char>(_foregroundLimit));
+
+   for (; x <= width - 16; x += 16)
+   {
+      __m128i value0 = ScaleDepthSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + x)), scale);
+      __m128i value1 = ScaleDepthSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + x + 8)), scale);
+
+      __m128i packed = _mm_packus_epi16(value0, value1);
+      __m128i isForeground = _mm_cmpeq_epi8(_mm_min_epu8(packed, limit), packed);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(scaled + x), packed);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(foreground + x), _mm_and_si128(packed, isForeground));
+   }
+#endif
+
+#if HOLOHANDS_DEPTH_SEGMENTER_NEON
+   const float32x4_t scale = vdupq_n_f32(_scale);
+   const uint8x16_t limit = vdupq_n_u8(_foregroundLimit);
+
+   for (; x <= width - 16; x += 16)
+   {
+      uint16x8_t depth0 = vld1q_u16(depth + x);
+      uint16x8_t depth1 = vld1q_u16(depth + x + 8);
+
+      //Round half to even, then saturate down to 8 bit.
+      uint16x8_t value0 = vcombine_u16(
+         vqmovn_u32(vcvtnq_u32_f32(vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(depth0))), scale))),
+         vqmovn_u32(vcvtnq_u32_f32(vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(depth0))), scale))));
+
+      uint16x8_t value1 = vcombine_u16(
+         vqmovn_u32(vcvtnq_u32_f32(vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(depth1))), scale))),
+         vqmovn_u32(vcvtnq_u32_f32(vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(depth1))), scale))));
+
+      uint8x16_t packed = vcombine_u8(vqmovn_u16(value0), vqmovn_u16(value1));
+      uint8x16_t isForeground = vcleq_u8(packed, limit);
+
+      vst1q_u8(scaled + x, packed);
+      vst1q_u8(foreground + x, vandq_u8(packed, isForeground));
+   }
+#endif
+
+   //Remaining pixels.
+   ProcessRowScalar(depth + x, scaled + x, foreground + x, width - x);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace HoloHands
+{
+   // Converts raw 16 bit depth frames into the 8 bit images used by the hand detector.
+   // Scaling, thresholding and background removal are fused into a single pass over
+   // the frame, writing into caller owned buffers that are reused between frames.
+   class DepthSegmenter
+   {
+   public:
+      DepthSegmenter();
+
+      // Sets the depth mapped to the top of the 8 bit range, and the 8 bit value
+      // above which pixels are treated as background.
+      void Configure(float maxImageDepth, float detectionThreshold);
+
+      // Produces the scaled 8 bit image and the foreground image, which is the scaled
+      // image with all background pixels set to zero.
+      void Process(const cv::Mat& depth, cv::Mat& scaled, cv::Mat& foreground) const;
+
+      // Same output as Process, computed with the original chain of OpenCV operations.
+      void ProcessReference(const cv::Mat& depth, cv::Mat& scaled, cv::Mat& foreground) const;
+
+      // Returns true when the vectorized kernel is in use. It is only enabled when it
+      // matches the scalar kernel for every possible depth value. Rows narrower than
+      // its vectors, and the pixels left over at the end of a row, are processed
+      // without it.
+      bool IsVectorized() const { return _isVectorized; }
+
+   private:
+      float _maxImageDepth;
+      float _detectionThreshold;
+      float _scale;
+      uint8_t _foregroundLimit;
+      bool _isVectorized;
+
+      //Scaled 8 bit value for every 16 bit depth, taken from the reference chain.
+      std::vector<uint8_t> _scaleTable;
+
+      // Processes a single row without SIMD instructions.
+      void ProcessRowScalar(
+         const uint16_t* depth,
+         uint8_t* scaled,
+         uint8_t* foreground,
+         int width) const;
+
+      // Processes a single row with SIMD instructions, when available.
+      void ProcessRowVectorized(
+         const uint16_t* depth,
+         uint8_t* scaled,
+         uint8_t* foreground,
+         int width) const;
+   };
+}
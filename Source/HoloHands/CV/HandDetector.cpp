@@ -4,109 +4,342 @@
 
 #include "Defect.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <functional>
+
 using namespace HoloHands;
-using namespace Windows::Graphics::Imaging;
 using namespace cv;
 
+namespace
+{
+   typedef std::chrono::high_resolution_clock Clock;
+
+   double MillisecondsBetween(const Clock::time_point& start, const Clock::time_point& end)
+   {
+      return std::chrono::duration<double, std::milli>(end - start).count();
+   }
+
+   //Connected components that were not selected have no contour to draw.
+   void DrawContour(Mat& image, const std::vector<std::vector<Point>>& contours, int index, int thickness)
+   {
+      if (!contours[index].empty())
+      {
+         drawContours(image, contours, index, Scalar(255), thickness);
+      }
+   }
+}
+
+class HandDetector::ParallelHandProcessor : public ParallelLoopBody
+{
+public:
+   ParallelHandProcessor(HandDetector& handDetector, const Mat& input)
+      :
+      _handDetector(handDetector),
+      _input(input)
+   {}
+
+   void operator()(const Range& range) const override
+   {
+      for (int i = range.start; i < range.end; i++)
+      {
+         _handDetector.ProcessCandidate(_input, static_cast<size_t>(i));
+      }
+   }
+
+private:
+   HandDetector& _handDetector;
+   const Mat& _input;
+};
+
 HoloHands::HandDetector::HandDetector()
    :
-   _isClosed(false)
+   _segmentationBackend(SegmentationBackend::Edges),
+   _contourApproximation(ContourApproximation::None),
+   _contourTolerance(0),
+   _isClosed(false),
+   _showDebugInfo(false),
+   _isTrackingEnabled(false),
+   _hasTrackingRegion(false),
+   _trackingMargin(DEFAULT_TRACKING_MARGIN),
+   _maxHandCount(1),
+   _nextHandId(0)
 {
+   _depthSegmenter.Configure(MAX_IMAGE_DEPTH, MAX_DETECTION_THRESHOLD);
 }
 
 bool HandDetector::Process(cv::Mat& input)
 {
+   Clock::time_point stageStart = Clock::now();
+   _stageTimings = StageTimings();
+
    _imageSize = Size(input.size());
    _defectExtractor.SetImageSize(_imageSize);
 
-   Mat scaled = input / MAX_IMAGE_DEPTH * 255.0; //Scale to within 8bit range.
-   scaled.convertTo(scaled, CV_8UC1); //Make correct format for OpenCV.
+   //Scale to 8 bit and discard background information in a single pass.
+   _depthSegmenter.Process(input, _scaled, _hands);
 
-   //Create background mask.
-   Mat mask;
-   threshold(scaled, mask, MAX_DETECTION_THRESHOLD, 255, CV_THRESH_BINARY);
-   mask = 255 - mask; //Invert.
+   _stageTimings.Segmentation = MillisecondsBetween(stageStart, Clock::now());
 
-   //Discard background information.
-   Mat hands;
-   scaled.copyTo(hands, mask);
+   if (_showDebugInfo)
+   {
+      //Save debug image.
+      _debugImage = _scaled;
+   }
 
-   Mat cannyMat;
-   Canny(hands, cannyMat, 200, 250);
+   _trackingStatistics.FrameCount++;
 
-   blur(cannyMat, cannyMat, Size(6, 6));
+   //Keep the previous frame's hands, so that hands found again keep their ids.
+   _previousHands.swap(_detectedHands);
+   _detectedHands.clear();
 
-   //Find contours.
-   std::vector<std::vector<Point>> contours;
-   findContours(cannyMat, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
+   bool isFound = _maxHandCount > 1 ? ProcessMultipleHands(input) : ProcessSingleHand(input);
 
-   //Get rectangular bounds for all the contours.
-   std::vector<Rect> bounds;
-   CalculateBounds(contours, bounds);
+   if (!isFound)
+   {
+      _trackingStatistics.LostFrameCount++;
+      return false;
+   }
 
    if (_showDebugInfo)
    {
-      //Save debug image.
-      _debugImage = scaled;
+      for (const DetectedHand& hand : _detectedHands)
+      {
+         DrawHand(hand);
+      }
+
+      putText(_debugImage, _isClosed ? "Closed" : "Open", Point(20, 20), FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255));
+
+      //Draw depth text.
+      putText(_debugImage, std::to_string(_hand.Depth), Point(20, 40), FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255));
+   }
+
+   return true;
+}
+
+bool HandDetector::ProcessSingleHand(const Mat& input)
+{
+   Clock::time_point stageStart = Clock::now();
+
+   //Select best contour, starting with the tracking region when possible.
+   int contourIndex = -1;
+   bool isTracked = false;
+   if (_isTrackingEnabled && _hasTrackingRegion)
+   {
+      //The prediction may leave the image entirely, which leaves nothing to search.
+      Rect region = PredictTrackingRegion();
+      if (region.area() > 0)
+      {
+         contourIndex = FindContourInRegion(region);
+
+         if (_showDebugInfo)
+         {
+            rectangle(_debugImage, region, Scalar(150));
+         }
+      }
+
+      if (contourIndex >= 0 && !TouchesRegionBorder(_bounds[contourIndex], region))
+      {
+         _trackingStatistics.TrackedFrameCount++;
+         isTracked = true;
+      }
+      else
+      {
+         //Hand lost or leaving the region, search the full frame instead.
+         _trackingStatistics.ReacquisitionCount++;
+         contourIndex = FindContourInRegion(Rect(Point(), _imageSize));
+      }
+   }
+   else
+   {
+      contourIndex = FindContourInRegion(Rect(Point(), _imageSize));
    }
 
-   //Select best contour.
-   std::vector<Point> finalContour = FindBestContour(contours, bounds);
-   if (finalContour.size() == 0)
+   Clock::time_point stageEnd = Clock::now();
+   _stageTimings.Contours = MillisecondsBetween(stageStart, stageEnd);
+   stageStart = stageEnd;
+
+   if (contourIndex < 0)
    {
+      _hasTrackingRegion = false;
       return false;
    }
 
+   Point2f previousHandPosition = _hand.Position;
+
+   //A hand found after a frame without one is a new hand.
+   if (_previousHands.empty())
+   {
+      _hand.Id = _nextHandId++;
+   }
+
+   _hand.Bounds = _bounds[contourIndex];
+   _hand.Score = CalculateContourScore(_contours[contourIndex], _hand.Bounds);
+
+   const std::vector<Point>& finalContour = ApproximateContour(_contours[contourIndex], 0);
+
    //Calculate 2d hand position.
    if (_isClosed)
    {
-      ProcessClosedHand(finalContour);
+      ProcessClosedHand(finalContour, _hand);
    }
    else
    {
-      ProcessOpenHand(finalContour);
+      ProcessOpenHand(finalContour, _defectExtractor, _hand);
    }
 
+   //Remember where the hand is for the next frame. The movement is only known when
+   //the hand was followed, a reacquired hand may be a different one.
+   _trackingVelocity = isTracked ? _hand.Position - previousHandPosition : Point2f();
+   _trackingBounds = _hand.Bounds;
+   _hasTrackingRegion = true;
+
+   stageEnd = Clock::now();
+   _stageTimings.Pose = MillisecondsBetween(stageStart, stageEnd);
+   stageStart = stageEnd;
+
    //Calculate depth.
-   _handDepth = CalculateDepth(input);
+   CalculateDepth(input, _hand);
 
-   if (_showDebugInfo)
-   {
-      //Draw hand position.
-      float crossSize = 6.f;
-      line(_debugImage, _handPosition - Point2f(crossSize, 0), _handPosition + Point2f(crossSize, 0), Scalar(255), 2);
-      line(_debugImage, _handPosition - Point2f(0, crossSize), _handPosition + Point2f(0, crossSize), Scalar(255), 2);
+   _stageTimings.Depth = MillisecondsBetween(stageStart, Clock::now());
+
+   _detectedHands.push_back(_hand);
+
+   return true;
+}
+
+bool HandDetector::ProcessMultipleHands(const Mat& input)
+{
+   Clock::time_point stageStart = Clock::now();
 
-      //Draw hand direction.
-      line(_debugImage, _handPosition, _handPosition + _direction * 50, Scalar(200));
+   FindContoursInRegion(Rect(Point(), _imageSize));
+   FindBestContours(_contours, _bounds, static_cast<size_t>(_maxHandCount), _candidates);
 
-      if (_isClosed)
+   if (_segmentationBackend == SegmentationBackend::ConnectedComponents)
+   {
+      for (const auto& candidate : _candidates)
       {
-         putText(_debugImage, "Closed", Point(20, 20), CV_FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255));
+         TraceComponent(candidate.second);
       }
-      else
-      {
-         putText(_debugImage, "Open", Point(20, 20), CV_FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255));
+   }
 
-         circle(_debugImage, _finger1Position, 6, Scalar(255), 1);
-         circle(_debugImage, _finger2Position, 6, Scalar(255), 1);
-         circle(_debugImage, _palmPosition, 6, Scalar(255), 1);
-      }
+   Clock::time_point stageEnd = Clock::now();
+   _stageTimings.Contours = MillisecondsBetween(stageStart, stageEnd);
+   stageStart = stageEnd;
 
-      //Draw depth text.
-      putText(_debugImage, std::to_string(_handDepth), Point(20, 40), CV_FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255));
+   if (_candidates.empty())
+   {
+      return false;
+   }
+
+   for (const auto& candidate : _candidates)
+   {
+      DetectedHand hand;
+      hand.Score = candidate.first;
+      hand.Bounds = _bounds[candidate.second];
+      _detectedHands.push_back(hand);
+   }
+
+   MatchPreviousHands();
+
+   //Sized before the hands are processed in parallel.
+   if (_candidateDefectExtractors.size() < _candidates.size())
+   {
+      _candidateDefectExtractors.resize(_candidates.size());
    }
 
+   if (_approximatedContours.size() < _candidates.size())
+   {
+      _approximatedContours.resize(_candidates.size());
+   }
+
+   for (size_t i = 0; i < _candidates.size(); i++)
+   {
+      _candidateDefectExtractors[i].SetImageSize(_imageSize);
+      _candidateDefectExtractors[i].ShowDebugInfo(_showDebugInfo);
+   }
+
+   //Every hand has its own contour, defect extractor and result, so the hull, defect
+   //and depth sampling work of the hands runs in parallel.
+   parallel_for_(
+      Range(0, static_cast<int>(_candidates.size())),
+      ParallelHandProcessor(*this, input),
+      static_cast<double>(_candidates.size()));
+
+   _hand = _detectedHands.front();
+
+   _stageTimings.Pose = MillisecondsBetween(stageStart, Clock::now());
+
    return true;
 }
 
-void HandDetector::ProcessOpenHand(const std::vector<Point>& contour)
+void HandDetector::ProcessCandidate(const Mat& input, size_t index)
+{
+   DetectedHand& hand = _detectedHands[index];
+   const std::vector<Point>& contour = ApproximateContour(_contours[_candidates[index].second], index);
+
+   if (_isClosed)
+   {
+      ProcessClosedHand(contour, hand);
+   }
+   else
+   {
+      ProcessOpenHand(contour, _candidateDefectExtractors[index], hand);
+   }
+
+   CalculateDepth(input, hand);
+}
+
+void HandDetector::MatchPreviousHands()
+{
+   for (DetectedHand& hand : _detectedHands)
+   {
+      int matchIndex = -1;
+      int matchArea = 0;
+
+      for (size_t i = 0; i < _previousHands.size(); i++)
+      {
+         int area = (hand.Bounds & _previousHands[i].Bounds).area();
+         if (area > matchArea)
+         {
+            matchIndex = static_cast<int>(i);
+            matchArea = area;
+         }
+      }
+
+      if (matchIndex >= 0)
+      {
+         //Continue from the previous pose, for smoothing and the closed hand direction.
+         DetectedHand& previous = _previousHands[matchIndex];
+         previous.Bounds = Rect();
+
+         float score = hand.Score;
+         Rect bounds = hand.Bounds;
+
+         hand = previous;
+         hand.Score = score;
+         hand.Bounds = bounds;
+      }
+      else
+      {
+         hand.Id = _nextHandId++;
+         hand.Position = (hand.Bounds.tl() + hand.Bounds.br()) * 0.5f;
+      }
+   }
+}
+
+void HandDetector::ProcessOpenHand(
+   const std::vector<Point>& contour,
+   ConvexityDefectExtractor& defectExtractor,
+   DetectedHand& hand) const
 {
    Point2f position;
    Point2f direction;
 
    Defect defect;
-   if (_defectExtractor.FindDefect(contour, defect))
+   if (defectExtractor.FindDefect(contour, defect))
    {
       //Draw hull defects.
       Point2f midPoint = (defect.Start + defect.End) / 2.f;
@@ -120,17 +353,19 @@ void HandDetector::ProcessOpenHand(const std::vector<Point>& contour)
 
       //Calculate direction.
       Point across = defect.Start - defect.End;
-      _direction = Point(across.y, -across.x); //Orthogonal.
-      _direction /= norm(_direction); //Normalise.
+      hand.Direction = Point(across.y, -across.x); //Orthogonal.
+      hand.Direction /= norm(hand.Direction); //Normalise.
 
-      _handPosition = ApplySmoothing(position);
-      _finger1Position = Point2f(defect.Start);
-      _finger2Position = Point2f(defect.End);
-      _palmPosition = Point2f(defect.Far);
+      hand.Position = ApplySmoothing(hand.Position, position);
+      hand.Finger1Position = Point2f(defect.Start);
+      hand.Finger2Position = Point2f(defect.End);
+      hand.PalmPosition = Point2f(defect.Far);
    }
 }
 
-void HandDetector::ProcessClosedHand(const std::vector<Point>& contour)
+void HandDetector::ProcessClosedHand(
+   const std::vector<Point>& contour,
+   DetectedHand& hand) const
 {
    if (contour.size() > 0)
    {
@@ -138,7 +373,7 @@ void HandDetector::ProcessClosedHand(const std::vector<Point>& contour)
       float furthestDistance = -FLT_MAX;
       for (int i = 0; i < static_cast<int>(contour.size()); i++)
       {
-         float distance =  _direction.dot(contour[i]);
+         float distance =  hand.Direction.dot(contour[i]);
          if (distance > furthestDistance)
          {
             furthestIndex = i;
@@ -146,7 +381,31 @@ void HandDetector::ProcessClosedHand(const std::vector<Point>& contour)
          }
       }
 
-      _handPosition = contour[furthestIndex];
+      hand.Position = contour[furthestIndex];
+   }
+}
+
+void HandDetector::DrawHand(const DetectedHand& hand)
+{
+   //Draw hand position.
+   float crossSize = 6.f;
+   line(_debugImage, hand.Position - Point2f(crossSize, 0), hand.Position + Point2f(crossSize, 0), Scalar(255), 2);
+   line(_debugImage, hand.Position - Point2f(0, crossSize), hand.Position + Point2f(0, crossSize), Scalar(255), 2);
+
+   //Draw hand direction.
+   line(_debugImage, hand.Position, hand.Position + hand.Direction * 50, Scalar(200));
+
+   if (!_isClosed)
+   {
+      circle(_debugImage, hand.Finger1Position, 6, Scalar(255), 1);
+      circle(_debugImage, hand.Finger2Position, 6, Scalar(255), 1);
+      circle(_debugImage, hand.PalmPosition, 6, Scalar(255), 1);
+   }
+
+   if (_maxHandCount > 1)
+   {
+      //Draw hand id.
+      putText(_debugImage, std::to_string(hand.Id), hand.Bounds.tl() + Point(0, -4), FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255));
    }
 }
 
@@ -156,49 +415,280 @@ void HandDetector::ShowDebugInfo(bool enabled)
    _defectExtractor.ShowDebugInfo(enabled);
 }
 
-void HandDetector::CalculateBounds(const std::vector<std::vector<Point>>& contours, std::vector<Rect>& bounds)
+void HandDetector::SetTrackingEnabled(bool enabled)
 {
-   bounds.clear();
-   for (auto& contour : contours)
+   _isTrackingEnabled = enabled;
+   _hasTrackingRegion = false;
+}
+
+void HandDetector::SetContourApproximation(ContourApproximation approximation, float tolerance)
+{
+   _contourApproximation = approximation;
+   _contourTolerance = tolerance;
+}
+
+void HandDetector::SetSegmentationBackend(SegmentationBackend backend)
+{
+   _segmentationBackend = backend;
+   _hasTrackingRegion = false;
+}
+
+void HandDetector::SetMaxHandCount(int count)
+{
+   count = std::max(1, count);
+
+   if (count != _maxHandCount)
    {
-      bounds.push_back(boundingRect(contour));
+      _maxHandCount = count;
+      _hasTrackingRegion = false;
+      _detectedHands.clear();
    }
 }
 
-bool HandDetector::Intersects(const Rect& a, const Rect& b)
+int HandDetector::FindContourInRegion(const Rect& region)
 {
-   return (a & b).area() > 0;
+   FindContoursInRegion(region);
+
+   int contourIndex = FindBestContour(_contours, _bounds);
+
+   if (contourIndex >= 0 && _segmentationBackend == SegmentationBackend::ConnectedComponents)
+   {
+      TraceComponent(contourIndex);
+   }
+
+   return contourIndex;
+}
+
+void HandDetector::FindContoursInRegion(const Rect& region)
+{
+   //Neither backend accepts an empty region, which has no contours anyway.
+   if (region.area() == 0)
+   {
+      _contours.clear();
+      _bounds.clear();
+      return;
+   }
+
+   if (_segmentationBackend == SegmentationBackend::ConnectedComponents)
+   {
+      FindComponentsInRegion(region);
+      return;
+   }
+
+   //Work on views into the full size buffers, so no per frame allocation is needed.
+   _edges.create(_imageSize, CV_8UC1);
+   Mat edges = _edges(region);
+
+   Canny(_hands(region), edges, 200, 250);
+
+   //Do not read stale edges from outside the region.
+   blur(edges, edges, Size(6, 6), Point(-1, -1), BORDER_DEFAULT | BORDER_ISOLATED);
+
+   //Find contours, in full image coordinates.
+   int method = _contourApproximation == ContourApproximation::Simple ? CHAIN_APPROX_SIMPLE : CHAIN_APPROX_NONE;
+   findContours(edges, _contours, RETR_EXTERNAL, method, region.tl());
+
+   //Get rectangular bounds for all the contours.
+   CalculateBounds(_contours, _bounds);
+}
+
+void HandDetector::FindComponentsInRegion(const Rect& region)
+{
+   //Label into a view of the full size buffer, so the labels can be read back at
+   //image coordinates. Background pixels are zero and get label 0.
+   _labels.create(_imageSize, CV_32SC1);
+   Mat labels = _labels(region);
+
+   //The bounds are gathered separately, as connectedComponentsWithStats updates the
+   //stats, including centroid sums, for every pixel, which costs more than the edge path.
+   int labelCount = connectedComponents(_hands(region), labels, 8, CV_32S);
+   int componentCount = std::max(0, labelCount - 1);
+
+   CalculateComponentBounds(_hands(region), labels, componentCount, region.tl());
+
+   //Contours are only traced once their component is selected.
+   _contours.resize(componentCount);
+   for (auto& contour : _contours)
+   {
+      contour.clear();
+   }
 }
 
-std::vector<Point> HandDetector::FindBestContour(
-   const std::vector<std::vector<Point>>& rawCountours,
-   const std::vector<Rect>& rawBounds)
+void HandDetector::CalculateComponentBounds(
+   const Mat& foreground,
+   const Mat& labels,
+   int componentCount,
+   const Point& offset)
 {
-   std::vector<std::vector<Point>> filteredContours;
-   std::vector<Rect> filteredBounds;
+   //Left, top, right and bottom of every component, inclusive. Component i has label i + 1.
+   _componentExtents.assign(componentCount, Vec4i(INT_MAX, INT_MAX, -1, -1));
 
-   for (size_t i = 0; i < rawCountours.size(); i++)
+   for (int y = 0; y < labels.rows; y++)
    {
-      //Filter out small contours.
-      if (rawBounds[i].width > MIN_CONTOUR_SIZE && rawBounds[i].height > MIN_CONTOUR_SIZE)
+      const uchar* foregroundRow = foreground.ptr<uchar>(y);
+      const int* labelRow = labels.ptr<int>(y);
+
+      int x = 0;
+      while (x < labels.cols)
       {
-         filteredContours.push_back(rawCountours[i]);
-         filteredBounds.push_back(rawBounds[i]);
+         //Skip background, which is most of the image, eight pixels at a time.
+         if (x + 8 <= labels.cols)
+         {
+            uint64_t pixels;
+            memcpy(&pixels, foregroundRow + x, sizeof(pixels));
+
+            if (pixels == 0)
+            {
+               x += 8;
+               continue;
+            }
+         }
+
+         int label = labelRow[x];
+         if (label == 0)
+         {
+            x++;
+            continue;
+         }
+
+         //Update the extents once for every run of the component.
+         int start = x;
+         while (++x < labels.cols && labelRow[x] == label)
+         {
+         }
+
+         Vec4i& extents = _componentExtents[label - 1];
+         extents[0] = std::min(extents[0], start);
+         extents[1] = std::min(extents[1], y);
+         extents[2] = std::max(extents[2], x - 1);
+         extents[3] = y;
       }
    }
 
+   _bounds.clear();
+   for (const Vec4i& extents : _componentExtents)
+   {
+      _bounds.push_back(Rect(
+         extents[0] + offset.x,
+         extents[1] + offset.y,
+         extents[2] - extents[0] + 1,
+         extents[3] - extents[1] + 1));
+   }
+}
+
+void HandDetector::TraceComponent(int index)
+{
+   const Rect& bound = _bounds[index];
+
+   //Trace a mask of the component with a border of zeros, so that components
+   //touching the image edge are still closed.
+   _componentMask.create(Size(_imageSize.width + 2, _imageSize.height + 2), CV_8UC1);
+   Mat mask = _componentMask(Rect(0, 0, bound.width + 2, bound.height + 2));
+   mask.setTo(Scalar(0));
+
+   Mat component = mask(Rect(1, 1, bound.width, bound.height));
+   compare(_labels(bound), Scalar(index + 1), component, CMP_EQ);
+
+   //An 8 connected component has a single external contour.
+   int method = _contourApproximation == ContourApproximation::Simple ? CHAIN_APPROX_SIMPLE : CHAIN_APPROX_NONE;
+   findContours(mask, _componentContours, RETR_EXTERNAL, method, bound.tl() - Point(1, 1));
+
+   if (!_componentContours.empty())
+   {
+      _contours[index].swap(_componentContours.front());
+   }
+
+   if (_showDebugInfo)
+   {
+      drawContours(_debugImage, _contours, index, Scalar(255), 3);
+   }
+}
+
+const std::vector<Point>& HandDetector::ApproximateContour(
+   const std::vector<Point>& contour,
+   size_t handIndex)
+{
+   if (_contourApproximation != ContourApproximation::Polygon)
+   {
+      return contour;
+   }
+
+   if (_approximatedContours.size() <= handIndex)
+   {
+      _approximatedContours.resize(handIndex + 1);
+   }
+
+   //Approximated as an open curve, which keeps the first point. A closed curve may
+   //start elsewhere, which changes the order of the defects.
+   std::vector<Point>& approximated = _approximatedContours[handIndex];
+   approxPolyDP(contour, approximated, _contourTolerance, false);
+
+   return approximated;
+}
+
+Rect HandDetector::PredictTrackingRegion() const
+{
+   //Assume the hand keeps moving as it did between the last two frames.
+   Point offset(cvRound(_trackingVelocity.x), cvRound(_trackingVelocity.y));
+   Rect predicted = _trackingBounds + offset;
+
+   //Grow by the margin in every direction and keep within the image.
+   predicted -= Point(_trackingMargin, _trackingMargin);
+   predicted += Size(_trackingMargin * 2, _trackingMargin * 2);
+
+   return predicted & Rect(Point(), _imageSize);
+}
+
+bool HandDetector::TouchesRegionBorder(const Rect& bound, const Rect& region) const
+{
+   bool touchesLeft = region.x > 0 &&
+      bound.x <= region.x + TRACKING_BORDER_TOLERANCE;
+   bool touchesTop = region.y > 0 &&
+      bound.y <= region.y + TRACKING_BORDER_TOLERANCE;
+   bool touchesRight = region.br().x < _imageSize.width &&
+      bound.br().x >= region.br().x - TRACKING_BORDER_TOLERANCE;
+   bool touchesBottom = region.br().y < _imageSize.height &&
+      bound.br().y >= region.br().y - TRACKING_BORDER_TOLERANCE;
+
+   return touchesLeft || touchesTop || touchesRight || touchesBottom;
+}
+
+void HandDetector::CalculateBounds(const std::vector<std::vector<Point>>& contours, std::vector<Rect>& bounds)
+{
+   bounds.clear();
+   for (auto& contour : contours)
+   {
+      bounds.push_back(boundingRect(contour));
+   }
+}
+
+bool HandDetector::Intersects(const Rect& a, const Rect& b)
+{
+   return (a & b).area() > 0;
+}
+
+int HandDetector::FindBestContour(
+   const std::vector<std::vector<Point>>& contours,
+   const std::vector<Rect>& bounds)
+{
    int contourCandidateIndex = -1;
    float contourCandiadateScore = 0;
 
    //Find contour with the highest score.
-   for (size_t i = 0; i < filteredContours.size(); i++)
+   for (size_t i = 0; i < contours.size(); i++)
    {
-      float score = CalculateContourScore(filteredContours[i], filteredBounds[i]);
+      if (!IsValidContourBound(bounds[i]))
+      {
+         //Filter out small contours.
+         continue;
+      }
+
+      float score = CalculateContourScore(contours[i], bounds[i]);
 
       if (score > contourCandiadateScore)
       {
          contourCandiadateScore = score;
-         contourCandidateIndex = i;
+         contourCandidateIndex = static_cast<int>(i);
       }
    }
 
@@ -207,23 +697,79 @@ std::vector<Point> HandDetector::FindBestContour(
       //Draw debug info.
       if (contourCandidateIndex != -1)
       {
-         for (size_t i = 0; i < filteredContours.size(); i++)
+         for (size_t i = 0; i < contours.size(); i++)
          {
-            drawContours(_debugImage, filteredContours, i, Scalar(255));
-            rectangle(_debugImage, filteredBounds[i], Scalar(100));
+            if (IsValidContourBound(bounds[i]))
+            {
+               DrawContour(_debugImage, contours, static_cast<int>(i), 1);
+               rectangle(_debugImage, bounds[i], Scalar(100));
+            }
          }
 
-         drawContours(_debugImage, filteredContours, contourCandidateIndex, Scalar(255), 3);
-         rectangle(_debugImage, filteredBounds[contourCandidateIndex], Scalar(100), 3);
+         DrawContour(_debugImage, contours, contourCandidateIndex, 3);
+         rectangle(_debugImage, bounds[contourCandidateIndex], Scalar(100), 3);
       }
    }
 
-   if (contourCandidateIndex >= 0)
+   return contourCandidateIndex;
+}
+
+void HandDetector::FindBestContours(
+   const std::vector<std::vector<Point>>& contours,
+   const std::vector<Rect>& bounds,
+   size_t count,
+   std::vector<std::pair<float, int>>& candidates)
+{
+   candidates.clear();
+
+   for (size_t i = 0; i < contours.size(); i++)
    {
-      return filteredContours[contourCandidateIndex];
+      if (!IsValidContourBound(bounds[i]))
+      {
+         //Filter out small contours.
+         continue;
+      }
+
+      float score = CalculateContourScore(contours[i], bounds[i]);
+
+      if (score > 0)
+      {
+         candidates.push_back(std::make_pair(score, static_cast<int>(i)));
+      }
+   }
+
+   //Keep the highest scores, in order.
+   count = std::min(count, candidates.size());
+   std::partial_sort(
+      candidates.begin(),
+      candidates.begin() + count,
+      candidates.end(),
+      std::greater<std::pair<float, int>>());
+   candidates.resize(count);
+
+   if (_showDebugInfo)
+   {
+      //Draw debug info.
+      for (size_t i = 0; i < contours.size(); i++)
+      {
+         if (IsValidContourBound(bounds[i]))
+         {
+            DrawContour(_debugImage, contours, static_cast<int>(i), 1);
+            rectangle(_debugImage, bounds[i], Scalar(100));
+         }
+      }
+
+      for (const auto& candidate : candidates)
+      {
+         DrawContour(_debugImage, contours, candidate.second, 3);
+         rectangle(_debugImage, bounds[candidate.second], Scalar(100), 3);
+      }
    }
+}
 
-   return {};
+bool HandDetector::IsValidContourBound(const Rect& bound) const
+{
+   return bound.width > MIN_CONTOUR_SIZE && bound.height > MIN_CONTOUR_SIZE;
 }
 
 float HandDetector::CalculateContourScore(const std::vector<cv::Point>& countour, const cv::Rect& bound)
@@ -242,7 +788,7 @@ float HandDetector::CalculateContourScore(const std::vector<cv::Point>& countour
 float HandDetector::SampleDepthInDirection(
    const Mat& depthInput,
    const Point2f& startPoint,
-   const Point2f& direction)
+   const Point2f& direction) const
 {
    float totalDepth = 0;
    int totalSampleCount = 0;
@@ -273,28 +819,57 @@ float HandDetector::SampleDepthInDirection(
    return 0;
 }
 
-Point2f HandDetector::ApplySmoothing(const Point2f& position)
+Point2f HandDetector::ApplySmoothing(const Point2f& previous, const Point2f& position) const
 {
-   Point2f previous = _handPosition;
    Point2f total = previous * POSITION_SMOOTHING + position;
    
    return total / (1.f + POSITION_SMOOTHING);
 }
 
-float HandDetector::CalculateDepth(const cv::Mat& depthInput)
+void HandDetector::CalculateDepth(const cv::Mat& depthInput, DetectedHand& hand) const
 {
    if (_isClosed)
    {
       //Calculate depth at hand position.
-      return SampleDepthInDirection(depthInput, _handPosition, -_direction);
+      hand.Depth = SampleDepthInDirection(depthInput, hand.Position, -hand.Direction);
    }
    else
    {
       //Calculate average depth of both finger tips.
-      float totalSamples =
-         SampleDepthInDirection(depthInput, _finger1Position, -_direction) +
-         SampleDepthInDirection(depthInput, _finger2Position, -_direction);
+      hand.Finger1Depth = SampleDepthInDirection(depthInput, hand.Finger1Position, -hand.Direction);
+      hand.Finger2Depth = SampleDepthInDirection(depthInput, hand.Finger2Position, -hand.Direction);
+
+      hand.Depth = (hand.Finger1Depth + hand.Finger2Depth) / 2.0f;
+   }
+}
+
+void HandDetector::GetKeypoints(std::vector<cv::Point2f>& positions, std::vector<float>& depths) const
+{
+   positions.clear();
+   depths.clear();
+
+   AppendKeypoints(_hand, positions, depths);
+}
+
+void HandDetector::AppendKeypoints(
+   const DetectedHand& hand,
+   std::vector<cv::Point2f>& positions,
+   std::vector<float>& depths) const
+{
+   positions.push_back(hand.Position);
+   depths.push_back(hand.Depth);
+
+   if (!_isClosed)
+   {
+      positions.push_back(hand.Finger1Position);
+      depths.push_back(hand.Finger1Depth);
+
+      positions.push_back(hand.Finger2Position);
+      depths.push_back(hand.Finger2Depth);
 
-      return totalSamples / 2.0f;
+      //The palm point lies between the fingers, where depth samples miss the hand,
+      //so it takes the hand depth.
+      positions.push_back(hand.PalmPosition);
+      depths.push_back(hand.Depth);
    }
 }
\ No newline at end of file
@@ -1,9 +1,93 @@
 #pragma once
 
 #include "CV/ConvexityDefectExtractor.h"
+#include "CV/DepthSegmenter.h"
 
 namespace HoloHands
 {
+   // Counters describing how often the tracking region had to be abandoned.
+   struct TrackingStatistics
+   {
+      TrackingStatistics()
+         :
+         FrameCount(0),
+         TrackedFrameCount(0),
+         ReacquisitionCount(0),
+         LostFrameCount(0)
+      {}
+
+      // Fraction of tracked frames that fell back to a full frame search.
+      float GetReacquisitionRate() const
+      {
+         int attempts = TrackedFrameCount + ReacquisitionCount;
+         return attempts > 0 ? static_cast<float>(ReacquisitionCount) / attempts : 0.f;
+      }
+
+      int FrameCount; //Frames processed.
+      int TrackedFrameCount; //Frames where the hand was found inside the tracking region.
+      int ReacquisitionCount; //Frames where the tracking region failed and the full frame was searched.
+      int LostFrameCount; //Frames where no hand was found at all.
+   };
+
+   // Time spent in each stage of a call to HandDetector::Process, in milliseconds.
+   struct StageTimings
+   {
+      StageTimings()
+         :
+         Segmentation(0),
+         Contours(0),
+         Pose(0),
+         Depth(0)
+      {}
+
+      double GetTotal() const { return Segmentation + Contours + Pose + Depth; }
+
+      double Segmentation; //Depth scaling and background removal.
+      double Contours; //Edge detection, contour extraction and selection.
+      double Pose; //Open or closed hand position.
+      double Depth; //Depth sampling at the hand position.
+   };
+
+   // How hand contours are simplified before the hand pose is calculated from them.
+   enum class ContourApproximation
+   {
+      None, //Every boundary pixel.
+      Simple, //Horizontal, vertical and diagonal runs reduced to their end points, which keeps the outline exact.
+      Polygon //Douglas-Peucker, keeping the outline within a tolerance.
+   };
+
+   // How the foreground image is divided into the regions hands are selected from.
+   enum class SegmentationBackend
+   {
+      Edges, //Edge detection and a blur close the outlines, and every outline is traced.
+      ConnectedComponents //Foreground pixels are labelled in a single pass, and only the selected hands are traced.
+   };
+
+   // A hand found in a depth image, in image coordinates.
+   struct DetectedHand
+   {
+      DetectedHand()
+         :
+         Id(0),
+         Score(0),
+         Depth(0),
+         Finger1Depth(0),
+         Finger2Depth(0)
+      {}
+
+      int Id; //Stays the same while the hand is found in consecutive frames.
+      float Score; //Contour score, higher == more suitable.
+      cv::Rect Bounds; //Of the hand's contour.
+      cv::Point2f Position;
+      cv::Point2f Direction; //Defined by the most recent open pose.
+      cv::Point2f Finger1Position;
+      cv::Point2f Finger2Position;
+      cv::Point2f PalmPosition;
+      float Depth;
+      float Finger1Depth;
+      float Finger2Depth;
+   };
+
    class HandDetector
    {
    public:
@@ -12,13 +96,58 @@ namespace HoloHands
       // Calculate a 2D position from a given image using OpenCV.
       bool Process(cv::Mat& input);
 
-      cv::Point2f GetHandPosition2D() { return _handPosition; }
-      float GetHandDepth() { return _handDepth; }
+      // The highest scoring hand of the most recent frame it was found in.
+      cv::Point2f GetHandPosition2D() { return _hand.Position; }
+      float GetHandDepth() { return _hand.Depth; }
+
+      // Hands found by the most recent call to Process, highest scoring first.
+      const std::vector<DetectedHand>& GetHands() const { return _detectedHands; }
+
+      // Number of hands searched for in each frame, 1 by default. With more than one,
+      // the most suitable contours are processed in parallel, each keeping its id while
+      // it overlaps the same hand's contour in the previous frame. The tracking region
+      // is only used when searching for a single hand.
+      void SetMaxHandCount(int count);
+
+      // Image positions and depths of the hand's keypoints: the hand position, then for
+      // an open hand the two finger tips and the palm. Depths of 0 could not be sampled.
+      void GetKeypoints(std::vector<cv::Point2f>& positions, std::vector<float>& depths) const;
+
+      // As above for any of the detected hands, appending to the vectors.
+      void AppendKeypoints(
+         const DetectedHand& hand,
+         std::vector<cv::Point2f>& positions,
+         std::vector<float>& depths) const;
+
       void SetIsClosed(bool isClosed) { _isClosed = isClosed; }
       void ShowDebugInfo(bool enabled);
+
+      // Simplifies the hand contours before the hull, defects, moments and closed hand
+      // scan see them. Fewer points are faster to process, but move the hand position.
+      // The tolerance, in pixels, only applies to ContourApproximation::Polygon.
+      void SetContourApproximation(ContourApproximation approximation, float tolerance);
+
+      // Edges by default. Connected components are selected by the same score, from
+      // their bounds, and their outlines follow the foreground pixels, where the blurred
+      // edges lie a few pixels outside them.
+      void SetSegmentationBackend(SegmentationBackend backend);
+
       cv::Mat& GetDebugImage() { return _debugImage; }
 
+      // When enabled, frames are only searched in a region around the previous hand
+      // location. The full frame is searched when the hand is lost or leaves the region.
+      void SetTrackingEnabled(bool enabled);
+      void SetTrackingMargin(int margin) { _trackingMargin = margin; }
+      const TrackingStatistics& GetTrackingStatistics() const { return _trackingStatistics; }
+      void ResetTrackingStatistics() { _trackingStatistics = TrackingStatistics(); }
+
+      // Stage timings of the most recent call to Process. When searching for more than
+      // one hand, the pose time includes depth sampling, which runs in the same pass.
+      const StageTimings& GetStageTimings() const { return _stageTimings; }
+
    private:
+      class ParallelHandProcessor;
+
       const float MAX_IMAGE_DEPTH = 1000; //Scales the image to fit within this range.
       const float MAX_DETECTION_THRESHOLD = 170; //Higher == detects objects further away.
       const float MIN_CONTOUR_SIZE = 40; //Minimum size of a valid contour.
@@ -31,25 +160,81 @@ namespace HoloHands
       const float DEPTH_SAMPLE_MIN = 200; //Minimum valid sample value, lower value will be discarded.
       const float DEPTH_SAMPLE_MAX = 1000; //Maximum valid sample value, higher value will be discarded.
       const float POSITION_SMOOTHING = 0.0f; //Higher == Positions are smoothed more with previous positions.
+      const int DEFAULT_TRACKING_MARGIN = 30; //Higher == Larger search region around the previous hand.
+      const int TRACKING_BORDER_TOLERANCE = 2; //Contours closer than this to the region border restart a full search.
 
       ConvexityDefectExtractor _defectExtractor;
+      DepthSegmenter _depthSegmenter;
+
+      //Per frame buffers, reused so that steady state processing does not allocate.
+      cv::Mat _scaled;
+      cv::Mat _hands;
+      cv::Mat _edges;
+      std::vector<std::vector<cv::Point>> _contours;
+      std::vector<cv::Rect> _bounds;
+      std::vector<std::vector<cv::Point>> _approximatedContours; //One per hand.
+      cv::Mat _labels;
+      cv::Mat _componentMask;
+      std::vector<cv::Vec4i> _componentExtents;
+      std::vector<std::vector<cv::Point>> _componentContours;
+
+      SegmentationBackend _segmentationBackend;
+
+      ContourApproximation _contourApproximation;
+      float _contourTolerance;
+
       bool _isClosed;
-      cv::Point2f _handPosition;
-      cv::Point2f _finger1Position;
-      cv::Point2f _finger2Position;
-      cv::Point2f _palmPosition;
-      cv::Point2f _direction;
-      float _handDepth;
+      DetectedHand _hand;
       cv::Mat _debugImage;
       bool _showDebugInfo;
       cv::Size _imageSize;
 
+      bool _isTrackingEnabled;
+      bool _hasTrackingRegion;
+      int _trackingMargin;
+      cv::Rect _trackingBounds;
+      cv::Point2f _trackingVelocity;
+      TrackingStatistics _trackingStatistics;
+      StageTimings _stageTimings;
+
+      int _maxHandCount;
+      int _nextHandId;
+      std::vector<DetectedHand> _detectedHands;
+      std::vector<DetectedHand> _previousHands;
+      std::vector<std::pair<float, int>> _candidates; //Scores and indices of the hands' contours.
+      std::vector<ConvexityDefectExtractor> _candidateDefectExtractors; //One per hand, as they keep buffers.
+
+      // Finds the single most suitable hand, inside the tracking region when possible.
+      bool ProcessSingleHand(const cv::Mat& input);
+
+      // Finds up to the maximum number of hands, processing each in parallel.
+      bool ProcessMultipleHands(const cv::Mat& input);
+
+      // Calculates the pose and depth of one of the hands found by ProcessMultipleHands.
+      // Safe to call for different hands at the same time.
+      void ProcessCandidate(
+         const cv::Mat& input,
+         size_t index);
+
+      // Gives each hand the id and pose of the previous frame's hand whose bounds it
+      // overlaps most, or a new id when it overlaps none. Hands are matched highest
+      // scoring first, and each previous hand is matched at most once.
+      void MatchPreviousHands();
+
       // Selects the mid point between the thumb and finger.
-      void ProcessOpenHand(const std::vector<cv::Point>& contour);
+      void ProcessOpenHand(
+         const std::vector<cv::Point>& contour,
+         ConvexityDefectExtractor& defectExtractor,
+         DetectedHand& hand) const;
 
       // Selects the furthest contour point in the hand's direction.
       // The hand direction is defined by the most recent open pose.
-      void ProcessClosedHand(const std::vector<cv::Point>& contour);
+      void ProcessClosedHand(
+         const std::vector<cv::Point>& contour,
+         DetectedHand& hand) const;
+
+      // Draws the hand's position, direction and finger points.
+      void DrawHand(const DetectedHand& hand);
 
       // Calculates a vector of bounds for a given vector of contours.
       static void CalculateBounds(
@@ -61,28 +246,80 @@ namespace HoloHands
          const cv::Rect& a,
          const cv::Rect& b);
 
-      // Find the most suitable contours.
-      std::vector<cv::Point> FindBestContour(
-         const std::vector<std::vector<cv::Point>>& countours,
+      // Runs edge detection and contour extraction inside a region of the image.
+      // Returns the index of the most suitable contour, or -1 if none is found.
+      int FindContourInRegion(const cv::Rect& region);
+
+      // Runs edge detection and contour extraction inside a region of the image.
+      // With connected components, only the bounds are found, and the contours are
+      // left empty until TraceComponent is called.
+      void FindContoursInRegion(const cv::Rect& region);
+
+      // Labels the foreground pixels inside a region of the image, and sets the bounds
+      // of every component.
+      void FindComponentsInRegion(const cv::Rect& region);
+
+      // Sets the bounds of the labelled components, in full image coordinates.
+      void CalculateComponentBounds(
+         const cv::Mat& foreground,
+         const cv::Mat& labels,
+         int componentCount,
+         const cv::Point& offset);
+
+      // Traces the contour of a component found by FindComponentsInRegion.
+      void TraceComponent(int index);
+
+      // Returns the contour simplified with Douglas-Peucker when enabled, using the
+      // hand's buffer, or else the contour itself.
+      const std::vector<cv::Point>& ApproximateContour(
+         const std::vector<cv::Point>& contour,
+         size_t handIndex);
+
+      // Predicts where the hand will be from its previous bounds and movement.
+      cv::Rect PredictTrackingRegion() const;
+
+      // Returns true when the bound touches an edge of the region that is not
+      // also an edge of the image.
+      bool TouchesRegionBorder(
+         const cv::Rect& bound,
+         const cv::Rect& region) const;
+
+      // Find the most suitable contour.
+      // Returns the index of the contour, or -1 if no contour is suitable.
+      int FindBestContour(
+         const std::vector<std::vector<cv::Point>>& contours,
          const std::vector<cv::Rect>& bounds);
 
+      // Finds up to count of the most suitable contours, highest scoring first.
+      void FindBestContours(
+         const std::vector<std::vector<cv::Point>>& contours,
+         const std::vector<cv::Rect>& bounds,
+         size_t count,
+         std::vector<std::pair<float, int>>& candidates);
+
+      // Returns true when the contour bound is large enough to be a hand.
+      bool IsValidContourBound(const cv::Rect& bound) const;
+
       // Calculates a score for a given contour.
       // The higher to score, to more suitable the contour.
       float CalculateContourScore(
          const std::vector<cv::Point>& countour,
          const cv::Rect& bound);
 
-      // Calculate a depth at the current hand postion.
-      float HandDetector::CalculateDepth(const cv::Mat& depthInput);
+      // Calculate a depth at the hand postion.
+      void CalculateDepth(
+         const cv::Mat& depthInput,
+         DetectedHand& hand) const;
 
       // Samples depth value at multiples points in a given direction.
       float SampleDepthInDirection(
          const cv::Mat& depthInput,
          const cv::Point2f& startPoint,
-         const cv::Point2f& direction);
+         const cv::Point2f& direction) const;
 
       // Apply temporal smoothing the 2D position values.
-      cv::Point2f HandDetector::ApplySmoothing(
-         const cv::Point2f& position);
+      cv::Point2f ApplySmoothing(
+         const cv::Point2f& previous,
+         const cv::Point2f& position) const;
    };
 }  
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "pch.h"
+
+#include "HandTrackingPipeline.h"
+
+using namespace HoloHands;
+using namespace Windows::Foundation;
+using namespace Windows::Foundation::Numerics;
+
+HandTrackingPipeline::HandTrackingPipeline()
+   :
+   _isRunning(false),
+   _isClosed(false),
+   _showDebugInfo(false),
+   _maxHandCount(1),
+   _maxFrameAge(DEFAULT_MAX_FRAME_AGE)
+{
+   _handDetector.SetTrackingEnabled(true);
+}
+
+HandTrackingPipeline::~HandTrackingPipeline()
+{
+   Stop();
+}
+
+void HandTrackingPipeline::Start(HoloLensForCV::MediaFrameSourceGroup^ frameSource)
+{
+   Stop();
+
+   _frameSource = frameSource;
+   _isRunning = true;
+   _thread = std::thread(&HandTrackingPipeline::Run, this);
+}
+
+void HandTrackingPipeline::Stop()
+{
+   _isRunning = false;
+
+   if (_thread.joinable())
+   {
+      _thread.join();
+   }
+
+   _frameSource = nullptr;
+}
+
+void HandTrackingPipeline::Run()
+{
+   int64_t latestTimestamp = 0;
+
+   while (_isRunning)
+   {
+      HoloLensForCV::SensorFrame^ frame =
+         _frameSource->GetLatestSensorFrame(HoloLensForCV::SensorType::ShortThrowToFDepth);
+
+      if (frame == nullptr || frame->Timestamp.UniversalTime == latestTimestamp)
+      {
+         //Wait for the next frame.
+         std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_POLL_INTERVAL));
+         continue;
+      }
+
+      latestTimestamp = frame->Timestamp.UniversalTime;
+
+      //Drop stale frames rather than falling behind the sensor.
+      double frameAge = GetFrameAge(frame);
+      if (frameAge > _maxFrameAge)
+      {
+         _statistics.DroppedFrameCount++;
+         continue;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+
+      HandTrackingResult& result = _results.GetBackBuffer();
+      ProcessFrame(frame, result);
+
+      double processingTime =
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+      _statistics.ProcessedFrameCount++;
+      _statistics.FrameAge = frameAge;
+      _statistics.MaxFrameAge = std::max(_statistics.MaxFrameAge, frameAge);
+      _statistics.TotalFrameAge += frameAge;
+      _statistics.ProcessingTime = processingTime;
+      _statistics.MaxProcessingTime = std::max(_statistics.MaxProcessingTime, processingTime);
+      _statistics.TotalProcessingTime += processingTime;
+
+      result.Statistics = _statistics;
+      _results.Publish();
+
+      if (_statistics.ProcessedFrameCount % STATISTICS_REPORT_INTERVAL == 0)
+      {
+         dbg::trace(
+            L"HandTrackingPipeline: %i frames processed, %i dropped, frame age %.02fms (max %.02fms), processing %.02fms (max %.02fms)",
+            _statistics.ProcessedFrameCount,
+            _statistics.DroppedFrameCount,
+            _statistics.GetAverageFrameAge(),
+            _statistics.MaxFrameAge,
+            _statistics.GetAverageProcessingTime(),
+            _statistics.MaxProcessingTime);
+      }
+   }
+}
+
+void HandTrackingPipeline::ProcessFrame(
+   HoloLensForCV::SensorFrame^ frame,
+   HandTrackingResult& result)
+{
+   cv::Mat image;
+   rmcv::WrapHoloLensSensorFrameWithCvMat(frame, image);
+
+   bool showDebugInfo = _showDebugInfo;
+   _handDetector.SetIsClosed(_isClosed);
+   _handDetector.ShowDebugInfo(showDebugInfo);
+   _handDetector.SetMaxHandCount(_maxHandCount);
+
+   //Detect 2D hand positions and depths from OpenCV Mat.
+   result.HandFound = _handDetector.Process(image);
+   result.Timestamp = frame->Timestamp;
+
+   bool hasUnprojectionTable = result.HandFound && UpdateUnprojectionTable(frame);
+
+   result.Hands.clear();
+   result.Keypoints.clear();
+   _keypointPositions.clear();
+   _keypointDepths.clear();
+
+   if (result.HandFound)
+   {
+      for (const DetectedHand& hand : _handDetector.GetHands())
+      {
+         TrackedHand trackedHand;
+         trackedHand.Id = hand.Id;
+         trackedHand.HasPosition =
+            hasUnprojectionTable && hand.Depth >= MIN_HAND_DEPTH && hand.Depth <= MAX_HAND_DEPTH;
+
+         if (trackedHand.HasPosition)
+         {
+            trackedHand.FirstKeypoint = _keypointPositions.size();
+            _handDetector.AppendKeypoints(hand, _keypointPositions, _keypointDepths);
+            trackedHand.KeypointCount = _keypointPositions.size() - trackedHand.FirstKeypoint;
+         }
+
+         result.Hands.push_back(trackedHand);
+      }
+   }
+
+   if (!_keypointPositions.empty())
+   {
+      UnprojectKeypoints(frame, result.Keypoints);
+
+      //Each hand's position is its first keypoint.
+      for (TrackedHand& trackedHand : result.Hands)
+      {
+         if (trackedHand.HasPosition)
+         {
+            trackedHand.Position = result.Keypoints[trackedHand.FirstKeypoint];
+         }
+      }
+   }
+
+   result.HasHandPosition = !result.Hands.empty() && result.Hands[0].HasPosition;
+
+   if (result.HasHandPosition)
+   {
+      result.HandPosition = result.Hands[0].Position;
+   }
+
+   if (showDebugInfo)
+   {
+      //Reuses the result's buffer once it has the right size.
+      _handDetector.GetDebugImage().copyTo(result.DebugImage);
+   }
+}
+
+bool HandTrackingPipeline::UpdateUnprojectionTable(HoloLensForCV::SensorFrame^ frame)
+{
+   HoloLensForCV::CameraIntrinsics^ cameraIntrinsics = frame->SensorStreamingCameraIntrinsics;
+
+   if (cameraIntrinsics == nullptr)
+   {
+      return false;
+   }
+
+   //The frame reader passes the same intrinsics with every frame of the same size.
+   if (cameraIntrinsics != _cameraIntrinsics)
+   {
+      unsigned int width = cameraIntrinsics->ImageWidth;
+      unsigned int height = cameraIntrinsics->ImageHeight;
+
+      auto unitPlaneX = ref new Platform::Array<float>(width * height);
+      auto unitPlaneY = ref new Platform::Array<float>(width * height);
+      cameraIntrinsics->CopyUnprojectionTable(unitPlaneX, unitPlaneY);
+
+      _unprojectionTable = Io::CameraUnprojectionTable(width, height);
+
+      for (unsigned int y = 0; y < height; y++)
+      {
+         for (unsigned int x = 0; x < width; x++)
+         {
+            _unprojectionTable.Set(x, y, unitPlaneX[y * width + x], unitPlaneY[y * width + x]);
+         }
+      }
+
+      _cameraIntrinsics = cameraIntrinsics;
+   }
+
+   return true;
+}
+
+void HandTrackingPipeline::UnprojectKeypoints(
+   HoloLensForCV::SensorFrame^ frame,
+   std::vector<float3>& worldPositions)
+{
+   //Calculate the camera to world transform once for all keypoints.
+   float4x4 viewToFrame;
+   invert(frame->CameraViewTransform, &viewToFrame);
+
+   float4x4 cameraToWorld = viewToFrame * frame->FrameToOrigin;
+
+   size_t count = _keypointPositions.size();
+   _keypointU.resize(count);
+   _keypointV.resize(count);
+   _keypointX.resize(count);
+   _keypointY.resize(count);
+   _keypointZ.resize(count);
+
+   for (size_t i = 0; i < count; i++)
+   {
+      _keypointU[i] = _keypointPositions[i].x;
+      _keypointV[i] = _keypointPositions[i].y;
+   }
+
+   //Convert from UV space to world space, interpolating between pixels.
+   Io::UnprojectImagePoints(
+      _unprojectionTable,
+      _keypointU.data(),
+      _keypointV.data(),
+      _keypointDepths.data(),
+      count,
+      DEPTH_SCALE,
+      &cameraToWorld.m11,
+      _keypointX.data(),
+      _keypointY.data(),
+      _keypointZ.data());
+
+   worldPositions.resize(count);
+
+   for (size_t i = 0; i < count; i++)
+   {
+      worldPositions[i] = float3(_keypointX[i], _keypointY[i], _keypointZ[i]);
+   }
+}
+
+double HandTrackingPipeline::GetFrameAge(HoloLensForCV::SensorFrame^ frame)
+{
+   //Frame timestamps are absolute, in hundreds of nanoseconds since January 1st 1601.
+   FILETIME now;
+   GetSystemTimePreciseAsFileTime(&now);
+
+   ULARGE_INTEGER nowTicks;
+   nowTicks.LowPart = now.dwLowDateTime;
+   nowTicks.HighPart = now.dwHighDateTime;
+
+   return (static_cast<int64_t>(nowTicks.QuadPart) - frame->Timestamp.UniversalTime) / 10000.0;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "CV/HandDetector.h"
+
+namespace HoloHands
+{
+   // Frame age and processing time of the hand tracking pipeline, in milliseconds.
+   // The frame age is the time between the frame's capture and the start of its processing.
+   struct PipelineStatistics
+   {
+      PipelineStatistics()
+         :
+         ProcessedFrameCount(0),
+         DroppedFrameCount(0),
+         FrameAge(0),
+         MaxFrameAge(0),
+         TotalFrameAge(0),
+         ProcessingTime(0),
+         MaxProcessingTime(0),
+         TotalProcessingTime(0)
+      {}
+
+      double GetAverageFrameAge() const
+      {
+         return ProcessedFrameCount > 0 ? TotalFrameAge / ProcessedFrameCount : 0;
+      }
+
+      double GetAverageProcessingTime() const
+      {
+         return ProcessedFrameCount > 0 ? TotalProcessingTime / ProcessedFrameCount : 0;
+      }
+
+      int ProcessedFrameCount; //Frames run through the hand detector.
+      int DroppedFrameCount; //Frames discarded because they were too old when picked up.
+      double FrameAge; //Age of the most recently processed frame.
+      double MaxFrameAge;
+      double TotalFrameAge;
+      double ProcessingTime; //Processing time of the most recently processed frame.
+      double MaxProcessingTime;
+      double TotalProcessingTime;
+   };
+
+   // A hand found in a depth frame.
+   struct TrackedHand
+   {
+      TrackedHand()
+         :
+         Id(0),
+         HasPosition(false),
+         FirstKeypoint(0),
+         KeypointCount(0)
+      {}
+
+      int Id; //Stays the same while the hand is found in consecutive frames.
+      bool HasPosition; //The hand depth was valid, so Position and the keypoints are set.
+      Windows::Foundation::Numerics::float3 Position; //World space hand position.
+      size_t FirstKeypoint; //Index of the hand's first keypoint in HandTrackingResult::Keypoints.
+      size_t KeypointCount;
+   };
+
+   // Result of processing a single depth frame.
+   struct HandTrackingResult
+   {
+      HandTrackingResult()
+         :
+         HandFound(false),
+         HasHandPosition(false)
+      {}
+
+      bool HandFound; //A hand was found in the depth image.
+      bool HasHandPosition; //The hand depth was valid, so HandPosition is set.
+      Windows::Foundation::Numerics::float3 HandPosition; //World space position of the highest scoring hand.
+      std::vector<TrackedHand> Hands; //All hands found, highest scoring first.
+      std::vector<Windows::Foundation::Numerics::float3> Keypoints; //World space HandDetector::AppendKeypoints of each hand with a position, NaN without depth.
+      Windows::Foundation::DateTime Timestamp; //Capture time of the processed frame.
+      cv::Mat DebugImage; //Only set when debug info is shown.
+      PipelineStatistics Statistics;
+   };
+
+   // Runs the hand detector on its own thread, so depth processing does not compete
+   // with the holographic frame update. The thread always picks up the latest depth
+   // frame, drops frames that are too old, and publishes each result through a lock-free
+   // slot that the render thread reads without blocking.
+   class HandTrackingPipeline
+   {
+   public:
+      HandTrackingPipeline();
+      ~HandTrackingPipeline();
+
+      // Starts processing depth frames from the given frame source.
+      void Start(HoloLensForCV::MediaFrameSourceGroup^ frameSource);
+
+      // Stops processing and waits for the current frame to finish.
+      void Stop();
+
+      bool IsRunning() const { return _isRunning; }
+
+      void SetIsClosed(bool isClosed) { _isClosed = isClosed; }
+      void ShowDebugInfo(bool enabled) { _showDebugInfo = enabled; }
+
+      // Number of hands searched for in each frame, see HandDetector::SetMaxHandCount.
+      void SetMaxHandCount(int count) { _maxHandCount = count; }
+
+      // Frames older than this when picked up are dropped instead of processed.
+      void SetMaxFrameAge(double milliseconds) { _maxFrameAge = milliseconds; }
+
+      // Picks up the latest result. Never blocks.
+      // Returns false if no frame was processed since the previous call.
+      bool Update() { return _results.Update(); }
+
+      // The result picked up by the last successful call to Update.
+      HandTrackingResult& GetLatestResult() { return _results.GetFrontBuffer(); }
+
+   private:
+      const double DEFAULT_MAX_FRAME_AGE = 100; //Higher == Older frames are still processed.
+      const int FRAME_POLL_INTERVAL = 2; //Milliseconds to wait for a new frame.
+      const int STATISTICS_REPORT_INTERVAL = 300; //Frames between statistics traces.
+      const float MIN_HAND_DEPTH = 200; //Minimum valid hand depth.
+      const float MAX_HAND_DEPTH = 1000; //Maximum valid hand depth.
+      const float DEPTH_SCALE = 0.001f; //Meters per depth unit.
+
+      HandDetector _handDetector;
+      HoloLensForCV::MediaFrameSourceGroup^ _frameSource;
+      std::thread _thread;
+      std::atomic<bool> _isRunning;
+      std::atomic<bool> _isClosed;
+      std::atomic<bool> _showDebugInfo;
+      std::atomic<int> _maxHandCount;
+      std::atomic<double> _maxFrameAge;
+
+      Io::LatestValueSlot<HandTrackingResult> _results;
+      PipelineStatistics _statistics;
+
+      //Local copy of the depth camera's unprojection table, so hand positions are
+      //looked up without calling into HoloLensForCV.
+      HoloLensForCV::CameraIntrinsics^ _cameraIntrinsics; //The intrinsics the table was copied from.
+      Io::CameraUnprojectionTable _unprojectionTable;
+
+      //Keypoints of the current frame, reused so that steady state processing does not allocate.
+      std::vector<cv::Point2f> _keypointPositions;
+      std::vector<float> _keypointDepths;
+      std::vector<float> _keypointU;
+      std::vector<float> _keypointV;
+      std::vector<float> _keypointX;
+      std::vector<float> _keypointY;
+      std::vector<float> _keypointZ;
+
+      // Thread function, processes frames until the pipeline is stopped.
+      void Run();
+
+      // Runs the hand detector on a frame and fills in the result.
+      void ProcessFrame(
+         HoloLensForCV::SensorFrame^ frame,
+         HandTrackingResult& result);
+
+      // Copies the unprojection table of the frame's intrinsics, unless already copied.
+      // Returns false if the frame has no sensor streaming intrinsics.
+      bool UpdateUnprojectionTable(HoloLensForCV::SensorFrame^ frame);
+
+      // Unprojects the keypoints of all hands and their depths into world space in one call,
+      // with the camera to world transform calculated once per frame.
+      void UnprojectKeypoints(
+         HoloLensForCV::SensorFrame^ frame,
+         std::vector<Windows::Foundation::Numerics::float3>& worldPositions);
+
+      // Milliseconds between the frame's capture and now.
+      static double GetFrameAge(HoloLensForCV::SensorFrame^ frame);
+   };
+}
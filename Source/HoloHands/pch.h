@@ -13,6 +13,7 @@
 
 #include <agile.h>
 #include <array>
+#include <atomic>
 #include <collection.h>
 #include <d2d1_2.h>
 #include <d3d11_4.h>
@@ -26,6 +27,7 @@
 #include <WindowsNumerics.h>
 #include <ppltasks.h>
 #include <stddef.h>
+#include <thread>
 #include <unordered_set>
 #include <memorybuffer.h>
 
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <Debugging/Annotations.h>
 #include <Debugging/Trace.h>
 #include <Debugging/Timer.h>
 #include <Debugging/TimerGuard.h>
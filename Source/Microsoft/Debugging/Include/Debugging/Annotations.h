@@ -0,0 +1,31 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+//
+// The Visual C++ source annotation (SAL) macros used throughout the shared libraries
+// only have a meaning for the Microsoft compiler. Define them away elsewhere, so the
+// platform neutral parts of the code can be built with GCC or Clang.
+//
+#if !defined(_MSC_VER)
+#define _In_
+#define _In_z_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _Inout_opt_
+#define _In_reads_(size)
+#define _Out_writes_(size)
+#define _Use_decl_annotations_
+#endif /* !defined(_MSC_VER) */
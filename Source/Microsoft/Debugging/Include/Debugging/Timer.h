@@ -14,7 +14,8 @@
 namespace dbg
 {
     //
-    // QueryPerformanceCounter-based timer / stop-watch.
+    // QueryPerformanceCounter-based timer / stop-watch. Uses std::chrono::steady_clock
+    // on platforms other than Windows.
     //
     class Timer
     {
@@ -32,7 +33,12 @@ namespace dbg
     private:
         double _ticksPerMilisecond;
 
+#if defined(_WIN32)
         LARGE_INTEGER _startTime;
         LARGE_INTEGER _lastEventTime;
+#else
+        std::chrono::steady_clock::time_point _startTime;
+        std::chrono::steady_clock::time_point _lastEventTime;
+#endif /* defined(_WIN32) */
     };
 }
@@ -15,6 +15,7 @@ namespace dbg
 {
     //
     // Formats a message and sends it to the debugger using the OutputDebugString API.
+    // On other platforms the message is written to the standard error stream.
     //
     void trace(
         _In_z_ const wchar_t* msg,
@@ -13,6 +13,7 @@
 
 namespace dbg
 {
+#if defined(_WIN32)
     Timer::Timer()
     {
         LARGE_INTEGER ticks_per_second;
@@ -53,4 +54,40 @@ namespace dbg
 
         return static_cast<double>(current_time.QuadPart - _lastEventTime.QuadPart) / _ticksPerMilisecond;
     }
+#else
+    Timer::Timer()
+    {
+        _ticksPerMilisecond =
+            static_cast<double>(std::chrono::steady_clock::period::den) /
+            std::chrono::steady_clock::period::num / 1000.0;
+
+        Reset();
+    }
+
+    void Timer::Reset()
+    {
+        MarkEvent();
+
+        _startTime = _lastEventTime;
+    }
+
+    void Timer::MarkEvent()
+    {
+        _lastEventTime = std::chrono::steady_clock::now();
+    }
+
+    double Timer::GetMillisecondsFromStart() const
+    {
+        const auto current_time = std::chrono::steady_clock::now();
+
+        return static_cast<double>((current_time - _startTime).count()) / _ticksPerMilisecond;
+    }
+
+    double Timer::GetMillisecondsFromLastEvent() const
+    {
+        const auto current_time = std::chrono::steady_clock::now();
+
+        return static_cast<double>((current_time - _lastEventTime).count()) / _ticksPerMilisecond;
+    }
+#endif /* defined(_WIN32) */
 }
@@ -15,6 +15,7 @@
 
 namespace dbg
 {
+#if defined(_WIN32)
     void trace(
         _In_z_ const wchar_t* msg,
         ...)
@@ -35,4 +36,66 @@ namespace dbg
 
         OutputDebugString(buffer);
     }
+#else
+    //
+    // The trace messages follow the Visual C++ convention for wide format strings, where
+    // %s expects a wide string and %S a narrow one. Standard C uses %ls and %s instead.
+    //
+    static std::wstring ToStandardFormat(
+        _In_z_ const wchar_t* msg)
+    {
+        std::wstring format;
+
+        for (const wchar_t* cursor = msg; *cursor != L'\0'; ++cursor)
+        {
+            format.push_back(*cursor);
+
+            if (*cursor != L'%')
+            {
+                continue;
+            }
+
+            //
+            // Copy the flags, width, precision and length modifiers.
+            //
+            bool hasLengthModifier = false;
+
+            while (cursor[1] != L'\0' && wcschr(L"-+ #0123456789.*hlLjzt", cursor[1]) != nullptr)
+            {
+                hasLengthModifier |= wcschr(L"hlLjzt", cursor[1]) != nullptr;
+                format.push_back(*++cursor);
+            }
+
+            if (cursor[1] == L'S' || cursor[1] == L'C')
+            {
+                format.push_back(static_cast<wchar_t>(towlower(*++cursor)));
+            }
+            else if ((cursor[1] == L's' || cursor[1] == L'c') && !hasLengthModifier)
+            {
+                format.push_back(L'l');
+                format.push_back(*++cursor);
+            }
+            else if (cursor[1] != L'\0')
+            {
+                format.push_back(*++cursor);
+            }
+        }
+
+        return format;
+    }
+
+    void trace(
+        _In_z_ const wchar_t* msg,
+        ...)
+    {
+        wchar_t buffer[TRACE_BUFFER_SIZE + 1] = {};
+        va_list args;
+
+        va_start(args, msg);
+        vswprintf(buffer, TRACE_BUFFER_SIZE, ToStandardFormat(msg).c_str(), args);
+        va_end(args);
+
+        fprintf(stderr, "%ls\n", buffer);
+    }
+#endif /* defined(_WIN32) */
 }
@@ -11,11 +11,12 @@
 
 #pragma once
 
-#include "targetver.h"
-
 #include <string>
 #include <stdexcept>
 
+#if defined(_WIN32)
+#include "targetver.h"
+
 #if !defined(WIN32_LEAN_AND_MEAN)
 #define WIN32_LEAN_AND_MEAN
 #endif /* !defined(WIN32_LEAN_AND_MEAN) */
@@ -25,5 +26,12 @@
 #endif /* !defined(NOMINMAX) */
 
 #include <Windows.h>
+#else
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cwchar>
+#include <cwctype>
+#endif /* defined(_WIN32) */
 
 #include <Debugging/All.h>
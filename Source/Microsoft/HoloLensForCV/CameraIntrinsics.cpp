@@ -27,20 +27,11 @@ namespace HoloLensForCV
         _In_ Windows::Foundation::Point UV,
         _Out_ Windows::Foundation::Point* XY)
     {
-        float uv[2] = { UV.X, UV.Y };
-        float xy[2];
-
-        if (FAILED(_sensorStreamingCameraIntrinsics->MapImagePointToCameraUnitPlane(uv, xy)))
-        {
-            XY->X = XY->Y = std::numeric_limits<float>::infinity();
-
-            return false;
-        }
-
-        XY->X = xy[0];
-        XY->Y = xy[1];
-
-        return true;
+        return GetUnprojectionTable().MapImagePointToCameraUnitPlane(
+            UV.X,
+            UV.Y,
+            XY->X,
+            XY->Y);
     }
 
     bool CameraIntrinsics::MapCameraSpaceToImagePoint(
@@ -62,4 +53,66 @@ namespace HoloLensForCV
 
         return true;
     }
+
+    void CameraIntrinsics::CopyUnprojectionTable(
+        _Out_ Platform::WriteOnlyArray<float>^ unitPlaneX,
+        _Out_ Platform::WriteOnlyArray<float>^ unitPlaneY)
+    {
+        const Io::CameraUnprojectionTable& unprojectionTable =
+            GetUnprojectionTable();
+
+        const size_t pixelCount =
+            static_cast<size_t>(ImageWidth) * ImageHeight;
+
+        REQUIRES(
+            unitPlaneX->Length == pixelCount &&
+            unitPlaneY->Length == pixelCount);
+
+        memcpy(
+            unitPlaneX->Data,
+            unprojectionTable.GetUnitPlaneX(),
+            pixelCount * sizeof(float));
+
+        memcpy(
+            unitPlaneY->Data,
+            unprojectionTable.GetUnitPlaneY(),
+            pixelCount * sizeof(float));
+    }
+
+    const Io::CameraUnprojectionTable& CameraIntrinsics::GetUnprojectionTable()
+    {
+        std::call_once(
+            _unprojectionTableFlag,
+            [this]()
+        {
+            Io::CameraUnprojectionTable unprojectionTable(
+                ImageWidth,
+                ImageHeight);
+
+            for (unsigned int y = 0; y < ImageHeight; ++y)
+            {
+                for (unsigned int x = 0; x < ImageWidth; ++x)
+                {
+                    float uv[2] = { float(x), float(y) };
+                    float xy[2];
+
+                    //
+                    // Pixels the camera cannot map stay at infinity.
+                    //
+                    if (SUCCEEDED(_sensorStreamingCameraIntrinsics->MapImagePointToCameraUnitPlane(uv, xy)))
+                    {
+                        unprojectionTable.Set(
+                            x,
+                            y,
+                            xy[0],
+                            xy[1]);
+                    }
+                }
+            }
+
+            _unprojectionTable = std::move(unprojectionTable);
+        });
+
+        return _unprojectionTable;
+    }
 }
@@ -16,6 +16,12 @@ namespace HoloLensForCV
     /// <summary>
     /// Wraps the SensorStreaming::ICameraIntrinsics interface to exposes more detailed information
     /// about camera intrinsics.
+    ///
+    /// Image points are mapped to the unit plane through a table of every pixel, built by
+    /// the first call from the sensor streaming intrinsics, rather than through a call into
+    /// the sensor streaming intrinsics per point. MediaFrameReaderContext passes the same
+    /// instance with every frame of a sensor, so the table is built once per sensor and
+    /// resolution.
     /// </summary>
     public ref class CameraIntrinsics sealed
     {
@@ -30,7 +36,8 @@ namespace HoloLensForCV
         /// Maps an image pixel to the unit Z=1 plane.
         ///
         /// Convention applied is that integer coordinate of the pixel corresponds to
-        /// the location of its top-left corner.
+        /// the location of its top-left corner. Points between pixels are interpolated
+        /// bilinearly from the four pixels around them.
         /// </summary>
         bool MapImagePointToCameraUnitPlane(
             _In_ Windows::Foundation::Point UV,
@@ -47,11 +54,25 @@ namespace HoloLensForCV
             _In_ Windows::Foundation::Point XY,
             _Out_ Windows::Foundation::Point* UV);
 
+        /// <summary>
+        /// Copies the unit plane coordinates of all pixels, row by row, into arrays of
+        /// ImageWidth * ImageHeight elements, for callers that map many points at once.
+        /// </summary>
+        void CopyUnprojectionTable(
+            _Out_ Platform::WriteOnlyArray<float>^ unitPlaneX,
+            _Out_ Platform::WriteOnlyArray<float>^ unitPlaneY);
+
         property unsigned int ImageWidth;
 
         property unsigned int ImageHeight;
 
+    internal:
+        const Io::CameraUnprojectionTable& GetUnprojectionTable();
+
     private:
         Microsoft::WRL::ComPtr<SensorStreaming::ICameraIntrinsics> _sensorStreamingCameraIntrinsics;
+
+        std::once_flag _unprojectionTableFlag;
+        Io::CameraUnprojectionTable _unprojectionTable;
     };
 }
@@ -16,31 +16,24 @@ namespace HoloLensForCV
     _Use_decl_annotations_
     CsvWriter::CsvWriter(
         const std::wstring& outputFileName)
-        : _file(outputFileName)
+        : Io::CsvWriter(outputFileName)
     {
-        ASSERT(_file);
-    }
-
-    CsvWriter::~CsvWriter()
-    {
-        EndLine();
     }
 
     _Use_decl_annotations_
     void CsvWriter::WriteHeader(
         const std::vector<std::wstring>& columns)
     {
-        bool writeComma = false;
+        std::vector<std::string> utf8Columns;
 
         for (const auto& column : columns)
         {
-            WriteComma(
-                &writeComma);
-
-            _file << column;
+            utf8Columns.push_back(
+                Utf16ToUtf8(column));
         }
 
-        EndLine();
+        WriteHeader(
+            utf8Columns);
     }
 
     _Use_decl_annotations_
@@ -48,54 +41,9 @@ namespace HoloLensForCV
         const std::wstring& text,
         bool* writeComma)
     {
-        WriteComma(
-            writeComma);
-
-        _file << text;
-    }
-
-    _Use_decl_annotations_
-    void CsvWriter::WriteInt32(
-        const int32_t value,
-        bool* writeComma)
-    {
-        WriteComma(
+        WriteText(
+            Utf16ToUtf8(text),
             writeComma);
-
-        _file << value;
-    }
-
-    _Use_decl_annotations_
-    void CsvWriter::WriteUInt64(
-        _In_ const uint64_t value,
-        _Inout_ bool* writeComma)
-    {
-        WriteComma(
-            writeComma);
-
-        _file << value;
-    }
-
-    _Use_decl_annotations_
-    void CsvWriter::WriteFloat(
-        const float value,
-        bool* writeComma)
-    {
-        WriteComma(
-            writeComma);
-
-        _file << value;
-    }
-
-    _Use_decl_annotations_
-    void CsvWriter::WriteDouble(
-        const double value,
-        bool* writeComma)
-    {
-        WriteComma(
-            writeComma);
-
-        _file << value;
     }
 
     _Use_decl_annotations_
@@ -153,23 +101,4 @@ namespace HoloLensForCV
         WriteFloat(value.y, writeComma);
         WriteFloat(value.z, writeComma);
     }
-
-    void CsvWriter::EndLine()
-    {
-        _file << std::endl;
-    }
-
-    _Use_decl_annotations_
-    void CsvWriter::WriteComma(
-        bool* writeComma)
-    {
-        if (*writeComma)
-        {
-            _file << ',';
-        }
-        else
-        {
-            *writeComma = true;
-        }
-    }
 }
@@ -13,13 +13,19 @@
 
 namespace HoloLensForCV
 {
+    //
+    // Extends the platform neutral Io::CsvWriter with wide strings and the
+    // Windows::Foundation::Numerics types.
+    //
     class CsvWriter
+        : public Io::CsvWriter
     {
     public:
         CsvWriter(
             _In_ const std::wstring& outputFileName);
 
-        ~CsvWriter();
+        using Io::CsvWriter::WriteHeader;
+        using Io::CsvWriter::WriteText;
 
         void WriteHeader(
             _In_ const std::vector<std::wstring>& columns);
@@ -28,22 +34,6 @@ namespace HoloLensForCV
             _In_ const std::wstring& text,
             _Inout_ bool* writeComma);
 
-        void WriteInt32(
-            _In_ const int32_t value,
-            _Inout_ bool* writeComma);
-
-        void WriteUInt64(
-            _In_ const uint64_t value,
-            _Inout_ bool* writeComma);
-
-        void WriteFloat(
-            _In_ const float value,
-            _Inout_ bool* writeComma);
-
-        void WriteDouble(
-            _In_ const double value,
-            _Inout_ bool* writeComma);
-
         void WriteFloat4x4(
             _In_ const Windows::Foundation::Numerics::float4x4& value,
             _Inout_ bool* writeComma);
@@ -58,14 +48,5 @@ namespace HoloLensForCV
         void WriteFloat3XYZ(
             _In_ const Windows::Foundation::Numerics::float3& value,
             _Inout_ bool* writeComma);
-
-        void EndLine();
-
-    protected:
-        void WriteComma(
-            _Inout_ bool* shouldWrite);
-
-    protected:
-        std::wofstream _file;
     };
 }
@@ -285,11 +285,19 @@ namespace HoloLensForCV
                 imageWidth = imageWidth * 4;
             }
 
+            if ((nullptr == _sensorStreamingCameraIntrinsics) ||
+                (_sensorStreamingCameraIntrinsics->ImageWidth != imageWidth) ||
+                (_sensorStreamingCameraIntrinsics->ImageHeight != softwareBitmap->PixelHeight))
+            {
+                _sensorStreamingCameraIntrinsics =
+                    ref new CameraIntrinsics(
+                        sensorStreamingCameraIntrinsics,
+                        imageWidth,
+                        softwareBitmap->PixelHeight);
+            }
+
             sensorFrame->SensorStreamingCameraIntrinsics =
-                ref new CameraIntrinsics(
-                    sensorStreamingCameraIntrinsics,
-                    imageWidth,
-                    softwareBitmap->PixelHeight);
+                _sensorStreamingCameraIntrinsics;
         }
         else
         {
@@ -41,6 +41,12 @@ namespace HoloLensForCV
 
         Io::TimeConverter _timeConverter;
 
+        //
+        // Passed with every frame of the same size, so that its unprojection table is
+        // only built once.
+        //
+        CameraIntrinsics^ _sensorStreamingCameraIntrinsics;
+
         std::mutex _latestSensorFrameMutex;
         SensorFrame^ _latestSensorFrame;
     };
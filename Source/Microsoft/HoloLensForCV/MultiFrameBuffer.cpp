@@ -13,13 +13,25 @@
 
 namespace HoloLensForCV
 {
-    static double TimeDeltaAMinusB(
-        Windows::Foundation::DateTime a,
-        Windows::Foundation::DateTime b)
+    MultiFrameBuffer::MultiFrameBuffer()
+        : _frames(
+            static_cast<size_t>(SensorType::NumberOfSensorTypes),
+            DefaultFramesPerSensor)
     {
-        auto timeDiff100ns = a.UniversalTime - b.UniversalTime;
+    }
+
+    MultiFrameBuffer::MultiFrameBuffer(
+        _In_ uint32_t framesPerSensor)
+        : _frames(
+            static_cast<size_t>(SensorType::NumberOfSensorTypes),
+            framesPerSensor)
+    {
+    }
 
-        return timeDiff100ns * 1e-7;
+    uint32_t MultiFrameBuffer::FramesPerSensor::get()
+    {
+        return static_cast<uint32_t>(
+            _frames.GetCapacity());
     }
 
     ISensorFrameSink^ MultiFrameBuffer::GetSensorFrameSink(
@@ -31,31 +43,22 @@ namespace HoloLensForCV
     void MultiFrameBuffer::Send(
         SensorFrame^ sensorFrame)
     {
-        std::lock_guard<std::mutex> lock(_framesMutex);
-        
-        auto& buffer = _frames[sensorFrame->FrameType];
-        
-        buffer.push_back(sensorFrame);
-        
-        while (buffer.size() > 5)
-        {
-            buffer.pop_front();
-        }
+        _frames.Push(
+            (int32_t)sensorFrame->FrameType,
+            sensorFrame->Timestamp.UniversalTime,
+            sensorFrame);
     }
 
     SensorFrame^ MultiFrameBuffer::GetLatestFrame(
         SensorType sensor)
     {
-        std::lock_guard<std::mutex> lock(_framesMutex);
-
-        auto& buffer = _frames[sensor];
+        SensorFrame^ frame = nullptr;
 
-        if (buffer.empty())
-        {
-            return nullptr;
-        }
+        _frames.GetLatestFrame(
+            (int32_t)sensor,
+            frame);
 
-        return buffer.back();
+        return frame;
     }
 
     SensorFrame^ MultiFrameBuffer::GetFrameForTime(
@@ -63,25 +66,15 @@ namespace HoloLensForCV
         Windows::Foundation::DateTime Timestamp,
         float toleranceInSeconds)
     {
-        std::lock_guard<std::mutex> lock(_framesMutex);
+        SensorFrame^ frame = nullptr;
 
-        auto& buffer = _frames[sensor];
+        _frames.GetFrameForTime(
+            (int32_t)sensor,
+            Timestamp.UniversalTime,
+            toleranceInSeconds,
+            frame);
 
-        for (auto& f : buffer)
-        {
-            const double secondsDifference =
-                std::abs(
-                    TimeDeltaAMinusB(
-                        Timestamp,
-                        f->Timestamp));
-
-            if (secondsDifference < toleranceInSeconds)
-            {
-                return f;
-            }
-        }
-
-        return nullptr;
+        return frame;
     }
 
     Windows::Foundation::DateTime MultiFrameBuffer::GetTimestampForSensorPair(
@@ -89,39 +82,34 @@ namespace HoloLensForCV
         SensorType b,
         float toleranceInSeconds)
     {
-        std::vector<Windows::Foundation::DateTime> vta;
-        std::vector<Windows::Foundation::DateTime> vtb;
+        Windows::Foundation::DateTime best;
 
-        {
-            std::lock_guard<std::mutex> lock(_framesMutex);
+        best.UniversalTime = _frames.GetTimestampForSensorPair(
+            (int32_t)a,
+            (int32_t)b,
+            toleranceInSeconds);
 
-            for (auto& f : _frames[a])
-            {
-                vta.push_back(f->Timestamp);
-            }
+        return best;
+    }
 
-            for (auto& f : _frames[b])
-            {
-                vtb.push_back(f->Timestamp);
-            }
+    Windows::Foundation::DateTime MultiFrameBuffer::GetTimestampForSensorSet(
+        Windows::Foundation::Collections::IVectorView<SensorType>^ sensors,
+        float toleranceInSeconds)
+    {
+        std::vector<int32_t> sensorIndices;
+
+        for (SensorType sensor : sensors)
+        {
+            sensorIndices.push_back(
+                (int32_t)sensor);
         }
 
         Windows::Foundation::DateTime best;
-        best.UniversalTime = 0;
 
-        for (auto ta : vta)
-        {
-            for (auto tb : vtb)
-            {
-                if (std::abs(TimeDeltaAMinusB(ta, tb)) < toleranceInSeconds)
-                {
-                    if (TimeDeltaAMinusB(ta, best) > 0)
-                    {
-                        best = ta;
-                    }
-                }
-            }
-        }
+        best.UniversalTime = _frames.GetTimestampForSensorSet(
+            sensorIndices.data(),
+            sensorIndices.size(),
+            toleranceInSeconds);
 
         return best;
     }
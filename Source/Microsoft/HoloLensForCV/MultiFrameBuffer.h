@@ -13,11 +13,26 @@
 
 namespace HoloLensForCV
 {
+    //
+    // Keeps the most recent frames of every sensor. Each sensor has its own ring, so
+    // sensors do not block each other, and readers are lock-free, so they never block
+    // the sensors.
+    //
     public ref class MultiFrameBuffer sealed
         : public ISensorFrameSink
         , public ISensorFrameSinkGroup
     {
     public:
+        MultiFrameBuffer();
+
+        MultiFrameBuffer(
+            _In_ uint32_t framesPerSensor);
+
+        property uint32_t FramesPerSensor
+        {
+            uint32_t get();
+        }
+
         virtual void Send(
             SensorFrame^ sensorFrame);
 
@@ -27,6 +42,10 @@ namespace HoloLensForCV
         SensorFrame^ GetLatestFrame(
             SensorType sensor);
 
+        //
+        // Returns the frame closest in time to the timestamp, or null if there is no
+        // frame within the tolerance.
+        //
         SensorFrame^ GetFrameForTime(
             SensorType sensor,
             Windows::Foundation::DateTime Timestamp,
@@ -37,8 +56,18 @@ namespace HoloLensForCV
             SensorType b,
             float toleranceInSeconds);
 
+        //
+        // Returns the latest timestamp of the first sensor for which every other sensor,
+        // such as depth, reflectivity and photo video, has a frame within the tolerance.
+        // The frames are then picked up with GetFrameForTime.
+        //
+        Windows::Foundation::DateTime GetTimestampForSensorSet(
+            Windows::Foundation::Collections::IVectorView<SensorType>^ sensors,
+            float toleranceInSeconds);
+
     private:
-        std::map<SensorType, std::deque<SensorFrame^>> _frames;
-        std::mutex _framesMutex;
+        static const uint32_t DefaultFramesPerSensor = 5;
+
+        Io::FrameBuffer<SensorFrame^> _frames;
     };
 }
@@ -0,0 +1,304 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    namespace
+    {
+        Windows::Foundation::Numerics::float4x4 ToFloat4x4(
+            _In_ const float (&m)[16])
+        {
+            return Windows::Foundation::Numerics::float4x4(
+                m[0], m[1], m[2], m[3],
+                m[4], m[5], m[6], m[7],
+                m[8], m[9], m[10], m[11],
+                m[12], m[13], m[14], m[15]);
+        }
+
+        //
+        // Turns the played back frames of a sensor into sensor frames.
+        //
+        class SensorFrameSinkAdapter
+            : public Io::RecordedFrameSink
+        {
+        public:
+            SensorFrameSinkAdapter(
+                _In_ SensorType sensorType,
+                _In_ ISensorFrameSink^ sensorFrameSink)
+                : _sensorType(sensorType)
+                , _sensorFrameSink(sensorFrameSink)
+            {
+            }
+
+            virtual void Send(
+                _In_ const Io::PlaybackFrame& frame) override
+            {
+                //
+                // The visible light cameras were recorded as gray images four times as
+                // wide as their Bgra8 frames, which is also how they are streamed. The
+                // photo video camera was recorded as RGB.
+                //
+                Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat;
+
+                switch (frame.Format)
+                {
+                case Io::FrameFileFormat::Gray16:
+                    pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray16;
+                    break;
+
+                case Io::FrameFileFormat::Gray8:
+                    pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray8;
+                    break;
+
+                case Io::FrameFileFormat::Rgb8:
+                    pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8;
+                    break;
+
+                default:
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"SensorFrameSinkAdapter::Send: unexpected frame format %i",
+                        (int32_t)frame.Format);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    return;
+                }
+
+                Windows::Graphics::Imaging::SoftwareBitmap^ softwareBitmap =
+                    ref new Windows::Graphics::Imaging::SoftwareBitmap(
+                        pixelFormat,
+                        frame.Width,
+                        frame.Height,
+                        Windows::Graphics::Imaging::BitmapAlphaMode::Ignore);
+
+                {
+                    Windows::Graphics::Imaging::BitmapBuffer^ bitmapBuffer =
+                        softwareBitmap->LockBuffer(
+                            Windows::Graphics::Imaging::BitmapBufferAccessMode::Write);
+
+                    const Windows::Graphics::Imaging::BitmapPlaneDescription plane =
+                        bitmapBuffer->GetPlaneDescription(0);
+
+                    Windows::Foundation::IMemoryBufferReference^ reference =
+                        bitmapBuffer->CreateReference();
+
+                    uint32_t pixelBufferDataLength = 0;
+                    uint8_t* pixelBufferData =
+                        Io::GetTypedPointerToMemoryBuffer<uint8_t>(
+                            reference,
+                            pixelBufferDataLength);
+
+                    for (uint32_t y = 0; y < frame.Height; ++y)
+                    {
+                        const uint8_t* source = frame.Pixels + y * frame.RowStride;
+                        uint8_t* destination = pixelBufferData + plane.StartIndex + y * plane.Stride;
+
+                        if (Io::FrameFileFormat::Rgb8 == frame.Format)
+                        {
+                            for (uint32_t x = 0; x < frame.Width; ++x)
+                            {
+                                destination[x * 4 + 0] = source[x * 3 + 2];
+                                destination[x * 4 + 1] = source[x * 3 + 1];
+                                destination[x * 4 + 2] = source[x * 3 + 0];
+                                destination[x * 4 + 3] = 0xff;
+                            }
+                        }
+                        else
+                        {
+                            memcpy(
+                                destination,
+                                source,
+                                frame.Width * frame.PixelStride);
+                        }
+                    }
+
+                    delete reference;
+                    delete bitmapBuffer;
+                }
+
+                Windows::Foundation::DateTime timestamp;
+
+                timestamp.UniversalTime =
+                    frame.Timestamp;
+
+                SensorFrame^ sensorFrame =
+                    ref new SensorFrame(
+                        _sensorType,
+                        timestamp,
+                        softwareBitmap);
+
+                if (nullptr != frame.Metadata)
+                {
+                    sensorFrame->FrameToOrigin =
+                        ToFloat4x4(frame.Metadata->FrameToOrigin);
+
+                    sensorFrame->CameraViewTransform =
+                        ToFloat4x4(frame.Metadata->CameraViewTransform);
+
+                    sensorFrame->CameraProjectionTransform =
+                        ToFloat4x4(frame.Metadata->CameraProjectionTransform);
+                }
+
+                _sensorFrameSink->Send(
+                    sensorFrame);
+            }
+
+        private:
+            SensorType _sensorType;
+            ISensorFrameSink^ _sensorFrameSink;
+        };
+
+        //
+        // Looks up the sink of each recorded sensor in a sensor frame sink group.
+        //
+        class SensorFrameSinkGroupAdapter
+            : public Io::RecordedFrameSinkGroup
+        {
+        public:
+            SensorFrameSinkGroupAdapter(
+                _In_ ISensorFrameSinkGroup^ sensorFrameSinkGroup)
+                : _sensorFrameSinkGroup(sensorFrameSinkGroup)
+            {
+            }
+
+            virtual Io::RecordedFrameSink* GetRecordedFrameSink(
+                _In_ const std::string& sensorName) override
+            {
+                for (int32_t sensorTypeAsIndex = 0; sensorTypeAsIndex < (int32_t)SensorType::NumberOfSensorTypes; ++sensorTypeAsIndex)
+                {
+                    const SensorType sensorType =
+                        (SensorType)sensorTypeAsIndex;
+
+                    if (sensorName != Utf16ToUtf8(SensorFrameRecorder::GetSensorName(sensorType)))
+                    {
+                        continue;
+                    }
+
+                    ISensorFrameSink^ sensorFrameSink =
+                        _sensorFrameSinkGroup->GetSensorFrameSink(
+                            sensorType);
+
+                    if (nullptr == sensorFrameSink)
+                    {
+                        return nullptr;
+                    }
+
+                    _sinks.emplace_back(
+                        new SensorFrameSinkAdapter(
+                            sensorType,
+                            sensorFrameSink));
+
+                    return _sinks.back().get();
+                }
+
+                return nullptr;
+            }
+
+        private:
+            ISensorFrameSinkGroup^ _sensorFrameSinkGroup;
+
+            std::vector<std::unique_ptr<SensorFrameSinkAdapter>> _sinks;
+        };
+    }
+
+    SensorFramePlayer::SensorFramePlayer(
+        _In_ Platform::String^ recordingFolderPath)
+    {
+        std::vector<std::string> sensorNames;
+
+        for (int32_t sensorTypeAsIndex = 0; sensorTypeAsIndex < (int32_t)SensorType::NumberOfSensorTypes; ++sensorTypeAsIndex)
+        {
+            sensorNames.push_back(
+                Utf16ToUtf8(
+                    SensorFrameRecorder::GetSensorName(
+                        (SensorType)sensorTypeAsIndex)));
+        }
+
+        _player.reset(
+            new Io::RecordingPlayer(
+                Utf16ToUtf8(recordingFolderPath->Data()),
+                sensorNames));
+
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+        dbg::trace(
+            L"SensorFramePlayer::SensorFramePlayer: %zu frames of %zu sensors in %s",
+            _player->GetFrameCount(),
+            _player->GetSensorCount(),
+            recordingFolderPath->Data());
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+    }
+
+    SensorFramePlayer::~SensorFramePlayer()
+    {
+        Stop();
+    }
+
+    Windows::Foundation::DateTime SensorFramePlayer::StartTime::get()
+    {
+        Windows::Foundation::DateTime timestamp;
+
+        timestamp.UniversalTime =
+            _player->GetStartTimestamp();
+
+        return timestamp;
+    }
+
+    Windows::Foundation::DateTime SensorFramePlayer::EndTime::get()
+    {
+        Windows::Foundation::DateTime timestamp;
+
+        timestamp.UniversalTime =
+            _player->GetEndTimestamp();
+
+        return timestamp;
+    }
+
+    void SensorFramePlayer::Seek(
+        _In_ Windows::Foundation::DateTime timestamp)
+    {
+        _player->Seek(
+            timestamp.UniversalTime);
+    }
+
+    bool SensorFramePlayer::Step(
+        _In_ ISensorFrameSinkGroup^ sensorFrameSinkGroup)
+    {
+        SensorFrameSinkGroupAdapter sinkGroup(
+            sensorFrameSinkGroup);
+
+        return _player->Step(
+            sinkGroup);
+    }
+
+    Windows::Foundation::IAsyncAction^ SensorFramePlayer::PlayAsync(
+        _In_ ISensorFrameSinkGroup^ sensorFrameSinkGroup,
+        _In_ SensorFramePlaybackMode mode,
+        _In_ double speed)
+    {
+        return concurrency::create_async(
+            [this, sensorFrameSinkGroup, mode, speed]()
+        {
+            SensorFrameSinkGroupAdapter sinkGroup(
+                sensorFrameSinkGroup);
+
+            _player->Play(
+                sinkGroup,
+                SensorFramePlaybackMode::RealTime == mode ? Io::PlaybackMode::RealTime : Io::PlaybackMode::AsFastAsPossible,
+                speed);
+        });
+    }
+
+    void SensorFramePlayer::Stop()
+    {
+        _player->Stop();
+    }
+}
@@ -0,0 +1,81 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace HoloLensForCV
+{
+    public enum class SensorFramePlaybackMode
+    {
+        //
+        // Keeps the recorded time between frames, scaled by the playback speed.
+        //
+        RealTime,
+
+        //
+        // Hands each frame on as soon as the sink returned from the one before.
+        //
+        AsFastAsPossible
+    };
+
+    //
+    // Plays back a recording made with the sensor frame recorder into any sensor frame
+    // sink group, such as the streamer, so that a recording can stand in for the device.
+    // The frames of all sensors are handed on in timestamp order, with their transforms.
+    //
+    // The recorded tarballs are memory mapped and read through their sidecar index, see
+    // Io::RecordingPlayer; each frame is copied once, into the software bitmap of its
+    // sensor frame.
+    //
+    // PlayAsync and Step must not be called while a playback started with PlayAsync is
+    // running. Stop ends it.
+    //
+    public ref class SensorFramePlayer sealed
+    {
+    public:
+        SensorFramePlayer(
+            _In_ Platform::String^ recordingFolderPath);
+
+        property Windows::Foundation::DateTime StartTime
+        {
+            Windows::Foundation::DateTime get();
+        }
+
+        property Windows::Foundation::DateTime EndTime
+        {
+            Windows::Foundation::DateTime get();
+        }
+
+        //
+        // Continues playback at the first frame recorded at or after the timestamp.
+        //
+        void Seek(
+            _In_ Windows::Foundation::DateTime timestamp);
+
+        //
+        // Hands the next frame to its sink. Returns false at the end of the recording.
+        //
+        bool Step(
+            _In_ ISensorFrameSinkGroup^ sensorFrameSinkGroup);
+
+        Windows::Foundation::IAsyncAction^ PlayAsync(
+            _In_ ISensorFrameSinkGroup^ sensorFrameSinkGroup,
+            _In_ SensorFramePlaybackMode mode,
+            _In_ double speed);
+
+        void Stop();
+
+    private:
+        ~SensorFramePlayer();
+
+    private:
+        std::unique_ptr<Io::RecordingPlayer> _player;
+    };
+}
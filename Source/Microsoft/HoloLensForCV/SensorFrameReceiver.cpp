@@ -61,7 +61,8 @@ namespace HoloLensForCV
 
             if (SensorFrameStreamHeader::ProtocolCookie != header->Cookie ||
                 SensorFrameStreamHeader::ProtocolVersionMajor != header->VersionMajor ||
-                SensorFrameStreamHeader::ProtocolVersionMinor != header->VersionMinor)
+                SensorFrameStreamHeader::ProtocolVersionMinorUncompressed > header->VersionMinor ||
+                SensorFrameStreamHeader::ProtocolVersionMinor < header->VersionMinor)
             {
 #if DBG_ENABLE_ERROR_LOGGING
                 dbg::trace(
@@ -86,6 +87,42 @@ namespace HoloLensForCV
                 header->Timestamp);
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
+            if (!header->HasCodecExtension)
+            {
+                return concurrency::task_from_result(header);
+            }
+
+            return ReceiveSensorFrameStreamHeaderCodecExtensionAsync(
+                header);
+        });
+    }
+
+    Concurrency::task<SensorFrameStreamHeader^> SensorFrameReceiver::ReceiveSensorFrameStreamHeaderCodecExtensionAsync(
+        SensorFrameStreamHeader^ header)
+    {
+        return concurrency::create_task(
+            _reader->LoadAsync(
+                SensorFrameStreamHeader::ProtocolCodecExtensionLength)
+        ).then([this, header](concurrency::task<unsigned int> extensionBytesLoadedTaskResult)
+        {
+            const size_t extensionBytesLoaded = extensionBytesLoadedTaskResult.get();
+
+            if (SensorFrameStreamHeader::ProtocolCodecExtensionLength != extensionBytesLoaded)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameReceiver::ReceiveAsync: expected SensorFrameStreamHeader codec extension of %i bytes, got %i bytes",
+                    SensorFrameStreamHeader::ProtocolCodecExtensionLength,
+                    extensionBytesLoaded);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            SensorFrameStreamHeader::ReadCodecExtension(
+                _reader,
+                header);
+
             return header;
         });
     }
@@ -93,10 +130,30 @@ namespace HoloLensForCV
     Concurrency::task<SensorFrame^> SensorFrameReceiver::ReceiveSensorFrameAsync(
         SensorFrameStreamHeader^ header)
     {
+        if (!Io::IsValidImageLayout(header->ToNative()))
+        {
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"SensorFrameReceiver::ReceiveAsync: rejecting a %ix%i image with pixel stride %i and row stride %i",
+                header->ImageWidth,
+                header->ImageHeight,
+                header->PixelStride,
+                header->RowStride);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        const uint32_t imageSize =
+            header->ImageHeight * header->RowStride;
+
+        const uint32_t payloadSize =
+            header->HasCodecExtension ? header->PayloadLength : imageSize;
+
         return concurrency::create_task(
             _reader->LoadAsync(
-                header->ImageHeight * header->RowStride)).
-            then([this, header](concurrency::task<unsigned int> frameBytesLoadedTaskResult)
+                payloadSize)).
+            then([this, header, imageSize, payloadSize](concurrency::task<unsigned int> frameBytesLoadedTaskResult)
         {
             //
             // Make sure that we have received exactly the number of bytes we have
@@ -105,12 +162,12 @@ namespace HoloLensForCV
             //
             const size_t frameBytesLoaded = frameBytesLoadedTaskResult.get();
 
-            if (header->ImageHeight * header->RowStride != frameBytesLoaded)
+            if (payloadSize != frameBytesLoaded)
             {
 #if DBG_ENABLE_ERROR_LOGGING
                 dbg::trace(
                     L"SensorFrameReceiver::ReceiveAsync: expected image frame data of %i bytes, got %i bytes",
-                    header->ImageHeight * header->RowStride,
+                    payloadSize,
                     frameBytesLoaded);
 #endif /* DBG_ENABLE_ERROR_LOGGING */
 
@@ -121,6 +178,12 @@ namespace HoloLensForCV
                 _reader->ReadBuffer(
                     static_cast<uint32_t>(frameBytesLoaded));
 
+            frameAsBuffer =
+                DecodeImage(
+                    header,
+                    frameAsBuffer,
+                    imageSize);
+
             Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat;
             uint32_t packedImageWidthMultiplier = 1;
 
@@ -186,6 +249,48 @@ namespace HoloLensForCV
         });
     }
 
+    Windows::Storage::Streams::IBuffer^ SensorFrameReceiver::DecodeImage(
+        SensorFrameStreamHeader^ header,
+        Windows::Storage::Streams::IBuffer^ payload,
+        uint32_t imageSize)
+    {
+        Windows::Storage::Streams::IBuffer^ image =
+            payload;
+
+        if (SensorFrameCodec::None != header->Codec)
+        {
+            Windows::Storage::Streams::Buffer^ decodedImage =
+                ref new Windows::Storage::Streams::Buffer(
+                    imageSize);
+
+            decodedImage->Length = imageSize;
+
+            image = decodedImage;
+        }
+
+        //
+        // Uncompressed images also go through the decoder, which keeps the keyframes of
+        // a delta stream for the delta frames that follow.
+        //
+        if (!_decoder.Decode(
+                header->ToNative(),
+                Io::GetTypedPointerToIBuffer<uint8_t>(payload),
+                payload->Length,
+                Io::GetTypedPointerToIBuffer<uint8_t>(image)))
+        {
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"SensorFrameReceiver::ReceiveAsync: cannot decode the image with codec %i at timestamp %llu",
+                header->Codec,
+                header->Timestamp);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        return image;
+    }
+
     Windows::Foundation::IAsyncOperation<SensorFrame^>^ SensorFrameReceiver::ReceiveAsync()
     {
         return concurrency::create_async(
@@ -31,11 +31,28 @@ namespace HoloLensForCV
     private:
         Concurrency::task<SensorFrameStreamHeader^> ReceiveSensorFrameStreamHeaderAsync();
 
+        Concurrency::task<SensorFrameStreamHeader^> ReceiveSensorFrameStreamHeaderCodecExtensionAsync(
+            SensorFrameStreamHeader^ header);
+
         Concurrency::task<SensorFrame^> ReceiveSensorFrameAsync(
             SensorFrameStreamHeader^ header);
 
+        //
+        // Returns the decoded image. Uncompressed images are returned as they are.
+        //
+        Windows::Storage::Streams::IBuffer^ DecodeImage(
+            SensorFrameStreamHeader^ header,
+            Windows::Storage::Streams::IBuffer^ payload,
+            uint32_t imageSize);
+
     private:
         Windows::Networking::Sockets::StreamSocket^ _streamSocket;
         Windows::Storage::Streams::DataReader^ _reader;
+
+        //
+        // Keeps the previous image, which delta frames are applied to. Frames are
+        // received one at a time, so it needs no lock.
+        //
+        Io::FrameDeltaDecoder _decoder;
     };
 }
@@ -48,12 +48,17 @@ namespace HoloLensForCV
         virtual ISensorFrameSink^ GetSensorFrameSink(
             _In_ SensorType sensorType);
 
+    internal:
+        //
+        // The name of the sensor's tarball and CSV file, and of the folder in the
+        // tarball its images are stored in.
+        //
+        static const wchar_t* GetSensorName(
+            SensorType sensorType);
+
     private:
         ~SensorFrameRecorder();
 
-        const wchar_t* GetSensorName(
-            SensorType sensorType);
-
         void ReportRecorderVersioningInformation(
             _Inout_ std::vector<std::wstring>& sourceFiles);
 
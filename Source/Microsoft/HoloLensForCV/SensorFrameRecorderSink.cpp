@@ -13,11 +13,53 @@
 
 namespace HoloLensForCV
 {
+	namespace
+	{
+		// Frames that can wait for the writer thread. Queued frames hold on to their
+		// sensor buffers, so the queue only absorbs short stalls, such as a slow write.
+		const size_t RecorderQueueCapacity = 15;
+
+		void CopyFloat4x4(
+			_In_ const Windows::Foundation::Numerics::float4x4& value,
+			_Out_ float (&values)[16])
+		{
+			memcpy(values, &value.m11, sizeof(values));
+		}
+	}
+
 	SensorFrameRecorderSink::SensorFrameRecorderSink(
 		_In_ SensorType sensorType,
 		_In_ Platform::String^ sensorName)
-		: _sensorType(sensorType), _sensorName(sensorName)
+		: _sensorType(sensorType), _sensorName(sensorName), _keyframeInterval(0)
+		, _writerQueue(RecorderQueueCapacity)
+	{
+	}
+
+	uint64_t SensorFrameRecorderSink::RecordedFrameCount::get()
+	{
+		return _writerQueue.GetWrittenCount();
+	}
+
+	uint64_t SensorFrameRecorderSink::DroppedFrameCount::get()
 	{
+		return _writerQueue.GetDroppedCount();
+	}
+
+	uint32_t SensorFrameRecorderSink::QueueHighWaterMark::get()
+	{
+		return static_cast<uint32_t>(_writerQueue.GetHighWaterMark());
+	}
+
+	uint32_t SensorFrameRecorderSink::KeyframeInterval::get()
+	{
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+		return _keyframeInterval;
+	}
+
+	void SensorFrameRecorderSink::KeyframeInterval::set(uint32_t value)
+	{
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+		_keyframeInterval = value;
 	}
 
 	SensorFrameRecorderSink::~SensorFrameRecorderSink()
@@ -45,52 +87,69 @@ namespace HoloLensForCV
 				_sensorName->Data());
 			_bitmapTarball.reset(new Io::Tarball(fileName));
 		}
-		
 
-		// Create the csv file for the frame information.
+		// Create the index of the tarball, for random access to the frames.
 
 		{
 			wchar_t fileName[MAX_PATH] = {};
 			swprintf_s(
 				fileName,
-				L"%s\\%s.csv",
+				L"%s\\%s.idx",
 				_archiveSourceFolder->Path->Data(),
 				_sensorName->Data());
-			_csvWriter.reset(new CsvWriter(fileName));
+			_frameIndexWriter.reset(new Io::FrameIndexWriter(fileName));
 		}
+		
 
-		// Write header information to csv file.
+		// Create the pose log for the frame transforms.
 
 		{
-			std::vector<std::wstring> columns;
-
-			columns.push_back(L"Timestamp");
-			columns.push_back(L"ImageFileName");
+			wchar_t fileName[MAX_PATH] = {};
+			swprintf_s(
+				fileName,
+				L"%s\\%s.pose",
+				_archiveSourceFolder->Path->Data(),
+				_sensorName->Data());
+			_poseLogWriter.reset(new Io::PoseLogWriter(fileName));
+		}
 
-			columns.push_back(L"FrameToOrigin.m11"); columns.push_back(L"FrameToOrigin.m12"); columns.push_back(L"FrameToOrigin.m13"); columns.push_back(L"FrameToOrigin.m14");
-			columns.push_back(L"FrameToOrigin.m21"); columns.push_back(L"FrameToOrigin.m22"); columns.push_back(L"FrameToOrigin.m23"); columns.push_back(L"FrameToOrigin.m24");
-			columns.push_back(L"FrameToOrigin.m31"); columns.push_back(L"FrameToOrigin.m32"); columns.push_back(L"FrameToOrigin.m33"); columns.push_back(L"FrameToOrigin.m34");
-			columns.push_back(L"FrameToOrigin.m41"); columns.push_back(L"FrameToOrigin.m42"); columns.push_back(L"FrameToOrigin.m43"); columns.push_back(L"FrameToOrigin.m44");
+		// Frames between keyframes are recorded as deltas.
 
-			columns.push_back(L"CameraViewTransform.m11"); columns.push_back(L"CameraViewTransform.m12"); columns.push_back(L"CameraViewTransform.m13"); columns.push_back(L"CameraViewTransform.m14");
-			columns.push_back(L"CameraViewTransform.m21"); columns.push_back(L"CameraViewTransform.m22"); columns.push_back(L"CameraViewTransform.m23"); columns.push_back(L"CameraViewTransform.m24");
-			columns.push_back(L"CameraViewTransform.m31"); columns.push_back(L"CameraViewTransform.m32"); columns.push_back(L"CameraViewTransform.m33"); columns.push_back(L"CameraViewTransform.m34");
-			columns.push_back(L"CameraViewTransform.m41"); columns.push_back(L"CameraViewTransform.m42"); columns.push_back(L"CameraViewTransform.m43"); columns.push_back(L"CameraViewTransform.m44");
+		if (_keyframeInterval > 1)
+		{
+			_deltaEncoder.reset(new Io::FrameDeltaEncoder(_keyframeInterval));
+		}
 
-			columns.push_back(L"CameraProjectionTransform.m11"); columns.push_back(L"CameraProjectionTransform.m12"); columns.push_back(L"CameraProjectionTransform.m13"); columns.push_back(L"CameraProjectionTransform.m14");
-			columns.push_back(L"CameraProjectionTransform.m21"); columns.push_back(L"CameraProjectionTransform.m22"); columns.push_back(L"CameraProjectionTransform.m23"); columns.push_back(L"CameraProjectionTransform.m24");
-			columns.push_back(L"CameraProjectionTransform.m31"); columns.push_back(L"CameraProjectionTransform.m32"); columns.push_back(L"CameraProjectionTransform.m33"); columns.push_back(L"CameraProjectionTransform.m34");
-			columns.push_back(L"CameraProjectionTransform.m41"); columns.push_back(L"CameraProjectionTransform.m42"); columns.push_back(L"CameraProjectionTransform.m43"); columns.push_back(L"CameraProjectionTransform.m44");
+		// Start the writer thread, with fresh statistics.
 
-			_csvWriter->WriteHeader(columns);
-		}
+		_writerQueue.Start(
+			[this](SensorFrame^ sensorFrame)
+			{
+				return TryWriteFrame(sensorFrame);
+			});
 	}
 
 	void SensorFrameRecorderSink::Stop()
 	{
 		std::lock_guard<std::mutex> guard(_sinkMutex);
+
+		// Let the writer thread write the frames still queued, then wait for it.
+		if (_writerQueue.Stop())
+		{
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+			dbg::trace(
+				L"SensorFrameRecorderSink::Stop: %s: %llu frames recorded, %llu dropped, at most %i frames queued",
+				_sensorName->Data(),
+				RecordedFrameCount,
+				DroppedFrameCount,
+				QueueHighWaterMark);
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+		}
+
 		_bitmapTarball.reset();
-		_csvWriter.reset();
+		_frameIndexWriter.reset();
+		_poseLogWriter.reset();
+		_deltaEncoder.reset();
 		_archiveSourceFolder = nullptr;
 	}
 
@@ -107,42 +166,88 @@ namespace HoloLensForCV
 	void SensorFrameRecorderSink::ReportArchiveSourceFiles(
 		_Inout_ std::vector<std::wstring>& sourceFiles)
 	{
-		wchar_t csvFileName[MAX_PATH] = {};
+		wchar_t poseLogFileName[MAX_PATH] = {};
 
 		swprintf_s(
-			csvFileName,
-			L"%s.csv",
+			poseLogFileName,
+			L"%s.pose",
 			_sensorName->Data());
 
-		sourceFiles.push_back(csvFileName);
+		sourceFiles.push_back(poseLogFileName);
 	}
 
 	void SensorFrameRecorderSink::Send(
 		SensorFrame^ sensorFrame)
 	{
-		dbg::TimerGuard timerGuard(
-			L"SensorFrameRecorderSink::Send: synchrounous I/O",
-			20.0 /* minimum_time_elapsed_in_milliseconds */);
+		// Only queue the frame; the writer thread does the I/O.
+		{
+			std::lock_guard<std::mutex> sendGuard(_sendMutex);
 
-		std::lock_guard<std::mutex> lockGuard(_sinkMutex);
+			if (!_writerQueue.IsWriting())
+			{
+				return;
+			}
 
-		if (nullptr == _archiveSourceFolder)
-		{
-			return;
+			// Store a reference to the camera intrinsics.
+			if (nullptr == _cameraIntrinsics)
+			{
+				_cameraIntrinsics = sensorFrame->SensorStreamingCameraIntrinsics;
+			}
+
+			// Avoid duplicate sensor frame recordings.
+			if (_prevFrameTimestamp.Equals(sensorFrame->Timestamp)) {
+				return;
+			}
+
+			_prevFrameTimestamp = sensorFrame->Timestamp;
 		}
 
-		// Store a reference to the camera intrinsics.
-		if (nullptr == _cameraIntrinsics)
+		if (!_writerQueue.Push(sensorFrame))
 		{
-			_cameraIntrinsics = sensorFrame->SensorStreamingCameraIntrinsics;
+#if DBG_ENABLE_VERBOSE_LOGGING
+			dbg::trace(
+				L"SensorFrameRecorderSink::Send: frame dropped -- the writer thread is stopped or %i frames behind",
+				static_cast<int32_t>(RecorderQueueCapacity));
+#endif /* DBG_ENABLE_VERBOSE_LOGGING */
 		}
+	}
+
+	bool SensorFrameRecorderSink::TryWriteFrame(
+		SensorFrame^ sensorFrame)
+	{
+		// An exception would end the thread and the recording with it.
+		try
+		{
+			WriteFrame(sensorFrame);
 
-		// Avoid duplicate sensor frame recordings.
-		if (_prevFrameTimestamp.Equals(sensorFrame->Timestamp)) {
-			return;
+			return true;
+		}
+		catch (const std::exception& exception)
+		{
+#if DBG_ENABLE_ERROR_LOGGING
+			dbg::trace(
+				L"SensorFrameRecorderSink::TryWriteFrame: cannot write a frame: %S",
+				exception.what());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+		}
+		catch (Platform::Exception^ exception)
+		{
+#if DBG_ENABLE_ERROR_LOGGING
+			dbg::trace(
+				L"SensorFrameRecorderSink::TryWriteFrame: cannot write a frame: %s",
+				exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
 		}
 
-		_prevFrameTimestamp = sensorFrame->Timestamp;
+		return false;
+	}
+
+	void SensorFrameRecorderSink::WriteFrame(
+		SensorFrame^ sensorFrame)
+	{
+		dbg::TimerGuard timerGuard(
+			L"SensorFrameRecorderSink::WriteFrame: writer thread I/O",
+			20.0 /* minimum_time_elapsed_in_milliseconds */);
 
 		//
 		// Write the sensor frame as a bitmap to the archive.
@@ -150,7 +255,7 @@ namespace HoloLensForCV
 
 #if DBG_ENABLE_VERBOSE_LOGGING
 		dbg::trace(
-			L"SensorFrameRecorderSink::Send: saving sensor frame to %s",
+			L"SensorFrameRecorderSink::WriteFrame: saving sensor frame to %s",
 			bitmapPath);
 #endif /* DBG_ENABLE_VERBOSE_LOGGING */
 
@@ -197,7 +302,7 @@ namespace HoloLensForCV
 			// Unsupported by PGM format. Need to update save logic
 #if DBG_ENABLE_INFORMATIONAL_LOGGING
 			dbg::trace(
-				L"SensorFrameRecorderSink::Send: unsupported bitmap pixel format for PGM");
+				L"SensorFrameRecorderSink::WriteFrame: unsupported bitmap pixel format for PGM");
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
 			ASSERT(false);
@@ -218,14 +323,6 @@ namespace HoloLensForCV
             bitmapFileExtension = L"pgm";
         }
 
-        // Compose the output file name.
-        wchar_t bitmapPath[MAX_PATH];
-        swprintf_s(
-            bitmapPath, L"%s\\%020llu.%s",
-            _sensorName->Data(),
-            sensorFrame->Timestamp.UniversalTime,
-            bitmapFileExtension.c_str());
-
 		// Compose PGM header string.
 		std::stringstream header;
 		header << bitmapFormat << "\n"
@@ -246,8 +343,9 @@ namespace HoloLensForCV
 				bitmapBuffer->CreateReference(),
 				pixelBufferDataLength);
 
-        // Convert the software bitmap to raw bytes.
-        std::vector<uint8_t> bitmapData;
+        // Convert the software bitmap to raw bytes, reusing the previous frame's buffer.
+        std::vector<uint8_t>& bitmapData = _bitmapData;
+        bitmapData.clear();
         if (_sensorType == SensorType::PhotoVideo)
         {
             const uint32_t numPixels = softwareBitmap->PixelWidth * softwareBitmap->PixelHeight;
@@ -284,32 +382,88 @@ namespace HoloLensForCV
                 pixelBufferData, pixelBufferData + pixelBufferDataLength);
         }
 
-		// Add the bitmap to the tarball.
-		_bitmapTarball->AddFile(bitmapPath, bitmapData.data(), bitmapData.size());
+		// Between keyframes, record the difference to the previous frame instead.
+		if (nullptr != _deltaEncoder)
+		{
+			Io::FrameStreamHeader deltaHeader;
+
+			deltaHeader.FrameType = static_cast<uint16_t>(_sensorType);
+			deltaHeader.Timestamp = sensorFrame->Timestamp.UniversalTime;
+			deltaHeader.ImageWidth = _sensorType == SensorType::PhotoVideo ? softwareBitmap->PixelWidth : actualBitmapWidth;
+			deltaHeader.ImageHeight = softwareBitmap->PixelHeight;
+			deltaHeader.PixelStride = _sensorType == SensorType::PhotoVideo ? 3 : (maxBitmapValue > 255 ? 2 : 1);
+			deltaHeader.RowStride = deltaHeader.ImageWidth * deltaHeader.PixelStride;
+
+			if (_deltaEncoder->Encode(
+					deltaHeader,
+					bitmapData.data() + headerString.size(),
+					_deltaImage))
+			{
+				Io::SetFrameCodec(
+					deltaHeader,
+					Io::FrameCodec::Delta,
+					static_cast<uint32_t>(_deltaImage.size()));
 
-		//
-		// Record the sensor frame meta data to the csv file.
-		//
+				const size_t deltaHeaderLength =
+					Io::GetEncodedLength(deltaHeader);
+
+				bitmapData.resize(deltaHeaderLength);
+
+				Io::EncodeFrameStreamHeader(
+					deltaHeader,
+					bitmapData.data());
 
-		bool writeComma = false;
+				bitmapData.insert(
+					bitmapData.end(),
+					_deltaImage.begin(), _deltaImage.end());
 
-		_csvWriter->WriteUInt64(
-			sensorFrame->Timestamp.UniversalTime, &writeComma);
+				bitmapFileExtension = L"delta";
+			}
+		}
 
+		// Compose the output file name.
+		wchar_t bitmapPath[MAX_PATH];
+		swprintf_s(
+			bitmapPath, L"%s\\%020llu.%s",
+			_sensorName->Data(),
+			sensorFrame->Timestamp.UniversalTime,
+			bitmapFileExtension.c_str());
+
+		// Add the bitmap to the tarball, and its location to the index.
+		Io::FrameIndexEntry indexEntry;
+
+		indexEntry.Timestamp = sensorFrame->Timestamp.UniversalTime;
+		indexEntry.Offset = _bitmapTarball->AddFile(bitmapPath, bitmapData.data(), bitmapData.size());
+		indexEntry.Size = static_cast<uint32_t>(bitmapData.size());
+
+		if (bitmapFileExtension == L"delta")
 		{
-			_csvWriter->WriteText(
-				bitmapPath, &writeComma);
+			indexEntry.Format = Io::FrameFileFormat::Delta;
 		}
+		else if (_sensorType == SensorType::PhotoVideo)
+		{
+			indexEntry.Format = Io::FrameFileFormat::Rgb8;
+		}
+		else
+		{
+			indexEntry.Format = maxBitmapValue > 255 ? Io::FrameFileFormat::Gray16 : Io::FrameFileFormat::Gray8;
+		}
+
+		_frameIndexWriter->Add(indexEntry);
+
+		//
+		// Record the sensor frame transforms to the pose log.
+		//
 
-		_csvWriter->WriteFloat4x4(
-			sensorFrame->FrameToOrigin, &writeComma);
+		Io::PoseLogRecord poseLogRecord;
 
-		_csvWriter->WriteFloat4x4(
-			sensorFrame->CameraViewTransform, &writeComma);
+		poseLogRecord.Timestamp = indexEntry.Timestamp;
+		poseLogRecord.Offset = indexEntry.Offset;
 
-		_csvWriter->WriteFloat4x4(
-			sensorFrame->CameraProjectionTransform, &writeComma);
+		CopyFloat4x4(sensorFrame->FrameToOrigin, poseLogRecord.Metadata.FrameToOrigin);
+		CopyFloat4x4(sensorFrame->CameraViewTransform, poseLogRecord.Metadata.CameraViewTransform);
+		CopyFloat4x4(sensorFrame->CameraProjectionTransform, poseLogRecord.Metadata.CameraProjectionTransform);
 
-		_csvWriter->EndLine();
+		_poseLogWriter->Add(poseLogRecord);
 	}
 }
@@ -17,8 +17,20 @@ namespace HoloLensForCV
 {
 	//
 	// Saves sensor images originated on device to disk and collects sensor frame
-	// metadata that will be used to create the per-sensor recording manifest CSV
-	// file.
+	// metadata in the per-sensor ".pose" file, a binary log of the timestamp, tarball
+	// offset and transforms of every frame, see Io::PoseLog. Tools/PoseLogToCsv turns
+	// it into the CSV file earlier recordings have.
+	//
+	// Send only queues the frame. A writer thread, started by Start, writes the queued
+	// frames in batches; Stop waits until it has written them all. Frames arriving
+	// while the queue is full are dropped and counted, see Io::FrameWriterQueue.
+	//
+	// With a KeyframeInterval above 1, only every KeyframeInterval-th frame is saved
+	// as an image. The frames in between are saved as ".delta" files holding the
+	// difference to the previous frame, see Io::RecordedFrameReader.
+	//
+	// Next to each tarball, a ".idx" file indexes the timestamp, offset, size and
+	// format of every frame, see Io::FrameIndex and Io::IndexedFrameReader.
 	//
 	public ref class SensorFrameRecorderSink sealed
 		: public ISensorFrameSink
@@ -34,6 +46,32 @@ namespace HoloLensForCV
 
 		virtual void Send(_In_ SensorFrame^ sensorFrame);
 
+		// Frames from one keyframe to the next; 0 or 1 saves every frame as an image.
+		// Takes effect on the next call to Start.
+		property uint32_t KeyframeInterval
+		{
+			uint32_t get();
+			void set(uint32_t value);
+		}
+
+		// Statistics of the current or last recording.
+		property uint64_t RecordedFrameCount
+		{
+			uint64_t get();
+		}
+
+		// Frames dropped because the writer thread fell too far behind.
+		property uint64_t DroppedFrameCount
+		{
+			uint64_t get();
+		}
+
+		// The most frames that waited for the writer thread at once.
+		property uint32_t QueueHighWaterMark
+		{
+			uint32_t get();
+		}
+
 	internal:
 		Platform::String^ GetSensorName();
 
@@ -45,6 +83,11 @@ namespace HoloLensForCV
 	private:
 		~SensorFrameRecorderSink();
 
+		// Writes a frame on the writer thread. Returns false if it could not be written.
+		bool TryWriteFrame(_In_ SensorFrame^ sensorFrame);
+
+		void WriteFrame(_In_ SensorFrame^ sensorFrame);
+
 		Platform::String^ _sensorName;
 
 		SensorType _sensorType;
@@ -54,7 +97,19 @@ namespace HoloLensForCV
 		Windows::Storage::StorageFolder^ _archiveSourceFolder;
 
 		std::unique_ptr<Io::Tarball> _bitmapTarball;
-		std::unique_ptr<CsvWriter> _csvWriter;
+		std::unique_ptr<Io::FrameIndexWriter> _frameIndexWriter;
+		std::unique_ptr<Io::PoseLogWriter> _poseLogWriter;
+
+		uint32_t _keyframeInterval;
+		std::unique_ptr<Io::FrameDeltaEncoder> _deltaEncoder;
+		std::vector<uint8_t> _deltaImage;
+		std::vector<uint8_t> _bitmapData;
+
+		// Hands the frames from Send to the writer thread.
+		Io::FrameWriterQueue<SensorFrame^> _writerQueue;
+
+		// Guards the camera intrinsics and the duplicate frame check of Send.
+		std::mutex _sendMutex;
 
 		CameraIntrinsics^ _cameraIntrinsics;
 
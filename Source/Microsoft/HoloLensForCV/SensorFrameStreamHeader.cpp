@@ -17,47 +17,122 @@ namespace HoloLensForCV
     {
         Cookie = ProtocolCookie;
         VersionMajor = ProtocolVersionMajor;
-        VersionMinor = ProtocolVersionMinor;
+        VersionMinor = ProtocolVersionMinorUncompressed;
         FrameType = SensorType::Undefined;
         Timestamp = 0;
         ImageWidth = 0;
         ImageHeight = 0;
         PixelStride = 0;
         RowStride = 0;
+        Codec = SensorFrameCodec::None;
+        Flags = 0;
+        PayloadLength = 0;
     }
 
     /* static */ void SensorFrameStreamHeader::Read(
         _Inout_ Windows::Storage::Streams::DataReader^ dataReader,
         _Out_ SensorFrameStreamHeader^* headerReference)
     {
-        SensorFrameStreamHeader^ header =
-            ref new SensorFrameStreamHeader();
+        std::array<uint8_t, Io::FrameStreamHeader::EncodedLength> buffer;
+
+        dataReader->ReadBytes(
+            Platform::ArrayReference<uint8_t>(
+                buffer.data(),
+                static_cast<unsigned int>(buffer.size())));
+
+        Io::FrameStreamHeader nativeHeader;
+
+        ASSERT(Io::DecodeFrameStreamHeader(
+            buffer.data(),
+            buffer.size(),
+            nativeHeader));
+
+        *headerReference = FromNative(
+            nativeHeader);
+    }
 
-        header->Cookie = dataReader->ReadUInt32();
-        header->VersionMajor = dataReader->ReadByte();
-        header->VersionMinor = dataReader->ReadByte();
-        header->FrameType = (SensorType)dataReader->ReadUInt16();
-        header->Timestamp = dataReader->ReadUInt64();
-        header->ImageWidth = dataReader->ReadUInt32();
-        header->ImageHeight = dataReader->ReadUInt32();
-        header->PixelStride = dataReader->ReadUInt32();
-        header->RowStride = dataReader->ReadUInt32();
-
-        *headerReference = header;
+    /* static */ void SensorFrameStreamHeader::ReadCodecExtension(
+        _Inout_ Windows::Storage::Streams::DataReader^ dataReader,
+        _Inout_ SensorFrameStreamHeader^ header)
+    {
+        std::array<uint8_t, Io::FrameStreamHeader::CodecExtensionLength> buffer;
+
+        dataReader->ReadBytes(
+            Platform::ArrayReference<uint8_t>(
+                buffer.data(),
+                static_cast<unsigned int>(buffer.size())));
+
+        Io::FrameStreamHeader nativeHeader =
+            header->ToNative();
+
+        ASSERT(Io::DecodeFrameStreamHeaderCodecExtension(
+            buffer.data(),
+            buffer.size(),
+            nativeHeader));
+
+        header->Codec = (SensorFrameCodec)nativeHeader.Codec;
+        header->Flags = nativeHeader.Flags;
+        header->PayloadLength = nativeHeader.PayloadLength;
     }
 
     /* static */ void SensorFrameStreamHeader::Write(
         _In_ SensorFrameStreamHeader^ header,
         _Inout_ Windows::Storage::Streams::DataWriter^ dataWriter)
     {
-        dataWriter->WriteUInt32(header->Cookie);
-        dataWriter->WriteByte(header->VersionMajor);
-        dataWriter->WriteByte(header->VersionMinor);
-        dataWriter->WriteUInt16((uint16_t)header->FrameType);
-        dataWriter->WriteUInt64(header->Timestamp);
-        dataWriter->WriteUInt32(header->ImageWidth);
-        dataWriter->WriteUInt32(header->ImageHeight);
-        dataWriter->WriteUInt32(header->PixelStride);
-        dataWriter->WriteUInt32(header->RowStride);
+        std::array<uint8_t, Io::FrameStreamHeader::MaxEncodedLength> buffer;
+
+        const Io::FrameStreamHeader nativeHeader =
+            header->ToNative();
+
+        Io::EncodeFrameStreamHeader(
+            nativeHeader,
+            buffer.data());
+
+        dataWriter->WriteBytes(
+            Platform::ArrayReference<uint8_t>(
+                buffer.data(),
+                static_cast<unsigned int>(Io::GetEncodedLength(nativeHeader))));
+    }
+
+    /* static */ SensorFrameStreamHeader^ SensorFrameStreamHeader::FromNative(
+        _In_ const Io::FrameStreamHeader& nativeHeader)
+    {
+        SensorFrameStreamHeader^ header =
+            ref new SensorFrameStreamHeader();
+
+        header->Cookie = nativeHeader.Cookie;
+        header->VersionMajor = nativeHeader.VersionMajor;
+        header->VersionMinor = nativeHeader.VersionMinor;
+        header->FrameType = (SensorType)nativeHeader.FrameType;
+        header->Timestamp = nativeHeader.Timestamp;
+        header->ImageWidth = nativeHeader.ImageWidth;
+        header->ImageHeight = nativeHeader.ImageHeight;
+        header->PixelStride = nativeHeader.PixelStride;
+        header->RowStride = nativeHeader.RowStride;
+        header->Codec = (SensorFrameCodec)nativeHeader.Codec;
+        header->Flags = nativeHeader.Flags;
+        header->PayloadLength = nativeHeader.PayloadLength;
+
+        return header;
+    }
+
+    Io::FrameStreamHeader SensorFrameStreamHeader::ToNative()
+    {
+        Io::FrameStreamHeader nativeHeader;
+
+        nativeHeader.Cookie = Cookie;
+        nativeHeader.VersionMajor = VersionMajor;
+        nativeHeader.VersionMinor = VersionMinor;
+        nativeHeader.FrameType = (uint16_t)FrameType;
+        nativeHeader.Timestamp = Timestamp;
+        nativeHeader.ImageWidth = ImageWidth;
+        nativeHeader.ImageHeight = ImageHeight;
+        nativeHeader.PixelStride = PixelStride;
+        nativeHeader.RowStride = RowStride;
+        nativeHeader.Codec = (Io::FrameCodec)Codec;
+        nativeHeader.Flags = Flags;
+        nativeHeader.PayloadLength = PayloadLength;
+
+        return nativeHeader;
     }
 }
@@ -14,7 +14,30 @@
 namespace HoloLensForCV
 {
     //
-    // Network header for sensor frame streaming.
+    // How the image that follows a sensor frame stream header is encoded.
+    //
+    public enum class SensorFrameCodec
+    {
+        None = 0,
+
+        //
+        // Lossless 16-bit depth compression.
+        //
+        Depth = 1,
+
+        //
+        // Difference to the previous frame of the stream.
+        //
+        Delta = 2
+    };
+
+    //
+    // Network header for sensor frame streaming. Adapts the platform neutral
+    // Io::FrameStreamHeader, which implements the wire format.
+    //
+    // Headers of compressed frames are ProtocolCodecExtensionLength bytes longer: read
+    // the first ProtocolHeaderLength bytes with Read and, if HasCodecExtension is true,
+    // the rest with ReadCodecExtension.
     //
     public ref class SensorFrameStreamHeader sealed
     {
@@ -23,30 +46,40 @@ namespace HoloLensForCV
 
         static property uint32_t ProtocolHeaderLength
         {
-            uint32_t get()
-            {
-                return
-                    sizeof(uint32_t) /* Cookie */ +
-                    2 * sizeof(uint8_t) /* VersionMajor, VersionMinor */ +
-                    sizeof(uint16_t) /* FrameType */ +
-                    sizeof(uint64_t) /* Timestamp */ +
-                    4 * sizeof(uint32_t) /* ImageWidth, ImageHeight, PixelStride, RowStride */;
-            }
+            uint32_t get() { return static_cast<uint32_t>(Io::FrameStreamHeader::EncodedLength); }
         }
 
         static property uint32_t ProtocolCookie
         {
-            uint32_t get() { return 0x484c524d; }
+            uint32_t get() { return Io::FrameStreamHeader::ProtocolCookie; }
         }
 
         static property uint8_t ProtocolVersionMajor
         {
-            uint8_t get() { return 0x00; }
+            uint8_t get() { return Io::FrameStreamHeader::ProtocolVersionMajor; }
+        }
+
+        static property uint32_t ProtocolCodecExtensionLength
+        {
+            uint32_t get() { return static_cast<uint32_t>(Io::FrameStreamHeader::CodecExtensionLength); }
         }
 
         static property uint8_t ProtocolVersionMinor
         {
-            uint8_t get() { return 0x01; }
+            uint8_t get() { return Io::FrameStreamHeader::ProtocolVersionMinor; }
+        }
+
+        static property uint8_t ProtocolVersionMinorUncompressed
+        {
+            uint8_t get() { return Io::FrameStreamHeader::ProtocolVersionMinorUncompressed; }
+        }
+
+        //
+        // Flag of a keyframe that delta frames follow.
+        //
+        static property uint16_t DeltaKeyframeFlag
+        {
+            uint16_t get() { return Io::FrameStreamHeader::DeltaKeyframeFlag; }
         }
 
         property uint32_t Cookie;
@@ -58,13 +91,31 @@ namespace HoloLensForCV
         property uint32_t ImageHeight;
         property uint32_t PixelStride;
         property uint32_t RowStride;
+        property SensorFrameCodec Codec;
+        property uint16_t Flags;
+        property uint32_t PayloadLength;
+
+        property bool HasCodecExtension
+        {
+            bool get() { return VersionMinor > ProtocolVersionMinorUncompressed; }
+        }
 
         static void Read(
             _Inout_ Windows::Storage::Streams::DataReader^ dataReader,
             _Out_ SensorFrameStreamHeader^* header);
 
+        static void ReadCodecExtension(
+            _Inout_ Windows::Storage::Streams::DataReader^ dataReader,
+            _Inout_ SensorFrameStreamHeader^ header);
+
         static void Write(
             _In_ SensorFrameStreamHeader^ header,
             _Inout_ Windows::Storage::Streams::DataWriter^ dataWriter);
+
+    internal:
+        static SensorFrameStreamHeader^ FromNative(
+            _In_ const Io::FrameStreamHeader& nativeHeader);
+
+        Io::FrameStreamHeader ToNative();
     };
 }
@@ -13,9 +13,81 @@
 
 namespace HoloLensForCV
 {
+    SensorFrameStreamingServer::Client::Client(
+        _In_ Windows::Networking::Sockets::StreamSocket^ socket,
+        _In_ const Io::FrameSendPolicy& policy,
+        _In_ uint32_t keyframeInterval)
+        : Socket(socket)
+        , Queue(policy)
+        , WriteInProgress(false)
+        , IsConnected(true)
+    {
+        if (keyframeInterval > 1)
+        {
+            DeltaEncoder.reset(
+                new Io::FrameDeltaEncoder(
+                    keyframeInterval));
+        }
+
+        Writer = ref new Windows::Storage::Streams::DataWriter(
+            Socket->OutputStream);
+
+        Writer->UnicodeEncoding =
+            Windows::Storage::Streams::UnicodeEncoding::Utf8;
+
+        Writer->ByteOrder =
+            Windows::Storage::Streams::ByteOrder::LittleEndian;
+    }
+
+    SensorFrameStreamingServer::SensorFrameStreamingServer(
+        _In_ Platform::String^ serviceName)
+        : _compressDepthFrames(false)
+        , _keyframeInterval(0)
+    {
+        Listen(
+            serviceName);
+    }
+
     SensorFrameStreamingServer::SensorFrameStreamingServer(
+        _In_ Platform::String^ serviceName,
+        _In_ StreamingDropPolicy dropPolicy,
+        _In_ uint32_t keepEveryNth,
+        _In_ uint32_t maxQueuedFrames)
+        : _policy(
+            static_cast<Io::FrameDropPolicy>(dropPolicy),
+            keepEveryNth,
+            maxQueuedFrames)
+        , _compressDepthFrames(false)
+        , _keyframeInterval(0)
+    {
+        Listen(
+            serviceName);
+    }
+
+    SensorFrameStreamingServer::~SensorFrameStreamingServer()
+    {
+        // The listener can be closed in two ways:
+        //  - explicit: by using delete operator (the listener is closed even if there are outstanding references to it).
+        //  - implicit: by removing last reference to it (i.e. falling out-of-scope).
+        // In this case this is the last reference to the listener so both will yield the same result.
+        delete _listener;
+        _listener = nullptr;
+
+        std::lock_guard<std::mutex> guard(_clientsMutex);
+
+        for (const auto& client : _clients)
+        {
+            std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+            Disconnect(
+                *client);
+        }
+
+        _clients.clear();
+    }
+
+    void SensorFrameStreamingServer::Listen(
         _In_ Platform::String^ serviceName)
-        : _writeInProgress(false)
     {
         _listener = ref new Windows::Networking::Sockets::StreamSocketListener();
 
@@ -48,57 +120,212 @@ namespace HoloLensForCV
         });
     }
 
-    SensorFrameStreamingServer::~SensorFrameStreamingServer()
-    {
-        // The listener can be closed in two ways:
-        //  - explicit: by using delete operator (the listener is closed even if there are outstanding references to it).
-        //  - implicit: by removing last reference to it (i.e. falling out-of-scope).
-        // In this case this is the last reference to the listener so both will yield the same result.
-        delete _listener;
-        _listener = nullptr;
-    }
-
     void SensorFrameStreamingServer::OnConnection(
         Windows::Networking::Sockets::StreamSocketListener^ listener,
         Windows::Networking::Sockets::StreamSocketListenerConnectionReceivedEventArgs^ object)
     {
-        _socket = object->Socket;
+        std::shared_ptr<Client> client =
+            std::make_shared<Client>(
+                object->Socket,
+                _policy,
+                _keyframeInterval);
 
-        _writeInProgress = false;
+        std::lock_guard<std::mutex> guard(_clientsMutex);
 
-        _writer = ref new Windows::Storage::Streams::DataWriter(
-            _socket->OutputStream);
+        _clients.push_back(
+            client);
 
-        _writer->UnicodeEncoding =
-            Windows::Storage::Streams::UnicodeEncoding::Utf8;
-
-        _writer->ByteOrder =
-            Windows::Storage::Streams::ByteOrder::LittleEndian;
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+        dbg::trace(
+            L"SensorFrameStreamingServer::OnConnection: %i clients connected",
+            static_cast<int32_t>(_clients.size()));
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
     }
 
     void SensorFrameStreamingServer::Send(
         SensorFrame^ sensorFrame)
     {
-        if (nullptr == _socket)
+        std::vector<std::shared_ptr<Client>> clients;
+
+        {
+            std::lock_guard<std::mutex> guard(_clientsMutex);
+
+            //
+            // Forget the clients whose connection failed.
+            //
+            _clients.erase(
+                std::remove_if(
+                    _clients.begin(),
+                    _clients.end(),
+                    [](const std::shared_ptr<Client>& client)
+                    {
+                        std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+                        return !client->IsConnected;
+                    }),
+                _clients.end());
+
+            clients = _clients;
+        }
+
+        if (clients.empty())
         {
 #if DBG_ENABLE_VERBOSE_LOGGING
             dbg::trace(
-                L"SensorFrameStreamingServer::Consume: image dropped -- no connection!");
+                L"SensorFrameStreamingServer::Send: image dropped -- no connection!");
 #endif /* DBG_ENABLE_VERBOSE_LOGGING */
 
             return;
         }
 
-        if (_writeInProgress)
+        QueuedFrame queuedFrame;
+
+        queuedFrame.Frame = sensorFrame;
+
+        //
+        // With delta frames, only keyframes are compressed, as they are written.
+        //
+        if (_compressDepthFrames && _keyframeInterval <= 1)
+        {
+            queuedFrame.EncodedImage =
+                EncodeDepthImage(
+                    sensorFrame);
+        }
+
+        for (const auto& client : clients)
         {
-#if DBG_ENABLE_INFORMATIONAL_LOGGING
+            bool startWriting = false;
+
+            {
+                std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+                if (!client->IsConnected)
+                {
+                    continue;
+                }
+
+                switch (client->Queue.Push(queuedFrame))
+                {
+                case Io::FrameQueueResult::Queued:
+                    startWriting = !client->WriteInProgress;
+                    client->WriteInProgress = true;
+                    break;
+
+                case Io::FrameQueueResult::Dropped:
+#if DBG_ENABLE_VERBOSE_LOGGING
+                    dbg::trace(
+                        L"SensorFrameStreamingServer::Send: image dropped -- the client is still receiving previous images!");
+#endif /* DBG_ENABLE_VERBOSE_LOGGING */
+                    break;
+
+                case Io::FrameQueueResult::Overflow:
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"SensorFrameStreamingServer::Send: lossless client fell %i images behind, disconnecting it",
+                        static_cast<int32_t>(client->Queue.GetPolicy().Capacity));
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    Disconnect(
+                        *client);
+                    break;
+                }
+            }
+
+            if (startWriting)
+            {
+                SendNext(
+                    client);
+            }
+        }
+    }
+
+    void SensorFrameStreamingServer::SendNext(
+        std::shared_ptr<Client> client)
+    {
+        QueuedFrame queuedFrame;
+
+        {
+            std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+            if (!client->IsConnected || !client->Queue.Pop(queuedFrame))
+            {
+                client->WriteInProgress = false;
+
+                return;
+            }
+        }
+
+        try
+        {
+            WriteImage(
+                *client,
+                queuedFrame);
+        }
+        catch (Platform::Exception^ exception)
+        {
+#if DBG_ENABLE_ERROR_LOGGING
             dbg::trace(
-                L"SensorFrameStreamingServer::Send: image dropped -- previous send operation is in progress!");
-#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+                L"SensorFrameStreamingServer::SendNext: writing the image failed with error: %s",
+                exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+            Disconnect(
+                *client);
 
             return;
         }
 
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+        dbg::TimerGuard timerGuard(
+            L"SensorFrameStreamingServer::SendNext: StoreAsync task creation",
+            10.0 /* minimum_time_elapsed_in_milliseconds */);
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+        //
+        // The continuation keeps the client alive, and writes the frames that were
+        // queued for it in the meantime.
+        //
+        Concurrency::create_task(client->Writer->StoreAsync()).then(
+            [this, client](Concurrency::task<unsigned int> writeTask)
+        {
+            try
+            {
+                // Try getting an exception.
+                writeTask.get();
+            }
+            catch (Platform::Exception^ exception)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameStreamingServer::SendNext: StoreAsync call failed with error: %s",
+                    exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+                Disconnect(
+                    *client);
+
+                return;
+            }
+
+            SendNext(
+                client);
+        });
+    }
+
+    void SensorFrameStreamingServer::WriteImage(
+        Client& client,
+        const QueuedFrame& queuedFrame)
+    {
+        SensorFrame^ sensorFrame =
+            queuedFrame.Frame;
+
+        std::shared_ptr<const std::vector<uint8_t>> encodedImage =
+            queuedFrame.EncodedImage;
+
         Windows::Graphics::Imaging::SoftwareBitmap^ bitmap;
         Windows::Graphics::Imaging::BitmapBuffer^ bitmapBuffer;
         Windows::Foundation::IMemoryBufferReference^ bitmapBufferReference;
@@ -108,13 +335,13 @@ namespace HoloLensForCV
         int32_t pixelStride = 1;
         int32_t rowStride = 0;
 
-        Platform::Array<uint8_t>^ imageBufferAsPlatformArray;
+        uint8_t* bitmapBufferData = nullptr;
         int32_t imageBufferSize = 0;
 
         {
 #if DBG_ENABLE_INFORMATIONAL_LOGGING
             dbg::TimerGuard timerGuard(
-                L"SensorFrameStreamingServer::Send: buffer preparation",
+                L"SensorFrameStreamingServer::WriteImage: buffer preparation",
                 4.0 /* minimum_time_elapsed_in_milliseconds */);
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
@@ -133,7 +360,7 @@ namespace HoloLensForCV
 
             uint32_t bitmapBufferDataSize = 0;
 
-            uint8_t* bitmapBufferData =
+            bitmapBufferData =
                 Io::GetTypedPointerToMemoryBuffer<uint8_t>(
                     bitmapBufferReference,
                     bitmapBufferDataSize);
@@ -155,7 +382,7 @@ namespace HoloLensForCV
             default:
 #if DBG_ENABLE_INFORMATIONAL_LOGGING
                 dbg::trace(
-                    L"SensorFrameStreamingServer::Send: unrecognized bitmap pixel format, assuming 1 byte per pixel");
+                    L"SensorFrameStreamingServer::WriteImage: unrecognized bitmap pixel format, assuming 1 byte per pixel");
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
                 break;
@@ -169,11 +396,6 @@ namespace HoloLensForCV
 
             ASSERT(
                 imageBufferSize == (int32_t)bitmapBufferDataSize);
-
-            imageBufferAsPlatformArray =
-                ref new Platform::Array<uint8_t>(
-                    bitmapBufferData,
-                    imageBufferSize);
         }
 
         SensorFrameStreamHeader^ header =
@@ -186,78 +408,157 @@ namespace HoloLensForCV
         header->PixelStride = pixelStride;
         header->RowStride = rowStride;
 
-        SendImage(
-            header,
-            imageBufferAsPlatformArray);
-    }
+        const uint8_t* payload = bitmapBufferData;
+        uint32_t payloadLength = static_cast<uint32_t>(imageBufferSize);
 
-    void SensorFrameStreamingServer::SendImage(
-        SensorFrameStreamHeader^ header,
-        const Platform::Array<uint8_t>^ data)
-    {
-        if (nullptr == _socket)
+        if (nullptr != client.DeltaEncoder &&
+            client.DeltaEncoder->Encode(
+                header->ToNative(),
+                bitmapBufferData,
+                client.DeltaImage))
         {
-#if DBG_ENABLE_VERBOSE_LOGGING
-            dbg::trace(
-                L"SensorFrameStreamingServer::SendImage: image dropped -- no connection!");
-#endif /* DBG_ENABLE_VERBOSE_LOGGING */
+            header->Codec = SensorFrameCodec::Delta;
 
-            return;
+            payload = client.DeltaImage.data();
+            payloadLength = static_cast<uint32_t>(client.DeltaImage.size());
         }
-
-        if (_writeInProgress)
+        else
         {
-#if DBG_ENABLE_INFORMATIONAL_LOGGING
-            dbg::trace(
-                L"SensorFrameStreamingServer::SendImage: image dropped -- previous StoreAsync task is still in progress!");
-#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+            //
+            // Keyframes of a delta stream were not compressed when they were queued.
+            //
+            if (nullptr == encodedImage && _compressDepthFrames)
+            {
+                encodedImage =
+                    EncodeDepthImage(
+                        sensorFrame);
+            }
 
-            return;
+            if (nullptr != encodedImage)
+            {
+                header->Codec = SensorFrameCodec::Depth;
+
+                payload = encodedImage->data();
+                payloadLength = static_cast<uint32_t>(encodedImage->size());
+            }
         }
 
-        _writeInProgress = true;
+        //
+        // The receiver keeps the keyframes of a delta stream for the delta frames that
+        // follow, and only those.
+        //
+        if (nullptr != client.DeltaEncoder && SensorFrameCodec::Delta != header->Codec)
+        {
+            header->Flags = SensorFrameStreamHeader::DeltaKeyframeFlag;
+        }
 
+        if (SensorFrameCodec::None != header->Codec || 0 != header->Flags)
         {
+            header->VersionMinor = SensorFrameStreamHeader::ProtocolVersionMinor;
+            header->PayloadLength = payloadLength;
+        }
+
+        //
+        // The bitmap buffer stays locked while the image is handed to the writer, which
+        // copies it, so the image does not need to be copied into an array first.
+        //
 #if DBG_ENABLE_INFORMATIONAL_LOGGING
-            dbg::TimerGuard timerGuard(
-                L"SensorFrameStreamingServer::SendImage: writer operations",
-                4.0 /* minimum_time_elapsed_in_milliseconds */);
+        dbg::TimerGuard timerGuard(
+            L"SensorFrameStreamingServer::WriteImage: writer operations",
+            4.0 /* minimum_time_elapsed_in_milliseconds */);
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
-            SensorFrameStreamHeader::Write(
-                header,
-                _writer);
+        SensorFrameStreamHeader::Write(
+            header,
+            client.Writer);
 
-            _writer->WriteBytes(
-                data);
+        client.Writer->WriteBytes(
+            Platform::ArrayReference<uint8_t>(
+                const_cast<uint8_t*>(payload),
+                payloadLength));
+    }
+
+    std::shared_ptr<const std::vector<uint8_t>> SensorFrameStreamingServer::EncodeDepthImage(
+        SensorFrame^ sensorFrame)
+    {
+        Windows::Graphics::Imaging::SoftwareBitmap^ bitmap =
+            sensorFrame->SoftwareBitmap;
+
+        if (bitmap->BitmapPixelFormat != Windows::Graphics::Imaging::BitmapPixelFormat::Gray16)
+        {
+            return nullptr;
         }
 
 #if DBG_ENABLE_INFORMATIONAL_LOGGING
         dbg::TimerGuard timerGuard(
-            L"SensorFrameStreamingServer::SendImage: StoreAsync task creation",
-            10.0 /* minimum_time_elapsed_in_milliseconds */);
+            L"SensorFrameStreamingServer::EncodeDepthImage: depth compression",
+            4.0 /* minimum_time_elapsed_in_milliseconds */);
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
-        Concurrency::create_task(_writer->StoreAsync()).then(
-            [&](Concurrency::task<unsigned int> writeTask)
+        const uint32_t imageWidth = static_cast<uint32_t>(bitmap->PixelWidth);
+        const uint32_t imageHeight = static_cast<uint32_t>(bitmap->PixelHeight);
+        const uint32_t rowStride = imageWidth * 2;
+
+        Windows::Graphics::Imaging::BitmapBuffer^ bitmapBuffer =
+            bitmap->LockBuffer(
+                Windows::Graphics::Imaging::BitmapBufferAccessMode::Read);
+
+        Windows::Foundation::IMemoryBufferReference^ bitmapBufferReference =
+            bitmapBuffer->CreateReference();
+
+        uint32_t bitmapBufferDataSize = 0;
+
+        const uint8_t* bitmapBufferData =
+            Io::GetTypedPointerToMemoryBuffer<uint8_t>(
+                bitmapBufferReference,
+                bitmapBufferDataSize);
+
+        ASSERT(
+            imageHeight * rowStride == bitmapBufferDataSize);
+
+        std::shared_ptr<std::vector<uint8_t>> encodedImage =
+            std::make_shared<std::vector<uint8_t>>(
+                Io::GetMaxEncodedDepthImageLength(
+                    imageWidth,
+                    imageHeight));
+
+        const size_t encodedImageLength =
+            Io::EncodeDepthImage(
+                bitmapBufferData,
+                imageWidth,
+                imageHeight,
+                rowStride,
+                encodedImage->data());
+
+        //
+        // Noisy images can come out larger than they went in; those are sent as they are.
+        //
+        if (encodedImageLength >= bitmapBufferDataSize)
         {
-            try
-            {
-                // Try getting an exception.
-                writeTask.get();
+            return nullptr;
+        }
 
-                _writeInProgress = false;
-            }
-            catch (Platform::Exception^ exception)
-            {
-#if DBG_ENABLE_ERROR_LOGGING
-                dbg::trace(
-                    L"SensorFrameStreamingServer::SendImage: StoreAsync call failed with error: %s",
-                    exception->Message->Data());
-#endif /* DBG_ENABLE_ERROR_LOGGING */
+        encodedImage->resize(
+            encodedImageLength);
 
-                _socket = nullptr;
-            }
-        });
+        return encodedImage;
+    }
+
+    void SensorFrameStreamingServer::Disconnect(
+        Client& client)
+    {
+        //
+        // Called with the client's mutex held. Closing the socket fails any pending
+        // StoreAsync call, whose continuation then finds the client disconnected.
+        //
+        if (client.IsConnected)
+        {
+            client.IsConnected = false;
+            client.Queue.Clear();
+
+            delete client.Socket;
+        }
+
+        client.WriteInProgress = false;
     }
 }
@@ -13,6 +13,40 @@
 
 namespace HoloLensForCV
 {
+    //
+    // What the streaming server does with frames a client cannot receive right away.
+    //
+    public enum class StreamingDropPolicy
+    {
+        //
+        // Only the newest frame waits to be sent; older frames are dropped.
+        //
+        LatestOnly,
+
+        //
+        // Only every Nth frame is sent; frames arriving with a full queue are dropped.
+        //
+        KeepEveryNth,
+
+        //
+        // Every frame is sent. A client that falls more than the queue length behind
+        // is disconnected.
+        //
+        Lossless
+    };
+
+    //
+    // Streams the frames of a sensor to every connected client. Each client has its own
+    // queue and drop policy, so a slow client does not cause frames to be dropped for
+    // the others. Queued frames are referenced, not copied, until they are written.
+    //
+    // With CompressDepthFrames set, 16-bit depth frames are compressed losslessly before
+    // they are queued, once for all clients, and sent with a version 0.2 header.
+    //
+    // With a KeyframeInterval above 1, frames between keyframes are sent as deltas to the
+    // previous frame. Each client has its own delta encoder, which sees the frames its
+    // drop policy lets through, and every new client starts with a keyframe.
+    //
     public ref class SensorFrameStreamingServer sealed
         : public ISensorFrameSink
     {
@@ -20,24 +54,99 @@ namespace HoloLensForCV
         SensorFrameStreamingServer(
             _In_ Platform::String^ serviceName);
 
+        SensorFrameStreamingServer(
+            _In_ Platform::String^ serviceName,
+            _In_ StreamingDropPolicy dropPolicy,
+            _In_ uint32_t keepEveryNth,
+            _In_ uint32_t maxQueuedFrames);
+
         virtual void Send(
             SensorFrame^ sensorFrame);
 
+        property bool CompressDepthFrames
+        {
+            bool get() { return _compressDepthFrames; }
+            void set(bool value) { _compressDepthFrames = value; }
+        }
+
+        //
+        // Frames from one keyframe to the next; 0 or 1 turns delta frames off. Applies to
+        // the clients that connect after it is set.
+        //
+        property uint32_t KeyframeInterval
+        {
+            uint32_t get() { return _keyframeInterval; }
+            void set(uint32_t value) { _keyframeInterval = value; }
+        }
+
     private:
+        //
+        // A queued frame, and its compressed image if it was compressed.
+        //
+        struct QueuedFrame
+        {
+            SensorFrame^ Frame;
+            std::shared_ptr<const std::vector<uint8_t>> EncodedImage;
+        };
+
+        struct Client
+        {
+            Client(
+                _In_ Windows::Networking::Sockets::StreamSocket^ socket,
+                _In_ const Io::FrameSendPolicy& policy,
+                _In_ uint32_t keyframeInterval);
+
+            Windows::Networking::Sockets::StreamSocket^ Socket;
+            Windows::Storage::Streams::DataWriter^ Writer;
+
+            std::mutex Mutex;
+            Io::FrameSendQueue<QueuedFrame> Queue;
+            bool WriteInProgress;
+            bool IsConnected;
+
+            //
+            // Only used while writing, which happens one frame at a time.
+            //
+            std::unique_ptr<Io::FrameDeltaEncoder> DeltaEncoder;
+            std::vector<uint8_t> DeltaImage;
+        };
+
         ~SensorFrameStreamingServer();
 
+        void Listen(
+            _In_ Platform::String^ serviceName);
+
         void OnConnection(
             Windows::Networking::Sockets::StreamSocketListener^ listener,
             Windows::Networking::Sockets::StreamSocketListenerConnectionReceivedEventArgs^ object);
 
-        void SendImage(
-            SensorFrameStreamHeader^ header,
-            const Platform::Array<uint8_t>^ data);
+        //
+        // Writes the next queued frame of the client, if it has one.
+        //
+        void SendNext(
+            std::shared_ptr<Client> client);
+
+        void WriteImage(
+            Client& client,
+            const QueuedFrame& queuedFrame);
+
+        //
+        // Compresses a 16-bit depth image. Returns null for other images, and for images
+        // that do not get smaller.
+        //
+        std::shared_ptr<const std::vector<uint8_t>> EncodeDepthImage(
+            SensorFrame^ sensorFrame);
+
+        void Disconnect(
+            Client& client);
 
     private:
         Windows::Networking::Sockets::StreamSocketListener^ _listener;
-        Windows::Networking::Sockets::StreamSocket^ _socket;
-        Windows::Storage::Streams::DataWriter^ _writer;
-        bool _writeInProgress;
+        Io::FrameSendPolicy _policy;
+        std::atomic<bool> _compressDepthFrames;
+        std::atomic<uint32_t> _keyframeInterval;
+
+        std::mutex _clientsMutex;
+        std::vector<std::shared_ptr<Client>> _clients;
     };
 }
@@ -24,6 +24,11 @@
 #include <stdexcept>
 #include <shared_mutex>
 #include <unordered_set>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 
 #include <agile.h>
 #include <collection.h>
@@ -63,6 +68,7 @@
 
 #include "SensorFrameRecorderSink.h"
 #include "SensorFrameRecorder.h"
+#include "SensorFramePlayer.h"
 
 #include "MediaFrameReaderContext.h"
 #include "MediaFrameSourceGroupType.h"
@@ -0,0 +1,69 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Helpers shared by the binary files and headers of a recording: the frame stream
+    // header, the frame index, the pose log and the camera unprojection table. All of
+    // them store their fields in little endian byte order, without padding.
+    //
+    namespace BinaryFormat
+    {
+        template <typename Ty>
+        inline void WriteLittleEndian(
+            _In_ const Ty value,
+            _Inout_ uint8_t*& cursor)
+        {
+            for (size_t i = 0; i < sizeof(Ty); ++i)
+            {
+                *cursor++ = static_cast<uint8_t>(
+                    static_cast<uint64_t>(value) >> (8 * i));
+            }
+        }
+
+        template <typename Ty>
+        inline Ty ReadLittleEndian(
+            _Inout_ const uint8_t*& cursor)
+        {
+            uint64_t value = 0;
+
+            for (size_t i = 0; i < sizeof(Ty); ++i)
+            {
+                value |= static_cast<uint64_t>(*cursor++) << (8 * i);
+            }
+
+            return static_cast<Ty>(value);
+        }
+
+        //
+        // Name of the sidecar file with the extension next to the tarball: the tarball
+        // name with its extension, if any, replaced.
+        //
+        inline std::string GetSidecarFileName(
+            _In_ const std::string& tarballFileName,
+            _In_ const char* extension)
+        {
+            const size_t extensionStart = tarballFileName.find_last_of('.');
+            const size_t separator = tarballFileName.find_last_of("\\/");
+
+            const size_t nameLength =
+                std::string::npos == extensionStart ||
+                (std::string::npos != separator && extensionStart < separator) ?
+                    tarballFileName.size() :
+                    extensionStart;
+
+            return tarballFileName.substr(0, nameLength) + "." + extension;
+        }
+    }
+}
@@ -0,0 +1,314 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+#include "BinaryFormat.h"
+
+namespace Io
+{
+    using namespace BinaryFormat;
+
+    namespace
+    {
+        //
+        // Bytes per pixel in the table file: the X and Y coordinates.
+        //
+        const size_t FileEntryLength = 2 * sizeof(float);
+
+        void WriteFloat(
+            _In_ const float value,
+            _Inout_ uint8_t*& cursor)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            WriteLittleEndian(bits, cursor);
+        }
+
+        float ReadFloat(
+            _Inout_ const uint8_t*& cursor)
+        {
+            const uint32_t bits = ReadLittleEndian<uint32_t>(cursor);
+
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+
+            return value;
+        }
+
+        //
+        // The file is column major, as the recorder always wrote it.
+        //
+        bool WriteTable(
+            _In_ const CameraUnprojectionTable& table,
+            _Inout_ std::ofstream& file)
+        {
+            const uint32_t imageWidth = table.GetImageWidth();
+            const uint32_t imageHeight = table.GetImageHeight();
+
+            std::vector<uint8_t> column(
+                imageHeight * FileEntryLength);
+
+            for (uint32_t x = 0; x < imageWidth; ++x)
+            {
+                uint8_t* cursor = column.data();
+
+                for (uint32_t y = 0; y < imageHeight; ++y)
+                {
+                    const size_t index = static_cast<size_t>(y) * imageWidth + x;
+
+                    WriteFloat(table.GetUnitPlaneX()[index], cursor);
+                    WriteFloat(table.GetUnitPlaneY()[index], cursor);
+                }
+
+                file.write(reinterpret_cast<const char*>(column.data()), column.size());
+            }
+
+            file.flush();
+
+            return !!file;
+        }
+    }
+
+    const char* const CameraUnprojectionTable::FileNameSuffix = "_camera_space_projection.bin";
+
+    CameraUnprojectionTable::CameraUnprojectionTable()
+        : _imageWidth(0)
+        , _imageHeight(0)
+    {
+    }
+
+    _Use_decl_annotations_
+    CameraUnprojectionTable::CameraUnprojectionTable(
+        uint32_t imageWidth,
+        uint32_t imageHeight)
+        : _imageWidth(imageWidth)
+        , _imageHeight(imageHeight)
+        , _unitPlaneX(static_cast<size_t>(imageWidth) * imageHeight, std::numeric_limits<float>::infinity())
+        , _unitPlaneY(static_cast<size_t>(imageWidth) * imageHeight, std::numeric_limits<float>::infinity())
+    {
+    }
+
+    _Use_decl_annotations_
+    std::string CameraUnprojectionTable::GetFileName(
+        const std::string& folderPath,
+        const std::string& sensorName)
+    {
+#if defined(_WIN32)
+        const char separator = '\\';
+#else
+        const char separator = '/';
+#endif /* defined(_WIN32) */
+
+        return folderPath + separator + sensorName + FileNameSuffix;
+    }
+
+    bool CameraUnprojectionTable::IsEmpty() const
+    {
+        return _unitPlaneX.empty();
+    }
+
+    uint32_t CameraUnprojectionTable::GetImageWidth() const
+    {
+        return _imageWidth;
+    }
+
+    uint32_t CameraUnprojectionTable::GetImageHeight() const
+    {
+        return _imageHeight;
+    }
+
+    _Use_decl_annotations_
+    void CameraUnprojectionTable::Set(
+        uint32_t x,
+        uint32_t y,
+        float unitPlaneX,
+        float unitPlaneY)
+    {
+        REQUIRES(x < _imageWidth && y < _imageHeight);
+
+        const size_t index = static_cast<size_t>(y) * _imageWidth + x;
+
+        _unitPlaneX[index] = unitPlaneX;
+        _unitPlaneY[index] = unitPlaneY;
+    }
+
+    _Use_decl_annotations_
+    bool CameraUnprojectionTable::MapImagePointToCameraUnitPlane(
+        float u,
+        float v,
+        float& unitPlaneX,
+        float& unitPlaneY) const
+    {
+        unitPlaneX = unitPlaneY = std::numeric_limits<float>::infinity();
+
+        //
+        // Written so that NaN coordinates are rejected too.
+        //
+        if (IsEmpty() ||
+            !(u >= 0.0f && u <= static_cast<float>(_imageWidth - 1)) ||
+            !(v >= 0.0f && v <= static_cast<float>(_imageHeight - 1)))
+        {
+            return false;
+        }
+
+        const uint32_t x0 = static_cast<uint32_t>(u);
+        const uint32_t y0 = static_cast<uint32_t>(v);
+
+        const float fractionX = u - static_cast<float>(x0);
+        const float fractionY = v - static_cast<float>(y0);
+
+        //
+        // On the last column or row, the fraction is 0 and the pixel is its own neighbour.
+        //
+        const size_t topLeft = static_cast<size_t>(y0) * _imageWidth + x0;
+        const size_t right = x0 + 1 < _imageWidth ? 1 : 0;
+        const size_t down = y0 + 1 < _imageHeight ? _imageWidth : 0;
+
+        const float weights[4] =
+        {
+            (1.0f - fractionX) * (1.0f - fractionY),
+            fractionX * (1.0f - fractionY),
+            (1.0f - fractionX) * fractionY,
+            fractionX * fractionY
+        };
+
+        const size_t indices[4] =
+        {
+            topLeft,
+            topLeft + right,
+            topLeft + down,
+            topLeft + down + right
+        };
+
+        float x = 0.0f;
+        float y = 0.0f;
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            //
+            // Unmapped neighbours are skipped only when they do not contribute, so that
+            // integer coordinates at the edge of the mapped area still map exactly.
+            //
+            if (0.0f == weights[i])
+            {
+                continue;
+            }
+
+            x += weights[i] * _unitPlaneX[indices[i]];
+            y += weights[i] * _unitPlaneY[indices[i]];
+        }
+
+        if (!std::isfinite(x) || !std::isfinite(y))
+        {
+            return false;
+        }
+
+        unitPlaneX = x;
+        unitPlaneY = y;
+
+        return true;
+    }
+
+    const float* CameraUnprojectionTable::GetUnitPlaneX() const
+    {
+        return _unitPlaneX.data();
+    }
+
+    const float* CameraUnprojectionTable::GetUnitPlaneY() const
+    {
+        return _unitPlaneY.data();
+    }
+
+    _Use_decl_annotations_
+    bool ReadCameraUnprojectionTable(
+        const std::string& fileName,
+        uint32_t imageWidth,
+        uint32_t imageHeight,
+        CameraUnprojectionTable& table)
+    {
+        table = CameraUnprojectionTable();
+
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+
+        if (!file || 0 == imageWidth || 0 == imageHeight)
+        {
+            return false;
+        }
+
+        const uint64_t expectedLength =
+            static_cast<uint64_t>(imageWidth) * imageHeight * FileEntryLength;
+
+        if (static_cast<uint64_t>(file.tellg()) != expectedLength)
+        {
+            dbg::trace(
+                L"ReadCameraUnprojectionTable: %S does not hold a table of %ux%u pixels",
+                fileName.c_str(),
+                imageWidth,
+                imageHeight);
+
+            return false;
+        }
+
+        file.seekg(0);
+
+        CameraUnprojectionTable fileTable(
+            imageWidth,
+            imageHeight);
+
+        std::vector<uint8_t> column(
+            imageHeight * FileEntryLength);
+
+        for (uint32_t x = 0; x < imageWidth; ++x)
+        {
+            if (!file.read(reinterpret_cast<char*>(column.data()), column.size()))
+            {
+                return false;
+            }
+
+            const uint8_t* cursor = column.data();
+
+            for (uint32_t y = 0; y < imageHeight; ++y)
+            {
+                const float unitPlaneX = ReadFloat(cursor);
+                const float unitPlaneY = ReadFloat(cursor);
+
+                fileTable.Set(x, y, unitPlaneX, unitPlaneY);
+            }
+        }
+
+        table = std::move(fileTable);
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    bool WriteCameraUnprojectionTable(
+        const std::string& fileName,
+        const CameraUnprojectionTable& table)
+    {
+        std::ofstream file(fileName, std::ios::binary);
+
+        return file && WriteTable(table, file);
+    }
+
+#if defined(_WIN32)
+    _Use_decl_annotations_
+    bool WriteCameraUnprojectionTable(
+        const std::wstring& fileName,
+        const CameraUnprojectionTable& table)
+    {
+        std::ofstream file(fileName, std::ios::binary);
+
+        return file && WriteTable(table, file);
+    }
+#endif /* defined(_WIN32) */
+}
@@ -0,0 +1,155 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Tokens shared by the depth and frame delta codecs. A token is a little endian base
+    // 128 number. Its lowest bit tells a residual (0) from a run of at least two zero
+    // residuals (1); the other bits hold the zigzag encoded residual, or the run length
+    // minus two.
+    //
+    namespace CodecTokens
+    {
+        const size_t MaxTokenLength = 5;
+
+        //
+        // A 16-bit residual token holds 17 bits, so it takes at most 3 bytes; an 8-bit
+        // residual token at most 2.
+        //
+        template <typename TSample>
+        inline size_t GetMaxResidualTokenLength()
+        {
+            return sizeof(TSample) == sizeof(uint16_t) ? 3 : 2;
+        }
+
+        template <typename TSample>
+        inline TSample ZigZagEncode(
+            _In_ const TSample difference)
+        {
+            typedef typename std::make_signed<TSample>::type SignedSample;
+
+            const SignedSample residual = static_cast<SignedSample>(difference);
+
+            return static_cast<TSample>(
+                (static_cast<TSample>(residual) << 1) ^
+                static_cast<TSample>(residual >> (8 * sizeof(TSample) - 1)));
+        }
+
+        template <typename TSample>
+        inline TSample ZigZagDecode(
+            _In_ const TSample value)
+        {
+            return static_cast<TSample>((value >> 1) ^ (0u - (value & 1u)));
+        }
+
+        inline void WriteToken(
+            _In_ uint32_t token,
+            _Inout_ uint8_t*& cursor)
+        {
+            while (token >= 0x80)
+            {
+                *cursor++ = static_cast<uint8_t>(token | 0x80);
+
+                token >>= 7;
+            }
+
+            *cursor++ = static_cast<uint8_t>(token);
+        }
+
+        inline bool ReadToken(
+            _Inout_ const uint8_t*& cursor,
+            _In_ const uint8_t* end,
+            _Out_ uint32_t& token)
+        {
+            token = 0;
+
+            for (size_t i = 0; i < MaxTokenLength && cursor < end; ++i)
+            {
+                const uint8_t byte = *cursor++;
+
+                token |= static_cast<uint32_t>(byte & 0x7f) << (7 * i);
+
+                if (0 == (byte & 0x80))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        inline void WriteZeroRun(
+            _Inout_ uint32_t& zeroRunLength,
+            _Inout_ uint8_t*& cursor)
+        {
+            if (1 == zeroRunLength)
+            {
+                WriteToken(0, cursor);
+            }
+            else if (zeroRunLength > 1)
+            {
+                WriteToken(((zeroRunLength - 2) << 1) | 1, cursor);
+            }
+
+            zeroRunLength = 0;
+        }
+
+        //
+        // Reads the zigzag encoded residual of the next sample, which is zero while a run
+        // of zero residuals lasts. Returns false if the tokens are corrupt.
+        //
+        template <typename TSample>
+        inline bool ReadResidual(
+            _Inout_ const uint8_t*& cursor,
+            _In_ const uint8_t* end,
+            _Inout_ uint32_t& zeroRunLength,
+            _Out_ TSample& residual)
+        {
+            residual = 0;
+
+            if (zeroRunLength > 0)
+            {
+                --zeroRunLength;
+
+                return true;
+            }
+
+            uint32_t token = 0;
+
+            if (!ReadToken(cursor, end, token))
+            {
+                return false;
+            }
+
+            if (0 != (token & 1))
+            {
+                //
+                // This sample is the first of the run.
+                //
+                zeroRunLength = (token >> 1) + 1;
+
+                return true;
+            }
+
+            if ((token >> 1) > std::numeric_limits<TSample>::max())
+            {
+                return false;
+            }
+
+            residual = static_cast<TSample>(token >> 1);
+
+            return true;
+        }
+    }
+}
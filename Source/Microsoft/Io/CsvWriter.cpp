@@ -0,0 +1,285 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+namespace Io
+{
+    namespace
+    {
+        //
+        // Longest number the Write methods format: a double with 17 significant
+        // digits, sign, decimal point and exponent.
+        //
+        const size_t MaxNumberLength = 32;
+
+#if defined(__cpp_lib_to_chars)
+        template <typename Ty>
+        size_t FormatNumber(
+            _In_ const Ty value,
+            _Out_writes_(MaxNumberLength) char* text)
+        {
+            return std::to_chars(text, text + MaxNumberLength, value).ptr - text;
+        }
+#else
+        //
+        // Without std::to_chars, integers are formatted by hand, and floats with the
+        // number of significant digits that always parses back to the same value.
+        //
+        size_t FormatNumber(
+            _In_ const uint64_t value,
+            _Out_writes_(MaxNumberLength) char* text)
+        {
+            char digits[20];
+            size_t digitCount = 0;
+            uint64_t remainder = value;
+
+            do
+            {
+                digits[digitCount++] = static_cast<char>('0' + remainder % 10);
+                remainder /= 10;
+            } while (0 != remainder);
+
+            for (size_t i = 0; i < digitCount; ++i)
+            {
+                text[i] = digits[digitCount - 1 - i];
+            }
+
+            return digitCount;
+        }
+
+        size_t FormatNumber(
+            _In_ const int32_t value,
+            _Out_writes_(MaxNumberLength) char* text)
+        {
+            if (value >= 0)
+            {
+                return FormatNumber(static_cast<uint64_t>(value), text);
+            }
+
+            text[0] = '-';
+
+            return 1 + FormatNumber(
+                static_cast<uint64_t>(-static_cast<int64_t>(value)),
+                text + 1);
+        }
+
+        size_t FormatNumber(
+            _In_ const float value,
+            _Out_writes_(MaxNumberLength) char* text)
+        {
+            return static_cast<size_t>(
+                snprintf(text, MaxNumberLength, "%.9g", value));
+        }
+
+        size_t FormatNumber(
+            _In_ const double value,
+            _Out_writes_(MaxNumberLength) char* text)
+        {
+            return static_cast<size_t>(
+                snprintf(text, MaxNumberLength, "%.17g", value));
+        }
+#endif /* defined(__cpp_lib_to_chars) */
+    }
+
+    const size_t CsvWriter::BufferSize;
+
+    _Use_decl_annotations_
+    CsvWriter::CsvWriter(
+        const std::string& outputFileName)
+        : _buffer(new char[BufferSize])
+        , _bufferLength(0)
+    {
+        //
+        // The text is already buffered here, so the stream writes it through.
+        //
+        _file.rdbuf()->pubsetbuf(nullptr, 0);
+        _file.open(outputFileName);
+
+        ASSERT(_file);
+    }
+
+#if defined(_WIN32)
+    _Use_decl_annotations_
+    CsvWriter::CsvWriter(
+        const std::wstring& outputFileName)
+        : _buffer(new char[BufferSize])
+        , _bufferLength(0)
+    {
+        _file.rdbuf()->pubsetbuf(nullptr, 0);
+        _file.open(outputFileName);
+
+        ASSERT(_file);
+    }
+#endif /* defined(_WIN32) */
+
+    CsvWriter::~CsvWriter()
+    {
+        EndLine();
+        Flush();
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteHeader(
+        const std::vector<std::string>& columns)
+    {
+        bool writeComma = false;
+
+        for (const auto& column : columns)
+        {
+            WriteText(
+                column,
+                &writeComma);
+        }
+
+        EndLine();
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteText(
+        const std::string& text,
+        bool* writeComma)
+    {
+        WriteComma(
+            writeComma);
+
+        Append(
+            text.data(),
+            text.size());
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteInt32(
+        const int32_t value,
+        bool* writeComma)
+    {
+        WriteComma(
+            writeComma);
+
+        _bufferLength += FormatNumber(
+            value,
+            Reserve(MaxNumberLength));
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteUInt64(
+        const uint64_t value,
+        bool* writeComma)
+    {
+        WriteComma(
+            writeComma);
+
+        _bufferLength += FormatNumber(
+            value,
+            Reserve(MaxNumberLength));
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteFloat(
+        const float value,
+        bool* writeComma)
+    {
+        WriteComma(
+            writeComma);
+
+        _bufferLength += FormatNumber(
+            value,
+            Reserve(MaxNumberLength));
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteDouble(
+        const double value,
+        bool* writeComma)
+    {
+        WriteComma(
+            writeComma);
+
+        _bufferLength += FormatNumber(
+            value,
+            Reserve(MaxNumberLength));
+    }
+
+    void CsvWriter::EndLine()
+    {
+        *Reserve(1) = '\n';
+        ++_bufferLength;
+    }
+
+    void CsvWriter::Flush()
+    {
+        if (0 != _bufferLength)
+        {
+            _file.write(_buffer.get(), _bufferLength);
+            _bufferLength = 0;
+        }
+
+        _file.flush();
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteComma(
+        bool* writeComma)
+    {
+        if (*writeComma)
+        {
+            *Reserve(1) = ',';
+            ++_bufferLength;
+        }
+        else
+        {
+            *writeComma = true;
+        }
+    }
+
+    _Use_decl_annotations_
+    char* CsvWriter::Reserve(
+        const size_t length)
+    {
+        if (_bufferLength + length > BufferSize)
+        {
+            _file.write(_buffer.get(), _bufferLength);
+            _bufferLength = 0;
+        }
+
+        return _buffer.get() + _bufferLength;
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::Append(
+        const char* text,
+        const size_t length)
+    {
+        //
+        // Text longer than the buffer is written as it is.
+        //
+        if (length > BufferSize)
+        {
+            Flush();
+
+            _file.write(text, length);
+
+            return;
+        }
+
+        memcpy(
+            Reserve(length),
+            text,
+            length);
+
+        _bufferLength += length;
+    }
+}
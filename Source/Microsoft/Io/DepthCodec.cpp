@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+#include "CodecTokens.h"
+
+namespace Io
+{
+    using namespace CodecTokens;
+
+    _Use_decl_annotations_
+    size_t GetMaxEncodedDepthImageLength(
+        const uint32_t width,
+        const uint32_t height)
+    {
+        return static_cast<size_t>(width) * height * GetMaxResidualTokenLength<uint16_t>();
+    }
+
+    _Use_decl_annotations_
+    size_t EncodeDepthImage(
+        const uint8_t* image,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t rowStride,
+        uint8_t* encodedImage)
+    {
+        REQUIRES(rowStride >= width * sizeof(uint16_t));
+
+        uint8_t* cursor = encodedImage;
+        uint32_t zeroRunLength = 0;
+        uint16_t rowPrediction = 0;
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint16_t* row =
+                reinterpret_cast<const uint16_t*>(image + static_cast<size_t>(y) * rowStride);
+
+            uint16_t prediction = rowPrediction;
+
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint16_t residual =
+                    ZigZagEncode(static_cast<uint16_t>(row[x] - prediction));
+
+                prediction = row[x];
+
+                if (0 == residual)
+                {
+                    ++zeroRunLength;
+
+                    continue;
+                }
+
+                WriteZeroRun(zeroRunLength, cursor);
+                WriteToken(static_cast<uint32_t>(residual) << 1, cursor);
+            }
+
+            rowPrediction = width > 0 ? row[0] : 0;
+        }
+
+        WriteZeroRun(zeroRunLength, cursor);
+
+        return static_cast<size_t>(cursor - encodedImage);
+    }
+
+    _Use_decl_annotations_
+    bool DecodeDepthImage(
+        const uint8_t* encodedImage,
+        const size_t encodedImageLength,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t rowStride,
+        uint8_t* image)
+    {
+        REQUIRES(rowStride >= width * sizeof(uint16_t));
+
+        const uint8_t* cursor = encodedImage;
+        const uint8_t* end = encodedImage + encodedImageLength;
+        uint32_t zeroRunLength = 0;
+        uint16_t rowPrediction = 0;
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            uint16_t* row =
+                reinterpret_cast<uint16_t*>(image + static_cast<size_t>(y) * rowStride);
+
+            uint16_t prediction = rowPrediction;
+
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint16_t residual = 0;
+
+                if (!ReadResidual(cursor, end, zeroRunLength, residual))
+                {
+                    return false;
+                }
+
+                prediction = static_cast<uint16_t>(prediction + ZigZagDecode(residual));
+
+                row[x] = prediction;
+            }
+
+            rowPrediction = width > 0 ? row[0] : 0;
+        }
+
+        return cursor == end && 0 == zeroRunLength;
+    }
+}
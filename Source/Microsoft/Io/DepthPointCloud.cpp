@@ -0,0 +1,439 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IO_DEPTH_POINT_CLOUD_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Io
+{
+    namespace
+    {
+        const float IdentityTransform[16] =
+        {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+#if IO_DEPTH_POINT_CLOUD_USE_SSE2
+        const uint8_t SetBitCounts[16] =
+        {
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+        };
+#endif /* IO_DEPTH_POINT_CLOUD_USE_SSE2 */
+    }
+
+    DepthImageRegion::DepthImageRegion()
+        : X(0)
+        , Y(0)
+        , Width(0)
+        , Height(0)
+    {
+    }
+
+    _Use_decl_annotations_
+    DepthImageRegion::DepthImageRegion(
+        uint32_t x,
+        uint32_t y,
+        uint32_t width,
+        uint32_t height)
+        : X(x)
+        , Y(y)
+        , Width(width)
+        , Height(height)
+    {
+    }
+
+    DepthPointCloud::DepthPointCloud()
+        : Width(0)
+        , Height(0)
+        , ValidPointCount(0)
+    {
+    }
+
+    DepthPointCloudOptions::DepthPointCloudOptions()
+        : MinDepth(200.0f)
+        , MaxDepth(1000.0f)
+        , DepthScale(0.001f)
+        , BandCount(1)
+    {
+    }
+
+    _Use_decl_annotations_
+    DepthPointCloudConverter::DepthPointCloudConverter(
+        const CameraUnprojectionTable& unprojectionTable,
+        const DepthPointCloudOptions& options)
+        : _imageWidth(unprojectionTable.GetImageWidth())
+        , _imageHeight(unprojectionTable.GetImageHeight())
+        , _options(options)
+    {
+        const size_t pixelCount =
+            static_cast<size_t>(_imageWidth) * _imageHeight;
+
+        _rayX.resize(pixelCount);
+        _rayY.resize(pixelCount);
+        _rayZ.resize(pixelCount);
+
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            const float x = -unprojectionTable.GetUnitPlaneX()[i];
+            const float y = -unprojectionTable.GetUnitPlaneY()[i];
+            const float z = -1.0f;
+
+            const float length = std::sqrt(x * x + y * y + z * z);
+
+            if (!std::isfinite(length))
+            {
+                _rayX[i] = _rayY[i] = _rayZ[i] = std::numeric_limits<float>::quiet_NaN();
+
+                continue;
+            }
+
+            _rayX[i] = x / length;
+            _rayY[i] = y / length;
+            _rayZ[i] = z / length;
+        }
+    }
+
+    const DepthPointCloudOptions& DepthPointCloudConverter::GetOptions() const
+    {
+        return _options;
+    }
+
+    _Use_decl_annotations_
+    void DepthPointCloudConverter::Convert(
+        const uint16_t* depthImage,
+        size_t depthImageRowStride,
+        const DepthImageRegion& region,
+        const float* cameraToWorld,
+        DepthPointCloud& pointCloud) const
+    {
+        REQUIRES(
+            nullptr != depthImage &&
+            depthImageRowStride >= _imageWidth * sizeof(uint16_t));
+
+        REQUIRES(
+            region.X <= _imageWidth &&
+            region.Width <= _imageWidth - region.X &&
+            region.Y <= _imageHeight &&
+            region.Height <= _imageHeight - region.Y);
+
+        float transform[16];
+
+        memcpy(
+            transform,
+            nullptr != cameraToWorld ? cameraToWorld : IdentityTransform,
+            sizeof(transform));
+
+        const size_t pointCount =
+            static_cast<size_t>(region.Width) * region.Height;
+
+        pointCloud.Width = region.Width;
+        pointCloud.Height = region.Height;
+        pointCloud.X.resize(pointCount);
+        pointCloud.Y.resize(pointCount);
+        pointCloud.Z.resize(pointCount);
+
+        const uint32_t bandCount =
+            std::max<uint32_t>(1, std::min(_options.BandCount, region.Height));
+
+        if (1 == bandCount)
+        {
+            pointCloud.ValidPointCount = ConvertRows(
+                depthImage,
+                depthImageRowStride,
+                region,
+                transform,
+                0 /* firstRow */,
+                region.Height,
+                pointCloud);
+
+            return;
+        }
+
+        //
+        // The calling thread converts the first band while the others run.
+        //
+        std::vector<size_t> validPointCounts(bandCount);
+        std::vector<std::thread> threads;
+
+        for (uint32_t band = 1; band < bandCount; ++band)
+        {
+            threads.emplace_back(
+                [&, band]()
+            {
+                validPointCounts[band] = ConvertRows(
+                    depthImage,
+                    depthImageRowStride,
+                    region,
+                    transform,
+                    region.Height * band / bandCount,
+                    region.Height * (band + 1) / bandCount,
+                    pointCloud);
+            });
+        }
+
+        validPointCounts[0] = ConvertRows(
+            depthImage,
+            depthImageRowStride,
+            region,
+            transform,
+            0 /* firstRow */,
+            region.Height / bandCount,
+            pointCloud);
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        pointCloud.ValidPointCount = 0;
+
+        for (size_t validPointCount : validPointCounts)
+        {
+            pointCloud.ValidPointCount += validPointCount;
+        }
+    }
+
+    _Use_decl_annotations_
+    size_t DepthPointCloudConverter::ConvertRows(
+        const uint16_t* depthImage,
+        size_t depthImageRowStride,
+        const DepthImageRegion& region,
+        const float (&transform)[16],
+        uint32_t firstRow,
+        uint32_t endRow,
+        DepthPointCloud& pointCloud) const
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+
+        size_t validPointCount = 0;
+
+#if IO_DEPTH_POINT_CLOUD_USE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 nanValues = _mm_set1_ps(nan);
+        const __m128 minDepth = _mm_set1_ps(_options.MinDepth);
+        const __m128 maxDepth = _mm_set1_ps(_options.MaxDepth);
+        const __m128 depthScale = _mm_set1_ps(_options.DepthScale);
+
+        __m128 m[16];
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            m[i] = _mm_set1_ps(transform[i]);
+        }
+#endif /* IO_DEPTH_POINT_CLOUD_USE_SSE2 */
+
+        for (uint32_t row = firstRow; row < endRow; ++row)
+        {
+            const uint16_t* depths = reinterpret_cast<const uint16_t*>(
+                reinterpret_cast<const uint8_t*>(depthImage) +
+                (region.Y + row) * depthImageRowStride) + region.X;
+
+            const size_t rayOffset =
+                static_cast<size_t>(region.Y + row) * _imageWidth + region.X;
+
+            const float* rayX = _rayX.data() + rayOffset;
+            const float* rayY = _rayY.data() + rayOffset;
+            const float* rayZ = _rayZ.data() + rayOffset;
+
+            const size_t pointOffset =
+                static_cast<size_t>(row) * region.Width;
+
+            float* pointX = pointCloud.X.data() + pointOffset;
+            float* pointY = pointCloud.Y.data() + pointOffset;
+            float* pointZ = pointCloud.Z.data() + pointOffset;
+
+            uint32_t x = 0;
+
+#if IO_DEPTH_POINT_CLOUD_USE_SSE2
+            for (; x + 4 <= region.Width; x += 4)
+            {
+                const __m128 depth = _mm_cvtepi32_ps(
+                    _mm_unpacklo_epi16(
+                        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(depths + x)),
+                        zero));
+
+                const __m128 cameraX = _mm_loadu_ps(rayX + x);
+                const __m128 cameraY = _mm_loadu_ps(rayY + x);
+                const __m128 cameraZ = _mm_loadu_ps(rayZ + x);
+
+                //
+                // Unmapped pixels have NaN rays, which are not ordered.
+                //
+                const __m128 isValid = _mm_and_ps(
+                    _mm_and_ps(
+                        _mm_cmpgt_ps(depth, minDepth),
+                        _mm_cmplt_ps(depth, maxDepth)),
+                    _mm_cmpord_ps(cameraZ, cameraZ));
+
+                const __m128 distance = _mm_mul_ps(depth, depthScale);
+
+                const __m128 px = _mm_mul_ps(cameraX, distance);
+                const __m128 py = _mm_mul_ps(cameraY, distance);
+                const __m128 pz = _mm_mul_ps(cameraZ, distance);
+
+                const __m128 wx = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(px, m[0]), _mm_mul_ps(py, m[4])),
+                    _mm_add_ps(_mm_mul_ps(pz, m[8]), m[12]));
+
+                const __m128 wy = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(px, m[1]), _mm_mul_ps(py, m[5])),
+                    _mm_add_ps(_mm_mul_ps(pz, m[9]), m[13]));
+
+                const __m128 wz = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(px, m[2]), _mm_mul_ps(py, m[6])),
+                    _mm_add_ps(_mm_mul_ps(pz, m[10]), m[14]));
+
+                _mm_storeu_ps(pointX + x, _mm_or_ps(_mm_and_ps(isValid, wx), _mm_andnot_ps(isValid, nanValues)));
+                _mm_storeu_ps(pointY + x, _mm_or_ps(_mm_and_ps(isValid, wy), _mm_andnot_ps(isValid, nanValues)));
+                _mm_storeu_ps(pointZ + x, _mm_or_ps(_mm_and_ps(isValid, wz), _mm_andnot_ps(isValid, nanValues)));
+
+                validPointCount += SetBitCounts[_mm_movemask_ps(isValid)];
+            }
+#endif /* IO_DEPTH_POINT_CLOUD_USE_SSE2 */
+
+            //
+            // The same, one pixel at a time, for the pixels left over and without SSE2.
+            //
+            for (; x < region.Width; ++x)
+            {
+                const float depth = depths[x];
+
+                if (!(depth > _options.MinDepth && depth < _options.MaxDepth) ||
+                    std::isnan(rayZ[x]))
+                {
+                    pointX[x] = pointY[x] = pointZ[x] = nan;
+
+                    continue;
+                }
+
+                const float distance = depth * _options.DepthScale;
+
+                const float px = rayX[x] * distance;
+                const float py = rayY[x] * distance;
+                const float pz = rayZ[x] * distance;
+
+                pointX[x] = (px * transform[0] + py * transform[4]) + (pz * transform[8] + transform[12]);
+                pointY[x] = (px * transform[1] + py * transform[5]) + (pz * transform[9] + transform[13]);
+                pointZ[x] = (px * transform[2] + py * transform[6]) + (pz * transform[10] + transform[14]);
+
+                ++validPointCount;
+            }
+        }
+
+        return validPointCount;
+    }
+
+    _Use_decl_annotations_
+    size_t UnprojectImagePoints(
+        const CameraUnprojectionTable& unprojectionTable,
+        const float* u,
+        const float* v,
+        const float* depths,
+        size_t count,
+        float depthScale,
+        const float* cameraToWorld,
+        float* x,
+        float* y,
+        float* z)
+    {
+        const float* transform =
+            nullptr != cameraToWorld ? cameraToWorld : IdentityTransform;
+
+        size_t validPointCount = 0;
+
+        //
+        // First, look up the rays, which does not vectorize, leaving the unnormalized
+        // ray in x and y and the distance along it in z. Invalid points get a NaN
+        // distance, which carries through to all three coordinates.
+        //
+        for (size_t i = 0; i < count; ++i)
+        {
+            float unitPlaneX;
+            float unitPlaneY;
+
+            const bool isValid =
+                depths[i] > 0.0f &&
+                unprojectionTable.MapImagePointToCameraUnitPlane(u[i], v[i], unitPlaneX, unitPlaneY);
+
+            x[i] = isValid ? -unitPlaneX : 0.0f;
+            y[i] = isValid ? -unitPlaneY : 0.0f;
+            z[i] = isValid ? depths[i] * depthScale : std::numeric_limits<float>::quiet_NaN();
+
+            validPointCount += isValid ? 1 : 0;
+        }
+
+        //
+        // Then normalize, scale and transform them in place.
+        //
+        size_t i = 0;
+
+#if IO_DEPTH_POINT_CLOUD_USE_SSE2
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        __m128 m[16];
+
+        for (size_t j = 0; j < 16; ++j)
+        {
+            m[j] = _mm_set1_ps(transform[j]);
+        }
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 rayX = _mm_loadu_ps(x + i);
+            const __m128 rayY = _mm_loadu_ps(y + i);
+
+            const __m128 length = _mm_sqrt_ps(
+                _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(rayX, rayX), _mm_mul_ps(rayY, rayY)),
+                    one));
+
+            const __m128 scale = _mm_div_ps(_mm_loadu_ps(z + i), length);
+
+            const __m128 px = _mm_mul_ps(rayX, scale);
+            const __m128 py = _mm_mul_ps(rayY, scale);
+            const __m128 pz = _mm_sub_ps(_mm_setzero_ps(), scale);
+
+            _mm_storeu_ps(x + i, _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(px, m[0]), _mm_mul_ps(py, m[4])),
+                _mm_add_ps(_mm_mul_ps(pz, m[8]), m[12])));
+
+            _mm_storeu_ps(y + i, _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(px, m[1]), _mm_mul_ps(py, m[5])),
+                _mm_add_ps(_mm_mul_ps(pz, m[9]), m[13])));
+
+            _mm_storeu_ps(z + i, _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(px, m[2]), _mm_mul_ps(py, m[6])),
+                _mm_add_ps(_mm_mul_ps(pz, m[10]), m[14])));
+        }
+#endif /* IO_DEPTH_POINT_CLOUD_USE_SSE2 */
+
+        for (; i < count; ++i)
+        {
+            const float scale = z[i] / std::sqrt(x[i] * x[i] + y[i] * y[i] + 1.0f);
+
+            const float px = x[i] * scale;
+            const float py = y[i] * scale;
+            const float pz = -scale;
+
+            x[i] = (px * transform[0] + py * transform[4]) + (pz * transform[8] + transform[12]);
+            y[i] = (px * transform[1] + py * transform[5]) + (pz * transform[9] + transform[13]);
+            z[i] = (px * transform[2] + py * transform[6]) + (pz * transform[10] + transform[14]);
+        }
+
+        return validPointCount;
+    }
+}
@@ -0,0 +1,378 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+#include "CodecTokens.h"
+
+namespace Io
+{
+    using namespace CodecTokens;
+
+    namespace
+    {
+        template <typename TSample>
+        size_t EncodeSampleDelta(
+            _In_ const uint8_t* image,
+            _In_ const uint8_t* previousImage,
+            _In_ const uint32_t samplesPerRow,
+            _In_ const uint32_t height,
+            _In_ const uint32_t rowStride,
+            _Out_ uint8_t* encodedImage)
+        {
+            uint8_t* cursor = encodedImage;
+            uint32_t zeroRunLength = 0;
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                const size_t rowOffset = static_cast<size_t>(y) * rowStride;
+
+                const TSample* row =
+                    reinterpret_cast<const TSample*>(image + rowOffset);
+
+                const TSample* previousRow =
+                    reinterpret_cast<const TSample*>(previousImage + rowOffset);
+
+                for (uint32_t x = 0; x < samplesPerRow; ++x)
+                {
+                    const TSample residual =
+                        ZigZagEncode(static_cast<TSample>(row[x] - previousRow[x]));
+
+                    if (0 == residual)
+                    {
+                        ++zeroRunLength;
+
+                        continue;
+                    }
+
+                    WriteZeroRun(zeroRunLength, cursor);
+                    WriteToken(static_cast<uint32_t>(residual) << 1, cursor);
+                }
+            }
+
+            WriteZeroRun(zeroRunLength, cursor);
+
+            return static_cast<size_t>(cursor - encodedImage);
+        }
+
+        template <typename TSample>
+        bool DecodeSampleDelta(
+            _In_ const uint8_t* encodedImage,
+            _In_ const size_t encodedImageLength,
+            _In_ const uint8_t* previousImage,
+            _In_ const uint32_t samplesPerRow,
+            _In_ const uint32_t height,
+            _In_ const uint32_t rowStride,
+            _Out_ uint8_t* image)
+        {
+            const uint8_t* cursor = encodedImage;
+            const uint8_t* end = encodedImage + encodedImageLength;
+            uint32_t zeroRunLength = 0;
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                const size_t rowOffset = static_cast<size_t>(y) * rowStride;
+
+                TSample* row =
+                    reinterpret_cast<TSample*>(image + rowOffset);
+
+                const TSample* previousRow =
+                    reinterpret_cast<const TSample*>(previousImage + rowOffset);
+
+                for (uint32_t x = 0; x < samplesPerRow; ++x)
+                {
+                    TSample residual = 0;
+
+                    if (!ReadResidual(cursor, end, zeroRunLength, residual))
+                    {
+                        return false;
+                    }
+
+                    row[x] = static_cast<TSample>(previousRow[x] + ZigZagDecode(residual));
+                }
+            }
+
+            return cursor == end && 0 == zeroRunLength;
+        }
+
+        bool HasSameLayout(
+            _In_ const FrameStreamHeader& header,
+            _In_ const FrameStreamHeader& otherHeader)
+        {
+            return
+                header.ImageWidth == otherHeader.ImageWidth &&
+                header.ImageHeight == otherHeader.ImageHeight &&
+                header.PixelStride == otherHeader.PixelStride &&
+                header.RowStride == otherHeader.RowStride;
+        }
+
+        size_t GetImageLength(
+            _In_ const FrameStreamHeader& header)
+        {
+            return static_cast<size_t>(header.ImageHeight) * header.RowStride;
+        }
+    }
+
+    _Use_decl_annotations_
+    size_t GetMaxEncodedFrameDeltaLength(
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t pixelStride)
+    {
+        if (sizeof(uint16_t) == pixelStride)
+        {
+            return static_cast<size_t>(width) * height * GetMaxResidualTokenLength<uint16_t>();
+        }
+
+        return static_cast<size_t>(width) * height * pixelStride * GetMaxResidualTokenLength<uint8_t>();
+    }
+
+    _Use_decl_annotations_
+    size_t EncodeFrameDelta(
+        const uint8_t* image,
+        const uint8_t* previousImage,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t pixelStride,
+        const uint32_t rowStride,
+        uint8_t* encodedImage)
+    {
+        REQUIRES(rowStride >= width * pixelStride);
+
+        if (sizeof(uint16_t) == pixelStride)
+        {
+            return EncodeSampleDelta<uint16_t>(
+                image, previousImage, width, height, rowStride, encodedImage);
+        }
+
+        return EncodeSampleDelta<uint8_t>(
+            image, previousImage, width * pixelStride, height, rowStride, encodedImage);
+    }
+
+    _Use_decl_annotations_
+    bool DecodeFrameDelta(
+        const uint8_t* encodedImage,
+        const size_t encodedImageLength,
+        const uint8_t* previousImage,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t pixelStride,
+        const uint32_t rowStride,
+        uint8_t* image)
+    {
+        REQUIRES(rowStride >= width * pixelStride);
+
+        if (sizeof(uint16_t) == pixelStride)
+        {
+            return DecodeSampleDelta<uint16_t>(
+                encodedImage, encodedImageLength, previousImage, width, height, rowStride, image);
+        }
+
+        return DecodeSampleDelta<uint8_t>(
+            encodedImage, encodedImageLength, previousImage, width * pixelStride, height, rowStride, image);
+    }
+
+    _Use_decl_annotations_
+    bool IsKeyframe(
+        const FrameStreamHeader& header)
+    {
+        return FrameCodec::Delta != header.Codec;
+    }
+
+    _Use_decl_annotations_
+    bool IsDeltaKeyframe(
+        const FrameStreamHeader& header)
+    {
+        return
+            HasCodecExtension(header) &&
+            FrameCodec::Delta != header.Codec &&
+            0 != (header.Flags & FrameStreamHeader::DeltaKeyframeFlag);
+    }
+
+    _Use_decl_annotations_
+    void SetDeltaKeyframe(
+        FrameStreamHeader& header)
+    {
+        if (!HasCodecExtension(header))
+        {
+            SetFrameCodec(
+                header,
+                FrameCodec::None,
+                static_cast<uint32_t>(GetImageLength(header)));
+        }
+
+        header.Flags |= FrameStreamHeader::DeltaKeyframeFlag;
+    }
+
+    _Use_decl_annotations_
+    FrameDeltaEncoder::FrameDeltaEncoder(
+        const uint32_t keyframeInterval)
+        : _keyframeInterval(std::max(keyframeInterval, 1u))
+        , _framesSinceKeyframe(0)
+        , _isKeyframeRequested(true)
+    {
+    }
+
+    uint32_t FrameDeltaEncoder::GetKeyframeInterval() const
+    {
+        return _keyframeInterval;
+    }
+
+    _Use_decl_annotations_
+    bool FrameDeltaEncoder::Encode(
+        const FrameStreamHeader& header,
+        const uint8_t* image,
+        std::vector<uint8_t>& encodedImage)
+    {
+        REQUIRES(header.RowStride >= header.ImageWidth * header.PixelStride);
+
+        const size_t imageLength =
+            GetImageLength(header);
+
+        bool isDelta =
+            !_isKeyframeRequested &&
+            _framesSinceKeyframe + 1 < _keyframeInterval &&
+            HasSameLayout(header, _previousHeader);
+
+        if (isDelta)
+        {
+            encodedImage.resize(
+                GetMaxEncodedFrameDeltaLength(
+                    header.ImageWidth,
+                    header.ImageHeight,
+                    header.PixelStride));
+
+            encodedImage.resize(
+                EncodeFrameDelta(
+                    image,
+                    _previousImage.data(),
+                    header.ImageWidth,
+                    header.ImageHeight,
+                    header.PixelStride,
+                    header.RowStride,
+                    encodedImage.data()));
+
+            //
+            // A scene change can make the delta larger than the frame itself.
+            //
+            isDelta = encodedImage.size() < imageLength;
+        }
+
+        if (isDelta)
+        {
+            ++_framesSinceKeyframe;
+        }
+        else
+        {
+            encodedImage.clear();
+
+            _framesSinceKeyframe = 0;
+            _isKeyframeRequested = false;
+        }
+
+        _previousHeader = header;
+        _previousImage.assign(
+            image,
+            image + imageLength);
+
+        return isDelta;
+    }
+
+    void FrameDeltaEncoder::RequestKeyframe()
+    {
+        _isKeyframeRequested = true;
+    }
+
+    FrameDeltaDecoder::FrameDeltaDecoder()
+        : _hasPreviousImage(false)
+    {
+    }
+
+    _Use_decl_annotations_
+    bool FrameDeltaDecoder::Decode(
+        const FrameStreamHeader& header,
+        const uint8_t* payload,
+        const size_t payloadLength,
+        uint8_t* image)
+    {
+        const size_t imageLength =
+            GetImageLength(header);
+
+        bool isDecoded = false;
+
+        if (header.RowStride >= header.ImageWidth * header.PixelStride)
+        {
+            switch (header.Codec)
+            {
+            case FrameCodec::None:
+                isDecoded = payloadLength == imageLength;
+
+                if (isDecoded && payload != image)
+                {
+                    memcpy(image, payload, imageLength);
+                }
+                break;
+
+            case FrameCodec::Depth:
+                isDecoded =
+                    sizeof(uint16_t) == header.PixelStride &&
+                    DecodeDepthImage(
+                        payload,
+                        payloadLength,
+                        header.ImageWidth,
+                        header.ImageHeight,
+                        header.RowStride,
+                        image);
+                break;
+
+            case FrameCodec::Delta:
+                isDecoded =
+                    _hasPreviousImage &&
+                    HasSameLayout(header, _previousHeader) &&
+                    DecodeFrameDelta(
+                        payload,
+                        payloadLength,
+                        _previousImage.data(),
+                        header.ImageWidth,
+                        header.ImageHeight,
+                        header.PixelStride,
+                        header.RowStride,
+                        image);
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        //
+        // Only the frames delta frames follow are kept, sparing the copy of every other frame.
+        //
+        _hasPreviousImage =
+            isDecoded &&
+            (FrameCodec::Delta == header.Codec || IsDeltaKeyframe(header));
+
+        if (_hasPreviousImage)
+        {
+            _previousHeader = header;
+            _previousImage.assign(
+                image,
+                image + imageLength);
+        }
+
+        return isDecoded;
+    }
+
+    void FrameDeltaDecoder::Reset()
+    {
+        _hasPreviousImage = false;
+    }
+}
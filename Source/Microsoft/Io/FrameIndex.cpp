@@ -0,0 +1,185 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+#include "BinaryFormat.h"
+
+namespace Io
+{
+    using namespace BinaryFormat;
+
+    const uint32_t FrameIndex::FileCookie;
+    const uint16_t FrameIndex::FileVersion;
+    const size_t FrameIndex::HeaderLength;
+    const size_t FrameIndex::EntryLength;
+    const char* const FrameIndex::FileExtension = "idx";
+
+    FrameIndexEntry::FrameIndexEntry()
+        : Timestamp(0)
+        , Offset(0)
+        , Size(0)
+        , Format(FrameFileFormat::Unknown)
+    {
+    }
+
+    _Use_decl_annotations_
+    std::string FrameIndex::GetFileName(
+        const std::string& tarballFileName)
+    {
+        return GetSidecarFileName(
+            tarballFileName,
+            FileExtension);
+    }
+
+    _Use_decl_annotations_
+    FrameFileFormat GetFrameFileFormat(
+        const std::string& fileName,
+        const uint8_t* fileData,
+        const size_t fileSize)
+    {
+        if (!RecordedFrameReader::IsKeyframeFileName(fileName))
+        {
+            return FrameFileFormat::Delta;
+        }
+
+        FrameStreamHeader header;
+        size_t imageOffset = 0;
+
+        if (!DecodeImageFileHeader(fileData, fileSize, header, imageOffset))
+        {
+            return FrameFileFormat::Unknown;
+        }
+
+        switch (header.PixelStride)
+        {
+        case 1:
+            return FrameFileFormat::Gray8;
+
+        case 2:
+            return FrameFileFormat::Gray16;
+
+        default:
+            return FrameFileFormat::Rgb8;
+        }
+    }
+
+    _Use_decl_annotations_
+    bool IsKeyframe(
+        const FrameIndexEntry& entry)
+    {
+        return FrameFileFormat::Delta != entry.Format;
+    }
+
+    _Use_decl_annotations_
+    bool ReadFrameIndex(
+        const std::string& indexFileName,
+        std::vector<FrameIndexEntry>& entries)
+    {
+        entries.clear();
+
+        std::ifstream file(indexFileName, std::ios::binary);
+
+        if (!file)
+        {
+            return false;
+        }
+
+        uint8_t header[FrameIndex::HeaderLength];
+
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+        {
+            return false;
+        }
+
+        const uint8_t* cursor = header;
+
+        const uint32_t cookie = ReadLittleEndian<uint32_t>(cursor);
+        const uint16_t version = ReadLittleEndian<uint16_t>(cursor);
+        const uint16_t entryLength = ReadLittleEndian<uint16_t>(cursor);
+
+        //
+        // Later versions may only append fields to the entries.
+        //
+        if (FrameIndex::FileCookie != cookie ||
+            version < FrameIndex::FileVersion ||
+            entryLength < FrameIndex::EntryLength)
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> entryData(entryLength);
+
+        while (file.read(reinterpret_cast<char*>(entryData.data()), entryData.size()))
+        {
+            cursor = entryData.data();
+
+            FrameIndexEntry entry;
+
+            entry.Timestamp = ReadLittleEndian<uint64_t>(cursor);
+            entry.Offset = ReadLittleEndian<uint64_t>(cursor);
+            entry.Size = ReadLittleEndian<uint32_t>(cursor);
+            entry.Format = static_cast<FrameFileFormat>(ReadLittleEndian<uint8_t>(cursor));
+
+            entries.push_back(entry);
+        }
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    FrameIndexWriter::FrameIndexWriter(
+        const std::string& indexFileName)
+        : _file(indexFileName, std::ios::binary)
+    {
+        ASSERT(_file);
+
+        WriteHeader();
+    }
+
+#if defined(_WIN32)
+    _Use_decl_annotations_
+    FrameIndexWriter::FrameIndexWriter(
+        const std::wstring& indexFileName)
+        : _file(indexFileName, std::ios::binary)
+    {
+        ASSERT(_file);
+
+        WriteHeader();
+    }
+#endif /* defined(_WIN32) */
+
+    _Use_decl_annotations_
+    void FrameIndexWriter::Add(
+        const FrameIndexEntry& entry)
+    {
+        uint8_t entryData[FrameIndex::EntryLength] = {};
+        uint8_t* cursor = entryData;
+
+        WriteLittleEndian(entry.Timestamp, cursor);
+        WriteLittleEndian(entry.Offset, cursor);
+        WriteLittleEndian(entry.Size, cursor);
+        WriteLittleEndian(static_cast<uint8_t>(entry.Format), cursor);
+
+        _file.write(reinterpret_cast<const char*>(entryData), sizeof(entryData));
+    }
+
+    void FrameIndexWriter::WriteHeader()
+    {
+        uint8_t header[FrameIndex::HeaderLength] = {};
+        uint8_t* cursor = header;
+
+        WriteLittleEndian(FrameIndex::FileCookie, cursor);
+        WriteLittleEndian(FrameIndex::FileVersion, cursor);
+        WriteLittleEndian(static_cast<uint16_t>(FrameIndex::EntryLength), cursor);
+
+        _file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+}
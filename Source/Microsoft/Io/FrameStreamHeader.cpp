@@ -0,0 +1,195 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+#include "BinaryFormat.h"
+
+namespace Io
+{
+    using namespace BinaryFormat;
+
+    const uint32_t FrameStreamHeader::ProtocolCookie;
+    const uint8_t FrameStreamHeader::ProtocolVersionMajor;
+    const uint8_t FrameStreamHeader::ProtocolVersionMinor;
+    const uint8_t FrameStreamHeader::ProtocolVersionMinorUncompressed;
+    const size_t FrameStreamHeader::EncodedLength;
+    const size_t FrameStreamHeader::CodecExtensionLength;
+    const size_t FrameStreamHeader::MaxEncodedLength;
+
+    FrameStreamHeader::FrameStreamHeader()
+        : Cookie(ProtocolCookie)
+        , VersionMajor(ProtocolVersionMajor)
+        , VersionMinor(ProtocolVersionMinorUncompressed)
+        , FrameType(0)
+        , Timestamp(0)
+        , ImageWidth(0)
+        , ImageHeight(0)
+        , PixelStride(0)
+        , RowStride(0)
+        , Codec(FrameCodec::None)
+        , Flags(0)
+        , PayloadLength(0)
+    {
+    }
+
+    _Use_decl_annotations_
+    bool HasCodecExtension(
+        const FrameStreamHeader& header)
+    {
+        return header.VersionMinor > FrameStreamHeader::ProtocolVersionMinorUncompressed;
+    }
+
+    _Use_decl_annotations_
+    size_t GetEncodedLength(
+        const FrameStreamHeader& header)
+    {
+        return HasCodecExtension(header) ?
+            FrameStreamHeader::MaxEncodedLength :
+            FrameStreamHeader::EncodedLength;
+    }
+
+    _Use_decl_annotations_
+    size_t GetPayloadLength(
+        const FrameStreamHeader& header)
+    {
+        return HasCodecExtension(header) ?
+            header.PayloadLength :
+            static_cast<size_t>(header.ImageHeight) * header.RowStride;
+    }
+
+    _Use_decl_annotations_
+    bool IsValidImageLayout(
+        const FrameStreamHeader& header)
+    {
+        const uint64_t rowLength =
+            static_cast<uint64_t>(header.ImageWidth) * header.PixelStride;
+
+        const uint64_t imageLength =
+            static_cast<uint64_t>(header.ImageHeight) * header.RowStride;
+
+        if (0 == header.PixelStride ||
+            header.RowStride < rowLength ||
+            imageLength > FrameStreamHeader::MaxImageLength)
+        {
+            return false;
+        }
+
+        const FrameCodec codec =
+            HasCodecExtension(header) ? header.Codec : FrameCodec::None;
+
+        switch (codec)
+        {
+        case FrameCodec::None:
+            return GetPayloadLength(header) == imageLength;
+
+        case FrameCodec::Depth:
+            return
+                sizeof(uint16_t) == header.PixelStride &&
+                header.PayloadLength <= GetMaxEncodedDepthImageLength(header.ImageWidth, header.ImageHeight);
+
+        case FrameCodec::Delta:
+            return header.PayloadLength <= GetMaxEncodedFrameDeltaLength(
+                header.ImageWidth,
+                header.ImageHeight,
+                header.PixelStride);
+        }
+
+        return false;
+    }
+
+    _Use_decl_annotations_
+    void SetFrameCodec(
+        FrameStreamHeader& header,
+        const FrameCodec codec,
+        const uint32_t payloadLength)
+    {
+        header.VersionMinor = FrameStreamHeader::ProtocolVersionMinor;
+        header.Codec = codec;
+        header.Flags = 0;
+        header.PayloadLength = payloadLength;
+    }
+
+    _Use_decl_annotations_
+    void EncodeFrameStreamHeader(
+        const FrameStreamHeader& header,
+        uint8_t* buffer)
+    {
+        uint8_t* cursor = buffer;
+
+        WriteLittleEndian(header.Cookie, cursor);
+        WriteLittleEndian(header.VersionMajor, cursor);
+        WriteLittleEndian(header.VersionMinor, cursor);
+        WriteLittleEndian(header.FrameType, cursor);
+        WriteLittleEndian(header.Timestamp, cursor);
+        WriteLittleEndian(header.ImageWidth, cursor);
+        WriteLittleEndian(header.ImageHeight, cursor);
+        WriteLittleEndian(header.PixelStride, cursor);
+        WriteLittleEndian(header.RowStride, cursor);
+
+        if (HasCodecExtension(header))
+        {
+            WriteLittleEndian(static_cast<uint16_t>(header.Codec), cursor);
+            WriteLittleEndian(header.Flags, cursor);
+            WriteLittleEndian(header.PayloadLength, cursor);
+        }
+
+        ENSURES(GetEncodedLength(header) == static_cast<size_t>(cursor - buffer));
+    }
+
+    _Use_decl_annotations_
+    bool DecodeFrameStreamHeader(
+        const uint8_t* buffer,
+        const size_t bufferLength,
+        FrameStreamHeader& header)
+    {
+        if (bufferLength < FrameStreamHeader::EncodedLength)
+        {
+            return false;
+        }
+
+        const uint8_t* cursor = buffer;
+
+        header.Cookie = ReadLittleEndian<uint32_t>(cursor);
+        header.VersionMajor = ReadLittleEndian<uint8_t>(cursor);
+        header.VersionMinor = ReadLittleEndian<uint8_t>(cursor);
+        header.FrameType = ReadLittleEndian<uint16_t>(cursor);
+        header.Timestamp = ReadLittleEndian<uint64_t>(cursor);
+        header.ImageWidth = ReadLittleEndian<uint32_t>(cursor);
+        header.ImageHeight = ReadLittleEndian<uint32_t>(cursor);
+        header.PixelStride = ReadLittleEndian<uint32_t>(cursor);
+        header.RowStride = ReadLittleEndian<uint32_t>(cursor);
+        header.Codec = FrameCodec::None;
+        header.Flags = 0;
+        header.PayloadLength = 0;
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    bool DecodeFrameStreamHeaderCodecExtension(
+        const uint8_t* buffer,
+        const size_t bufferLength,
+        FrameStreamHeader& header)
+    {
+        if (bufferLength < FrameStreamHeader::CodecExtensionLength)
+        {
+            return false;
+        }
+
+        const uint8_t* cursor = buffer;
+
+        header.Codec = static_cast<FrameCodec>(ReadLittleEndian<uint16_t>(cursor));
+        header.Flags = ReadLittleEndian<uint16_t>(cursor);
+        header.PayloadLength = ReadLittleEndian<uint32_t>(cursor);
+
+        return true;
+    }
+}
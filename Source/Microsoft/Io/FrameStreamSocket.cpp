@@ -0,0 +1,672 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+#if !defined(_WIN32)
+
+namespace Io
+{
+    namespace
+    {
+        void CloseSocket(
+            _Inout_ int& socket)
+        {
+            if (socket >= 0)
+            {
+                close(socket);
+
+                socket = -1;
+            }
+        }
+    }
+
+    //
+    // A frame queued for the clients. It is shared by their queues, and releases its
+    // owner once the last client is done with it.
+    //
+    struct FrameStreamServer::Frame
+    {
+        uint8_t Header[FrameStreamHeader::MaxEncodedLength];
+        size_t HeaderLength;
+        const uint8_t* Data;
+        size_t DataLength;
+        std::shared_ptr<const void> Owner;
+    };
+
+    struct FrameStreamServer::Client
+    {
+        Client(
+            _In_ const int socket,
+            _In_ const FrameSendPolicy& policy)
+            : Socket(socket)
+            , Queue(policy)
+            , IsSending(false)
+            , IsConnected(true)
+            , SentFrameCount(0)
+        {
+            Thread = std::thread(
+                &Client::SendLoop,
+                this);
+        }
+
+        ~Client()
+        {
+            Disconnect();
+
+            Thread.join();
+
+            CloseSocket(Socket);
+        }
+
+        //
+        // Stops streaming. Also unblocks a send to a client that stopped reading.
+        //
+        void Disconnect()
+        {
+            {
+                std::lock_guard<std::mutex> guard(Mutex);
+
+                if (IsConnected)
+                {
+                    IsConnected = false;
+
+                    shutdown(Socket, SHUT_RDWR);
+                }
+            }
+
+            FrameQueued.notify_one();
+        }
+
+        void SendLoop()
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+
+            for (;;)
+            {
+                FrameQueued.wait(lock, [this]() { return !Queue.IsEmpty() || !IsConnected; });
+
+                std::shared_ptr<const Frame> frame;
+
+                if (!IsConnected || !Queue.Pop(frame))
+                {
+                    break;
+                }
+
+                IsSending = true;
+
+                lock.unlock();
+
+                const bool isSent = SendFrame(*frame);
+
+                frame.reset();
+
+                lock.lock();
+
+                IsSending = false;
+
+                if (isSent)
+                {
+                    ++SentFrameCount;
+                }
+                else if (IsConnected)
+                {
+                    dbg::trace(
+                        L"FrameStreamServer::Client::SendLoop: send failed with error %i, disconnecting the client",
+                        errno);
+
+                    IsConnected = false;
+                }
+
+                if (Queue.IsEmpty())
+                {
+                    QueueEmptied.notify_all();
+                }
+            }
+
+            Queue.Clear();
+
+            QueueEmptied.notify_all();
+        }
+
+        bool SendFrame(
+            _In_ const Frame& frame)
+        {
+            iovec buffers[2];
+
+            buffers[0].iov_base = const_cast<uint8_t*>(frame.Header);
+            buffers[0].iov_len = frame.HeaderLength;
+            buffers[1].iov_base = const_cast<uint8_t*>(frame.Data);
+            buffers[1].iov_len = frame.DataLength;
+
+            msghdr message = {};
+
+            message.msg_iov = buffers;
+            message.msg_iovlen = 2;
+
+            while (message.msg_iovlen > 0)
+            {
+                const ssize_t bytesSent = sendmsg(Socket, &message, MSG_NOSIGNAL);
+
+                if (bytesSent < 0)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+
+                    return false;
+                }
+
+                //
+                // Skip what was sent, which may end in the middle of a buffer.
+                //
+                size_t remaining = static_cast<size_t>(bytesSent);
+
+                while (message.msg_iovlen > 0 && remaining >= message.msg_iov->iov_len)
+                {
+                    remaining -= message.msg_iov->iov_len;
+
+                    ++message.msg_iov;
+                    --message.msg_iovlen;
+                }
+
+                if (message.msg_iovlen > 0)
+                {
+                    message.msg_iov->iov_base = static_cast<uint8_t*>(message.msg_iov->iov_base) + remaining;
+                    message.msg_iov->iov_len -= remaining;
+                }
+            }
+
+            return true;
+        }
+
+        int Socket;
+        std::thread Thread;
+
+        std::mutex Mutex;
+        std::condition_variable FrameQueued;
+        std::condition_variable QueueEmptied;
+        FrameSendQueue<std::shared_ptr<const Frame>> Queue;
+        bool IsSending;
+        bool IsConnected;
+        uint64_t SentFrameCount;
+    };
+
+    FrameStreamServer::FrameStreamServer()
+        : _listener(-1)
+        , _port(0)
+    {
+    }
+
+    FrameStreamServer::~FrameStreamServer()
+    {
+        Close();
+
+        CloseSocket(_listener);
+    }
+
+    _Use_decl_annotations_
+    bool FrameStreamServer::Listen(
+        const uint16_t port)
+    {
+        REQUIRES(_listener < 0);
+
+        _listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (_listener < 0)
+        {
+            dbg::trace(
+                L"FrameStreamServer::Listen: socket failed with error %i",
+                errno);
+
+            return false;
+        }
+
+        const int reuseAddress = 1;
+
+        setsockopt(
+            _listener,
+            SOL_SOCKET,
+            SO_REUSEADDR,
+            &reuseAddress,
+            sizeof(reuseAddress));
+
+        sockaddr_in address = {};
+
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+
+        socklen_t addressLength = sizeof(address);
+
+        if (0 != bind(_listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) ||
+            0 != listen(_listener, SOMAXCONN) ||
+            0 != getsockname(_listener, reinterpret_cast<sockaddr*>(&address), &addressLength))
+        {
+            dbg::trace(
+                L"FrameStreamServer::Listen: cannot listen on port %i, error %i",
+                port,
+                errno);
+
+            CloseSocket(_listener);
+
+            return false;
+        }
+
+        _port = ntohs(address.sin_port);
+
+        return true;
+    }
+
+    uint16_t FrameStreamServer::GetPort() const
+    {
+        return _port;
+    }
+
+    _Use_decl_annotations_
+    bool FrameStreamServer::Accept(
+        const FrameSendPolicy& policy)
+    {
+        REQUIRES(_listener >= 0);
+
+        const int client = accept(_listener, nullptr, nullptr);
+
+        if (client < 0)
+        {
+            dbg::trace(
+                L"FrameStreamServer::Accept: accept failed with error %i",
+                errno);
+
+            return false;
+        }
+
+        //
+        // Frames are sent whole, so there is nothing to gain from Nagle's algorithm.
+        //
+        const int noDelay = 1;
+
+        setsockopt(
+            client,
+            IPPROTO_TCP,
+            TCP_NODELAY,
+            &noDelay,
+            sizeof(noDelay));
+
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        RemoveDisconnectedClients();
+
+        _clients.push_back(
+            std::make_shared<Client>(client, policy));
+
+        return true;
+    }
+
+    size_t FrameStreamServer::GetClientCount() const
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        size_t clientCount = 0;
+
+        for (const auto& client : _clients)
+        {
+            std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+            clientCount += client->IsConnected ? 1 : 0;
+        }
+
+        return clientCount;
+    }
+
+    std::vector<FrameStreamClientStatistics> FrameStreamServer::GetClientStatistics() const
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        std::vector<FrameStreamClientStatistics> statistics;
+
+        for (const auto& client : _clients)
+        {
+            std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+            if (client->IsConnected)
+            {
+                FrameStreamClientStatistics clientStatistics;
+
+                clientStatistics.SentFrameCount = client->SentFrameCount;
+                clientStatistics.DroppedFrameCount = client->Queue.GetDroppedCount();
+
+                statistics.push_back(clientStatistics);
+            }
+        }
+
+        return statistics;
+    }
+
+    _Use_decl_annotations_
+    bool FrameStreamServer::Send(
+        const FrameStreamHeader& header,
+        const uint8_t* data,
+        const size_t dataLength,
+        std::shared_ptr<const void> owner)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        RemoveDisconnectedClients();
+
+        if (_clients.empty())
+        {
+            return false;
+        }
+
+        std::shared_ptr<Frame> frame =
+            std::make_shared<Frame>();
+
+        EncodeFrameStreamHeader(
+            header,
+            frame->Header);
+
+        frame->HeaderLength = GetEncodedLength(header);
+
+        frame->Data = data;
+        frame->DataLength = dataLength;
+        frame->Owner = std::move(owner);
+
+        bool isQueued = false;
+
+        for (const auto& client : _clients)
+        {
+            std::unique_lock<std::mutex> clientLock(client->Mutex);
+
+            const FrameQueueResult result =
+                client->Queue.Push(frame);
+
+            if (FrameQueueResult::Queued == result)
+            {
+                isQueued = true;
+
+                clientLock.unlock();
+
+                client->FrameQueued.notify_one();
+            }
+            else if (FrameQueueResult::Overflow == result)
+            {
+                dbg::trace(
+                    L"FrameStreamServer::Send: lossless client fell %i frames behind, disconnecting it",
+                    static_cast<int32_t>(client->Queue.GetPolicy().Capacity));
+
+                clientLock.unlock();
+
+                client->Disconnect();
+            }
+        }
+
+        return isQueued;
+    }
+
+    _Use_decl_annotations_
+    bool FrameStreamServer::Flush(
+        const uint32_t timeoutMilliseconds)
+    {
+        //
+        // Waits without holding the server lock, so frames can still be sent to the
+        // other clients, and Close can still disconnect them.
+        //
+        std::vector<std::shared_ptr<Client>> clients;
+
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+
+            clients = _clients;
+        }
+
+        const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+
+        bool isFlushed = true;
+
+        for (const auto& client : clients)
+        {
+            std::unique_lock<std::mutex> clientLock(client->Mutex);
+
+            const bool isClientFlushed = client->QueueEmptied.wait_until(clientLock, deadline, [&client]()
+            {
+                return !client->IsConnected || (client->Queue.IsEmpty() && !client->IsSending);
+            });
+
+            if (!isClientFlushed)
+            {
+                dbg::trace(
+                    L"FrameStreamServer::Flush: client did not send %i queued frames within %u ms, disconnecting it",
+                    static_cast<int32_t>(client->Queue.GetSize()),
+                    timeoutMilliseconds);
+
+                clientLock.unlock();
+
+                client->Disconnect();
+
+                isFlushed = false;
+            }
+        }
+
+        return isFlushed;
+    }
+
+    void FrameStreamServer::Close()
+    {
+        if (_listener >= 0)
+        {
+            shutdown(_listener, SHUT_RDWR);
+        }
+
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        //
+        // A client a flush still waits on outlives the list, so disconnect it here.
+        //
+        for (const auto& client : _clients)
+        {
+            client->Disconnect();
+        }
+
+        _clients.clear();
+    }
+
+    void FrameStreamServer::RemoveDisconnectedClients()
+    {
+        _clients.erase(
+            std::remove_if(
+                _clients.begin(),
+                _clients.end(),
+                [](const std::shared_ptr<Client>& client)
+                {
+                    std::lock_guard<std::mutex> clientGuard(client->Mutex);
+
+                    return !client->IsConnected;
+                }),
+            _clients.end());
+    }
+
+    FrameStreamClient::FrameStreamClient()
+        : _socket(-1)
+    {
+    }
+
+    FrameStreamClient::~FrameStreamClient()
+    {
+        Close();
+    }
+
+    _Use_decl_annotations_
+    bool FrameStreamClient::Connect(
+        const std::string& address,
+        const uint16_t port)
+    {
+        Close();
+
+        _decoder.Reset();
+
+        sockaddr_in serverAddress = {};
+
+        serverAddress.sin_family = AF_INET;
+        serverAddress.sin_port = htons(port);
+
+        if (1 != inet_pton(AF_INET, address.c_str(), &serverAddress.sin_addr))
+        {
+            return false;
+        }
+
+        _socket = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (_socket < 0 ||
+            0 != connect(_socket, reinterpret_cast<const sockaddr*>(&serverAddress), sizeof(serverAddress)))
+        {
+            dbg::trace(
+                L"FrameStreamClient::Connect: cannot connect to %S:%i, error %i",
+                address.c_str(),
+                port,
+                errno);
+
+            Close();
+
+            return false;
+        }
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    bool FrameStreamClient::Receive(
+        FrameStreamHeader& header,
+        std::vector<uint8_t>& data)
+    {
+        uint8_t headerBuffer[FrameStreamHeader::MaxEncodedLength];
+
+        if (!ReceiveAll(headerBuffer, FrameStreamHeader::EncodedLength) ||
+            !DecodeFrameStreamHeader(headerBuffer, FrameStreamHeader::EncodedLength, header))
+        {
+            return false;
+        }
+
+        if (FrameStreamHeader::ProtocolCookie != header.Cookie ||
+            FrameStreamHeader::ProtocolVersionMajor != header.VersionMajor ||
+            FrameStreamHeader::ProtocolVersionMinorUncompressed > header.VersionMinor ||
+            FrameStreamHeader::ProtocolVersionMinor < header.VersionMinor)
+        {
+            dbg::trace(
+                L"FrameStreamClient::Receive: expected ProtocolCookie/ProtocolVersionMajor/ProtocolVersionMinor of 0x%08x/0x%02x/0x%02x, got 0x%08x/0x%02x/0x%02x",
+                FrameStreamHeader::ProtocolCookie,
+                FrameStreamHeader::ProtocolVersionMajor,
+                FrameStreamHeader::ProtocolVersionMinor,
+                header.Cookie,
+                header.VersionMajor,
+                header.VersionMinor);
+
+            return false;
+        }
+
+        if (HasCodecExtension(header) &&
+            (!ReceiveAll(headerBuffer + FrameStreamHeader::EncodedLength, FrameStreamHeader::CodecExtensionLength) ||
+             !DecodeFrameStreamHeaderCodecExtension(
+                 headerBuffer + FrameStreamHeader::EncodedLength,
+                 FrameStreamHeader::CodecExtensionLength,
+                 header)))
+        {
+            return false;
+        }
+
+        if (!IsValidImageLayout(header))
+        {
+            dbg::trace(
+                L"FrameStreamClient::Receive: rejecting a %ux%u image with pixel stride %u, row stride %u and a payload of %zu bytes",
+                header.ImageWidth,
+                header.ImageHeight,
+                header.PixelStride,
+                header.RowStride,
+                GetPayloadLength(header));
+
+            return false;
+        }
+
+        data.resize(
+            static_cast<size_t>(header.ImageHeight) * header.RowStride);
+
+        //
+        // Uncompressed images are received in place, compressed ones into the payload.
+        //
+        const bool isCompressed =
+            FrameCodec::None != header.Codec;
+
+        if (isCompressed)
+        {
+            _payload.resize(
+                GetPayloadLength(header));
+        }
+
+        std::vector<uint8_t>& payload =
+            isCompressed ? _payload : data;
+
+        if (!ReceiveAll(payload.data(), payload.size()))
+        {
+            return false;
+        }
+
+        if (!_decoder.Decode(
+                header,
+                payload.data(),
+                payload.size(),
+                data.data()))
+        {
+            dbg::trace(
+                L"FrameStreamClient::Receive: cannot decode the image with codec %u at timestamp %llu",
+                static_cast<uint32_t>(header.Codec),
+                static_cast<unsigned long long>(header.Timestamp));
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void FrameStreamClient::Close()
+    {
+        CloseSocket(_socket);
+    }
+
+    _Use_decl_annotations_
+    bool FrameStreamClient::ReceiveAll(
+        uint8_t* buffer,
+        const size_t length)
+    {
+        size_t received = 0;
+
+        while (received < length)
+        {
+            const ssize_t bytesReceived = recv(_socket, buffer + received, length - received, 0);
+
+            if (bytesReceived < 0 && EINTR == errno)
+            {
+                continue;
+            }
+
+            if (bytesReceived <= 0)
+            {
+                return false;
+            }
+
+            received += static_cast<size_t>(bytesReceived);
+        }
+
+        return true;
+    }
+}
+
+#endif /* !defined(_WIN32) */
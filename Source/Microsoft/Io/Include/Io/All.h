@@ -11,11 +11,38 @@
 
 #pragma once
 
+#if defined(_WIN32)
 #include <Io/Time.h>
 #include <Io/TimeConverter.h>
 #include <Io/Timer.h>
 #include <Io/StorageHandleAccess.h>
+#endif /* defined(_WIN32) */
+
 #include <Io/Tar.h>
-#include <Io/BufferHelpers.h>
+#include <Io/TarReader.h>
+#include <Io/CsvWriter.h>
+#include <Io/CameraUnprojectionTable.h>
+#include <Io/DepthPointCloud.h>
+#include <Io/FrameBuffer.h>
+#include <Io/LatestValueSlot.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/DepthCodec.h>
+#include <Io/FrameDeltaCodec.h>
+#include <Io/FrameIndex.h>
+#include <Io/PoseLog.h>
+#include <Io/RecordedFrameReader.h>
+#include <Io/MappedFile.h>
+#include <Io/IndexedFrameReader.h>
+#include <Io/RecordingPlayer.h>
+#include <Io/FrameSendQueue.h>
+#include <Io/FrameWriterQueue.h>
 #include <Io/StringHelpers.h>
-#include <Io/IoHelpers.h>
\ No newline at end of file
+
+#if !defined(_WIN32)
+#include <Io/FrameStreamSocket.h>
+#endif /* !defined(_WIN32) */
+
+#if defined(_WIN32)
+#include <Io/BufferHelpers.h>
+#include <Io/IoHelpers.h>
+#endif /* defined(_WIN32) */
@@ -0,0 +1,111 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace Io
+{
+    //
+    // Maps every pixel of a camera image to the unit Z=1 plane, as
+    // HoloLensForCV::CameraIntrinsics::MapImagePointToCameraUnitPlane does, from a
+    // table computed once per sensor and resolution. The X and Y coordinates are
+    // kept in separate row major arrays, so lookups along an image row read
+    // consecutive floats.
+    //
+    // The recorder saves the table of each sensor as <sensor>_camera_space_projection.bin:
+    // for every column from left to right, the X and Y coordinates of every pixel in it
+    // from top to bottom, as little endian IEEE 754 single precision floats, without a
+    // header. The image size is therefore not in the file and must be known to read it.
+    //
+    class CameraUnprojectionTable
+    {
+    public:
+        static const char* const FileNameSuffix;
+
+        CameraUnprojectionTable();
+
+        //
+        // Creates a table of the given size, with every pixel unmapped.
+        //
+        CameraUnprojectionTable(
+            _In_ uint32_t imageWidth,
+            _In_ uint32_t imageHeight);
+
+        //
+        // Builds the name of the table file of a sensor in a recording folder, such as
+        // "<folder>/short_throw_depth_camera_space_projection.bin".
+        //
+        static std::string GetFileName(
+            _In_ const std::string& folderPath,
+            _In_ const std::string& sensorName);
+
+        bool IsEmpty() const;
+
+        uint32_t GetImageWidth() const;
+
+        uint32_t GetImageHeight() const;
+
+        //
+        // Sets the unit plane coordinates of the pixel whose top-left corner is at (x, y).
+        // Pixels that the camera cannot map are set to infinity.
+        //
+        void Set(
+            _In_ uint32_t x,
+            _In_ uint32_t y,
+            _In_ float unitPlaneX,
+            _In_ float unitPlaneY);
+
+        //
+        // Maps an image point to the unit Z=1 plane, interpolating bilinearly between
+        // the four pixels around it. As with CameraIntrinsics, integer coordinates are
+        // the top-left corners of pixels. Returns false, and sets the coordinates to
+        // infinity, for points outside the table or next to unmapped pixels.
+        //
+        bool MapImagePointToCameraUnitPlane(
+            _In_ float u,
+            _In_ float v,
+            _Out_ float& unitPlaneX,
+            _Out_ float& unitPlaneY) const;
+
+        //
+        // The unit plane coordinates of all pixels, ImageWidth per row.
+        //
+        const float* GetUnitPlaneX() const;
+
+        const float* GetUnitPlaneY() const;
+
+    private:
+        uint32_t _imageWidth;
+        uint32_t _imageHeight;
+
+        std::vector<float> _unitPlaneX;
+        std::vector<float> _unitPlaneY;
+    };
+
+    //
+    // Reads the table file of a camera whose images have the given size. Returns false
+    // if the file does not exist or does not hold exactly one entry per pixel.
+    //
+    bool ReadCameraUnprojectionTable(
+        _In_ const std::string& fileName,
+        _In_ uint32_t imageWidth,
+        _In_ uint32_t imageHeight,
+        _Out_ CameraUnprojectionTable& table);
+
+    bool WriteCameraUnprojectionTable(
+        _In_ const std::string& fileName,
+        _In_ const CameraUnprojectionTable& table);
+
+#if defined(_WIN32)
+    bool WriteCameraUnprojectionTable(
+        _In_ const std::wstring& fileName,
+        _In_ const CameraUnprojectionTable& table);
+#endif /* defined(_WIN32) */
+}
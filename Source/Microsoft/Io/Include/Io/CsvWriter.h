@@ -0,0 +1,93 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <fstream>
+#include <memory>
+
+namespace Io
+{
+    //
+    // Writes comma separated values to a UTF-8 text file. Columns are separated by
+    // passing the same writeComma flag to all values of a line.
+    //
+    // The text is gathered in a buffer of BufferSize bytes, which is written to the
+    // file when it is full, by Flush, and on destruction; lines are not flushed. Numbers
+    // are formatted without the locale, floats and doubles with as many digits as
+    // they need to be parsed back to the same value.
+    //
+    class CsvWriter
+    {
+    public:
+        static const size_t BufferSize = 64 * 1024;
+
+        CsvWriter(
+            _In_ const std::string& outputFileName);
+
+#if defined(_WIN32)
+        CsvWriter(
+            _In_ const std::wstring& outputFileName);
+#endif /* defined(_WIN32) */
+
+        virtual ~CsvWriter();
+
+        void WriteHeader(
+            _In_ const std::vector<std::string>& columns);
+
+        void WriteText(
+            _In_ const std::string& text,
+            _Inout_ bool* writeComma);
+
+        void WriteInt32(
+            _In_ const int32_t value,
+            _Inout_ bool* writeComma);
+
+        void WriteUInt64(
+            _In_ const uint64_t value,
+            _Inout_ bool* writeComma);
+
+        void WriteFloat(
+            _In_ const float value,
+            _Inout_ bool* writeComma);
+
+        void WriteDouble(
+            _In_ const double value,
+            _Inout_ bool* writeComma);
+
+        void EndLine();
+
+        //
+        // Writes the buffered text to the file.
+        //
+        void Flush();
+
+    protected:
+        void WriteComma(
+            _Inout_ bool* shouldWrite);
+
+        //
+        // Returns room for length more characters, writing the buffer to the file
+        // first if it does not fit. The caller adds what it used to _bufferLength.
+        //
+        char* Reserve(
+            _In_ const size_t length);
+
+        void Append(
+            _In_reads_(length) const char* text,
+            _In_ const size_t length);
+
+    protected:
+        std::ofstream _file;
+
+        std::unique_ptr<char[]> _buffer;
+        size_t _bufferLength;
+    };
+}
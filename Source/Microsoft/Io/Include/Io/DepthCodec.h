@@ -0,0 +1,54 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Lossless compression for 16-bit depth images, cheap enough to run on every frame.
+    //
+    // Every pixel is predicted from its left neighbour, and the first pixel of a row from
+    // the pixel above it. The prediction residuals are zigzag encoded and written as
+    // variable length tokens: small residuals take one byte, and a run of zero residuals,
+    // such as the invalid pixels around the short throw depth image, takes a single token.
+    //
+
+    //
+    // Upper bound of the encoded length of a width x height depth image.
+    //
+    size_t GetMaxEncodedDepthImageLength(
+        _In_ const uint32_t width,
+        _In_ const uint32_t height);
+
+    //
+    // Encodes the image, whose rows are rowStride bytes apart, into the buffer, which must
+    // hold GetMaxEncodedDepthImageLength bytes. Returns the encoded length.
+    //
+    size_t EncodeDepthImage(
+        _In_ const uint8_t* image,
+        _In_ const uint32_t width,
+        _In_ const uint32_t height,
+        _In_ const uint32_t rowStride,
+        _Out_ uint8_t* encodedImage);
+
+    //
+    // Decodes an image encoded by EncodeDepthImage. Returns false if the encoded image
+    // is corrupt or does not have the given dimensions.
+    //
+    bool DecodeDepthImage(
+        _In_ const uint8_t* encodedImage,
+        _In_ const size_t encodedImageLength,
+        _In_ const uint32_t width,
+        _In_ const uint32_t height,
+        _In_ const uint32_t rowStride,
+        _Out_ uint8_t* image);
+}
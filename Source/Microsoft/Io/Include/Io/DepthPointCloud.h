@@ -0,0 +1,159 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace Io
+{
+    //
+    // A rectangle of a depth image, in pixels.
+    //
+    struct DepthImageRegion
+    {
+        DepthImageRegion();
+
+        DepthImageRegion(
+            _In_ uint32_t x,
+            _In_ uint32_t y,
+            _In_ uint32_t width,
+            _In_ uint32_t height);
+
+        uint32_t X;
+        uint32_t Y;
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    //
+    // An organized point cloud: one point per pixel of the converted region, row by
+    // row, with the coordinates in separate arrays. Pixels without a valid depth are
+    // NaN in all three arrays.
+    //
+    struct DepthPointCloud
+    {
+        DepthPointCloud();
+
+        uint32_t Width;
+        uint32_t Height;
+        size_t ValidPointCount;
+
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+    };
+
+    struct DepthPointCloudOptions
+    {
+        DepthPointCloudOptions();
+
+        //
+        // Only depths strictly between these are valid, in the units of the depth
+        // image. The defaults are those of HandDetector's DEPTH_SAMPLE_MIN and
+        // DEPTH_SAMPLE_MAX.
+        //
+        float MinDepth;
+        float MaxDepth;
+
+        //
+        // Meters per depth image unit.
+        //
+        float DepthScale;
+
+        //
+        // The region is split into this many bands of rows, converted on their own
+        // threads. Starting the threads costs tens of microseconds, so more than one
+        // band only pays off for whole frames on a device with idle cores.
+        //
+        uint32_t BandCount;
+    };
+
+    //
+    // Lifts depth images into 3D camera or world space, as HoloHands does for the hand
+    // position: each pixel's ray through the unit Z=1 plane, pointing down the negative
+    // Z axis, is normalized and scaled by the pixel's depth, then transformed.
+    //
+    // The normalized rays are computed once, from the camera's unprojection table, so
+    // converting a pixel takes a scale and a transform. Four pixels are converted at a
+    // time with SSE2 where it is available.
+    //
+    class DepthPointCloudConverter
+    {
+    public:
+        DepthPointCloudConverter(
+            _In_ const CameraUnprojectionTable& unprojectionTable,
+            _In_ const DepthPointCloudOptions& options = DepthPointCloudOptions());
+
+        const DepthPointCloudOptions& GetOptions() const;
+
+        //
+        // Converts a region of a 16-bit depth image the size of the unprojection table.
+        // The row stride is in bytes. Without a transform, the points are in camera space;
+        // otherwise they are transformed by the 4x4 row major matrix, with points as row
+        // vectors, as Windows::Foundation::Numerics::float4x4 and the recorded transforms
+        // are. HoloHands passes inverse(CameraViewTransform) * FrameToOrigin.
+        //
+        void Convert(
+            _In_ const uint16_t* depthImage,
+            _In_ size_t depthImageRowStride,
+            _In_ const DepthImageRegion& region,
+            _In_opt_ const float* cameraToWorld,
+            _Out_ DepthPointCloud& pointCloud) const;
+
+    private:
+        //
+        // Converts the rows [firstRow, endRow) of the region, relative to its top.
+        // Returns the number of valid points.
+        //
+        size_t ConvertRows(
+            _In_ const uint16_t* depthImage,
+            _In_ size_t depthImageRowStride,
+            _In_ const DepthImageRegion& region,
+            _In_ const float (&transform)[16],
+            _In_ uint32_t firstRow,
+            _In_ uint32_t endRow,
+            _Inout_ DepthPointCloud& pointCloud) const;
+
+    private:
+        uint32_t _imageWidth;
+        uint32_t _imageHeight;
+
+        DepthPointCloudOptions _options;
+
+        //
+        // The normalized ray of every pixel, row major; NaN for pixels the camera
+        // cannot map.
+        //
+        std::vector<float> _rayX;
+        std::vector<float> _rayY;
+        std::vector<float> _rayZ;
+    };
+
+    //
+    // Unprojects a handful of image points with their depths, such as the keypoints of
+    // the hands in a frame, with the math of DepthPointCloudConverter and the transform
+    // of Convert. Positions between pixels are interpolated in the unprojection table.
+    // The points are converted four at a time with SSE2 where it is available.
+    //
+    // The points are read from and written to separate arrays of count elements. Points
+    // with a depth that is not positive, or that the table cannot map, are NaN. Returns
+    // the number of valid points.
+    //
+    size_t UnprojectImagePoints(
+        _In_ const CameraUnprojectionTable& unprojectionTable,
+        _In_reads_(count) const float* u,
+        _In_reads_(count) const float* v,
+        _In_reads_(count) const float* depths,
+        _In_ size_t count,
+        _In_ float depthScale,
+        _In_opt_ const float* cameraToWorld,
+        _Out_writes_(count) float* x,
+        _Out_writes_(count) float* y,
+        _Out_writes_(count) float* z);
+}
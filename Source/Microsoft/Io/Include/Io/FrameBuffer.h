@@ -0,0 +1,557 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace Io
+{
+    //
+    // Buffer of the most recent frames of each sensor, with a fixed capacity per sensor.
+    // Frames are stored with a timestamp counting hundreds of nanoseconds, and are looked
+    // up by sensor and time. The frames of a sensor are kept in timestamp order, so
+    // lookups by time are binary searches and cost O(log capacity). TFrame must be
+    // default constructible and copyable; C++/CX handles work as well.
+    //
+    // Only the readers are lock-free. A reader pins the slot it copies from, and
+    // producers only refill slots that are neither published nor pinned, so readers
+    // never wait for a producer or for each other.
+    //
+    // Producers are not lock-free: the producers of one sensor serialize on a spin lock,
+    // which readers never touch. A producer that is preempted while holding it leaves
+    // other producers of the same sensor spinning until it runs again. Each sensor has
+    // its own ring and lock, so producers of different sensors never contend, and a
+    // sensor with a single producer never spins.
+    //
+    template <typename TFrame>
+    class FrameBuffer
+    {
+    public:
+        FrameBuffer(
+            _In_ const size_t sensorCount,
+            _In_ const size_t capacity = 5)
+            : _sensorCount(sensorCount)
+            , _capacity(capacity)
+            , _slotCount(2 * capacity + SpareSlotCount)
+            , _rings(new Ring[sensorCount])
+        {
+            REQUIRES(capacity > 0);
+
+            for (size_t i = 0; i < _sensorCount; ++i)
+            {
+                _rings[i].Initialize(
+                    _capacity,
+                    _slotCount);
+            }
+        }
+
+        size_t GetCapacity() const
+        {
+            return _capacity;
+        }
+
+        //
+        // Adds a frame, replacing the oldest frame of the sensor once the ring is full.
+        // Returns false if the sensor is out of range, if the frame is older than the
+        // latest frame of the sensor, or if every free slot is pinned by a reader. In
+        // all of these cases the frame is dropped.
+        //
+        bool Push(
+            _In_ const int32_t sensor,
+            _In_ const int64_t timestamp,
+            _In_ const TFrame& frame)
+        {
+            if (!IsValidSensor(sensor))
+            {
+                return false;
+            }
+
+            Ring& ring = _rings[sensor];
+
+            while (ring.WriterLock.test_and_set(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            if (timestamp < ring.LatestTimestamp)
+            {
+                ring.WriterLock.clear(std::memory_order_release);
+
+                return false;
+            }
+
+            const uint64_t position = ring.Count.load(std::memory_order_relaxed);
+            const size_t index = static_cast<size_t>(position % _capacity);
+
+            //
+            // Retire the frame this position replaces. Readers that pin its slot from
+            // now on will see that it is no longer published.
+            //
+            const int32_t retiredSlot = ring.Positions[index].exchange(-1);
+
+            if (retiredSlot >= 0)
+            {
+                ring.IsPublished[retiredSlot] = false;
+
+                if (0 == ring.Slots[retiredSlot].Readers.load())
+                {
+                    ring.Slots[retiredSlot].Frame = TFrame();
+                }
+            }
+
+            const int32_t slot = FindFreeSlot(ring);
+
+            if (slot >= 0)
+            {
+                ring.Slots[slot].Timestamp = timestamp;
+                ring.Slots[slot].Frame = frame;
+                ring.IsPublished[slot] = true;
+                ring.LatestTimestamp = timestamp;
+
+                ring.Positions[index].store(slot);
+                ring.Count.store(position + 1);
+            }
+
+            ring.WriterLock.clear(std::memory_order_release);
+
+            return slot >= 0;
+        }
+
+        bool GetLatestFrame(
+            _In_ const int32_t sensor,
+            _Out_ TFrame& frame) const
+        {
+            if (!IsValidSensor(sensor))
+            {
+                return false;
+            }
+
+            const Ring& ring = _rings[sensor];
+
+            uint64_t count = ring.Count.load();
+
+            while (count > 0)
+            {
+                int64_t timestamp = 0;
+
+                if (TryRead(ring, count - 1, timestamp, &frame))
+                {
+                    return true;
+                }
+
+                //
+                // Only retry if a newer frame was published in the meantime.
+                //
+                const uint64_t previousCount = count;
+
+                count = ring.Count.load();
+
+                if (count == previousCount)
+                {
+                    break;
+                }
+            }
+
+            return false;
+        }
+
+        //
+        // Finds the frame closest in time to the timestamp. Returns false if there is
+        // no frame within the tolerance.
+        //
+        bool GetFrameForTime(
+            _In_ const int32_t sensor,
+            _In_ const int64_t timestamp,
+            _In_ const float toleranceInSeconds,
+            _Out_ TFrame& frame) const
+        {
+            if (!IsValidSensor(sensor))
+            {
+                return false;
+            }
+
+            const Ring& ring = _rings[sensor];
+
+            uint64_t position = 0;
+            int64_t closestTimestamp = 0;
+
+            //
+            // The closest frame can be replaced between the search and the copy, in
+            // which case the search is repeated on the newer frames.
+            //
+            while (FindClosest(ring, timestamp, position, closestTimestamp))
+            {
+                if (std::abs(SecondsBetween(timestamp, closestTimestamp)) >= toleranceInSeconds)
+                {
+                    return false;
+                }
+
+                if (TryRead(ring, position, closestTimestamp, &frame))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        //
+        // Returns the latest timestamp of sensor a that has a frame of sensor b within
+        // the tolerance, or zero if there is no such pair.
+        //
+        int64_t GetTimestampForSensorPair(
+            _In_ const int32_t a,
+            _In_ const int32_t b,
+            _In_ const float toleranceInSeconds) const
+        {
+            const int32_t sensors[] = { a, b };
+
+            return GetTimestampForSensorSet(
+                sensors,
+                2,
+                toleranceInSeconds);
+        }
+
+        //
+        // Returns the latest timestamp of the first sensor for which every other sensor
+        // has a frame within the tolerance, or zero if there is no such timestamp. The
+        // frames themselves are then found with GetFrameForTime.
+        //
+        // The frames of the first sensor are tried from newest to oldest, and each is
+        // matched against the other sensors with a binary search. When the sensors are
+        // in sync, the newest frame matches and the cost is O(sensors * log capacity).
+        //
+        int64_t GetTimestampForSensorSet(
+            _In_reads_(sensorCount) const int32_t* sensors,
+            _In_ const size_t sensorCount,
+            _In_ const float toleranceInSeconds) const
+        {
+            if (0 == sensorCount)
+            {
+                return 0;
+            }
+
+            if (!IsValidSensor(sensors[0]))
+            {
+                return 0;
+            }
+
+            const Ring& ring = _rings[sensors[0]];
+
+            const uint64_t count = ring.Count.load();
+            const uint64_t first = count > _capacity ? count - _capacity : 0;
+
+            for (uint64_t position = count; position > first; --position)
+            {
+                int64_t timestamp = 0;
+
+                if (!TryRead(ring, position - 1, timestamp, nullptr))
+                {
+                    continue;
+                }
+
+                bool isMatch = true;
+
+                for (size_t i = 1; i < sensorCount && isMatch; ++i)
+                {
+                    uint64_t closestPosition = 0;
+                    int64_t closestTimestamp = 0;
+
+                    isMatch =
+                        IsValidSensor(sensors[i]) &&
+                        FindClosest(_rings[sensors[i]], timestamp, closestPosition, closestTimestamp) &&
+                        std::abs(SecondsBetween(timestamp, closestTimestamp)) < toleranceInSeconds;
+                }
+
+                if (isMatch)
+                {
+                    return timestamp;
+                }
+            }
+
+            return 0;
+        }
+
+        //
+        // Copies the timestamps of the frames currently buffered for the sensor,
+        // oldest first.
+        //
+        void GetTimestamps(
+            _In_ const int32_t sensor,
+            _Inout_ std::vector<int64_t>& timestamps) const
+        {
+            timestamps.clear();
+
+            if (!IsValidSensor(sensor))
+            {
+                return;
+            }
+
+            const Ring& ring = _rings[sensor];
+
+            const uint64_t count = ring.Count.load();
+            const uint64_t first = count > _capacity ? count - _capacity : 0;
+
+            for (uint64_t position = first; position < count; ++position)
+            {
+                int64_t timestamp = 0;
+
+                if (TryRead(ring, position, timestamp, nullptr))
+                {
+                    timestamps.push_back(timestamp);
+                }
+            }
+        }
+
+    private:
+        //
+        // Slots beyond twice the capacity, so that a producer finds a free slot even
+        // when several readers have pinned slots.
+        //
+        static const size_t SpareSlotCount = 4;
+
+        struct Slot
+        {
+            Slot()
+                : Readers(0)
+                , Timestamp(0)
+            {
+            }
+
+            mutable std::atomic<int32_t> Readers;
+            int64_t Timestamp;
+            TFrame Frame;
+        };
+
+        struct Ring
+        {
+            Ring()
+                : Count(0)
+                , NextSlot(0)
+                , LatestTimestamp(INT64_MIN)
+            {
+                WriterLock.clear();
+            }
+
+            void Initialize(
+                _In_ const size_t capacity,
+                _In_ const size_t slotCount)
+            {
+                Positions.reset(new std::atomic<int32_t>[capacity]);
+                Slots.reset(new Slot[slotCount]);
+                IsPublished.assign(slotCount, false);
+
+                for (size_t i = 0; i < capacity; ++i)
+                {
+                    Positions[i].store(-1);
+                }
+            }
+
+            //
+            // Number of frames published so far. Position p lives at Positions[p % capacity]
+            // until position p + capacity is published.
+            //
+            std::atomic<uint64_t> Count;
+            std::unique_ptr<std::atomic<int32_t>[]> Positions;
+            std::unique_ptr<Slot[]> Slots;
+
+            //
+            // Producer state, guarded by WriterLock.
+            //
+            std::atomic_flag WriterLock;
+            std::vector<bool> IsPublished;
+            size_t NextSlot;
+            int64_t LatestTimestamp;
+        };
+
+        bool IsValidSensor(
+            _In_ const int32_t sensor) const
+        {
+            return sensor >= 0 && static_cast<size_t>(sensor) < _sensorCount;
+        }
+
+        //
+        // Returns a slot that is neither published nor pinned by a reader, or -1.
+        //
+        int32_t FindFreeSlot(
+            _Inout_ Ring& ring) const
+        {
+            for (size_t i = 0; i < _slotCount; ++i)
+            {
+                const size_t slot = (ring.NextSlot + i) % _slotCount;
+
+                if (!ring.IsPublished[slot] && 0 == ring.Slots[slot].Readers.load())
+                {
+                    ring.NextSlot = (slot + 1) % _slotCount;
+
+                    return static_cast<int32_t>(slot);
+                }
+            }
+
+            return -1;
+        }
+
+        //
+        // Finds the buffered position whose timestamp is closest to the timestamp. The
+        // binary search starts over if one of the positions it probes is replaced.
+        //
+        bool FindClosest(
+            _In_ const Ring& ring,
+            _In_ const int64_t timestamp,
+            _Out_ uint64_t& position,
+            _Out_ int64_t& closestTimestamp) const
+        {
+            for (;;)
+            {
+                const uint64_t count = ring.Count.load();
+
+                if (0 == count)
+                {
+                    return false;
+                }
+
+                //
+                // Find the first position at or after the timestamp, or the last position.
+                // Only the oldest position can be missing without the count changing: it
+                // is being replaced, or the frame replacing it was dropped.
+                //
+                const uint64_t first = count > _capacity ? count - _capacity : 0;
+
+                uint64_t low = first;
+                uint64_t high = count - 1;
+                int64_t highTimestamp = 0;
+
+                if (!TryRead(ring, high, highTimestamp, nullptr))
+                {
+                    if (high == first)
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                bool isReplaced = false;
+
+                while (!isReplaced && low < high)
+                {
+                    const uint64_t middle = low + (high - low) / 2;
+                    int64_t middleTimestamp = 0;
+
+                    if (!TryRead(ring, middle, middleTimestamp, nullptr))
+                    {
+                        if (middle == first)
+                        {
+                            low = middle + 1;
+                        }
+                        else
+                        {
+                            isReplaced = true;
+                        }
+                    }
+                    else if (middleTimestamp < timestamp)
+                    {
+                        low = middle + 1;
+                    }
+                    else
+                    {
+                        high = middle;
+                        highTimestamp = middleTimestamp;
+                    }
+                }
+
+                if (isReplaced)
+                {
+                    continue;
+                }
+
+                position = high;
+                closestTimestamp = highTimestamp;
+
+                //
+                // The position before may be closer.
+                //
+                int64_t previousTimestamp = 0;
+
+                if (position > first &&
+                    TryRead(ring, position - 1, previousTimestamp, nullptr) &&
+                    timestamp - previousTimestamp < closestTimestamp - timestamp)
+                {
+                    --position;
+                    closestTimestamp = previousTimestamp;
+                }
+
+                return true;
+            }
+        }
+
+        //
+        // Copies the timestamp, and the frame if requested, published at the position.
+        // Returns false if the position has been replaced or was never published.
+        //
+        // The reader count and the published position are both sequentially consistent,
+        // so either the producer sees the pin and leaves the slot alone, or the reader
+        // sees that the slot is no longer published and does not touch it.
+        //
+        bool TryRead(
+            _In_ const Ring& ring,
+            _In_ const uint64_t position,
+            _Out_ int64_t& timestamp,
+            _Out_opt_ TFrame* frame) const
+        {
+            const size_t index = static_cast<size_t>(position % _capacity);
+            const int32_t slot = ring.Positions[index].load();
+
+            if (slot < 0)
+            {
+                return false;
+            }
+
+            const Slot& pinnedSlot = ring.Slots[slot];
+
+            pinnedSlot.Readers.fetch_add(1);
+
+            const bool isPublished =
+                ring.Positions[index].load() == slot &&
+                ring.Count.load() <= position + _capacity;
+
+            if (isPublished)
+            {
+                timestamp = pinnedSlot.Timestamp;
+
+                if (nullptr != frame)
+                {
+                    *frame = pinnedSlot.Frame;
+                }
+            }
+
+            pinnedSlot.Readers.fetch_sub(1, std::memory_order_release);
+
+            return isPublished;
+        }
+
+        static double SecondsBetween(
+            _In_ const int64_t a,
+            _In_ const int64_t b)
+        {
+            return (a - b) * 1e-7;
+        }
+
+    private:
+        const size_t _sensorCount;
+        const size_t _capacity;
+        const size_t _slotCount;
+
+        std::unique_ptr<Ring[]> _rings;
+    };
+}
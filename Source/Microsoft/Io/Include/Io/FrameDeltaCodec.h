@@ -0,0 +1,162 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Lossless temporal delta compression for frames of a mostly static scene.
+    //
+    // A delta frame holds the difference of every sample to the same sample of the
+    // previous frame, written as zigzag encoded tokens like the depth codec's residuals,
+    // so the unchanged parts of the image collapse into runs of zero residuals. Samples
+    // are 16-bit for images with two bytes per pixel, and bytes otherwise.
+    //
+    // Every keyframeInterval frames, and whenever a delta would not be smaller than the
+    // image, the encoder produces a keyframe instead, which the caller sends as it would
+    // without delta compression, marked with SetDeltaKeyframe. Decoding can start at any
+    // keyframe. Recordings store keyframes as image files without a frame stream header;
+    // their readers mark the keyframes themselves.
+    //
+
+    //
+    // Upper bound of the encoded length of a delta frame.
+    //
+    size_t GetMaxEncodedFrameDeltaLength(
+        _In_ const uint32_t width,
+        _In_ const uint32_t height,
+        _In_ const uint32_t pixelStride);
+
+    //
+    // Encodes the difference of the image to the previous image, both with rows rowStride
+    // bytes apart, into the buffer, which must hold GetMaxEncodedFrameDeltaLength bytes.
+    // Returns the encoded length.
+    //
+    size_t EncodeFrameDelta(
+        _In_ const uint8_t* image,
+        _In_ const uint8_t* previousImage,
+        _In_ const uint32_t width,
+        _In_ const uint32_t height,
+        _In_ const uint32_t pixelStride,
+        _In_ const uint32_t rowStride,
+        _Out_ uint8_t* encodedImage);
+
+    //
+    // Decodes a delta frame encoded by EncodeFrameDelta against the previous image. The
+    // image may be the previous image, which is then updated in place. Returns false if
+    // the delta frame is corrupt or does not have the given dimensions.
+    //
+    bool DecodeFrameDelta(
+        _In_ const uint8_t* encodedImage,
+        _In_ const size_t encodedImageLength,
+        _In_ const uint8_t* previousImage,
+        _In_ const uint32_t width,
+        _In_ const uint32_t height,
+        _In_ const uint32_t pixelStride,
+        _In_ const uint32_t rowStride,
+        _Out_ uint8_t* image);
+
+    //
+    // Returns true if the frame can be decoded without the frames before it.
+    //
+    bool IsKeyframe(
+        _In_ const FrameStreamHeader& header);
+
+    //
+    // Returns true if the frame is a keyframe that delta frames follow.
+    //
+    bool IsDeltaKeyframe(
+        _In_ const FrameStreamHeader& header);
+
+    //
+    // Marks a keyframe the encoder chose, after its codec was set, so the decoder keeps
+    // it for the delta frames that follow. Switches the header to version 0.2, as an
+    // uncompressed frame without the codec extension cannot be marked.
+    //
+    void SetDeltaKeyframe(
+        _Inout_ FrameStreamHeader& header);
+
+    //
+    // Chooses between keyframes and delta frames for one stream of frames, and keeps the
+    // previous frame to encode the next delta against. A stream whose receiver may miss
+    // frames, such as a client with a drop policy, needs an encoder of its own.
+    //
+    class FrameDeltaEncoder
+    {
+    public:
+        //
+        // A keyframe interval of 1 makes every frame a keyframe.
+        //
+        FrameDeltaEncoder(
+            _In_ const uint32_t keyframeInterval);
+
+        uint32_t GetKeyframeInterval() const;
+
+        //
+        // Encodes the image described by the header as a delta frame and returns true,
+        // or returns false if the image is to be sent as a keyframe. Either way, the
+        // image becomes the previous frame of the next call.
+        //
+        bool Encode(
+            _In_ const FrameStreamHeader& header,
+            _In_ const uint8_t* image,
+            _Inout_ std::vector<uint8_t>& encodedImage);
+
+        //
+        // Makes the next frame a keyframe, for instance after the receiver lost a frame.
+        //
+        void RequestKeyframe();
+
+    private:
+        uint32_t _keyframeInterval;
+        uint32_t _framesSinceKeyframe;
+        bool _isKeyframeRequested;
+
+        FrameStreamHeader _previousHeader;
+        std::vector<uint8_t> _previousImage;
+    };
+
+    //
+    // Decodes the frames of one stream, whatever their codec. Delta frames and the
+    // keyframes marked with SetDeltaKeyframe are kept to apply the next delta frame to;
+    // other frames are not copied.
+    //
+    class FrameDeltaDecoder
+    {
+    public:
+        FrameDeltaDecoder();
+
+        //
+        // Decodes the payload of the frame described by the header into the image, which
+        // must hold ImageHeight * RowStride bytes and may be the payload of an uncompressed
+        // frame. Returns false if the payload is corrupt, or if a delta frame arrives
+        // before a keyframe; decoding then resumes at the next keyframe.
+        //
+        bool Decode(
+            _In_ const FrameStreamHeader& header,
+            _In_ const uint8_t* payload,
+            _In_ const size_t payloadLength,
+            _Out_ uint8_t* image);
+
+        //
+        // Forgets the previous frame, so decoding resumes at the next keyframe. Call this
+        // after seeking.
+        //
+        void Reset();
+
+    private:
+        bool _hasPreviousImage;
+
+        FrameStreamHeader _previousHeader;
+        std::vector<uint8_t> _previousImage;
+    };
+}
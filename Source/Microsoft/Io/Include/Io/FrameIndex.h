@@ -0,0 +1,135 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Format of a file recorded by the sensor frame recorder.
+    //
+    enum class FrameFileFormat : uint8_t
+    {
+        Unknown = 0,
+
+        //
+        // Binary PGM with 8-bit samples.
+        //
+        Gray8 = 1,
+
+        //
+        // Binary PGM with 16-bit big endian samples.
+        //
+        Gray16 = 2,
+
+        //
+        // Binary PPM with 8-bit RGB samples.
+        //
+        Rgb8 = 3,
+
+        //
+        // A frame stream header with the Delta codec followed by the difference to the
+        // frame before, see RecordedFrameReader.h.
+        //
+        Delta = 4
+    };
+
+    //
+    // Where a recorded frame is in its tarball.
+    //
+    struct FrameIndexEntry
+    {
+        FrameIndexEntry();
+
+        uint64_t Timestamp;
+
+        //
+        // Byte offset of the file data, after its TAR header, from the start of the tarball.
+        //
+        uint64_t Offset;
+
+        uint32_t Size;
+        FrameFileFormat Format;
+    };
+
+    //
+    // The sidecar index the recorder writes next to each tarball: a header, followed by
+    // one fixed length entry per recorded file in archive order, so in timestamp order.
+    // All fields are stored in little endian byte order, without padding.
+    //
+    struct FrameIndex
+    {
+        static const uint32_t FileCookie = 0x58444948; // "HIDX"
+        static const uint16_t FileVersion = 1;
+
+        static const size_t HeaderLength =
+            sizeof(uint32_t) /* Cookie */ +
+            2 * sizeof(uint16_t) /* Version, EntryLength */;
+
+        static const size_t EntryLength =
+            2 * sizeof(uint64_t) /* Timestamp, Offset */ +
+            sizeof(uint32_t) /* Size */ +
+            sizeof(uint8_t) /* Format */ +
+            3 * sizeof(uint8_t) /* Reserved */;
+
+        static const char* const FileExtension;
+
+        //
+        // Replaces the extension of a tarball file name with the index extension, such
+        // as "short_throw_depth.tar" with "short_throw_depth.idx".
+        //
+        static std::string GetFileName(
+            _In_ const std::string& tarballFileName);
+    };
+
+    //
+    // Determines the format of a recorded file from its name and first bytes.
+    //
+    FrameFileFormat GetFrameFileFormat(
+        _In_ const std::string& fileName,
+        _In_reads_(fileSize) const uint8_t* fileData,
+        _In_ const size_t fileSize);
+
+    bool IsKeyframe(
+        _In_ const FrameIndexEntry& entry);
+
+    //
+    // Reads a sidecar index. Returns false if the file does not exist or is not an
+    // index. A truncated last entry, left by a recording that did not stop, is ignored.
+    //
+    bool ReadFrameIndex(
+        _In_ const std::string& indexFileName,
+        _Out_ std::vector<FrameIndexEntry>& entries);
+
+    //
+    // Writes a sidecar index, one entry per file added to the tarball.
+    //
+    class FrameIndexWriter
+    {
+    public:
+        FrameIndexWriter(
+            _In_ const std::string& indexFileName);
+
+#if defined(_WIN32)
+        FrameIndexWriter(
+            _In_ const std::wstring& indexFileName);
+#endif /* defined(_WIN32) */
+
+        void Add(
+            _In_ const FrameIndexEntry& entry);
+
+    private:
+        void WriteHeader();
+
+    private:
+        std::ofstream _file;
+    };
+}
@@ -0,0 +1,182 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <deque>
+
+namespace Io
+{
+    //
+    // What a streaming client's queue does with frames it cannot send right away.
+    //
+    enum class FrameDropPolicy
+    {
+        //
+        // Only the newest frame is kept; a new frame replaces the one waiting to be sent.
+        //
+        LatestOnly,
+
+        //
+        // Only every Nth frame is queued; frames arriving with a full queue are dropped.
+        //
+        KeepEveryNth,
+
+        //
+        // Every frame is queued. A client whose queue overflows has fallen too far behind
+        // to ever catch up and must be disconnected.
+        //
+        Lossless
+    };
+
+    struct FrameSendPolicy
+    {
+        FrameSendPolicy()
+            : DropPolicy(FrameDropPolicy::LatestOnly)
+            , KeepEveryNth(1)
+            , Capacity(1)
+        {
+        }
+
+        FrameSendPolicy(
+            _In_ const FrameDropPolicy dropPolicy,
+            _In_ const uint32_t keepEveryNth,
+            _In_ const size_t capacity)
+            : DropPolicy(dropPolicy)
+            , KeepEveryNth(keepEveryNth)
+            , Capacity(capacity)
+        {
+        }
+
+        FrameDropPolicy DropPolicy;
+        uint32_t KeepEveryNth;
+        size_t Capacity;
+    };
+
+    enum class FrameQueueResult
+    {
+        Queued,
+        Dropped,
+        Overflow
+    };
+
+    //
+    // Bounded queue of the frames waiting to be sent to one streaming client. Each
+    // client has its own queue, so a slow client only loses its own frames. Not thread
+    // safe; the owner of the client serializes access.
+    //
+    template <typename TFrame>
+    class FrameSendQueue
+    {
+    public:
+        FrameSendQueue(
+            _In_ const FrameSendPolicy& policy)
+            : _policy(policy)
+            , _offeredCount(0)
+            , _droppedCount(0)
+        {
+            REQUIRES(policy.KeepEveryNth > 0);
+            REQUIRES(policy.Capacity > 0);
+        }
+
+        const FrameSendPolicy& GetPolicy() const
+        {
+            return _policy;
+        }
+
+        FrameQueueResult Push(
+            _In_ const TFrame& frame)
+        {
+            const uint64_t index = _offeredCount++;
+
+            switch (_policy.DropPolicy)
+            {
+            case FrameDropPolicy::LatestOnly:
+                _droppedCount += _frames.size();
+                _frames.clear();
+                break;
+
+            case FrameDropPolicy::KeepEveryNth:
+                if (0 != index % _policy.KeepEveryNth ||
+                    _frames.size() >= _policy.Capacity)
+                {
+                    ++_droppedCount;
+
+                    return FrameQueueResult::Dropped;
+                }
+                break;
+
+            case FrameDropPolicy::Lossless:
+                if (_frames.size() >= _policy.Capacity)
+                {
+                    ++_droppedCount;
+
+                    return FrameQueueResult::Overflow;
+                }
+                break;
+            }
+
+            _frames.push_back(frame);
+
+            return FrameQueueResult::Queued;
+        }
+
+        bool Pop(
+            _Out_ TFrame& frame)
+        {
+            if (_frames.empty())
+            {
+                return false;
+            }
+
+            frame = _frames.front();
+
+            _frames.pop_front();
+
+            return true;
+        }
+
+        bool IsEmpty() const
+        {
+            return _frames.empty();
+        }
+
+        size_t GetSize() const
+        {
+            return _frames.size();
+        }
+
+        //
+        // Drops the queued frames, such as when the client disconnected.
+        //
+        void Clear()
+        {
+            _droppedCount += _frames.size();
+            _frames.clear();
+        }
+
+        uint64_t GetOfferedCount() const
+        {
+            return _offeredCount;
+        }
+
+        uint64_t GetDroppedCount() const
+        {
+            return _droppedCount;
+        }
+
+    private:
+        FrameSendPolicy _policy;
+        std::deque<TFrame> _frames;
+        uint64_t _offeredCount;
+        uint64_t _droppedCount;
+    };
+}
@@ -0,0 +1,154 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace Io
+{
+    //
+    // How the image rows that follow a frame stream header are encoded.
+    //
+    enum class FrameCodec : uint16_t
+    {
+        None = 0,
+
+        //
+        // Lossless 16-bit depth compression, see DepthCodec.h.
+        //
+        Depth = 1,
+
+        //
+        // Difference to the previous frame of the stream, see FrameDeltaCodec.h. Frames
+        // with any other codec are keyframes, which can be decoded on their own; the ones
+        // delta frames follow carry FrameStreamHeader::DeltaKeyframeFlag.
+        //
+        Delta = 2
+    };
+
+    //
+    // Network header that precedes every frame sent by the sensor frame streaming server.
+    // All fields are stored in little endian byte order, without padding.
+    //
+    // Version 0.2 appends the codec and the length of the encoded image to the version
+    // 0.1 header. Frames sent without a codec keep the version 0.1 header, so receivers
+    // that predate codecs can still read them.
+    //
+    struct FrameStreamHeader
+    {
+        static const uint32_t ProtocolCookie = 0x484c524d;
+        static const uint8_t ProtocolVersionMajor = 0x00;
+        static const uint8_t ProtocolVersionMinor = 0x02;
+        static const uint8_t ProtocolVersionMinorUncompressed = 0x01;
+
+        //
+        // Length of the version 0.1 header, which starts every version of the header.
+        //
+        static const size_t EncodedLength =
+            sizeof(uint32_t) /* Cookie */ +
+            2 * sizeof(uint8_t) /* VersionMajor, VersionMinor */ +
+            sizeof(uint16_t) /* FrameType */ +
+            sizeof(uint64_t) /* Timestamp */ +
+            4 * sizeof(uint32_t) /* ImageWidth, ImageHeight, PixelStride, RowStride */;
+
+        static const size_t CodecExtensionLength =
+            2 * sizeof(uint16_t) /* Codec, Flags */ +
+            sizeof(uint32_t) /* PayloadLength */;
+
+        //
+        // Flag of a keyframe that delta frames follow, see FrameDeltaCodec.h. Receivers
+        // only keep a copy of the frames marked with it.
+        //
+        static const uint16_t DeltaKeyframeFlag = 0x0001;
+
+        static const size_t MaxEncodedLength =
+            EncodedLength + CodecExtensionLength;
+
+        //
+        // Largest image a header may describe, well above the 1280x720 BGRA frames of
+        // the photo/video camera. Receivers reject larger images before allocating them.
+        //
+        static const size_t MaxImageLength = 64 * 1024 * 1024;
+
+        FrameStreamHeader();
+
+        uint32_t Cookie;
+        uint8_t VersionMajor;
+        uint8_t VersionMinor;
+        uint16_t FrameType;
+        uint64_t Timestamp;
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+        uint32_t PixelStride;
+        uint32_t RowStride;
+        FrameCodec Codec;
+        uint16_t Flags;
+        uint32_t PayloadLength;
+    };
+
+    //
+    // Returns true if the header version includes the codec extension.
+    //
+    bool HasCodecExtension(
+        _In_ const FrameStreamHeader& header);
+
+    //
+    // Number of bytes EncodeFrameStreamHeader writes for the header.
+    //
+    size_t GetEncodedLength(
+        _In_ const FrameStreamHeader& header);
+
+    //
+    // Number of bytes of image data that follow the header.
+    //
+    size_t GetPayloadLength(
+        _In_ const FrameStreamHeader& header);
+
+    //
+    // Returns true if each image row of ImageWidth pixels of PixelStride bytes fits in
+    // RowStride bytes, the image is no larger than FrameStreamHeader::MaxImageLength,
+    // and the payload is no longer than the header's codec can produce for the image.
+    // The fields come from the network or a file, so check this before allocating
+    // anything for the image or the payload.
+    //
+    bool IsValidImageLayout(
+        _In_ const FrameStreamHeader& header);
+
+    //
+    // Switches the header to version 0.2, with the codec and the encoded image length,
+    // and clears its flags.
+    //
+    void SetFrameCodec(
+        _Inout_ FrameStreamHeader& header,
+        _In_ const FrameCodec codec,
+        _In_ const uint32_t payloadLength);
+
+    //
+    // Writes the header to the buffer, which must hold GetEncodedLength(header) bytes.
+    //
+    void EncodeFrameStreamHeader(
+        _In_ const FrameStreamHeader& header,
+        _Out_ uint8_t* buffer);
+
+    //
+    // Reads the first FrameStreamHeader::EncodedLength bytes of the header, which are
+    // the same for every version, from the buffer. If HasCodecExtension is then true,
+    // the FrameStreamHeader::CodecExtensionLength bytes that follow are read with
+    // DecodeFrameStreamHeaderCodecExtension. Returns false if the buffer is too short.
+    //
+    bool DecodeFrameStreamHeader(
+        _In_ const uint8_t* buffer,
+        _In_ const size_t bufferLength,
+        _Out_ FrameStreamHeader& header);
+
+    bool DecodeFrameStreamHeaderCodecExtension(
+        _In_ const uint8_t* buffer,
+        _In_ const size_t bufferLength,
+        _Inout_ FrameStreamHeader& header);
+}
@@ -0,0 +1,149 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <memory>
+
+namespace Io
+{
+    struct FrameStreamClientStatistics
+    {
+        uint64_t SentFrameCount;
+        uint64_t DroppedFrameCount;
+    };
+
+    //
+    // Streams frames to any number of clients over TCP with the frame stream protocol:
+    // a FrameStreamHeader followed by the image rows. This is the POSIX counterpart of
+    // HoloLensForCV::SensorFrameStreamingServer, used to stream recordings from Linux.
+    //
+    // Frames are not copied. Every client has its own thread and its own bounded queue
+    // with its own drop policy, so a slow client only loses its own frames. A frame is
+    // sent with a single scatter-gather send of the header and the pixel memory, and is
+    // kept alive through its owner until every client has sent or dropped it.
+    //
+    class FrameStreamServer
+    {
+    public:
+        FrameStreamServer();
+
+        ~FrameStreamServer();
+
+        //
+        // Listens on the port, on all interfaces. Pass port 0 to let the system choose
+        // a port, which GetPort then returns.
+        //
+        bool Listen(
+            _In_ const uint16_t port);
+
+        uint16_t GetPort() const;
+
+        //
+        // Waits for a client to connect and starts streaming to it with the policy.
+        //
+        bool Accept(
+            _In_ const FrameSendPolicy& policy = FrameSendPolicy());
+
+        size_t GetClientCount() const;
+
+        //
+        // Statistics of the connected clients, in the order they connected.
+        //
+        std::vector<FrameStreamClientStatistics> GetClientStatistics() const;
+
+        //
+        // Queues the frame for every client. The data must stay valid until owner is
+        // released, which happens once every client has sent or dropped the frame.
+        // Returns false if no client queued the frame.
+        //
+        bool Send(
+            _In_ const FrameStreamHeader& header,
+            _In_ const uint8_t* data,
+            _In_ const size_t dataLength,
+            _In_ std::shared_ptr<const void> owner);
+
+        //
+        // Waits until every client has sent the frames in its queue, for at most the
+        // timeout in total. Clients still sending at the deadline have stopped reading
+        // or cannot keep up, and are disconnected. Returns false if any client was.
+        //
+        bool Flush(
+            _In_ const uint32_t timeoutMilliseconds = DefaultFlushTimeoutMilliseconds);
+
+        static const uint32_t DefaultFlushTimeoutMilliseconds = 5000;
+
+        //
+        // Disconnects the clients and stops accepting new ones.
+        //
+        void Close();
+
+    private:
+        struct Frame;
+        struct Client;
+
+        void RemoveDisconnectedClients();
+
+    private:
+        int _listener;
+        uint16_t _port;
+
+        mutable std::mutex _mutex;
+        std::vector<std::shared_ptr<Client>> _clients;
+    };
+
+    //
+    // Receives frames sent by a frame stream server.
+    //
+    class FrameStreamClient
+    {
+    public:
+        FrameStreamClient();
+
+        ~FrameStreamClient();
+
+        //
+        // Connects to the server at the IPv4 address, such as "127.0.0.1".
+        //
+        bool Connect(
+            _In_ const std::string& address,
+            _In_ const uint16_t port);
+
+        //
+        // Receives the next frame into data, reusing its capacity, and decodes it if it
+        // was compressed. Returns false if the connection was closed, or if the frame
+        // could not be read.
+        //
+        bool Receive(
+            _Out_ FrameStreamHeader& header,
+            _Inout_ std::vector<uint8_t>& data);
+
+        void Close();
+
+    private:
+        bool ReceiveAll(
+            _Out_ uint8_t* buffer,
+            _In_ const size_t length);
+
+    private:
+        int _socket;
+
+        //
+        // Compressed image, before it is decoded.
+        //
+        std::vector<uint8_t> _payload;
+
+        //
+        // Keeps the previous image, which delta frames are applied to.
+        //
+        FrameDeltaDecoder _decoder;
+    };
+}
@@ -0,0 +1,228 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Hands frames from the thread they arrive on to a writer thread, as the sensor
+    // frame recorder does, so the arrival thread never waits for I/O.
+    //
+    // Push only queues the frame. The writer thread takes every queued frame at once
+    // and writes the batch with the queue unlocked. Stop lets it write the frames
+    // still queued before it exits. Frames arriving while the queue is full are
+    // dropped and counted, as the queue is lossless up to its capacity.
+    //
+    template <typename TFrame>
+    class FrameWriterQueue
+    {
+    public:
+        //
+        // Writes one frame on the writer thread. Returns false if the frame could not
+        // be written; it then does not count as written.
+        //
+        typedef std::function<bool(const TFrame&)> FrameWriter;
+
+        FrameWriterQueue(
+            _In_ const size_t capacity)
+            : _queue(FrameSendPolicy(FrameDropPolicy::Lossless, 1, capacity))
+            , _isWriting(false)
+            , _highWaterMark(0)
+            , _writtenCount(0)
+        {
+        }
+
+        ~FrameWriterQueue()
+        {
+            Stop();
+        }
+
+        //
+        // Starts the writer thread, with fresh statistics.
+        //
+        void Start(
+            _In_ FrameWriter writeFrame)
+        {
+            REQUIRES(!_writerThread.joinable());
+
+            {
+                std::lock_guard<std::mutex> queueGuard(_queueMutex);
+
+                _queue = FrameSendQueue<TFrame>(_queue.GetPolicy());
+                _highWaterMark = 0;
+                _writtenCount = 0;
+                _isWriting = true;
+            }
+
+            _writerThread = std::thread(
+                [this, writeFrame]()
+                {
+                    WriteFrames(writeFrame);
+                });
+        }
+
+        //
+        // Lets the writer thread write the frames still queued, then waits for it.
+        // Returns false if it was not running.
+        //
+        bool Stop()
+        {
+            {
+                std::lock_guard<std::mutex> queueGuard(_queueMutex);
+
+                _isWriting = false;
+            }
+
+            _frameQueued.notify_one();
+
+            if (!_writerThread.joinable())
+            {
+                return false;
+            }
+
+            _writerThread.join();
+
+            return true;
+        }
+
+        bool IsWriting() const
+        {
+            std::lock_guard<std::mutex> queueGuard(_queueMutex);
+
+            return _isWriting;
+        }
+
+        //
+        // Queues the frame for the writer thread. Returns false if the frame was not
+        // queued, because the writer is stopped or too far behind.
+        //
+        bool Push(
+            _In_ const TFrame& frame)
+        {
+            {
+                std::lock_guard<std::mutex> queueGuard(_queueMutex);
+
+                if (!_isWriting ||
+                    FrameQueueResult::Queued != _queue.Push(frame))
+                {
+                    return false;
+                }
+
+                _highWaterMark = std::max(
+                    _highWaterMark,
+                    _queue.GetSize());
+            }
+
+            _frameQueued.notify_one();
+
+            return true;
+        }
+
+        //
+        // Statistics of the current or last run of the writer thread.
+        //
+        uint64_t GetWrittenCount() const
+        {
+            return _writtenCount;
+        }
+
+        //
+        // Frames dropped because the writer thread fell too far behind.
+        //
+        uint64_t GetDroppedCount() const
+        {
+            std::lock_guard<std::mutex> queueGuard(_queueMutex);
+
+            return _queue.GetDroppedCount();
+        }
+
+        //
+        // The most frames that waited for the writer thread at once.
+        //
+        size_t GetHighWaterMark() const
+        {
+            std::lock_guard<std::mutex> queueGuard(_queueMutex);
+
+            return _highWaterMark;
+        }
+
+    private:
+        void WriteFrames(
+            _In_ const FrameWriter& writeFrame)
+        {
+            std::vector<TFrame> batch;
+
+            for (;;)
+            {
+                //
+                // Take every queued frame at once, so the queue lock is released while
+                // the whole batch is written.
+                //
+                {
+                    std::unique_lock<std::mutex> queueLock(_queueMutex);
+
+                    _frameQueued.wait(
+                        queueLock,
+                        [this]()
+                        {
+                            return !_isWriting || !_queue.IsEmpty();
+                        });
+
+                    TFrame frame;
+
+                    while (_queue.Pop(frame))
+                    {
+                        batch.push_back(frame);
+                    }
+
+                    //
+                    // Stop drains the queue before the thread exits.
+                    //
+                    if (batch.empty())
+                    {
+                        return;
+                    }
+                }
+
+                for (const TFrame& frame : batch)
+                {
+                    if (writeFrame(frame))
+                    {
+                        ++_writtenCount;
+                    }
+                }
+
+                //
+                // Release the written frames before waiting for the next ones.
+                //
+                batch.clear();
+            }
+        }
+
+    private:
+        mutable std::mutex _queueMutex;
+        std::condition_variable _frameQueued;
+        FrameSendQueue<TFrame> _queue;
+        bool _isWriting;
+        size_t _highWaterMark;
+        std::atomic<uint64_t> _writtenCount;
+        std::thread _writerThread;
+    };
+}
@@ -0,0 +1,93 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // A recorded file as it is stored in the tarball.
+    //
+    struct RecordedFrame
+    {
+        uint64_t Timestamp;
+        FrameFileFormat Format;
+
+        //
+        // Points into the mapped tarball, valid as long as the reader.
+        //
+        const uint8_t* Data;
+        size_t Size;
+    };
+
+    //
+    // Random access to the frames of a recorded tarball. The tarball is memory mapped
+    // and frames are looked up by ordinal or timestamp in its sidecar index, without
+    // reading or copying the frames before them.
+    //
+    // Recordings without an index, such as those made before the recorder wrote one,
+    // are indexed once by walking the TAR headers of the mapped tarball. Index entries
+    // past the end of the tarball, left by a recording that did not stop, are ignored.
+    //
+    // Delta frames are returned as they are stored; decode them with a
+    // FrameDeltaDecoder from the keyframe FindKeyframe returns, or read them with
+    // RecordedFrameReader.
+    //
+    class IndexedFrameReader
+    {
+    public:
+        IndexedFrameReader(
+            _In_ const std::string& tarballFileName);
+
+        bool IsOpen() const;
+
+        //
+        // True if the frames were indexed from the sidecar index file rather than by
+        // walking the tarball.
+        //
+        bool HasSidecarIndex() const;
+
+        size_t GetFrameCount() const;
+
+        const std::vector<FrameIndexEntry>& GetEntries() const;
+
+        RecordedFrame GetFrame(
+            _In_ const size_t ordinal) const;
+
+        //
+        // Ordinal of the last frame recorded at or before the timestamp, or of the first
+        // frame if they are all later. The reader must not be empty.
+        //
+        size_t FindFrame(
+            _In_ const uint64_t timestamp) const;
+
+        //
+        // Ordinal of the last keyframe at or before the frame, or of the first keyframe
+        // if there is none before it. Returns GetFrameCount() if there are no keyframes.
+        //
+        size_t FindKeyframe(
+            _In_ const size_t ordinal) const;
+
+    private:
+        void IndexTarball();
+
+    private:
+        MappedFile _tarball;
+        bool _hasSidecarIndex;
+
+        std::vector<FrameIndexEntry> _entries;
+
+        //
+        // Ordinals of the keyframes, in ascending order.
+        //
+        std::vector<size_t> _keyframes;
+    };
+}
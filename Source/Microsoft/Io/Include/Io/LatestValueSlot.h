@@ -0,0 +1,93 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <atomic>
+
+namespace Io
+{
+    //
+    // Lock-free single producer, single consumer slot holding the latest published value.
+    //
+    // Implemented as a triple buffer: the producer fills the back buffer and publishes it,
+    // the consumer picks up the most recent published buffer without ever waiting on the
+    // producer. Values that are not picked up before the next publish are overwritten,
+    // so the consumer only ever sees the newest one. Buffers are reused, so values that
+    // own memory (such as cv::Mat) do not reallocate once they have reached their size.
+    //
+    template <typename T>
+    class LatestValueSlot
+    {
+    public:
+        LatestValueSlot()
+            : _backIndex(0)
+            , _middleIndex(1)
+            , _frontIndex(2)
+        {
+        }
+
+        //
+        // Producer: the buffer to fill before calling Publish.
+        //
+        T& GetBackBuffer()
+        {
+            return _buffers[_backIndex];
+        }
+
+        //
+        // Producer: makes the back buffer available to the consumer.
+        //
+        void Publish()
+        {
+            _backIndex =
+                _middleIndex.exchange(_backIndex | FreshFlag, std::memory_order_acq_rel) & IndexMask;
+        }
+
+        //
+        // Consumer: swaps in the most recently published value, if there is one.
+        // Returns false if nothing was published since the previous call.
+        //
+        bool Update()
+        {
+            if (0 == (_middleIndex.load(std::memory_order_relaxed) & FreshFlag))
+            {
+                return false;
+            }
+
+            _frontIndex =
+                _middleIndex.exchange(_frontIndex, std::memory_order_acq_rel) & IndexMask;
+
+            return true;
+        }
+
+        //
+        // Consumer: the value picked up by the last successful call to Update.
+        //
+        T& GetFrontBuffer()
+        {
+            return _buffers[_frontIndex];
+        }
+
+    private:
+        static const int32_t IndexMask = 0x3;
+        static const int32_t FreshFlag = 0x4;
+
+        T _buffers[3];
+
+        //
+        // The producer and consumer indices are only touched by their own thread.
+        // Keep them on separate cache lines to avoid false sharing.
+        //
+        alignas(64) int32_t _backIndex;
+        alignas(64) std::atomic<int32_t> _middleIndex;
+        alignas(64) int32_t _frontIndex;
+    };
+}
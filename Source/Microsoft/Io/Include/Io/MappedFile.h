@@ -0,0 +1,48 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Maps a whole file into memory for reading.
+    //
+    class MappedFile
+    {
+    public:
+        MappedFile(
+            _In_ const std::string& fileName);
+
+        ~MappedFile();
+
+        bool IsOpen() const;
+
+        const uint8_t* GetData() const;
+
+        size_t GetSize() const;
+
+    private:
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+    private:
+#if defined(_WIN32)
+        HANDLE _file;
+        HANDLE _mapping;
+#else
+        int _file;
+#endif /* defined(_WIN32) */
+
+        const uint8_t* _data;
+        size_t _size;
+    };
+}
@@ -0,0 +1,108 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace Io
+{
+    //
+    // The transforms the recorder saves for a frame, as 4x4 row major matrices.
+    //
+    struct RecordedFrameMetadata
+    {
+        float FrameToOrigin[16];
+        float CameraViewTransform[16];
+        float CameraProjectionTransform[16];
+    };
+
+    struct PoseLogRecord
+    {
+        PoseLogRecord();
+
+        uint64_t Timestamp;
+
+        //
+        // Byte offset of the frame's file data in the tarball, as in its FrameIndexEntry.
+        //
+        uint64_t Offset;
+
+        RecordedFrameMetadata Metadata;
+    };
+
+    //
+    // The binary pose log the recorder writes next to each tarball, in place of the
+    // CSV file: a header, followed by one fixed length record per recorded frame. All
+    // fields are stored in little endian byte order, without padding; the matrices
+    // as IEEE 754 single precision floats. Tools/PoseLogToCsv converts it to the CSV
+    // file the recorder used to write.
+    //
+    struct PoseLog
+    {
+        static const uint32_t FileCookie = 0x534f5048; // "HPOS"
+        static const uint16_t FileVersion = 1;
+
+        static const size_t HeaderLength =
+            sizeof(uint32_t) /* Cookie */ +
+            2 * sizeof(uint16_t) /* Version, RecordLength */;
+
+        static const size_t RecordLength =
+            2 * sizeof(uint64_t) /* Timestamp, Offset */ +
+            3 * 16 * sizeof(float) /* FrameToOrigin, CameraViewTransform, CameraProjectionTransform */;
+
+        static const char* const FileExtension;
+
+        //
+        // Replaces the extension of a tarball file name with the pose log extension,
+        // such as "short_throw_depth.tar" with "short_throw_depth.pose".
+        //
+        static std::string GetFileName(
+            _In_ const std::string& tarballFileName);
+    };
+
+    //
+    // Reads a pose log. Returns false if the file does not exist or is not a pose log.
+    // A truncated last record, left by a recording that did not stop, is ignored.
+    //
+    bool ReadPoseLog(
+        _In_ const std::string& poseLogFileName,
+        _Out_ std::vector<PoseLogRecord>& records);
+
+    //
+    // Appends records to a pose log. The records are encoded into a buffer that is
+    // written once it holds BufferedRecordCount records, by Flush, and on destruction.
+    //
+    class PoseLogWriter
+    {
+    public:
+        static const size_t BufferedRecordCount = 256;
+
+        PoseLogWriter(
+            _In_ const std::string& poseLogFileName);
+
+#if defined(_WIN32)
+        PoseLogWriter(
+            _In_ const std::wstring& poseLogFileName);
+#endif /* defined(_WIN32) */
+
+        ~PoseLogWriter();
+
+        void Add(
+            _In_ const PoseLogRecord& record);
+
+        void Flush();
+
+    private:
+        void WriteHeader();
+
+    private:
+        std::ofstream _file;
+        std::vector<uint8_t> _buffer;
+    };
+}
@@ -0,0 +1,101 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Reads the frames of a tarball recorded by the sensor frame recorder, decoding delta
+    // frames, and seeks to keyframes for random access.
+    //
+    // Keyframes are recorded as binary PGM or PPM files. With a keyframe interval set,
+    // the frames in between are recorded as ".delta" files, which hold a frame stream
+    // header with the Delta codec followed by the difference to the pixels of the frame
+    // before. Recordings without delta frames read like they do with TarReader.
+    //
+    class RecordedFrameReader
+    {
+    public:
+        static const char* const DeltaFileExtension;
+
+        RecordedFrameReader(
+            _In_ const std::string& tarballFileName);
+
+        bool IsOpen() const;
+
+        //
+        // Reads the next frame into fileData as a PGM or PPM file, reusing its capacity.
+        // The file name is the recorded one, so a delta frame keeps its extension.
+        // Returns false at the end of the archive, or if a delta frame cannot be decoded,
+        // for instance when the reader was not positioned at a keyframe.
+        //
+        bool ReadNext(
+            _Out_ std::string& fileName,
+            _Inout_ std::vector<uint8_t>& fileData);
+
+        //
+        // Positions the reader at the last keyframe recorded at or before the timestamp,
+        // or at the first keyframe if they are all later. Returns false if the archive
+        // has no keyframe. With a sidecar index next to the tarball, see FrameIndex.h,
+        // the keyframe is looked up in the index instead of walking the archive.
+        //
+        bool SeekToKeyframe(
+            _In_ const uint64_t timestamp);
+
+        //
+        // Extracts the timestamp from a recorded file name, such as
+        // "short_throw_depth\00000131711138130000.pgm".
+        //
+        static uint64_t GetTimestampFromFileName(
+            _In_ const std::string& fileName);
+
+        static bool IsKeyframeFileName(
+            _In_ const std::string& fileName);
+
+    private:
+        bool ReadKeyframe(
+            _Inout_ std::vector<uint8_t>& fileData);
+
+        bool ReadDeltaFrame(
+            _Inout_ std::vector<uint8_t>& fileData);
+
+        bool SeekToIndexedKeyframe(
+            _In_ const uint64_t timestamp);
+
+    private:
+        TarReader _tarReader;
+        FrameDeltaDecoder _decoder;
+
+        //
+        // The sidecar index of the tarball, empty if it has none.
+        //
+        std::vector<FrameIndexEntry> _index;
+
+        //
+        // The PGM or PPM header of the last keyframe, which delta frames share.
+        //
+        std::string _imageFileHeader;
+        std::vector<uint8_t> _deltaFileData;
+    };
+
+    //
+    // Reads the PGM or PPM header of a recorded keyframe into the image fields of the
+    // frame stream header, which otherwise describes an uncompressed frame, and sets
+    // imageOffset to the start of the pixels. Returns false for other files, or if the
+    // pixels are cut short.
+    //
+    bool DecodeImageFileHeader(
+        _In_reads_(fileSize) const uint8_t* fileData,
+        _In_ const size_t fileSize,
+        _Inout_ FrameStreamHeader& header,
+        _Out_ size_t& imageOffset);
+}
@@ -0,0 +1,211 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // A frame handed to a RecordedFrameSink during playback.
+    //
+    struct PlaybackFrame
+    {
+        size_t SensorIndex;
+        const char* SensorName;
+        uint64_t Timestamp;
+
+        //
+        // Gray8, Gray16 or Rgb8; delta frames are decoded.
+        //
+        FrameFileFormat Format;
+
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t PixelStride;
+        uint32_t RowStride;
+
+        //
+        // Keyframes point into the mapped tarball, decoded delta frames into a buffer of
+        // the player. Either is only valid during RecordedFrameSink::Send. Keyframe
+        // pixels follow the PGM/PPM header, so 16 bit pixels may not be 2 byte aligned.
+        //
+        const uint8_t* Pixels;
+
+        //
+        // Null if the pose log of the sensor has no record for the frame.
+        //
+        const RecordedFrameMetadata* Metadata;
+    };
+
+    class RecordedFrameSink
+    {
+    public:
+        virtual ~RecordedFrameSink()
+        {
+        }
+
+        virtual void Send(
+            _In_ const PlaybackFrame& frame) = 0;
+    };
+
+    class RecordedFrameSinkGroup
+    {
+    public:
+        virtual ~RecordedFrameSinkGroup()
+        {
+        }
+
+        //
+        // Returns null for sensors that are not to be played back.
+        //
+        virtual RecordedFrameSink* GetRecordedFrameSink(
+            _In_ const std::string& sensorName) = 0;
+    };
+
+    enum class PlaybackMode
+    {
+        //
+        // Keeps the recorded time between frames, scaled by the playback speed.
+        //
+        RealTime,
+
+        //
+        // Hands each frame on as soon as the sink returned from the one before.
+        //
+        AsFastAsPossible
+    };
+
+    //
+    // Plays back a folder recorded by the sensor frame recorder, with a "<sensor>.tar",
+    // "<sensor>.idx" and "<sensor>.pose" file for each sensor; recordings made before
+    // the pose log have a "<sensor>.csv" file instead. The frames of all sensors
+    // are handed to their sinks in timestamp order, so the recorded timing between
+    // sensors is kept in every mode.
+    //
+    // The tarballs are memory mapped, see IndexedFrameReader, so keyframes are handed on
+    // without being copied. Delta frames are decoded from the keyframe before.
+    //
+    // Play runs until the end of the recording or until Stop is called from another
+    // thread. Step hands on a single frame, for stepping through a recording.
+    //
+    class RecordingPlayer
+    {
+    public:
+        RecordingPlayer(
+            _In_ const std::string& recordingFolder,
+            _In_ const std::vector<std::string>& sensorNames);
+
+        //
+        // The sensors whose tarball was found in the recording folder.
+        //
+        size_t GetSensorCount() const;
+
+        const std::string& GetSensorName(
+            _In_ const size_t sensorIndex) const;
+
+        size_t GetFrameCount() const;
+
+        uint64_t GetStartTimestamp() const;
+
+        uint64_t GetEndTimestamp() const;
+
+        //
+        // Continues playback at the first frame recorded at or after the timestamp.
+        //
+        void Seek(
+            _In_ const uint64_t timestamp);
+
+        //
+        // Hands the next frame to its sink. Returns false at the end of the recording.
+        //
+        bool Step(
+            _In_ RecordedFrameSinkGroup& sinkGroup);
+
+        void Play(
+            _In_ RecordedFrameSinkGroup& sinkGroup,
+            _In_ const PlaybackMode mode,
+            _In_ const double speed = 1.0);
+
+        void Stop();
+
+    private:
+        struct Sensor
+        {
+            Sensor(
+                _In_ const std::string& name,
+                _In_ const std::string& tarballFileName);
+
+            std::string Name;
+            IndexedFrameReader Reader;
+            FrameDeltaDecoder Decoder;
+
+            //
+            // Ordinal of the frame the decoder holds as its previous frame, or the frame
+            // count if none.
+            //
+            size_t DecodedOrdinal;
+            std::vector<uint8_t> Image;
+
+            //
+            // Sorted by timestamp.
+            //
+            std::vector<uint64_t> MetadataTimestamps;
+            std::vector<RecordedFrameMetadata> Metadata;
+        };
+
+        struct FrameReference
+        {
+            uint64_t Timestamp;
+            uint32_t SensorIndex;
+            uint32_t Ordinal;
+        };
+
+        //
+        // Hands the next frame to its sink, if the sensor has one.
+        //
+        bool SendNextFrame(
+            _In_ const std::vector<RecordedFrameSink*>& sinks);
+
+        std::vector<RecordedFrameSink*> GetSinks(
+            _In_ RecordedFrameSinkGroup& sinkGroup) const;
+
+        //
+        // Decodes a frame of the sensor into a playback frame, decoding the delta frames
+        // before it from their keyframe if the decoder does not hold the frame before.
+        //
+        bool DecodeFrame(
+            _Inout_ Sensor& sensor,
+            _In_ const size_t ordinal,
+            _Out_ PlaybackFrame& frame);
+
+        //
+        // Reads the pose log of the sensor, or its CSV file if it has none.
+        //
+        static void ReadMetadata(
+            _In_ const std::string& fileName,
+            _Inout_ Sensor& sensor);
+
+        static void ReadCsvMetadata(
+            _In_ const std::string& csvFileName,
+            _Inout_ Sensor& sensor);
+
+    private:
+        std::vector<std::unique_ptr<Sensor>> _sensors;
+
+        //
+        // The frames of all sensors in the order they are played back.
+        //
+        std::vector<FrameReference> _frames;
+        size_t _position;
+
+        std::atomic<bool> _isStopping;
+    };
+}
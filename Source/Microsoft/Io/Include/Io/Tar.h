@@ -15,31 +15,116 @@
 
 namespace Io
 {
+#if defined(_WIN32)
     void CreateTarball(
         _In_ Windows::Storage::StorageFolder^ sourceFolder,
         _In_ const std::vector<std::wstring>& sourceFileNames,
         _In_ Windows::Storage::StorageFolder^ tarballFolder,
         _In_ const std::wstring& tarballFileName);
+#endif /* defined(_WIN32) */
+
+	// Options for writing a tarball.
+	struct TarballOptions
+	{
+		TarballOptions()
+			: StagingBufferSize(DefaultStagingBufferSize)
+			, UseDirectIo(false)
+		{
+		}
+
+		static const size_t DefaultStagingBufferSize = 1024 * 1024;
+
+		// The headers, file data and padding are gathered in a buffer of this
+		// many bytes, which is written to the file whenever it fills up. It is
+		// rounded up to a multiple of the direct I/O alignment. Without direct
+		// I/O, files that do not fit are written without being copied. Zero
+		// writes every header, file and padding to the file as it is added.
+		size_t StagingBufferSize;
+
+		// On Linux, open the tarball with O_DIRECT to bypass the page cache.
+		// Falls back to buffered writes where the file system does not support
+		// it. Ignored on Windows and without a staging buffer.
+		bool UseDirectIo;
+	};
 
 	// Class to create tarball, which allows for incremental
 	// streaming of files into the archive.
 	class Tarball
 	{
 	public:
+		Tarball(_In_ const std::string& tarballFileName);
 		Tarball(_In_ const std::wstring& tarballFileName);
+
+		Tarball(
+			_In_ const std::string& tarballFileName,
+			_In_ const TarballOptions& options);
+
+		Tarball(
+			_In_ const std::wstring& tarballFileName,
+			_In_ const TarballOptions& options);
+
 		~Tarball();
 
 		// Close the tarball.
 		void Close();
 
-		// Add a file to the tarball.
-		void AddFile(
+		// Add a file to the tarball. Returns the offset of the file
+		// data from the start of the tarball.
+		uint64_t AddFile(
+			_In_ const std::string& fileName,
+			_In_ const uint8_t* fileData,
+			_In_ const size_t fileSize);
+
+		uint64_t AddFile(
 			_In_ const std::wstring& fileName,
 			_In_ const uint8_t* fileData,
 			_In_ const size_t fileSize);
 
+		bool IsOpen() const;
+
+		// The number of bytes added to the tarball so far, including the
+		// bytes still held in the staging buffer.
+		uint64_t GetSize() const;
+
+		// True if the tarball bypasses the page cache with direct I/O.
+		bool IsDirectIo() const;
+
 	private:
+		void AllocateStagingBuffer();
+
+		void Open(
+			_In_ const std::string& tarballFileName);
+
+		void Append(
+			_In_reads_(size) const void* data,
+			_In_ size_t size);
+
+		void AppendZeros(
+			_In_ size_t size);
+
+		// Writes the staging buffer to the file. Only the last write before
+		// the tarball is closed may end in a partial direct I/O block.
+		void Flush();
+
+		void Write(
+			_In_reads_(size) const uint8_t* data,
+			_In_ size_t size);
+
+		TarballOptions _options;
+
 		// The file handler to the tarball.
 		std::ofstream _tarballFile;
+
+#if !defined(_WIN32)
+		// The file descriptor of a tarball opened for direct I/O, or -1.
+		int _directFile;
+#endif /* !defined(_WIN32) */
+
+		// The staging buffer is aligned within its storage for direct I/O.
+		std::vector<uint8_t> _stagingStorage;
+		uint8_t* _stagingBuffer;
+		size_t _stagedSize;
+
+		uint64_t _size;
 	};
 }
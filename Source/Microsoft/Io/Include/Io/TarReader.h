@@ -0,0 +1,63 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+#include <fstream>
+
+namespace Io
+{
+    //
+    // Sequential reader for tarballs written by the Tarball class. Files are
+    // returned one at a time, in the order they were added to the archive.
+    //
+    class TarReader
+    {
+    public:
+        TarReader(
+            _In_ const std::string& tarballFileName);
+
+        bool IsOpen() const;
+
+        //
+        // Reads the next regular file of the archive into fileData, reusing its
+        // capacity. Returns false at the end of the archive.
+        //
+        bool ReadNext(
+            _Out_ std::string& fileName,
+            _Inout_ std::vector<uint8_t>& fileData);
+
+        //
+        // Skips the next regular file of the archive without reading it. Returns false at
+        // the end of the archive.
+        //
+        bool SkipNext(
+            _Out_ std::string& fileName);
+
+        //
+        // Offset of the next file in the archive, which SetPosition returns to.
+        //
+        uint64_t GetPosition();
+
+        void SetPosition(
+            _In_ const uint64_t position);
+
+    private:
+        //
+        // Reads the header of the next regular file, and leaves the archive at its data.
+        //
+        bool ReadFileHeader(
+            _Out_ std::string& fileName,
+            _Out_ size_t& fileSize);
+
+    private:
+        std::ifstream _tarballFile;
+    };
+}
@@ -0,0 +1,209 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace Io
+{
+    namespace
+    {
+        const size_t TarBlockSize = 512;
+        const size_t TarFileNameOffset = 0;
+        const size_t TarFileNameLength = 100;
+        const size_t TarFileSizeOffset = 124;
+        const size_t TarFileSizeLength = 12;
+        const size_t TarTypeOffset = 156;
+
+        uint64_t GetPaddedFileSize(
+            _In_ const uint64_t fileSize)
+        {
+            return (fileSize + TarBlockSize - 1) / TarBlockSize * TarBlockSize;
+        }
+    }
+
+    _Use_decl_annotations_
+    IndexedFrameReader::IndexedFrameReader(
+        const std::string& tarballFileName)
+        : _tarball(tarballFileName)
+        , _hasSidecarIndex(false)
+    {
+        if (!_tarball.IsOpen())
+        {
+            return;
+        }
+
+        _hasSidecarIndex = ReadFrameIndex(
+            FrameIndex::GetFileName(tarballFileName),
+            _entries);
+
+        if (_hasSidecarIndex)
+        {
+            const auto pastEnd = std::find_if(
+                _entries.begin(),
+                _entries.end(),
+                [this](const FrameIndexEntry& entry)
+                {
+                    return
+                        entry.Offset > _tarball.GetSize() ||
+                        entry.Size > _tarball.GetSize() - entry.Offset;
+                });
+
+            _entries.erase(pastEnd, _entries.end());
+        }
+        else
+        {
+            IndexTarball();
+        }
+
+        for (size_t ordinal = 0; ordinal < _entries.size(); ++ordinal)
+        {
+            if (IsKeyframe(_entries[ordinal]))
+            {
+                _keyframes.push_back(ordinal);
+            }
+        }
+    }
+
+    bool IndexedFrameReader::IsOpen() const
+    {
+        return _tarball.IsOpen();
+    }
+
+    bool IndexedFrameReader::HasSidecarIndex() const
+    {
+        return _hasSidecarIndex;
+    }
+
+    size_t IndexedFrameReader::GetFrameCount() const
+    {
+        return _entries.size();
+    }
+
+    const std::vector<FrameIndexEntry>& IndexedFrameReader::GetEntries() const
+    {
+        return _entries;
+    }
+
+    _Use_decl_annotations_
+    RecordedFrame IndexedFrameReader::GetFrame(
+        const size_t ordinal) const
+    {
+        REQUIRES(ordinal < _entries.size());
+
+        const FrameIndexEntry& entry = _entries[ordinal];
+
+        RecordedFrame frame;
+
+        frame.Timestamp = entry.Timestamp;
+        frame.Format = entry.Format;
+        frame.Data = _tarball.GetData() + entry.Offset;
+        frame.Size = entry.Size;
+
+        return frame;
+    }
+
+    _Use_decl_annotations_
+    size_t IndexedFrameReader::FindFrame(
+        const uint64_t timestamp) const
+    {
+        REQUIRES(!_entries.empty());
+
+        const auto later = std::upper_bound(
+            _entries.begin(),
+            _entries.end(),
+            timestamp,
+            [](const uint64_t value, const FrameIndexEntry& entry)
+            {
+                return value < entry.Timestamp;
+            });
+
+        return later == _entries.begin() ?
+            0 :
+            static_cast<size_t>(later - _entries.begin()) - 1;
+    }
+
+    _Use_decl_annotations_
+    size_t IndexedFrameReader::FindKeyframe(
+        const size_t ordinal) const
+    {
+        if (_keyframes.empty())
+        {
+            return _entries.size();
+        }
+
+        const auto later = std::upper_bound(
+            _keyframes.begin(),
+            _keyframes.end(),
+            ordinal);
+
+        return later == _keyframes.begin() ?
+            _keyframes.front() :
+            *(later - 1);
+    }
+
+    void IndexedFrameReader::IndexTarball()
+    {
+        const uint8_t* const tarball = _tarball.GetData();
+        const uint64_t tarballSize = _tarball.GetSize();
+
+        uint64_t position = 0;
+
+        while (position + TarBlockSize <= tarballSize)
+        {
+            const char* const header =
+                reinterpret_cast<const char*>(tarball + position);
+
+            //
+            // The archive ends with two blocks of zeroes.
+            //
+            if ('\0' == header[TarFileNameOffset])
+            {
+                break;
+            }
+
+            const std::string fileName(
+                header + TarFileNameOffset,
+                strnlen(header + TarFileNameOffset, TarFileNameLength));
+
+            const std::string fileSizeField(
+                header + TarFileSizeOffset,
+                TarFileSizeLength);
+
+            const uint64_t fileSize =
+                strtoull(fileSizeField.c_str(), nullptr, 8);
+
+            const char type = header[TarTypeOffset];
+
+            position += TarBlockSize;
+
+            if (fileSize > tarballSize - position)
+            {
+                break;
+            }
+
+            //
+            // Skip anything that is not a regular file.
+            //
+            if ('0' == type || '\0' == type)
+            {
+                FrameIndexEntry entry;
+
+                entry.Timestamp = RecordedFrameReader::GetTimestampFromFileName(fileName);
+                entry.Offset = position;
+                entry.Size = static_cast<uint32_t>(fileSize);
+                entry.Format = GetFrameFileFormat(fileName, tarball + position, static_cast<size_t>(fileSize));
+
+                _entries.push_back(entry);
+            }
+
+            position += GetPaddedFileSize(fileSize);
+        }
+    }
+}
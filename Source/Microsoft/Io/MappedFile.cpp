@@ -0,0 +1,145 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace Io
+{
+#if defined(_WIN32)
+    _Use_decl_annotations_
+    MappedFile::MappedFile(
+        const std::string& fileName)
+        : _file(INVALID_HANDLE_VALUE)
+        , _mapping(nullptr)
+        , _data(nullptr)
+        , _size(0)
+    {
+        _file = CreateFile2(
+            Utf8ToUtf16(fileName).c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            OPEN_EXISTING,
+            nullptr /* pCreateExParams */);
+
+        LARGE_INTEGER fileSize = {};
+
+        if (INVALID_HANDLE_VALUE == _file ||
+            !GetFileSizeEx(_file, &fileSize) ||
+            0 == fileSize.QuadPart)
+        {
+            return;
+        }
+
+        _mapping = CreateFileMappingFromApp(
+            _file,
+            nullptr /* SecurityAttributes */,
+            PAGE_READONLY,
+            0 /* MaximumSize: the whole file */,
+            nullptr /* Name */);
+
+        if (nullptr == _mapping)
+        {
+            return;
+        }
+
+        _data = static_cast<const uint8_t*>(MapViewOfFileFromApp(
+            _mapping,
+            FILE_MAP_READ,
+            0 /* FileOffset */,
+            0 /* NumberOfBytesToMap: the whole file */));
+
+        if (nullptr != _data)
+        {
+            _size = static_cast<size_t>(fileSize.QuadPart);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (nullptr != _data)
+        {
+            UnmapViewOfFile(_data);
+        }
+
+        if (nullptr != _mapping)
+        {
+            CloseHandle(_mapping);
+        }
+
+        if (INVALID_HANDLE_VALUE != _file)
+        {
+            CloseHandle(_file);
+        }
+    }
+#else
+    _Use_decl_annotations_
+    MappedFile::MappedFile(
+        const std::string& fileName)
+        : _file(-1)
+        , _data(nullptr)
+        , _size(0)
+    {
+        _file = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+        struct stat fileStatus = {};
+
+        if (_file < 0 ||
+            0 != fstat(_file, &fileStatus) ||
+            0 == fileStatus.st_size)
+        {
+            return;
+        }
+
+        void* data = mmap(
+            nullptr,
+            static_cast<size_t>(fileStatus.st_size),
+            PROT_READ,
+            MAP_SHARED,
+            _file,
+            0 /* offset */);
+
+        if (MAP_FAILED == data)
+        {
+            return;
+        }
+
+        _data = static_cast<const uint8_t*>(data);
+        _size = static_cast<size_t>(fileStatus.st_size);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (nullptr != _data)
+        {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+
+        if (_file >= 0)
+        {
+            close(_file);
+        }
+    }
+#endif /* defined(_WIN32) */
+
+    bool MappedFile::IsOpen() const
+    {
+        return nullptr != _data;
+    }
+
+    const uint8_t* MappedFile::GetData() const
+    {
+        return _data;
+    }
+
+    size_t MappedFile::GetSize() const
+    {
+        return _size;
+    }
+}
@@ -0,0 +1,229 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+#include "BinaryFormat.h"
+
+namespace Io
+{
+    using namespace BinaryFormat;
+
+    namespace
+    {
+        const size_t MetadataValueCount =
+            sizeof(RecordedFrameMetadata) / sizeof(float);
+
+        void WriteMetadata(
+            _In_ const RecordedFrameMetadata& metadata,
+            _Inout_ uint8_t*& cursor)
+        {
+            const float* values = &metadata.FrameToOrigin[0];
+
+            for (size_t i = 0; i < MetadataValueCount; ++i)
+            {
+                uint32_t bits;
+                memcpy(&bits, &values[i], sizeof(bits));
+
+                WriteLittleEndian(bits, cursor);
+            }
+        }
+
+        void ReadMetadata(
+            _Inout_ const uint8_t*& cursor,
+            _Out_ RecordedFrameMetadata& metadata)
+        {
+            float* values = &metadata.FrameToOrigin[0];
+
+            for (size_t i = 0; i < MetadataValueCount; ++i)
+            {
+                const uint32_t bits = ReadLittleEndian<uint32_t>(cursor);
+                memcpy(&values[i], &bits, sizeof(bits));
+            }
+        }
+    }
+
+    static_assert(
+        sizeof(RecordedFrameMetadata) == 3 * 16 * sizeof(float),
+        "RecordedFrameMetadata must hold the three matrices without padding.");
+
+    const uint32_t PoseLog::FileCookie;
+    const uint16_t PoseLog::FileVersion;
+    const size_t PoseLog::HeaderLength;
+    const size_t PoseLog::RecordLength;
+    const char* const PoseLog::FileExtension = "pose";
+    const size_t PoseLogWriter::BufferedRecordCount;
+
+    PoseLogRecord::PoseLogRecord()
+        : Timestamp(0)
+        , Offset(0)
+        , Metadata()
+    {
+    }
+
+    _Use_decl_annotations_
+    std::string PoseLog::GetFileName(
+        const std::string& tarballFileName)
+    {
+        return GetSidecarFileName(
+            tarballFileName,
+            FileExtension);
+    }
+
+    _Use_decl_annotations_
+    bool ReadPoseLog(
+        const std::string& poseLogFileName,
+        std::vector<PoseLogRecord>& records)
+    {
+        records.clear();
+
+        std::ifstream file(poseLogFileName, std::ios::binary);
+
+        if (!file)
+        {
+            return false;
+        }
+
+        uint8_t header[PoseLog::HeaderLength];
+
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+        {
+            return false;
+        }
+
+        const uint8_t* cursor = header;
+
+        const uint32_t cookie = ReadLittleEndian<uint32_t>(cursor);
+        const uint16_t version = ReadLittleEndian<uint16_t>(cursor);
+        const uint16_t recordLength = ReadLittleEndian<uint16_t>(cursor);
+
+        //
+        // Later versions may only append fields to the records.
+        //
+        if (PoseLog::FileCookie != cookie ||
+            version < PoseLog::FileVersion ||
+            recordLength < PoseLog::RecordLength)
+        {
+            return false;
+        }
+
+        //
+        // Read the records in large blocks rather than one at a time.
+        //
+        std::vector<uint8_t> recordData(
+            PoseLogWriter::BufferedRecordCount * recordLength);
+
+        for (;;)
+        {
+            file.read(reinterpret_cast<char*>(recordData.data()), recordData.size());
+
+            const size_t recordCount =
+                static_cast<size_t>(file.gcount()) / recordLength;
+
+            for (size_t i = 0; i < recordCount; ++i)
+            {
+                cursor = recordData.data() + i * recordLength;
+
+                PoseLogRecord record;
+
+                record.Timestamp = ReadLittleEndian<uint64_t>(cursor);
+                record.Offset = ReadLittleEndian<uint64_t>(cursor);
+
+                ReadMetadata(cursor, record.Metadata);
+
+                records.push_back(record);
+            }
+
+            if (!file)
+            {
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    PoseLogWriter::PoseLogWriter(
+        const std::string& poseLogFileName)
+        : _file(poseLogFileName, std::ios::binary)
+    {
+        ASSERT(_file);
+
+        WriteHeader();
+    }
+
+#if defined(_WIN32)
+    _Use_decl_annotations_
+    PoseLogWriter::PoseLogWriter(
+        const std::wstring& poseLogFileName)
+        : _file(poseLogFileName, std::ios::binary)
+    {
+        ASSERT(_file);
+
+        WriteHeader();
+    }
+#endif /* defined(_WIN32) */
+
+    PoseLogWriter::~PoseLogWriter()
+    {
+        Flush();
+    }
+
+    _Use_decl_annotations_
+    void PoseLogWriter::Add(
+        const PoseLogRecord& record)
+    {
+        const size_t recordOffset = _buffer.size();
+
+        _buffer.resize(
+            recordOffset + PoseLog::RecordLength);
+
+        uint8_t* cursor = _buffer.data() + recordOffset;
+
+        WriteLittleEndian(record.Timestamp, cursor);
+        WriteLittleEndian(record.Offset, cursor);
+
+        WriteMetadata(record.Metadata, cursor);
+
+        if (_buffer.size() >= BufferedRecordCount * PoseLog::RecordLength)
+        {
+            Flush();
+        }
+    }
+
+    void PoseLogWriter::Flush()
+    {
+        if (_buffer.empty())
+        {
+            return;
+        }
+
+        _file.write(reinterpret_cast<const char*>(_buffer.data()), _buffer.size());
+        _file.flush();
+
+        _buffer.clear();
+    }
+
+    void PoseLogWriter::WriteHeader()
+    {
+        uint8_t header[PoseLog::HeaderLength] = {};
+        uint8_t* cursor = header;
+
+        WriteLittleEndian(PoseLog::FileCookie, cursor);
+        WriteLittleEndian(PoseLog::FileVersion, cursor);
+        WriteLittleEndian(static_cast<uint16_t>(PoseLog::RecordLength), cursor);
+
+        _file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        _buffer.reserve(
+            BufferedRecordCount * PoseLog::RecordLength);
+    }
+}
@@ -0,0 +1,327 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace Io
+{
+    namespace
+    {
+        const uint64_t TarHeaderLength = 512;
+
+        //
+        // Reads a whitespace separated decimal number from a PGM or PPM header.
+        //
+        bool ReadImageFileNumber(
+            _In_reads_(fileSize) const uint8_t* fileData,
+            _In_ const size_t fileSize,
+            _Inout_ size_t& position,
+            _Out_ uint32_t& value)
+        {
+            while (position < fileSize && isspace(fileData[position]))
+            {
+                ++position;
+            }
+
+            if (position >= fileSize || !isdigit(fileData[position]))
+            {
+                return false;
+            }
+
+            value = 0;
+
+            while (position < fileSize && isdigit(fileData[position]))
+            {
+                value = value * 10 + (fileData[position] - '0');
+                ++position;
+            }
+
+            return true;
+        }
+    }
+
+    const char* const RecordedFrameReader::DeltaFileExtension = "delta";
+
+    _Use_decl_annotations_
+    RecordedFrameReader::RecordedFrameReader(
+        const std::string& tarballFileName)
+        : _tarReader(tarballFileName)
+    {
+        ReadFrameIndex(
+            FrameIndex::GetFileName(tarballFileName),
+            _index);
+    }
+
+    bool RecordedFrameReader::IsOpen() const
+    {
+        return _tarReader.IsOpen();
+    }
+
+    _Use_decl_annotations_
+    bool RecordedFrameReader::ReadNext(
+        std::string& fileName,
+        std::vector<uint8_t>& fileData)
+    {
+        if (!_tarReader.ReadNext(fileName, fileData))
+        {
+            return false;
+        }
+
+        if (IsKeyframeFileName(fileName))
+        {
+            //
+            // Files other than images are returned as they are.
+            //
+            if (!ReadKeyframe(fileData))
+            {
+                _decoder.Reset();
+            }
+
+            return true;
+        }
+
+        std::swap(
+            fileData,
+            _deltaFileData);
+
+        if (!ReadDeltaFrame(fileData))
+        {
+            dbg::trace(
+                L"RecordedFrameReader::ReadNext: cannot decode %S, the reader must start at a keyframe",
+                fileName.c_str());
+
+            return false;
+        }
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    bool RecordedFrameReader::SeekToKeyframe(
+        const uint64_t timestamp)
+    {
+        _decoder.Reset();
+
+        if (!_index.empty())
+        {
+            return SeekToIndexedKeyframe(timestamp);
+        }
+
+        _tarReader.SetPosition(0);
+
+        bool hasKeyframe = false;
+        uint64_t keyframePosition = 0;
+        std::string fileName;
+
+        for (;;)
+        {
+            const uint64_t position = _tarReader.GetPosition();
+
+            if (!_tarReader.SkipNext(fileName))
+            {
+                break;
+            }
+
+            if (!IsKeyframeFileName(fileName))
+            {
+                continue;
+            }
+
+            if (hasKeyframe && GetTimestampFromFileName(fileName) > timestamp)
+            {
+                break;
+            }
+
+            hasKeyframe = true;
+            keyframePosition = position;
+        }
+
+        _tarReader.SetPosition(
+            keyframePosition);
+
+        return hasKeyframe;
+    }
+
+    _Use_decl_annotations_
+    bool RecordedFrameReader::SeekToIndexedKeyframe(
+        const uint64_t timestamp)
+    {
+        const auto later = std::upper_bound(
+            _index.begin(),
+            _index.end(),
+            timestamp,
+            [](const uint64_t value, const FrameIndexEntry& entry)
+            {
+                return value < entry.Timestamp;
+            });
+
+        const auto isKeyframe = [](const FrameIndexEntry& entry)
+        {
+            return IsKeyframe(entry);
+        };
+
+        //
+        // Walk back to the keyframe, or forward to the first one if there is none before.
+        //
+        const auto keyframe = std::find_if(
+            std::vector<FrameIndexEntry>::reverse_iterator(later),
+            _index.rend(),
+            isKeyframe);
+
+        const auto entry = keyframe != _index.rend() ?
+            keyframe.base() - 1 :
+            std::find_if(_index.begin(), _index.end(), isKeyframe);
+
+        if (entry == _index.end())
+        {
+            return false;
+        }
+
+        //
+        // The index points at the file data, which follows its TAR header.
+        //
+        _tarReader.SetPosition(
+            entry->Offset - TarHeaderLength);
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    uint64_t RecordedFrameReader::GetTimestampFromFileName(
+        const std::string& fileName)
+    {
+        const size_t separator = fileName.find_last_of("\\/");
+        const size_t start = separator == std::string::npos ? 0 : separator + 1;
+
+        return strtoull(fileName.c_str() + start, nullptr, 10);
+    }
+
+    _Use_decl_annotations_
+    bool RecordedFrameReader::IsKeyframeFileName(
+        const std::string& fileName)
+    {
+        const size_t extension = fileName.find_last_of('.');
+
+        return
+            std::string::npos == extension ||
+            0 != fileName.compare(extension + 1, std::string::npos, DeltaFileExtension);
+    }
+
+    _Use_decl_annotations_
+    bool RecordedFrameReader::ReadKeyframe(
+        std::vector<uint8_t>& fileData)
+    {
+        FrameStreamHeader header;
+        size_t imageOffset = 0;
+
+        if (!DecodeImageFileHeader(fileData.data(), fileData.size(), header, imageOffset))
+        {
+            return false;
+        }
+
+        _imageFileHeader.assign(
+            fileData.begin(),
+            fileData.begin() + imageOffset);
+
+        //
+        // Keeps the pixels for the delta frames that may follow.
+        //
+        SetDeltaKeyframe(
+            header);
+
+        return _decoder.Decode(
+            header,
+            fileData.data() + imageOffset,
+            GetPayloadLength(header),
+            fileData.data() + imageOffset);
+    }
+
+    _Use_decl_annotations_
+    bool RecordedFrameReader::ReadDeltaFrame(
+        std::vector<uint8_t>& fileData)
+    {
+        FrameStreamHeader header;
+
+        if (!DecodeFrameStreamHeader(_deltaFileData.data(), _deltaFileData.size(), header) ||
+            FrameStreamHeader::ProtocolCookie != header.Cookie ||
+            !HasCodecExtension(header) ||
+            !DecodeFrameStreamHeaderCodecExtension(
+                _deltaFileData.data() + FrameStreamHeader::EncodedLength,
+                _deltaFileData.size() - FrameStreamHeader::EncodedLength,
+                header) ||
+            GetEncodedLength(header) + GetPayloadLength(header) != _deltaFileData.size() ||
+            !IsValidImageLayout(header))
+        {
+            return false;
+        }
+
+        fileData.assign(
+            _imageFileHeader.begin(),
+            _imageFileHeader.end());
+
+        fileData.resize(
+            _imageFileHeader.size() + static_cast<size_t>(header.ImageHeight) * header.RowStride);
+
+        return _decoder.Decode(
+            header,
+            _deltaFileData.data() + GetEncodedLength(header),
+            GetPayloadLength(header),
+            fileData.data() + _imageFileHeader.size());
+    }
+
+    _Use_decl_annotations_
+    bool DecodeImageFileHeader(
+        const uint8_t* fileData,
+        const size_t fileSize,
+        FrameStreamHeader& header,
+        size_t& imageOffset)
+    {
+        if (fileSize < 2 ||
+            'P' != fileData[0] ||
+            ('5' != fileData[1] && '6' != fileData[1]))
+        {
+            return false;
+        }
+
+        size_t position = 2;
+        uint32_t maxValue = 0;
+
+        if (!ReadImageFileNumber(fileData, fileSize, position, header.ImageWidth) ||
+            !ReadImageFileNumber(fileData, fileSize, position, header.ImageHeight) ||
+            !ReadImageFileNumber(fileData, fileSize, position, maxValue))
+        {
+            return false;
+        }
+
+        //
+        // A single whitespace character separates the header from the pixels.
+        //
+        ++position;
+
+        header.PixelStride =
+            '6' == fileData[1] ? 3 : (maxValue > 255 ? 2 : 1);
+
+        header.RowStride =
+            header.ImageWidth * header.PixelStride;
+
+        const size_t imageLength =
+            static_cast<size_t>(header.ImageHeight) * header.RowStride;
+
+        if (position > fileSize || imageLength > fileSize - position)
+        {
+            return false;
+        }
+
+        imageOffset = position;
+
+        return true;
+    }
+}
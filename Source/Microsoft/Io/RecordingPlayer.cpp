@@ -0,0 +1,478 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace Io
+{
+    namespace
+    {
+        //
+        // Timestamps are in 100 ns units.
+        //
+        typedef std::chrono::duration<double, std::ratio<1, 10000000>> TimestampDuration;
+
+        const size_t MetadataValueCount =
+            sizeof(RecordedFrameMetadata) / sizeof(float);
+
+        void SetImage(
+            _In_ const FrameStreamHeader& header,
+            _In_ const uint8_t* pixels,
+            _Inout_ PlaybackFrame& frame)
+        {
+            switch (header.PixelStride)
+            {
+            case 1:
+                frame.Format = FrameFileFormat::Gray8;
+                break;
+
+            case 2:
+                frame.Format = FrameFileFormat::Gray16;
+                break;
+
+            default:
+                frame.Format = FrameFileFormat::Rgb8;
+                break;
+            }
+
+            frame.Width = header.ImageWidth;
+            frame.Height = header.ImageHeight;
+            frame.PixelStride = header.PixelStride;
+            frame.RowStride = header.RowStride;
+            frame.Pixels = pixels;
+        }
+    }
+
+    _Use_decl_annotations_
+    RecordingPlayer::Sensor::Sensor(
+        const std::string& name,
+        const std::string& tarballFileName)
+        : Name(name)
+        , Reader(tarballFileName)
+        , DecodedOrdinal(Reader.GetFrameCount())
+    {
+    }
+
+    _Use_decl_annotations_
+    RecordingPlayer::RecordingPlayer(
+        const std::string& recordingFolder,
+        const std::vector<std::string>& sensorNames)
+        : _position(0)
+        , _isStopping(false)
+    {
+        for (const std::string& sensorName : sensorNames)
+        {
+            const std::string fileName =
+                recordingFolder + "/" + sensorName;
+
+            std::unique_ptr<Sensor> sensor(
+                new Sensor(sensorName, fileName + ".tar"));
+
+            if (!sensor->Reader.IsOpen() || 0 == sensor->Reader.GetFrameCount())
+            {
+                continue;
+            }
+
+            ReadMetadata(
+                fileName,
+                *sensor);
+
+            const uint32_t sensorIndex =
+                static_cast<uint32_t>(_sensors.size());
+
+            const std::vector<FrameIndexEntry>& entries =
+                sensor->Reader.GetEntries();
+
+            for (size_t ordinal = 0; ordinal < entries.size(); ++ordinal)
+            {
+                FrameReference reference;
+
+                reference.Timestamp = entries[ordinal].Timestamp;
+                reference.SensorIndex = sensorIndex;
+                reference.Ordinal = static_cast<uint32_t>(ordinal);
+
+                _frames.push_back(reference);
+            }
+
+            _sensors.push_back(
+                std::move(sensor));
+        }
+
+        //
+        // Frames recorded at the same time keep the order of the sensor names.
+        //
+        std::stable_sort(
+            _frames.begin(),
+            _frames.end(),
+            [](const FrameReference& left, const FrameReference& right)
+            {
+                return left.Timestamp < right.Timestamp;
+            });
+    }
+
+    size_t RecordingPlayer::GetSensorCount() const
+    {
+        return _sensors.size();
+    }
+
+    _Use_decl_annotations_
+    const std::string& RecordingPlayer::GetSensorName(
+        const size_t sensorIndex) const
+    {
+        REQUIRES(sensorIndex < _sensors.size());
+
+        return _sensors[sensorIndex]->Name;
+    }
+
+    size_t RecordingPlayer::GetFrameCount() const
+    {
+        return _frames.size();
+    }
+
+    uint64_t RecordingPlayer::GetStartTimestamp() const
+    {
+        return _frames.empty() ? 0 : _frames.front().Timestamp;
+    }
+
+    uint64_t RecordingPlayer::GetEndTimestamp() const
+    {
+        return _frames.empty() ? 0 : _frames.back().Timestamp;
+    }
+
+    _Use_decl_annotations_
+    void RecordingPlayer::Seek(
+        const uint64_t timestamp)
+    {
+        const auto next = std::lower_bound(
+            _frames.begin(),
+            _frames.end(),
+            timestamp,
+            [](const FrameReference& reference, const uint64_t value)
+            {
+                return reference.Timestamp < value;
+            });
+
+        _position = static_cast<size_t>(next - _frames.begin());
+    }
+
+    _Use_decl_annotations_
+    bool RecordingPlayer::Step(
+        RecordedFrameSinkGroup& sinkGroup)
+    {
+        return SendNextFrame(
+            GetSinks(sinkGroup));
+    }
+
+    _Use_decl_annotations_
+    void RecordingPlayer::Play(
+        RecordedFrameSinkGroup& sinkGroup,
+        const PlaybackMode mode,
+        const double speed)
+    {
+        REQUIRES(speed > 0.0);
+
+        _isStopping = false;
+
+        const std::vector<RecordedFrameSink*> sinks =
+            GetSinks(sinkGroup);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        const uint64_t startTimestamp =
+            _position < _frames.size() ? _frames[_position].Timestamp : 0;
+
+        while (!_isStopping && _position < _frames.size())
+        {
+            if (PlaybackMode::RealTime == mode)
+            {
+                const TimestampDuration recordedTime(
+                    static_cast<double>(_frames[_position].Timestamp - startTimestamp) / speed);
+
+                std::this_thread::sleep_until(
+                    start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(recordedTime));
+            }
+
+            SendNextFrame(
+                sinks);
+        }
+    }
+
+    void RecordingPlayer::Stop()
+    {
+        _isStopping = true;
+    }
+
+    _Use_decl_annotations_
+    bool RecordingPlayer::SendNextFrame(
+        const std::vector<RecordedFrameSink*>& sinks)
+    {
+        if (_position >= _frames.size())
+        {
+            return false;
+        }
+
+        const FrameReference& reference =
+            _frames[_position++];
+
+        RecordedFrameSink* sink =
+            sinks[reference.SensorIndex];
+
+        if (nullptr == sink)
+        {
+            return true;
+        }
+
+        Sensor& sensor =
+            *_sensors[reference.SensorIndex];
+
+        PlaybackFrame frame;
+
+        if (!DecodeFrame(sensor, reference.Ordinal, frame))
+        {
+            dbg::trace(
+                L"RecordingPlayer::SendNextFrame: cannot decode the %S frame at %llu",
+                sensor.Name.c_str(),
+                reference.Timestamp);
+
+            return true;
+        }
+
+        frame.SensorIndex = reference.SensorIndex;
+        frame.SensorName = sensor.Name.c_str();
+        frame.Timestamp = reference.Timestamp;
+        frame.Metadata = nullptr;
+
+        const auto metadata = std::lower_bound(
+            sensor.MetadataTimestamps.begin(),
+            sensor.MetadataTimestamps.end(),
+            reference.Timestamp);
+
+        if (metadata != sensor.MetadataTimestamps.end() && *metadata == reference.Timestamp)
+        {
+            frame.Metadata =
+                &sensor.Metadata[metadata - sensor.MetadataTimestamps.begin()];
+        }
+
+        sink->Send(
+            frame);
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    std::vector<RecordedFrameSink*> RecordingPlayer::GetSinks(
+        RecordedFrameSinkGroup& sinkGroup) const
+    {
+        std::vector<RecordedFrameSink*> sinks;
+
+        for (const std::unique_ptr<Sensor>& sensor : _sensors)
+        {
+            sinks.push_back(
+                sinkGroup.GetRecordedFrameSink(sensor->Name));
+        }
+
+        return sinks;
+    }
+
+    _Use_decl_annotations_
+    bool RecordingPlayer::DecodeFrame(
+        Sensor& sensor,
+        const size_t ordinal,
+        PlaybackFrame& frame)
+    {
+        const std::vector<FrameIndexEntry>& entries =
+            sensor.Reader.GetEntries();
+
+        const RecordedFrame recordedFrame =
+            sensor.Reader.GetFrame(ordinal);
+
+        FrameStreamHeader header;
+
+        if (IsKeyframe(entries[ordinal]))
+        {
+            size_t imageOffset = 0;
+
+            if (!DecodeImageFileHeader(recordedFrame.Data, recordedFrame.Size, header, imageOffset))
+            {
+                return false;
+            }
+
+            const uint8_t* pixels =
+                recordedFrame.Data + imageOffset;
+
+            sensor.DecodedOrdinal = entries.size();
+
+            //
+            // Only the delta frames that follow need the keyframe in the decoder. An
+            // uncompressed frame decoded in place is not written, only copied into it.
+            //
+            if (ordinal + 1 < entries.size() && !IsKeyframe(entries[ordinal + 1]))
+            {
+                SetDeltaKeyframe(
+                    header);
+
+                if (!sensor.Decoder.Decode(header, pixels, GetPayloadLength(header), const_cast<uint8_t*>(pixels)))
+                {
+                    return false;
+                }
+
+                sensor.DecodedOrdinal = ordinal;
+            }
+
+            SetImage(header, pixels, frame);
+
+            return true;
+        }
+
+        //
+        // After seeking or skipping frames, decode from the keyframe before.
+        //
+        if (sensor.DecodedOrdinal + 1 != ordinal)
+        {
+            const size_t keyframe =
+                sensor.Reader.FindKeyframe(ordinal);
+
+            if (keyframe >= ordinal)
+            {
+                return false;
+            }
+
+            for (size_t previous = keyframe; previous < ordinal; ++previous)
+            {
+                PlaybackFrame previousFrame;
+
+                if (!DecodeFrame(sensor, previous, previousFrame))
+                {
+                    return false;
+                }
+            }
+        }
+
+        sensor.DecodedOrdinal = entries.size();
+
+        if (!DecodeFrameStreamHeader(recordedFrame.Data, recordedFrame.Size, header) ||
+            FrameStreamHeader::ProtocolCookie != header.Cookie ||
+            !HasCodecExtension(header) ||
+            !DecodeFrameStreamHeaderCodecExtension(
+                recordedFrame.Data + FrameStreamHeader::EncodedLength,
+                recordedFrame.Size - FrameStreamHeader::EncodedLength,
+                header) ||
+            GetEncodedLength(header) + GetPayloadLength(header) != recordedFrame.Size ||
+            !IsValidImageLayout(header))
+        {
+            return false;
+        }
+
+        sensor.Image.resize(
+            static_cast<size_t>(header.ImageHeight) * header.RowStride);
+
+        if (!sensor.Decoder.Decode(
+                header,
+                recordedFrame.Data + GetEncodedLength(header),
+                GetPayloadLength(header),
+                sensor.Image.data()))
+        {
+            return false;
+        }
+
+        sensor.DecodedOrdinal = ordinal;
+
+        SetImage(header, sensor.Image.data(), frame);
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    void RecordingPlayer::ReadMetadata(
+        const std::string& fileName,
+        Sensor& sensor)
+    {
+        std::vector<PoseLogRecord> records;
+
+        if (!ReadPoseLog(fileName + "." + PoseLog::FileExtension, records))
+        {
+            ReadCsvMetadata(
+                fileName + ".csv",
+                sensor);
+        }
+
+        for (const PoseLogRecord& record : records)
+        {
+            sensor.MetadataTimestamps.push_back(record.Timestamp);
+            sensor.Metadata.push_back(record.Metadata);
+        }
+
+        if (!std::is_sorted(sensor.MetadataTimestamps.begin(), sensor.MetadataTimestamps.end()))
+        {
+            dbg::trace(
+                L"RecordingPlayer::ReadMetadata: the transforms of %S are not in timestamp order, ignoring them",
+                fileName.c_str());
+
+            sensor.MetadataTimestamps.clear();
+            sensor.Metadata.clear();
+        }
+    }
+
+    _Use_decl_annotations_
+    void RecordingPlayer::ReadCsvMetadata(
+        const std::string& csvFileName,
+        Sensor& sensor)
+    {
+        std::ifstream file(csvFileName);
+        std::string line;
+
+        //
+        // Skip the column names.
+        //
+        if (!std::getline(file, line))
+        {
+            return;
+        }
+
+        //
+        // Timestamp, ImageFileName, then the three transforms.
+        //
+        while (std::getline(file, line))
+        {
+            const char* cursor = line.c_str();
+            char* end = nullptr;
+
+            const uint64_t timestamp = strtoull(cursor, &end, 10);
+
+            const char* values = strchr(end, ',');
+            values = nullptr != values ? strchr(values + 1, ',') : nullptr;
+
+            if (end == cursor || nullptr == values)
+            {
+                continue;
+            }
+
+            RecordedFrameMetadata metadata;
+            float* value = &metadata.FrameToOrigin[0];
+            size_t valueCount = 0;
+
+            cursor = values;
+
+            while (valueCount < MetadataValueCount && ',' == *cursor)
+            {
+                value[valueCount++] = strtof(cursor + 1, &end);
+                cursor = end;
+            }
+
+            if (MetadataValueCount != valueCount)
+            {
+                continue;
+            }
+
+            sensor.MetadataTimestamps.push_back(timestamp);
+            sensor.Metadata.push_back(metadata);
+        }
+    }
+}
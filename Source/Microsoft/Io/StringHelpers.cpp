@@ -34,6 +34,10 @@ namespace Io
         char* nextToken =
             nullptr;
 
+#if !defined(_WIN32)
+#define strtok_s strtok_r
+#endif /* !defined(_WIN32) */
+
         char* cursor =
             strtok_s(
             tokenizerBuffer.data(),
@@ -50,9 +54,14 @@ namespace Io
                 delimiter.c_str(),
                 &nextToken);
         }
+
+#if !defined(_WIN32)
+#undef strtok_s
+#endif /* !defined(_WIN32) */
     }
 }
 
+#if defined(_WIN32)
 std::wstring Utf8ToUtf16(
     _In_z_ const char* text)
 {
@@ -87,6 +96,25 @@ std::string Utf16ToUtf8(
     return std::string(
         buffer);
 }
+#else
+std::wstring Utf8ToUtf16(
+    _In_z_ const char* text)
+{
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+
+    return converter.from_bytes(
+        text);
+}
+
+std::string Utf16ToUtf8(
+    _In_z_ const wchar_t* text)
+{
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+
+    return converter.to_bytes(
+        text);
+}
+#endif /* defined(_WIN32) */
 
 std::string Utf16ToUtf8(
     _In_ const std::wstring& text)
@@ -130,11 +130,12 @@ namespace Io
         {
             char buffer[32] = {};
 
-            numberOfOctets = sprintf_s(
+            numberOfOctets = snprintf(
                 buffer,
+                sizeof(buffer),
                 "%0*llo",
                 static_cast<int>(N - 1),
-                input);
+                static_cast<unsigned long long>(input));
 
             ASSERT(numberOfOctets <= N - 1);
 
@@ -150,6 +151,7 @@ namespace Io
         }
     }
 
+#if defined(_WIN32)
     void CreateTarball(
         _In_ Windows::Storage::StorageFolder^ sourceFolder,
         _In_ const std::vector<std::wstring>& sourceFileNames,
@@ -316,42 +318,187 @@ namespace Io
         ASSERT(!!CloseHandle(
             output));
     }
+#endif /* defined(_WIN32) */
+
+	namespace
+	{
+		// Size of the TAR header and of the blocks file data is padded to.
+		const size_t TarBlockSize = 512;
+
+		// Direct I/O needs buffers, file offsets and write sizes aligned to
+		// the logical block size of the device, which is at most 4 KiB.
+		const size_t DirectIoAlignment = 4096;
+
+		const uint8_t ZeroBlock[TarBlockSize] = {};
+	}
+
+	Tarball::Tarball(_In_ const std::string& tarballFileName)
+		: Tarball(tarballFileName, TarballOptions()) {
+	}
+
+	Tarball::Tarball(_In_ const std::wstring& tarballFileName)
+		: Tarball(tarballFileName, TarballOptions()) {
+	}
+
+	Tarball::Tarball(
+		_In_ const std::string& tarballFileName,
+		_In_ const TarballOptions& options)
+		: _options(options)
+#if !defined(_WIN32)
+		, _directFile(-1)
+#endif
+		, _stagingBuffer(nullptr)
+		, _stagedSize(0)
+		, _size(0) {
+
+		Open(tarballFileName);
+	}
+
+	Tarball::Tarball(
+		_In_ const std::wstring& tarballFileName,
+		_In_ const TarballOptions& options)
+#if defined(_WIN32)
+		: _options(options)
+		, _stagingBuffer(nullptr)
+		, _stagedSize(0)
+		, _size(0) {
+
+		AllocateStagingBuffer();
+
+		_options.UseDirectIo = false;
 
-	Tarball::Tarball(_In_ const std::wstring& tarballFileName) {
 		_tarballFile.open(tarballFileName, std::ios::binary);
 		ASSERT(_tarballFile.is_open());
 	}
+#else
+		: Tarball(Utf16ToUtf8(tarballFileName), options) {
+	}
+#endif
 
 	Tarball::~Tarball() {
-		Close();
+		// Close throws if the last writes fail, which must not escape.
+		try {
+			Close();
+		}
+		catch (const std::exception& exception) {
+			dbg::trace(
+				L"Tarball::~Tarball: cannot close the tarball: %S",
+				exception.what());
+		}
+	}
+
+	void Tarball::AllocateStagingBuffer() {
+		if (0 == _options.StagingBufferSize) {
+			_options.UseDirectIo = false;
+			return;
+		}
+
+		const size_t stagingBufferSize =
+			(_options.StagingBufferSize + DirectIoAlignment - 1) /
+			DirectIoAlignment * DirectIoAlignment;
+
+		_options.StagingBufferSize = stagingBufferSize;
+		_stagingStorage.resize(stagingBufferSize + DirectIoAlignment);
+
+		const uintptr_t storageAddress =
+			reinterpret_cast<uintptr_t>(_stagingStorage.data());
+
+		_stagingBuffer = _stagingStorage.data() +
+			(DirectIoAlignment - storageAddress % DirectIoAlignment) % DirectIoAlignment;
+	}
+
+	void Tarball::Open(_In_ const std::string& tarballFileName) {
+		AllocateStagingBuffer();
+
+#if !defined(_WIN32) && defined(O_DIRECT)
+		if (_options.UseDirectIo) {
+			_directFile = open(
+				tarballFileName.c_str(),
+				O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT,
+				0644);
+
+			if (_directFile >= 0) {
+				return;
+			}
+
+			// Some file systems, such as tmpfs, do not support direct I/O.
+			ASSERT(EINVAL == errno);
+
+			dbg::trace(
+				L"Tarball::Open: direct I/O is not supported for %S, using buffered writes",
+				tarballFileName.c_str());
+		}
+#endif /* !defined(_WIN32) && defined(O_DIRECT) */
+
+		_options.UseDirectIo = false;
+
+		_tarballFile.open(tarballFileName, std::ios::binary);
+		ASSERT(_tarballFile.is_open());
+	}
+
+	bool Tarball::IsOpen() const {
+#if !defined(_WIN32)
+		if (_directFile >= 0) {
+			return true;
+		}
+#endif /* !defined(_WIN32) */
+
+		return _tarballFile.is_open();
+	}
+
+	uint64_t Tarball::GetSize() const {
+		return _size;
+	}
+
+	bool Tarball::IsDirectIo() const {
+		return _options.UseDirectIo;
 	}
 
 	void Tarball::Close() {
-		if (_tarballFile.is_open()) {
-			// The tarball always ends with two 512 byte blocks of zeros.
-			std::vector<char> alignmentData(512, 0);
-			_tarballFile.write(alignmentData.data(), alignmentData.size());
-			_tarballFile.write(alignmentData.data(), alignmentData.size());
-			_tarballFile.close();
+		if (!IsOpen()) {
+			return;
 		}
+
+		// The tarball always ends with two 512 byte blocks of zeros.
+		AppendZeros(2 * TarBlockSize);
+		Flush();
+
+#if !defined(_WIN32)
+		if (_directFile >= 0) {
+			const int result = close(_directFile);
+			_directFile = -1;
+			ASSERT(0 == result);
+			return;
+		}
+#endif /* !defined(_WIN32) */
+
+		_tarballFile.close();
 	}
 
-	void Tarball::AddFile(
+	uint64_t Tarball::AddFile(
 		_In_ const std::wstring& fileName,
 		_In_ const uint8_t* fileData,
 		_In_ const size_t fileSize) {
 
-		ASSERT(_tarballFile.is_open());
+		return AddFile(Utf16ToUtf8(fileName), fileData, fileSize);
+	}
+
+	uint64_t Tarball::AddFile(
+		_In_ const std::string& fileName,
+		_In_ const uint8_t* fileData,
+		_In_ const size_t fileSize) {
+
+		ASSERT(IsOpen());
 
 		static_assert(
-			sizeof(TarHeader) == 512,
+			sizeof(TarHeader) == TarBlockSize,
 			"Size of the TarHeader structure must be equal to 512 bytes.");
 
 		// Construct the file header.
 
 		TarHeader header;
 
-		CopyStringToTarHeader<100>(Utf16ToUtf8(fileName), header.FileName);
+		CopyStringToTarHeader<100>(fileName, header.FileName);
 		CopyUInt64ToTarHeaderAsOctets<12>(fileSize, header.FileSize);
 		CopyUInt64ToTarHeaderAsOctets<12>(
 			std::chrono::duration_cast<std::chrono::seconds>(
@@ -366,24 +513,131 @@ namespace Io
 
 		CopyUInt64ToTarHeaderAsOctets<7>(headerChecksum, header.Checksum);
 
-		// Write the header and the data to the tarball.
+		// Add the header and the data to the tarball.
+
+		Append(&header, sizeof(header));
+
+		const uint64_t fileOffset = _size;
+
+		Append(fileData, fileSize);
 
-		_tarballFile.write(
-			reinterpret_cast<const char*>(&header), sizeof(header));
-		_tarballFile.write(
-			reinterpret_cast<const char*>(fileData), fileSize);
-		
 		// Make sure the file is aligned to 512 byes, otherwise
 		// pad the file with zeros.
 
-		const size_t lastBlockSize = fileSize % 512;
+		const size_t lastBlockSize = fileSize % TarBlockSize;
 		if (lastBlockSize != 0)
 		{
-			const size_t lastBlockPadding = 512 - lastBlockSize;
-			ASSERT(lastBlockPadding < 512);
+			AppendZeros(TarBlockSize - lastBlockSize);
+		}
+
+		return fileOffset;
+	}
+
+	void Tarball::Append(
+		_In_reads_(size) const void* data,
+		_In_ size_t size) {
 
-			_tarballFile.write(
-				std::vector<char>(lastBlockPadding, 0).data(), lastBlockPadding);
+		const uint8_t* source = static_cast<const uint8_t*>(data);
+
+		_size += size;
+
+		if (nullptr == _stagingBuffer) {
+			Write(source, size);
+			return;
+		}
+
+		// Without direct I/O, data that does not fit is written from where it
+		// is rather than copied through the staging buffer.
+		if (!_options.UseDirectIo &&
+			size > _options.StagingBufferSize - _stagedSize) {
+			Flush();
+
+			if (size >= _options.StagingBufferSize) {
+				Write(source, size);
+				return;
+			}
+		}
+
+		while (size > 0) {
+			const size_t stagedSize = std::min(
+				size, _options.StagingBufferSize - _stagedSize);
+
+			memcpy(_stagingBuffer + _stagedSize, source, stagedSize);
+
+			_stagedSize += stagedSize;
+			source += stagedSize;
+			size -= stagedSize;
+
+			if (_options.StagingBufferSize == _stagedSize) {
+				Flush();
+			}
 		}
 	}
+
+	void Tarball::AppendZeros(
+		_In_ size_t size) {
+
+		while (size > 0) {
+			const size_t zeroSize = std::min(size, sizeof(ZeroBlock));
+
+			Append(ZeroBlock, zeroSize);
+
+			size -= zeroSize;
+		}
+	}
+
+	void Tarball::Flush() {
+		if (0 == _stagedSize) {
+			return;
+		}
+
+#if !defined(_WIN32) && defined(O_DIRECT)
+		const size_t partialBlockSize = _stagedSize % DirectIoAlignment;
+
+		if (_directFile >= 0 && 0 != partialBlockSize) {
+			// Write the whole blocks directly, then the rest through the page
+			// cache, so that the tarball does not grow past its end.
+			Write(_stagingBuffer, _stagedSize - partialBlockSize);
+
+			const int flags = fcntl(_directFile, F_GETFL);
+			ASSERT(-1 != flags);
+			ASSERT(-1 != fcntl(_directFile, F_SETFL, flags & ~O_DIRECT));
+
+			Write(_stagingBuffer + _stagedSize - partialBlockSize, partialBlockSize);
+
+			_stagedSize = 0;
+			return;
+		}
+#endif /* !defined(_WIN32) && defined(O_DIRECT) */
+
+		Write(_stagingBuffer, _stagedSize);
+
+		_stagedSize = 0;
+	}
+
+	void Tarball::Write(
+		_In_reads_(size) const uint8_t* data,
+		_In_ size_t size) {
+
+#if !defined(_WIN32)
+		if (_directFile >= 0) {
+			while (size > 0) {
+				const ssize_t bytesWritten = write(_directFile, data, size);
+
+				if (bytesWritten < 0) {
+					ASSERT(EINTR == errno);
+					continue;
+				}
+
+				data += bytesWritten;
+				size -= static_cast<size_t>(bytesWritten);
+			}
+
+			return;
+		}
+#endif /* !defined(_WIN32) */
+
+		_tarballFile.write(reinterpret_cast<const char*>(data), size);
+		ASSERT(_tarballFile.good());
+	}
 }
@@ -0,0 +1,143 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace Io
+{
+    namespace
+    {
+        const size_t TarBlockSize = 512;
+        const size_t TarFileNameOffset = 0;
+        const size_t TarFileNameLength = 100;
+        const size_t TarFileSizeOffset = 124;
+        const size_t TarFileSizeLength = 12;
+        const size_t TarTypeOffset = 156;
+
+        size_t GetPaddedFileSize(
+            _In_ const size_t fileSize)
+        {
+            return (fileSize + TarBlockSize - 1) / TarBlockSize * TarBlockSize;
+        }
+    }
+
+    _Use_decl_annotations_
+    TarReader::TarReader(
+        const std::string& tarballFileName)
+        : _tarballFile(tarballFileName, std::ios::binary)
+    {
+    }
+
+    bool TarReader::IsOpen() const
+    {
+        return _tarballFile.is_open();
+    }
+
+    _Use_decl_annotations_
+    bool TarReader::ReadNext(
+        std::string& fileName,
+        std::vector<uint8_t>& fileData)
+    {
+        size_t fileSize = 0;
+
+        if (!ReadFileHeader(fileName, fileSize))
+        {
+            return false;
+        }
+
+        fileData.resize(fileSize);
+
+        if (!_tarballFile.read(reinterpret_cast<char*>(fileData.data()), fileSize))
+        {
+            return false;
+        }
+
+        _tarballFile.seekg(GetPaddedFileSize(fileSize) - fileSize, std::ios::cur);
+
+        return true;
+    }
+
+    _Use_decl_annotations_
+    bool TarReader::SkipNext(
+        std::string& fileName)
+    {
+        size_t fileSize = 0;
+
+        if (!ReadFileHeader(fileName, fileSize))
+        {
+            return false;
+        }
+
+        _tarballFile.seekg(GetPaddedFileSize(fileSize), std::ios::cur);
+
+        return true;
+    }
+
+    uint64_t TarReader::GetPosition()
+    {
+        return static_cast<uint64_t>(_tarballFile.tellg());
+    }
+
+    _Use_decl_annotations_
+    void TarReader::SetPosition(
+        const uint64_t position)
+    {
+        //
+        // Reading past the end of the archive leaves the stream failed.
+        //
+        _tarballFile.clear();
+        _tarballFile.seekg(static_cast<std::streamoff>(position), std::ios::beg);
+    }
+
+    _Use_decl_annotations_
+    bool TarReader::ReadFileHeader(
+        std::string& fileName,
+        size_t& fileSize)
+    {
+        char header[TarBlockSize];
+
+        while (_tarballFile.read(header, sizeof(header)))
+        {
+            //
+            // The archive ends with two blocks of zeroes.
+            //
+            if ('\0' == header[TarFileNameOffset])
+            {
+                return false;
+            }
+
+            fileName.assign(
+                header + TarFileNameOffset,
+                strnlen(header + TarFileNameOffset, TarFileNameLength));
+
+            const std::string fileSizeField(
+                header + TarFileSizeOffset,
+                TarFileSizeLength);
+
+            fileSize =
+                static_cast<size_t>(strtoull(fileSizeField.c_str(), nullptr, 8));
+
+            const char type = header[TarTypeOffset];
+
+            if ('0' != type && '\0' != type)
+            {
+                //
+                // Skip anything that is not a regular file.
+                //
+                _tarballFile.seekg(GetPaddedFileSize(fileSize), std::ios::cur);
+                continue;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+}
@@ -14,10 +14,31 @@
 #include <string>
 #include <vector>
 
+#include <cctype>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <codecvt>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <locale>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#if defined(_WIN32)
 #include "targetver.h"
 
 #ifndef WIN32_LEAN_AND_MEAN
@@ -28,6 +49,19 @@
 #include <ppltasks.h>
 #include <memorybuffer.h>
 #include <robuffer.h>
+#else
+#include <cerrno>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
 
 #include <Debugging/All.h>
 #include <Io/All.h>
@@ -0,0 +1,17 @@
+#pragma once
+
+// Stand-in for the Visual Studio precompiled headers, used when the platform
+// neutral sources are built outside of the UWP projects.
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
@@ -0,0 +1,299 @@
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/CsvWriter.h>
+
+//
+// Checks that everything Io::CsvWriter writes parses back unchanged: rows of the
+// schema the recorder used for its CSV files, the extremes of every type it formats,
+// and text longer than its buffer. The files are written to the directory given as
+// the argument, or the current directory.
+//
+namespace
+{
+   const size_t ROW_COUNT = 2000; //About 1 MB, so the buffer is written many times.
+   const size_t VALUE_COUNT = 48; //Three 4x4 matrices per row.
+
+   struct Row
+   {
+      uint64_t Timestamp;
+      std::string ImageFileName;
+      float Values[VALUE_COUNT];
+   };
+
+   //Random matrices at full float precision, as tracked poses have, with a few
+   //values that are exactly 0 and 1, as in the rotation parts of real transforms.
+   std::vector<Row> MakeRows()
+   {
+      std::mt19937 random(42);
+      std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+
+      std::vector<Row> rows(ROW_COUNT);
+
+      for (size_t i = 0; i < rows.size(); i++)
+      {
+         rows[i].Timestamp = 131711138130000 + i * 333333;
+
+         char fileName[64];
+         snprintf(fileName, sizeof(fileName), "short_throw_depth\\%020llu.pgm",
+            static_cast<unsigned long long>(rows[i].Timestamp));
+         rows[i].ImageFileName = fileName;
+
+         for (size_t j = 0; j < VALUE_COUNT; j++)
+         {
+            rows[i].Values[j] = j % 16 == 15 ? 1.0f : (j % 16 == 3 ? 0.0f : distribution(random));
+         }
+      }
+
+      return rows;
+   }
+
+   bool ReadLines(const std::string& fileName, std::vector<std::string>& lines)
+   {
+      std::ifstream file(fileName);
+      std::string line;
+
+      lines.clear();
+      while (std::getline(file, line))
+      {
+         lines.push_back(line);
+      }
+
+      //The writer ends the file with an empty line when it is destroyed.
+      if (!lines.empty() && lines.back().empty())
+      {
+         lines.pop_back();
+      }
+
+      return !lines.empty();
+   }
+
+   bool IsSameFloat(float left, float right)
+   {
+      return memcmp(&left, &right, sizeof(left)) == 0;
+   }
+
+   bool IsSameDouble(double left, double right)
+   {
+      return memcmp(&left, &right, sizeof(left)) == 0;
+   }
+
+   //Writes the rows with a header, and checks that every value parses back bit for bit.
+   bool CheckRows(const std::string& fileName)
+   {
+      std::vector<Row> rows = MakeRows();
+
+      {
+         Io::CsvWriter csvWriter(fileName);
+         csvWriter.WriteHeader({ "Timestamp", "ImageFileName", "Values" });
+
+         for (const Row& row : rows)
+         {
+            bool writeComma = false;
+
+            csvWriter.WriteUInt64(row.Timestamp, &writeComma);
+            csvWriter.WriteText(row.ImageFileName, &writeComma);
+
+            for (float value : row.Values)
+            {
+               csvWriter.WriteFloat(value, &writeComma);
+            }
+
+            csvWriter.EndLine();
+         }
+      }
+
+      std::vector<std::string> lines;
+      if (!ReadLines(fileName, lines) ||
+         lines.size() != rows.size() + 1 ||
+         lines[0] != "Timestamp,ImageFileName,Values")
+      {
+         return false;
+      }
+
+      for (size_t i = 0; i < rows.size(); i++)
+      {
+         const char* cursor = lines[i + 1].c_str();
+         char* end = nullptr;
+
+         bool isSame = strtoull(cursor, &end, 10) == rows[i].Timestamp && *end == ',';
+
+         cursor = end + 1;
+         isSame = isSame && strncmp(cursor, rows[i].ImageFileName.c_str(), rows[i].ImageFileName.size()) == 0;
+         cursor += rows[i].ImageFileName.size();
+
+         for (size_t j = 0; j < VALUE_COUNT && isSame; j++)
+         {
+            isSame = *cursor == ',' && IsSameFloat(strtof(cursor + 1, &end), rows[i].Values[j]);
+            cursor = end;
+         }
+
+         if (!isSame || *cursor != '\0')
+         {
+            printf("Row %zu does not parse back: %s\n", i, lines[i + 1].c_str());
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   //Writes the extremes of every type and checks that they parse back unchanged.
+   bool CheckEdgeValues(const std::string& fileName)
+   {
+      const int32_t int32Values[] = { 0, 1, -1, INT32_MAX, INT32_MIN };
+      const uint64_t uint64Values[] = { 0, 9, 10, UINT64_MAX };
+      const float floatValues[] = { 0.0f, -0.0f, 1.0f, -1.5f, 0.1f, FLT_MIN, FLT_MAX, -FLT_MAX,
+         FLT_EPSILON, 1e-45f, 16777217.0f, 3.14159274f };
+      const double doubleValues[] = { 0.0, -0.0, 0.1, DBL_MIN, DBL_MAX, -DBL_MAX, DBL_EPSILON,
+         4.9e-324, 131711138130000.25 };
+
+      {
+         Io::CsvWriter csvWriter(fileName);
+         bool writeComma = false;
+
+         for (int32_t value : int32Values)
+         {
+            csvWriter.WriteInt32(value, &writeComma);
+         }
+
+         for (uint64_t value : uint64Values)
+         {
+            csvWriter.WriteUInt64(value, &writeComma);
+         }
+
+         for (float value : floatValues)
+         {
+            csvWriter.WriteFloat(value, &writeComma);
+         }
+
+         for (double value : doubleValues)
+         {
+            csvWriter.WriteDouble(value, &writeComma);
+         }
+
+         csvWriter.EndLine();
+      }
+
+      std::vector<std::string> lines;
+      if (!ReadLines(fileName, lines) || lines.size() != 1)
+      {
+         return false;
+      }
+
+      const char* cursor = lines[0].c_str();
+      char* end = nullptr;
+      bool isSame = true;
+
+      for (int32_t value : int32Values)
+      {
+         isSame = isSame && strtoll(cursor, &end, 10) == value;
+         cursor = end + 1;
+      }
+
+      for (uint64_t value : uint64Values)
+      {
+         isSame = isSame && strtoull(cursor, &end, 10) == value;
+         cursor = end + 1;
+      }
+
+      for (float value : floatValues)
+      {
+         isSame = isSame && IsSameFloat(strtof(cursor, &end), value);
+         cursor = end + 1;
+      }
+
+      for (double value : doubleValues)
+      {
+         isSame = isSame && IsSameDouble(strtod(cursor, &end), value);
+         cursor = end + 1;
+      }
+
+      if (!isSame)
+      {
+         printf("Edge values do not parse back: %s\n", lines[0].c_str());
+      }
+
+      return isSame;
+   }
+
+   //Text longer than the buffer is written from where it is, between buffered values.
+   bool CheckLongText(const std::string& fileName)
+   {
+      std::string text(Io::CsvWriter::BufferSize + 100, 'x');
+      for (size_t i = 0; i < text.size(); i += 97)
+      {
+         text[i] = static_cast<char>('a' + i % 26);
+      }
+
+      {
+         Io::CsvWriter csvWriter(fileName);
+         bool writeComma = false;
+
+         csvWriter.WriteInt32(1, &writeComma);
+         csvWriter.WriteText(text, &writeComma);
+         csvWriter.WriteInt32(2, &writeComma);
+         csvWriter.EndLine();
+      }
+
+      std::vector<std::string> lines;
+
+      return ReadLines(fileName, lines) &&
+         lines.size() == 1 &&
+         lines[0] == "1," + text + ",2";
+   }
+
+   //Flush writes the buffered lines before the writer is destroyed.
+   bool CheckFlush(const std::string& fileName)
+   {
+      Io::CsvWriter csvWriter(fileName);
+      bool writeComma = false;
+
+      csvWriter.WriteUInt64(42, &writeComma);
+      csvWriter.EndLine();
+      csvWriter.Flush();
+
+      std::vector<std::string> lines;
+
+      return ReadLines(fileName, lines) &&
+         lines.size() == 1 &&
+         lines[0] == "42";
+   }
+
+   bool Check(bool condition, const char* description)
+   {
+      printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+      return condition;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   std::string directory = argc > 1 ? argv[1] : ".";
+   std::string fileName = directory + "/CsvWriterTest.csv";
+
+   bool isValid = true;
+
+   isValid &= Check(CheckRows(fileName),
+      "rows of full precision floats parse back unchanged");
+   isValid &= Check(CheckEdgeValues(fileName),
+      "the extremes of every type parse back unchanged");
+   isValid &= Check(CheckLongText(fileName),
+      "text longer than the buffer is written in place");
+   isValid &= Check(CheckFlush(fileName),
+      "flushed lines are in the file before the writer closes it");
+
+   remove(fileName.c_str());
+
+   return isValid ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "pch.h"
+
+#include "CV/DepthSegmenter.h"
+
+#include <cstring>
+#include <random>
+
+using namespace HoloHands;
+
+//
+// Checks that DepthSegmenter::Process gives the same scaled and foreground images as
+// the chain of OpenCV operations HandDetector used before, DepthSegmenter::
+// ProcessReference, bit for bit. Every 16 bit depth goes through the vectorized kernel
+// and through the scalar one, for several scales and thresholds, and a noisy frame is
+// processed through a view, whose rows are not continuous.
+//
+namespace
+{
+   const int DEPTH_VALUE_COUNT = 65536;
+
+   struct Setting
+   {
+      float MaxImageDepth;
+      float DetectionThreshold;
+   };
+
+   // HandDetector's setting first.
+   const Setting SETTINGS[] =
+   {
+      { 1000, 170 },
+      { 4000, 100.5f },
+      { 600, 255 },
+      { 1000, 0 },
+      { 65535, 128 }
+   };
+
+   bool IsSame(const cv::Mat& a, const cv::Mat& b)
+   {
+      if (a.size() != b.size() || a.type() != b.type())
+      {
+         return false;
+      }
+
+      for (int y = 0; y < a.rows; y++)
+      {
+         if (memcmp(a.ptr<uint8_t>(y), b.ptr<uint8_t>(y), a.cols * a.elemSize()) != 0)
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   bool Check(const DepthSegmenter& segmenter, const cv::Mat& depth, const char* name, const Setting& setting)
+   {
+      cv::Mat scaled;
+      cv::Mat foreground;
+      segmenter.Process(depth, scaled, foreground);
+
+      cv::Mat referenceScaled;
+      cv::Mat referenceForeground;
+      segmenter.ProcessReference(depth, referenceScaled, referenceForeground);
+
+      bool isSame = IsSame(scaled, referenceScaled) && IsSame(foreground, referenceForeground);
+
+      printf("%-6s %-26s depth %8.1f, threshold %6.1f\n",
+         isSame ? "PASS" : "FAIL",
+         name,
+         setting.MaxImageDepth,
+         setting.DetectionThreshold);
+
+      return isSame;
+   }
+
+   // Every depth in a single row, which the vectorized kernel processes.
+   cv::Mat MakeRamp()
+   {
+      cv::Mat ramp(1, DEPTH_VALUE_COUNT, CV_16UC1);
+      for (int i = 0; i < DEPTH_VALUE_COUNT; i++)
+      {
+         ramp.at<uint16_t>(i) = static_cast<uint16_t>(i);
+      }
+
+      return ramp;
+   }
+
+   // Every depth in a view whose rows are too narrow for the vectorized kernel, so
+   // they are processed by the scalar one.
+   cv::Mat MakeNarrowRamp()
+   {
+      const int width = 8;
+
+      cv::Mat ramp(DEPTH_VALUE_COUNT / width, width * 2, CV_16UC1, cv::Scalar(0));
+      for (int i = 0; i < DEPTH_VALUE_COUNT; i++)
+      {
+         ramp.at<uint16_t>(i / width, i % width) = static_cast<uint16_t>(i);
+      }
+
+      return ramp(cv::Rect(0, 0, width, ramp.rows));
+   }
+
+   // A short throw depth frame with noise and invalid pixels, seen through a view
+   // that does not start on a vector boundary.
+   cv::Mat MakeFrameView()
+   {
+      std::mt19937 random(42);
+      std::uniform_int_distribution<int> depth(0, 4000);
+
+      cv::Mat frame(450, 448, CV_16UC1);
+      for (int y = 0; y < frame.rows; y++)
+      {
+         for (int x = 0; x < frame.cols; x++)
+         {
+            int value = depth(random);
+            frame.at<uint16_t>(y, x) = static_cast<uint16_t>(value < 200 ? 0 : value);
+         }
+      }
+
+      return frame(cv::Rect(3, 5, 401, 397));
+   }
+}
+
+int main()
+{
+   cv::Mat ramp = MakeRamp();
+   cv::Mat narrowRamp = MakeNarrowRamp();
+   cv::Mat frameView = MakeFrameView();
+
+   bool isValid = true;
+
+   for (const Setting& setting : SETTINGS)
+   {
+      DepthSegmenter segmenter;
+      segmenter.Configure(setting.MaxImageDepth, setting.DetectionThreshold);
+
+      isValid &= Check(segmenter, ramp, segmenter.IsVectorized() ? "every depth, vectorized" : "every depth", setting);
+      isValid &= Check(segmenter, narrowRamp, "every depth, scalar", setting);
+      isValid &= Check(segmenter, frameView, "frame view", setting);
+   }
+
+   return isValid ? 0 : 1;
+}
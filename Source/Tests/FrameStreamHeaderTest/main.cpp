@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/DepthCodec.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/FrameDeltaCodec.h>
+
+//
+// Checks Io::IsValidImageLayout, which receivers call on headers read from the
+// network or a recording before allocating the image and the payload they describe,
+// and the flag that marks the keyframes of a delta stream.
+//
+namespace
+{
+   const uint32_t WIDTH = 448;
+   const uint32_t HEIGHT = 450;
+
+   Io::FrameStreamHeader MakeHeader(uint32_t pixelStride)
+   {
+      Io::FrameStreamHeader header;
+
+      header.ImageWidth = WIDTH;
+      header.ImageHeight = HEIGHT;
+      header.PixelStride = pixelStride;
+      header.RowStride = WIDTH * pixelStride;
+
+      return header;
+   }
+
+   bool Check(bool condition, const char* description)
+   {
+      printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+      return condition;
+   }
+}
+
+int main()
+{
+   bool isValid = true;
+
+   //Uncompressed images.
+   {
+      Io::FrameStreamHeader header = MakeHeader(2);
+      isValid &= Check(Io::IsValidImageLayout(header),
+         "an uncompressed depth image is accepted");
+
+      header.RowStride = WIDTH * 2 + 64;
+      isValid &= Check(Io::IsValidImageLayout(header),
+         "rows may be padded");
+
+      header.RowStride = WIDTH * 2 - 1;
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "a row stride shorter than a row is rejected");
+
+      header = MakeHeader(0);
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "a pixel stride of zero is rejected");
+
+      header = MakeHeader(4);
+      header.ImageWidth = 0x40000000;
+      header.RowStride = 0;
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "a row length that overflows 32 bits is rejected");
+
+      header = MakeHeader(4);
+      header.ImageHeight = 0xffffffff;
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "an image larger than the maximum is rejected");
+   }
+
+   //Compressed images.
+   {
+      Io::FrameStreamHeader header = MakeHeader(2);
+      Io::SetFrameCodec(header, Io::FrameCodec::Depth, 0);
+
+      header.PayloadLength = static_cast<uint32_t>(Io::GetMaxEncodedDepthImageLength(WIDTH, HEIGHT));
+      isValid &= Check(Io::IsValidImageLayout(header),
+         "a depth payload up to the encoder's maximum is accepted");
+
+      header.PayloadLength++;
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "a depth payload beyond the encoder's maximum is rejected");
+
+      header = MakeHeader(4);
+      Io::SetFrameCodec(header, Io::FrameCodec::Depth, 0);
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "the depth codec is rejected for other than 16 bit pixels");
+
+      header = MakeHeader(4);
+      Io::SetFrameCodec(header, Io::FrameCodec::Delta, 0);
+
+      header.PayloadLength = static_cast<uint32_t>(Io::GetMaxEncodedFrameDeltaLength(WIDTH, HEIGHT, 4));
+      isValid &= Check(Io::IsValidImageLayout(header),
+         "a delta payload up to the encoder's maximum is accepted");
+
+      header.PayloadLength++;
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "a delta payload beyond the encoder's maximum is rejected");
+
+      header.Codec = static_cast<Io::FrameCodec>(7);
+      header.PayloadLength = 0;
+      isValid &= Check(!Io::IsValidImageLayout(header),
+         "an unknown codec is rejected");
+   }
+
+   //Keyframes of a delta stream.
+   {
+      Io::FrameStreamHeader header = MakeHeader(2);
+      Io::SetDeltaKeyframe(header);
+
+      uint8_t buffer[Io::FrameStreamHeader::MaxEncodedLength];
+      Io::EncodeFrameStreamHeader(header, buffer);
+
+      Io::FrameStreamHeader decoded;
+      bool isDecoded =
+         Io::DecodeFrameStreamHeader(buffer, sizeof(buffer), decoded) &&
+         Io::HasCodecExtension(decoded) &&
+         Io::DecodeFrameStreamHeaderCodecExtension(
+            buffer + Io::FrameStreamHeader::EncodedLength,
+            sizeof(buffer) - Io::FrameStreamHeader::EncodedLength,
+            decoded);
+
+      isValid &= Check(isDecoded && Io::IsDeltaKeyframe(decoded) && Io::IsValidImageLayout(decoded),
+         "an uncompressed keyframe marked for delta frames keeps its flag through encoding");
+
+      isValid &= Check(!Io::IsDeltaKeyframe(MakeHeader(2)),
+         "a version 0.1 frame is not a delta keyframe");
+
+      Io::SetFrameCodec(header, Io::FrameCodec::Depth, 0);
+      isValid &= Check(!Io::IsDeltaKeyframe(header),
+         "setting the codec clears the flag");
+   }
+
+   return isValid ? 0 : 1;
+}
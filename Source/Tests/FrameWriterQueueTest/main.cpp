@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/FrameSendQueue.h>
+#include <Io/FrameWriterQueue.h>
+
+//
+// Checks Io::FrameWriterQueue, the queue and writer thread behind
+// HoloLensForCV::SensorFrameRecorderSink: every frame the queue accepted must be
+// written once and in order, including the ones still queued when writing stops,
+// and a full queue drops and counts the frames that arrive.
+//
+namespace
+{
+   const size_t RECORDER_QUEUE_CAPACITY = 15; //As in SensorFrameRecorderSink.
+   const int FRAME_COUNT = 600;
+   const int FRAME_INTERVAL = 200; //Microseconds between arriving frames.
+   const int FRAME_WRITE_TIME = 1; //Milliseconds the writer takes per frame.
+   const int FAILED_WRITE_INTERVAL = 7; //Every 7th frame fails to be written.
+
+   struct Frame
+   {
+      explicit Frame(int index)
+         :
+         Index(index)
+      {}
+
+      int Index;
+   };
+
+   typedef std::shared_ptr<Frame> FramePtr;
+
+   bool Check(bool condition, const char* description)
+   {
+      printf("%s %s\n", condition ? "PASS" : "FAIL", description);
+      return condition;
+   }
+}
+
+int main()
+{
+   bool isValid = true;
+
+   //A full lossless queue reports an overflow and keeps its frames.
+   {
+      Io::FrameSendQueue<int> queue(Io::FrameSendPolicy(Io::FrameDropPolicy::Lossless, 1, 3));
+
+      for (int i = 0; i < 3; i++)
+      {
+         queue.Push(i);
+      }
+
+      bool isOverflow = queue.Push(3) == Io::FrameQueueResult::Overflow;
+
+      int first = -1;
+      queue.Pop(first);
+
+      isValid &= Check(isOverflow && queue.GetSize() == 2 && queue.GetDroppedCount() == 1 && first == 0,
+         "a full lossless queue rejects new frames");
+   }
+
+   //The writer is held on the first frame while the queue fills up, then stopped.
+   {
+      Io::FrameWriterQueue<int> writerQueue(RECORDER_QUEUE_CAPACITY);
+      std::vector<int> writtenFrames;
+      std::mutex gateMutex;
+      std::condition_variable gateChanged;
+      bool isWriterBlocked = false;
+      bool isGateOpen = false;
+
+      writerQueue.Start([&](const int& frame)
+      {
+         if (frame == 0)
+         {
+            std::unique_lock<std::mutex> gateLock(gateMutex);
+            isWriterBlocked = true;
+            gateChanged.notify_all();
+            gateChanged.wait(gateLock, [&]() { return isGateOpen; });
+         }
+
+         writtenFrames.push_back(frame);
+         return true;
+      });
+
+      writerQueue.Push(0);
+
+      {
+         std::unique_lock<std::mutex> gateLock(gateMutex);
+         gateChanged.wait(gateLock, [&]() { return isWriterBlocked; });
+      }
+
+      int acceptedCount = 1;
+      for (int i = 1; i <= static_cast<int>(RECORDER_QUEUE_CAPACITY) + 1; i++)
+      {
+         acceptedCount += writerQueue.Push(i) ? 1 : 0;
+      }
+
+      {
+         std::lock_guard<std::mutex> gateGuard(gateMutex);
+         isGateOpen = true;
+      }
+      gateChanged.notify_all();
+
+      bool isStopped = writerQueue.Stop();
+
+      std::vector<int> expectedFrames(RECORDER_QUEUE_CAPACITY + 1);
+      for (size_t i = 0; i < expectedFrames.size(); i++)
+      {
+         expectedFrames[i] = static_cast<int>(i);
+      }
+
+      isValid &= Check(acceptedCount == static_cast<int>(RECORDER_QUEUE_CAPACITY) + 1 &&
+         writerQueue.GetDroppedCount() == 1 &&
+         writerQueue.GetHighWaterMark() == RECORDER_QUEUE_CAPACITY,
+         "a full queue drops and counts the next frame");
+      isValid &= Check(isStopped && writtenFrames == expectedFrames &&
+         writerQueue.GetWrittenCount() == expectedFrames.size(),
+         "the frames queued when writing stops are written");
+      isValid &= Check(!writerQueue.Push(0) && !writerQueue.IsWriting() && !writerQueue.Stop(),
+         "frames pushed after stopping are not queued");
+   }
+
+   //Frames arrive faster than the writer keeps up with, and some fail to be written.
+   Io::FrameWriterQueue<FramePtr> writerQueue(RECORDER_QUEUE_CAPACITY);
+   std::vector<int> writtenFrames;
+   int failedWriteCount = 0;
+
+   writerQueue.Start([&](const FramePtr& frame)
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_WRITE_TIME));
+
+      if (frame->Index % FAILED_WRITE_INTERVAL == 0)
+      {
+         failedWriteCount++;
+         return false;
+      }
+
+      writtenFrames.push_back(frame->Index);
+      return true;
+   });
+
+   std::vector<int> acceptedFrames;
+   int acceptedFailingCount = 0;
+   std::weak_ptr<Frame> lastFrame;
+
+   auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < FRAME_COUNT; i++)
+   {
+      std::this_thread::sleep_until(start + std::chrono::microseconds(i * FRAME_INTERVAL));
+
+      FramePtr frame = std::make_shared<Frame>(i);
+      if (writerQueue.Push(frame))
+      {
+         if (i % FAILED_WRITE_INTERVAL == 0)
+         {
+            acceptedFailingCount++;
+         }
+         else
+         {
+            acceptedFrames.push_back(i);
+         }
+      }
+
+      lastFrame = frame;
+   }
+
+   writerQueue.Stop();
+
+   printf("Frames: %d sent, %llu written, %llu dropped, %d failed, at most %zu queued\n",
+      FRAME_COUNT,
+      static_cast<unsigned long long>(writerQueue.GetWrittenCount()),
+      static_cast<unsigned long long>(writerQueue.GetDroppedCount()),
+      failedWriteCount,
+      writerQueue.GetHighWaterMark());
+
+   isValid &= Check(writtenFrames == acceptedFrames && failedWriteCount == acceptedFailingCount,
+      "every accepted frame is written once and in order");
+   isValid &= Check(writerQueue.GetWrittenCount() == acceptedFrames.size(),
+      "frames that fail to be written are not counted as written");
+   isValid &= Check(acceptedFrames.size() + acceptedFailingCount + writerQueue.GetDroppedCount() == FRAME_COUNT,
+      "every frame is either written, failed or counted as dropped");
+   isValid &= Check(writerQueue.GetHighWaterMark() > 0 && writerQueue.GetHighWaterMark() <= RECORDER_QUEUE_CAPACITY,
+      "the queue stays within its capacity");
+   isValid &= Check(lastFrame.expired(),
+      "no frame is held after stopping");
+
+   //A restart begins with fresh statistics.
+   writerQueue.Start([](const FramePtr&) { return true; });
+   writerQueue.Push(std::make_shared<Frame>(FRAME_COUNT));
+   writerQueue.Stop();
+
+   isValid &= Check(writerQueue.GetWrittenCount() == 1 && writerQueue.GetDroppedCount() == 0,
+      "a restarted writer counts from zero");
+
+   return isValid ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include "pch.h"
+
+#include "CV/ConvexityDefectExtractor.h"
+#include "CV/Defect.h"
+#include "CV/DepthSegmenter.h"
+#include "CV/HandDetector.h"
+
+#include <atomic>
+#include <cmath>
+#include <new>
+
+using namespace HoloHands;
+
+//
+// Checks that the hand detection pipeline does not allocate once it is warm. The
+// global operator new is replaced with one that counts, which covers the standard
+// containers and every cv::Mat buffer, as OpenCV allocates the header of each with new.
+//
+// DepthSegmenter::Process and ConvexityDefectExtractor::FindDefect must not allocate
+// at all. HandDetector::Process writes into preallocated outputs everywhere, but
+// Canny, blur and findContours allocate scratch buffers inside OpenCV on every call.
+// Those three calls are exempt: the test makes them itself, as the detector does, and
+// the detector may allocate no more than they did.
+//
+namespace
+{
+   std::atomic<uint64_t> g_allocationCount(0);
+}
+
+//Every form is replaced, as sanitizers supply their own for any left out.
+void* operator new(size_t size)
+{
+   g_allocationCount++;
+
+   void* pointer = std::malloc(size > 0 ? size : 1);
+   if (pointer == nullptr)
+   {
+      throw std::bad_alloc();
+   }
+
+   return pointer;
+}
+
+void* operator new[](size_t size)
+{
+   return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+   g_allocationCount++;
+   return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+   return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+   std::free(pointer);
+}
+
+namespace
+{
+   const int FRAME_COUNT = 10;
+   const int WARM_UP_PASS_COUNT = 2; //Passes over the frames before allocations are counted.
+   const float MAX_IMAGE_DEPTH = 1000; //As in HandDetector.
+   const float MAX_DETECTION_THRESHOLD = 170;
+
+   float DistanceToSegment(const cv::Point2f& point, const cv::Point2f& start, const cv::Point2f& end)
+   {
+      cv::Point2f along = end - start;
+      float t = std::max(0.f, std::min(1.f, (point - start).dot(along) / along.dot(along)));
+      cv::Point2f offset = point - (start + along * t);
+
+      return std::sqrt(offset.dot(offset));
+   }
+
+   // An open hand in front of a wall, a palm with two spread fingers, moving across
+   // the frame. The wall is further away than the detection threshold.
+   cv::Mat MakeFrame(int index)
+   {
+      cv::Point2f palm(150.f + index * 15.f, 280.f);
+      cv::Point2f finger1 = palm + cv::Point2f(-50.f, -110.f);
+      cv::Point2f finger2 = palm + cv::Point2f(50.f, -110.f);
+
+      cv::Mat depth(450, 448, CV_16UC1);
+      for (int y = 0; y < depth.rows; y++)
+      {
+         for (int x = 0; x < depth.cols; x++)
+         {
+            cv::Point2f point(static_cast<float>(x), static_cast<float>(y));
+            cv::Point2f fromPalm = point - palm;
+
+            bool isHand =
+               fromPalm.dot(fromPalm) < 50.f * 50.f ||
+               DistanceToSegment(point, palm, finger1) < 10.f ||
+               DistanceToSegment(point, palm, finger2) < 10.f;
+
+            depth.at<uint16_t>(y, x) = static_cast<uint16_t>(isHand ? 500 + (x + y) % 7 : 900 + y / 2);
+         }
+      }
+
+      return depth;
+   }
+
+   // The calls HandDetector::FindContoursInRegion makes to OpenCV for the full frame,
+   // into buffers reused between frames as the detector's are.
+   struct ExemptCalls
+   {
+      cv::Mat Edges;
+      std::vector<std::vector<cv::Point>> Contours;
+
+      void Run(const cv::Mat& foreground)
+      {
+         Edges.create(foreground.size(), CV_8UC1);
+
+         cv::Canny(foreground, Edges, 200, 250);
+         cv::blur(Edges, Edges, cv::Size(6, 6), cv::Point(-1, -1), cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+         cv::findContours(Edges, Contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+      }
+
+      const std::vector<cv::Point>* GetLargestContour() const
+      {
+         const std::vector<cv::Point>* largest = nullptr;
+
+         for (const auto& contour : Contours)
+         {
+            if (largest == nullptr || contour.size() > largest->size())
+            {
+               largest = &contour;
+            }
+         }
+
+         return largest;
+      }
+   };
+
+   struct Counts
+   {
+      Counts()
+         :
+         Segmenter(0),
+         ExemptCalls(0),
+         DefectExtractor(0),
+         Detector(0)
+      {}
+
+      uint64_t Segmenter;
+      uint64_t ExemptCalls;
+      uint64_t DefectExtractor;
+      uint64_t Detector;
+   };
+
+   void PrintCount(const char* name, uint64_t count)
+   {
+      printf("%-40s %8.2f per frame\n", name, static_cast<double>(count) / FRAME_COUNT);
+   }
+}
+
+int main()
+{
+   //Parallel OpenCV calls would allocate on worker threads, and count those too.
+   cv::setNumThreads(0);
+
+   std::vector<cv::Mat> frames;
+   for (int i = 0; i < FRAME_COUNT; i++)
+   {
+      frames.push_back(MakeFrame(i));
+   }
+
+   DepthSegmenter segmenter;
+   segmenter.Configure(MAX_IMAGE_DEPTH, MAX_DETECTION_THRESHOLD);
+
+   ConvexityDefectExtractor defectExtractor;
+   defectExtractor.SetImageSize(frames[0].size());
+
+   HandDetector handDetector;
+
+   cv::Mat scaled;
+   cv::Mat foreground;
+   ExemptCalls exemptCalls;
+   Counts counts;
+   int foundCount = 0;
+
+   for (int pass = 0; pass <= WARM_UP_PASS_COUNT; pass++)
+   {
+      counts = Counts();
+
+      for (cv::Mat& frame : frames)
+      {
+         uint64_t before = g_allocationCount;
+         segmenter.Process(frame, scaled, foreground);
+         counts.Segmenter += g_allocationCount - before;
+
+         before = g_allocationCount;
+         exemptCalls.Run(foreground);
+         counts.ExemptCalls += g_allocationCount - before;
+
+         const std::vector<cv::Point>* contour = exemptCalls.GetLargestContour();
+         if (contour != nullptr)
+         {
+            Defect defect;
+
+            before = g_allocationCount;
+            defectExtractor.FindDefect(*contour, defect);
+            counts.DefectExtractor += g_allocationCount - before;
+         }
+
+         before = g_allocationCount;
+         foundCount += handDetector.Process(frame) ? 1 : 0;
+         counts.Detector += g_allocationCount - before;
+      }
+   }
+
+   bool isValid =
+      counts.Segmenter == 0 &&
+      counts.DefectExtractor == 0 &&
+      counts.Detector <= counts.ExemptCalls &&
+      foundCount > 0;
+
+   printf("Allocations once warm, over %d frames:\n", FRAME_COUNT);
+   PrintCount("DepthSegmenter::Process", counts.Segmenter);
+   PrintCount("ConvexityDefectExtractor::FindDefect", counts.DefectExtractor);
+   PrintCount("HandDetector::Process", counts.Detector);
+   PrintCount("Canny, blur and findContours (exempt)", counts.ExemptCalls);
+   printf("%s\n", isValid ? "PASS" : "FAIL");
+
+   return isValid ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+#include "pch.h"
+
+#include "CV/ConvexityDefectExtractor.h"
+#include "CV/Defect.h"
+#include "CV/DepthSegmenter.h"
+#include "FrameHelpers.h"
+
+#include <Debugging/All.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/FrameDeltaCodec.h>
+#include <Io/TarReader.h>
+#include <Io/FrameIndex.h>
+#include <Io/RecordedFrameReader.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace HoloHands;
+
+//
+// Times ConvexityDefectExtractor::FindDefect on the hand contours of a recording,
+// against the way it found defects before: the convex hull computed twice on a cv::Mat
+// wrapping the contour, once as points and once as indices, and every defect returned
+// by convexityDefects built and scored. Both must select the same defect.
+//
+// The contours are found as HandDetector finds them: the segmented depth image's Canny
+// edges, blurred into closed outlines, and the external contours of those whose bounds
+// are large enough to be a hand.
+//
+namespace
+{
+   const float MAX_IMAGE_DEPTH = 1000; //As in HandDetector.
+   const float MAX_DETECTION_THRESHOLD = 170;
+   const int MIN_CONTOUR_SIZE = 40;
+
+   struct Options
+   {
+      Options()
+         :
+         RepeatCount(20)
+      {}
+
+      std::string TarballFileName;
+      int RepeatCount;
+   };
+
+   // ConvexityDefectExtractor::FindDefect before the hull was found once.
+   class ReferenceDefectExtractor
+   {
+   public:
+      explicit ReferenceDefectExtractor(const cv::Size& imageSize)
+         :
+         _imageSize(imageSize)
+      {}
+
+      bool FindDefect(const std::vector<cv::Point>& contour, Defect& outDefect)
+      {
+         cv::convexHull(cv::Mat(contour), _hull);
+         cv::convexHull(cv::Mat(contour), _hullIndices, false, false);
+
+         cv::convexityDefects(contour, _hullIndices, _defects);
+
+         Defect defectCandidate;
+         double highestScore = 0;
+
+         for (size_t d = 1; d < _defects.size(); d++)
+         {
+            Defect defect = GetDefectFromContour(contour, _defects[d]);
+            if (defect.Depth > MIN_DEFECT_DEPTH)
+            {
+               double score = CalculateDefectScore(defect);
+
+               if (score > highestScore)
+               {
+                  highestScore = score;
+                  defectCandidate = defect;
+               }
+            }
+         }
+
+         if (highestScore > 0)
+         {
+            outDefect = defectCandidate;
+            return true;
+         }
+
+         return false;
+      }
+
+   private:
+      const double MIN_DEFECT_DEPTH = 20;
+      const double HEIGHT_BIAS = 1.0;
+      const double DEPTH_BIAS = 0.5;
+      const double VERTICALITY_BIAS = 10.0;
+
+      cv::Size _imageSize;
+      std::vector<cv::Point> _hull;
+      std::vector<int> _hullIndices;
+      std::vector<cv::Vec4i> _defects;
+
+      double CalculateDefectScore(const Defect& defect) const
+      {
+         const cv::Point2d vertical(0, 1);
+         cv::Point2d position = defect.Far;
+         cv::Point2d direction = (defect.Mid - defect.Far);
+         direction /= cv::norm(direction);
+
+         return
+            (_imageSize.height - position.y) * HEIGHT_BIAS +
+            defect.Depth * DEPTH_BIAS +
+            vertical.dot(direction) * VERTICALITY_BIAS;
+      }
+
+      static Defect GetDefectFromContour(const std::vector<cv::Point>& contour, const cv::Vec4i& defectIndices)
+      {
+         Defect defect;
+         defect.Start = cv::Point(contour[defectIndices[0]]);
+         defect.End = cv::Point(contour[defectIndices[1]]);
+         defect.Far = cv::Point(contour[defectIndices[2]]);
+         defect.Mid = (defect.Start + defect.End) / 2.0;
+         defect.Depth = defectIndices[3] / 256.0f;
+
+         return defect;
+      }
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: ConvexityDefectBenchmark <short_throw_depth.tar> [options]\n"
+         "  --repeat <count>    Times each contour is processed per extractor.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--repeat" && hasValue)
+         {
+            options.RepeatCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument[0] != '-' && options.TarballFileName.empty())
+         {
+            options.TarballFileName = argument;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return !options.TarballFileName.empty();
+   }
+
+   double Percentile(std::vector<double>& samples, double fraction)
+   {
+      if (samples.empty())
+      {
+         return 0;
+      }
+
+      std::sort(samples.begin(), samples.end());
+
+      size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+      return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+   }
+
+   // Finds the contours large enough to be a hand in every depth frame of the recording.
+   bool ReadContours(
+      const std::string& tarballFileName,
+      std::vector<std::vector<cv::Point>>& handContours,
+      cv::Size& imageSize)
+   {
+      Io::RecordedFrameReader reader(tarballFileName);
+      if (!reader.IsOpen())
+      {
+         return false;
+      }
+
+      DepthSegmenter depthSegmenter;
+      depthSegmenter.Configure(MAX_IMAGE_DEPTH, MAX_DETECTION_THRESHOLD);
+
+      std::string fileName;
+      std::vector<uint8_t> fileData;
+      cv::Mat image;
+      cv::Mat scaled;
+      cv::Mat foreground;
+      cv::Mat edges;
+      std::vector<std::vector<cv::Point>> contours;
+
+      while (reader.ReadNext(fileName, fileData))
+      {
+         if (!WrapPgmWithCvMat(fileData, image) || image.type() != CV_16UC1)
+         {
+            continue;
+         }
+
+         imageSize = image.size();
+
+         depthSegmenter.Process(image, scaled, foreground);
+         cv::Canny(foreground, edges, 200, 250);
+         cv::blur(edges, edges, cv::Size(6, 6));
+         cv::findContours(edges, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+
+         for (const std::vector<cv::Point>& contour : contours)
+         {
+            cv::Rect bound = cv::boundingRect(contour);
+            if (bound.width > MIN_CONTOUR_SIZE && bound.height > MIN_CONTOUR_SIZE)
+            {
+               handContours.push_back(contour);
+            }
+         }
+      }
+
+      return true;
+   }
+
+   bool IsSameDefect(bool found, const Defect& defect, bool referenceFound, const Defect& reference)
+   {
+      if (found != referenceFound)
+      {
+         return false;
+      }
+
+      return !found ||
+         (defect.Start == reference.Start &&
+         defect.End == reference.End &&
+         defect.Far == reference.Far &&
+         defect.Depth == reference.Depth);
+   }
+
+   void PrintResult(const char* name, std::vector<double>& times, double seconds, size_t pointCount)
+   {
+      printf("%-12s %10.2f %10.2f %10.2f %12.1f\n",
+         name,
+         Percentile(times, 0.50),
+         Percentile(times, 0.99),
+         seconds * 1e6 / times.size(),
+         pointCount / seconds / 1e6);
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   std::vector<std::vector<cv::Point>> contours;
+   cv::Size imageSize;
+
+   if (!ReadContours(options.TarballFileName, contours, imageSize))
+   {
+      std::cerr << "Cannot open " << options.TarballFileName << "\n";
+      return 2;
+   }
+
+   if (contours.empty())
+   {
+      std::cerr << "No hand contours found in " << options.TarballFileName << "\n";
+      return 2;
+   }
+
+   ConvexityDefectExtractor extractor;
+   extractor.SetImageSize(imageSize);
+
+   ReferenceDefectExtractor referenceExtractor(imageSize);
+
+   std::vector<double> times;
+   std::vector<double> referenceTimes;
+   double seconds = 0;
+   double referenceSeconds = 0;
+   size_t pointCount = 0;
+   size_t differentCount = 0;
+
+   for (int pass = 0; pass < options.RepeatCount; pass++)
+   {
+      for (const std::vector<cv::Point>& contour : contours)
+      {
+         Defect referenceDefect;
+         auto start = std::chrono::steady_clock::now();
+         bool referenceFound = referenceExtractor.FindDefect(contour, referenceDefect);
+         double referenceTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         Defect defect;
+         start = std::chrono::steady_clock::now();
+         bool found = extractor.FindDefect(contour, defect);
+         double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         referenceTimes.push_back(referenceTime * 1e6);
+         referenceSeconds += referenceTime;
+         times.push_back(time * 1e6);
+         seconds += time;
+         pointCount += contour.size();
+
+         if (pass == 0 && !IsSameDefect(found, defect, referenceFound, referenceDefect))
+         {
+            differentCount++;
+         }
+      }
+   }
+
+   printf("Contours:    %zu, %.0f points on average, %d passes\n",
+      contours.size(),
+      static_cast<double>(pointCount) / times.size(),
+      options.RepeatCount);
+   printf("%-12s %10s %10s %10s %12s\n", "Extractor", "p50 us", "p99 us", "mean us", "Mpoints/s");
+   PrintResult("Two hulls", referenceTimes, referenceSeconds, pointCount);
+   PrintResult("One hull", times, seconds, pointCount);
+
+   printf("\nFinding the hull once is %.1fx faster; %zu of %zu contours select a different defect.\n",
+      seconds > 0 ? referenceSeconds / seconds : 0,
+      differentCount,
+      contours.size());
+
+   return differentCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/CsvWriter.h>
+
+//
+// Rows per second of Io::CsvWriter on the 50 column schema the recorder used for its
+// CSV files: a timestamp, an image file name and three 4x4 matrices. For comparison,
+// the same rows are written the way CsvWriter used to write them, formatting every
+// value with operator<< on a std::ofstream and ending every line with std::endl.
+//
+// That every value CsvWriter writes parses back unchanged is checked by
+// Tests/CsvWriterTest.
+//
+namespace
+{
+   struct Options
+   {
+      Options()
+         :
+         RowCount(100000),
+         Directory("."),
+         KeepFiles(false)
+      {}
+
+      int RowCount;
+      std::string Directory;
+      bool KeepFiles;
+   };
+
+   struct Row
+   {
+      uint64_t Timestamp;
+      std::string ImageFileName;
+      float Values[48];
+   };
+
+   const size_t VALUE_COUNT = 48;
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: CsvWriterBenchmark [options]\n"
+         "  --rows <count>      Rows written per writer.\n"
+         "  --directory <path>  Directory the files are written to.\n"
+         "  --keep              Keep the files.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--rows" && hasValue)
+         {
+            options.RowCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--directory" && hasValue)
+         {
+            options.Directory = argv[++i];
+         }
+         else if (argument == "--keep")
+         {
+            options.KeepFiles = true;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   //Random matrices at full float precision, as tracked poses have, with a few
+   //values that are exactly 0 and 1, as in the rotation parts of real transforms.
+   std::vector<Row> MakeRows(const Options& options)
+   {
+      std::mt19937 random(42);
+      std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+
+      std::vector<Row> rows(options.RowCount);
+
+      for (size_t i = 0; i < rows.size(); i++)
+      {
+         rows[i].Timestamp = 131711138130000 + i * 333333;
+
+         char fileName[64];
+         snprintf(fileName, sizeof(fileName), "short_throw_depth\\%020llu.pgm",
+            static_cast<unsigned long long>(rows[i].Timestamp));
+         rows[i].ImageFileName = fileName;
+
+         for (size_t j = 0; j < VALUE_COUNT; j++)
+         {
+            rows[i].Values[j] = j % 16 == 15 ? 1.0f : (j % 16 == 3 ? 0.0f : distribution(random));
+         }
+      }
+
+      return rows;
+   }
+
+   std::vector<std::string> GetColumns()
+   {
+      std::vector<std::string> columns = { "Timestamp", "ImageFileName" };
+      const char* transforms[] = { "FrameToOrigin", "CameraViewTransform", "CameraProjectionTransform" };
+
+      for (const char* transform : transforms)
+      {
+         for (int i = 0; i < 16; i++)
+         {
+            columns.push_back(std::string(transform) + ".m" + std::to_string(i / 4 + 1) + std::to_string(i % 4 + 1));
+         }
+      }
+
+      return columns;
+   }
+
+   //Returns the seconds until the file was closed.
+   double WriteWithCsvWriter(const std::string& fileName, const std::vector<Row>& rows)
+   {
+      auto start = std::chrono::steady_clock::now();
+
+      {
+         Io::CsvWriter csvWriter(fileName);
+         csvWriter.WriteHeader(GetColumns());
+
+         for (const Row& row : rows)
+         {
+            bool writeComma = false;
+
+            csvWriter.WriteUInt64(row.Timestamp, &writeComma);
+            csvWriter.WriteText(row.ImageFileName, &writeComma);
+
+            for (float value : row.Values)
+            {
+               csvWriter.WriteFloat(value, &writeComma);
+            }
+
+            csvWriter.EndLine();
+         }
+      }
+
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   //The way CsvWriter wrote before it buffered and formatted the values itself.
+   double WriteWithStream(const std::string& fileName, const std::vector<Row>& rows)
+   {
+      auto start = std::chrono::steady_clock::now();
+
+      {
+         std::ofstream file(fileName);
+
+         std::vector<std::string> columns = GetColumns();
+         for (size_t i = 0; i < columns.size(); i++)
+         {
+            file << (i > 0 ? "," : "") << columns[i];
+         }
+
+         file << std::endl;
+
+         for (const Row& row : rows)
+         {
+            file << row.Timestamp << ',' << row.ImageFileName;
+
+            for (float value : row.Values)
+            {
+               file << ',' << value;
+            }
+
+            file << std::endl;
+         }
+      }
+
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   long GetFileSize(const std::string& fileName)
+   {
+      std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+      return file ? static_cast<long>(file.tellg()) : 0;
+   }
+
+   void PrintResult(const char* name, double seconds, const std::string& fileName, size_t rowCount)
+   {
+      long bytes = GetFileSize(fileName);
+
+      printf("%-12s %12.0f %10.1f %12.1f\n",
+         name,
+         seconds > 0 ? rowCount / seconds : 0,
+         seconds > 0 ? bytes / seconds / 1e6 : 0,
+         static_cast<double>(bytes) / rowCount);
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   std::vector<Row> rows = MakeRows(options);
+
+   std::string csvWriterFileName = options.Directory + "/csv_writer.csv";
+   std::string streamFileName = options.Directory + "/ofstream.csv";
+
+   double streamSeconds = WriteWithStream(streamFileName, rows);
+   double csvWriterSeconds = WriteWithCsvWriter(csvWriterFileName, rows);
+
+   printf("Writing %zu rows of 50 columns to %s\n", rows.size(), options.Directory.c_str());
+   printf("%-12s %12s %10s %12s\n", "Writer", "rows/s", "MB/s", "bytes/row");
+   PrintResult("ofstream", streamSeconds, streamFileName, rows.size());
+   PrintResult("CsvWriter", csvWriterSeconds, csvWriterFileName, rows.size());
+
+   printf("\nCsvWriter is %.1fx faster.\n",
+      csvWriterSeconds > 0 ? streamSeconds / csvWriterSeconds : 0);
+
+   if (!options.KeepFiles)
+   {
+      remove(csvWriterFileName.c_str());
+      remove(streamFileName.c_str());
+   }
+
+   return 0;
+}
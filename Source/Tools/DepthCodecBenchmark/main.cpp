@@ -0,0 +1,338 @@
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/DepthCodec.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/FrameDeltaCodec.h>
+#include <Io/TarReader.h>
+#include <Io/FrameIndex.h>
+#include <Io/RecordedFrameReader.h>
+
+//
+// Measures the compression ratio and the encode and decode throughput of the lossless
+// depth codec used by the frame stream protocol, on recorded short throw depth frames
+// or, without a recording, on synthetic ones. Every frame is decoded and compared with
+// the original.
+//
+// The frames are then compressed as a sequence, with delta frames between keyframes,
+// which is what the streaming server and the recorder do with a keyframe interval.
+//
+namespace
+{
+   struct DepthImage
+   {
+      uint32_t Width;
+      uint32_t Height;
+      std::vector<uint8_t> Pixels; //Little endian, rows are Width * 2 bytes apart.
+   };
+
+   // Reads a whitespace separated decimal number from a PGM header.
+   bool ReadPgmNumber(const std::vector<uint8_t>& data, size_t& position, uint32_t& value)
+   {
+      while (position < data.size() && isspace(data[position]))
+      {
+         position++;
+      }
+
+      if (position >= data.size() || !isdigit(data[position]))
+      {
+         return false;
+      }
+
+      value = 0;
+      while (position < data.size() && isdigit(data[position]))
+      {
+         value = value * 10 + (data[position] - '0');
+         position++;
+      }
+
+      return true;
+   }
+
+   // Reads a 16 bit PGM file written by the recorder. Returns false for other images.
+   bool ReadDepthPgm(const std::vector<uint8_t>& fileData, DepthImage& image)
+   {
+      if (fileData.size() < 2 || fileData[0] != 'P' || fileData[1] != '5')
+      {
+         return false;
+      }
+
+      size_t position = 2;
+      uint32_t maxValue = 0;
+
+      if (!ReadPgmNumber(fileData, position, image.Width) ||
+         !ReadPgmNumber(fileData, position, image.Height) ||
+         !ReadPgmNumber(fileData, position, maxValue) ||
+         maxValue <= 255)
+      {
+         return false;
+      }
+
+      //A single whitespace character separates the header from the pixels.
+      position++;
+
+      size_t imageSize = static_cast<size_t>(image.Width) * image.Height * 2;
+
+      if (position + imageSize > fileData.size())
+      {
+         return false;
+      }
+
+      image.Pixels.assign(
+         fileData.begin() + position,
+         fileData.begin() + position + imageSize);
+
+      return true;
+   }
+
+   // A hand in front of a wall: smooth surfaces with sensor noise, and a ring of
+   // invalid pixels around the edge, as in the short throw depth image.
+   void MakeSyntheticImage(int index, DepthImage& image)
+   {
+      image.Width = 450;
+      image.Height = 448;
+      image.Pixels.assign(static_cast<size_t>(image.Width) * image.Height * 2, 0);
+
+      uint32_t seed = 12345 + index;
+      float handX = 150.0f + (index % 60) * 2.5f;
+      float handY = 224.0f;
+
+      for (uint32_t y = 0; y < image.Height; ++y)
+      {
+         for (uint32_t x = 0; x < image.Width; ++x)
+         {
+            float dx = x - 225.0f;
+            float dy = y - 224.0f;
+
+            uint16_t depth = 0;
+
+            if (dx * dx + dy * dy < 210.0f * 210.0f)
+            {
+               seed = seed * 1103515245 + 12345;
+               int noise = static_cast<int>((seed >> 16) % 5) - 2;
+
+               float hx = x - handX;
+               float hy = y - handY;
+               bool isHand = hx * hx + hy * hy < 45.0f * 45.0f;
+
+               depth = static_cast<uint16_t>(
+                  (isHand ? 450 + (hx + hy) * 0.5f : 900 + y * 0.8f) + noise);
+            }
+
+            image.Pixels[(y * image.Width + x) * 2] = static_cast<uint8_t>(depth);
+            image.Pixels[(y * image.Width + x) * 2 + 1] = static_cast<uint8_t>(depth >> 8);
+         }
+      }
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   std::string tarballFileName;
+   int syntheticFrameCount = 60;
+   int iterations = 5;
+   uint32_t keyframeInterval = 30;
+
+   for (int i = 1; i < argc; ++i)
+   {
+      if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+      {
+         syntheticFrameCount = atoi(argv[++i]);
+      }
+      else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+      {
+         iterations = atoi(argv[++i]);
+      }
+      else if (strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc)
+      {
+         keyframeInterval = static_cast<uint32_t>(atoi(argv[++i]));
+      }
+      else if (argv[i][0] != '-' && tarballFileName.empty())
+      {
+         tarballFileName = argv[i];
+      }
+      else
+      {
+         std::cerr << "Usage: DepthCodecBenchmark [short_throw_depth.tar] [--frames N] [--iterations N] [--keyframe-interval N]" << std::endl;
+         return 2;
+      }
+   }
+
+   std::vector<DepthImage> images;
+
+   if (!tarballFileName.empty())
+   {
+      Io::RecordedFrameReader reader(tarballFileName);
+
+      if (!reader.IsOpen())
+      {
+         std::cerr << "Could not open " << tarballFileName << std::endl;
+         return 2;
+      }
+
+      std::string fileName;
+      std::vector<uint8_t> fileData;
+      DepthImage image;
+
+      while (reader.ReadNext(fileName, fileData))
+      {
+         if (ReadDepthPgm(fileData, image))
+         {
+            images.push_back(image);
+         }
+      }
+   }
+   else
+   {
+      images.resize(syntheticFrameCount);
+
+      for (int i = 0; i < syntheticFrameCount; ++i)
+      {
+         MakeSyntheticImage(i, images[i]);
+      }
+   }
+
+   if (images.empty())
+   {
+      std::cerr << "No 16 bit depth frames found." << std::endl;
+      return 2;
+   }
+
+   size_t rawBytes = 0;
+   size_t encodedBytes = 0;
+   double encodeSeconds = 0;
+   double decodeSeconds = 0;
+   int mismatchCount = 0;
+
+   std::vector<uint8_t> encoded;
+   std::vector<uint8_t> decoded;
+
+   for (const DepthImage& image : images)
+   {
+      const uint32_t rowStride = image.Width * 2;
+
+      encoded.resize(Io::GetMaxEncodedDepthImageLength(image.Width, image.Height));
+      decoded.assign(image.Pixels.size(), 0);
+
+      size_t encodedLength = 0;
+      bool isDecoded = true;
+
+      auto encodeStart = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < iterations; ++i)
+      {
+         encodedLength = Io::EncodeDepthImage(
+            image.Pixels.data(), image.Width, image.Height, rowStride, encoded.data());
+      }
+
+      auto decodeStart = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < iterations; ++i)
+      {
+         isDecoded &= Io::DecodeDepthImage(
+            encoded.data(), encodedLength, image.Width, image.Height, rowStride, decoded.data());
+      }
+
+      auto decodeEnd = std::chrono::steady_clock::now();
+
+      encodeSeconds += std::chrono::duration<double>(decodeStart - encodeStart).count();
+      decodeSeconds += std::chrono::duration<double>(decodeEnd - decodeStart).count();
+      rawBytes += image.Pixels.size();
+      encodedBytes += encodedLength;
+
+      if (!isDecoded || decoded != image.Pixels)
+      {
+         mismatchCount++;
+      }
+   }
+
+   const double megabytes = static_cast<double>(rawBytes) * iterations / (1024.0 * 1024.0);
+
+   printf("Frames:           %zu (%s)\n", images.size(), tarballFileName.empty() ? "synthetic" : tarballFileName.c_str());
+   printf("Raw size:         %.2f MB\n", rawBytes / (1024.0 * 1024.0));
+   printf("Encoded size:     %.2f MB\n", encodedBytes / (1024.0 * 1024.0));
+   printf("Ratio:            %.2f : 1\n", static_cast<double>(rawBytes) / encodedBytes);
+   printf("Encode:           %.1f MB/s, %.3f ms per frame\n",
+      megabytes / encodeSeconds, encodeSeconds * 1000.0 / (images.size() * iterations));
+   printf("Decode:           %.1f MB/s, %.3f ms per frame\n",
+      megabytes / decodeSeconds, decodeSeconds * 1000.0 / (images.size() * iterations));
+
+   //
+   // Delta frames between keyframes; keyframes are depth compressed.
+   //
+   size_t deltaBytes = 0;
+   size_t keyframeCount = 0;
+   double deltaEncodeSeconds = 0;
+   double deltaDecodeSeconds = 0;
+
+   for (int i = 0; i < iterations; ++i)
+   {
+      Io::FrameDeltaEncoder encoder(keyframeInterval);
+      Io::FrameDeltaDecoder decoder;
+
+      deltaBytes = 0;
+      keyframeCount = 0;
+
+      for (const DepthImage& image : images)
+      {
+         Io::FrameStreamHeader header;
+         header.ImageWidth = image.Width;
+         header.ImageHeight = image.Height;
+         header.PixelStride = 2;
+         header.RowStride = image.Width * 2;
+
+         auto encodeStart = std::chrono::steady_clock::now();
+
+         if (encoder.Encode(header, image.Pixels.data(), encoded))
+         {
+            Io::SetFrameCodec(header, Io::FrameCodec::Delta, static_cast<uint32_t>(encoded.size()));
+         }
+         else
+         {
+            encoded.resize(Io::GetMaxEncodedDepthImageLength(image.Width, image.Height));
+            encoded.resize(Io::EncodeDepthImage(
+               image.Pixels.data(), image.Width, image.Height, header.RowStride, encoded.data()));
+
+            Io::SetFrameCodec(header, Io::FrameCodec::Depth, static_cast<uint32_t>(encoded.size()));
+            Io::SetDeltaKeyframe(header);
+            keyframeCount++;
+         }
+
+         auto decodeStart = std::chrono::steady_clock::now();
+
+         decoded.resize(image.Pixels.size());
+         bool isDecoded = decoder.Decode(header, encoded.data(), encoded.size(), decoded.data());
+
+         auto decodeEnd = std::chrono::steady_clock::now();
+
+         deltaEncodeSeconds += std::chrono::duration<double>(decodeStart - encodeStart).count();
+         deltaDecodeSeconds += std::chrono::duration<double>(decodeEnd - decodeStart).count();
+         deltaBytes += encoded.size();
+
+         if (i == 0 && (!isDecoded || decoded != image.Pixels))
+         {
+            mismatchCount++;
+         }
+      }
+   }
+
+   printf("\nWith delta frames, a keyframe every %u frames (%zu keyframes):\n", keyframeInterval, keyframeCount);
+   printf("Encoded size:     %.2f MB\n", deltaBytes / (1024.0 * 1024.0));
+   printf("Ratio:            %.2f : 1\n", static_cast<double>(rawBytes) / deltaBytes);
+   printf("Encode:           %.1f MB/s, %.3f ms per frame\n",
+      megabytes / deltaEncodeSeconds, deltaEncodeSeconds * 1000.0 / (images.size() * iterations));
+   printf("Decode:           %.1f MB/s, %.3f ms per frame\n",
+      megabytes / deltaDecodeSeconds, deltaDecodeSeconds * 1000.0 / (images.size() * iterations));
+
+   printf("\nMismatches:       %i\n", mismatchCount);
+
+   return mismatchCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,464 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/FrameBuffer.h>
+
+//
+// Stress benchmark for Io::FrameBuffer, the frame buffer behind
+// HoloLensForCV::MultiFrameBuffer. One producer thread per sensor pushes frames
+// while reader threads poll for the latest frame and look up frames by time, the
+// way the hand tracking pipeline and the recorder do on the device.
+//
+namespace
+{
+   // Stand-in for SensorFrame^, reference counted and filled in by the producer.
+   struct Frame
+   {
+      Frame(int32_t sensor, int64_t timestamp)
+         :
+         Sensor(sensor),
+         Timestamp(timestamp),
+         Pixels(FRAME_SIZE, static_cast<uint8_t>(timestamp))
+      {}
+
+      static const size_t FRAME_SIZE = 4096;
+
+      int32_t Sensor;
+      int64_t Timestamp;
+      std::vector<uint8_t> Pixels;
+   };
+
+   typedef std::shared_ptr<const Frame> FramePtr;
+
+   // The mutex and deque based buffer that Io::FrameBuffer replaced, kept as the baseline.
+   class MutexFrameBuffer
+   {
+   public:
+      MutexFrameBuffer(size_t /* sensorCount */, size_t capacity)
+         :
+         _capacity(capacity)
+      {}
+
+      bool Push(int32_t sensor, int64_t timestamp, const FramePtr& frame)
+      {
+         std::lock_guard<std::mutex> guard(_mutex);
+
+         auto& frames = _frames[sensor];
+         frames.push_back(std::make_pair(timestamp, frame));
+
+         while (frames.size() > _capacity)
+         {
+            frames.pop_front();
+         }
+
+         return true;
+      }
+
+      bool GetLatestFrame(int32_t sensor, FramePtr& frame)
+      {
+         std::lock_guard<std::mutex> guard(_mutex);
+
+         auto& frames = _frames[sensor];
+         if (frames.empty())
+         {
+            return false;
+         }
+
+         frame = frames.back().second;
+         return true;
+      }
+
+      bool GetFrameForTime(int32_t sensor, int64_t timestamp, float toleranceInSeconds, FramePtr& frame)
+      {
+         std::lock_guard<std::mutex> guard(_mutex);
+
+         for (const auto& entry : _frames[sensor])
+         {
+            if (std::abs((timestamp - entry.first) * 1e-7) < toleranceInSeconds)
+            {
+               frame = entry.second;
+               return true;
+            }
+         }
+
+         return false;
+      }
+
+      int64_t GetTimestampForSensorPair(int32_t a, int32_t b, float toleranceInSeconds)
+      {
+         std::vector<int64_t> timestampsA;
+         std::vector<int64_t> timestampsB;
+
+         {
+            std::lock_guard<std::mutex> guard(_mutex);
+
+            for (const auto& entry : _frames[a])
+            {
+               timestampsA.push_back(entry.first);
+            }
+
+            for (const auto& entry : _frames[b])
+            {
+               timestampsB.push_back(entry.first);
+            }
+         }
+
+         int64_t best = 0;
+
+         for (int64_t timestampA : timestampsA)
+         {
+            for (int64_t timestampB : timestampsB)
+            {
+               if (std::abs((timestampA - timestampB) * 1e-7) < toleranceInSeconds && timestampA > best)
+               {
+                  best = timestampA;
+               }
+            }
+         }
+
+         return best;
+      }
+
+   private:
+      size_t _capacity;
+      std::mutex _mutex;
+      std::map<int32_t, std::deque<std::pair<int64_t, FramePtr>>> _frames;
+   };
+
+   struct Options
+   {
+      Options()
+         :
+         SensorCount(4),
+         ReaderCount(4),
+         Capacity(5),
+         Seconds(2)
+      {}
+
+      int SensorCount;
+      int ReaderCount;
+      int Capacity;
+      double Seconds;
+   };
+
+   struct Result
+   {
+      Result()
+         :
+         PushCount(0),
+         DroppedCount(0),
+         ReadCount(0),
+         MissCount(0),
+         ErrorCount(0)
+      {}
+
+      uint64_t PushCount;
+      uint64_t DroppedCount;
+      uint64_t ReadCount;
+      uint64_t MissCount;
+      uint64_t ErrorCount; //Frames of the wrong sensor, or going back in time.
+      std::vector<double> PushTimes;
+      std::vector<double> ReadTimes;
+   };
+
+   const float SYNC_TOLERANCE = 0.001f; //Seconds between frames matched by time.
+   const size_t MAX_SAMPLES = 1000000; //Latency samples kept per thread.
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: FrameBufferBenchmark [options]\n"
+         "  --sensors <count>   Producer threads, one per sensor.\n"
+         "  --readers <count>   Reader threads.\n"
+         "  --capacity <count>  Frames buffered per sensor.\n"
+         "  --seconds <value>   Duration of each run.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--sensors" && hasValue)
+         {
+            options.SensorCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--readers" && hasValue)
+         {
+            options.ReaderCount = std::max(0, atoi(argv[++i]));
+         }
+         else if (argument == "--capacity" && hasValue)
+         {
+            options.Capacity = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--seconds" && hasValue)
+         {
+            options.Seconds = std::max(0.01, atof(argv[++i]));
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   double Percentile(std::vector<double>& samples, double fraction)
+   {
+      if (samples.empty())
+      {
+         return 0;
+      }
+
+      std::sort(samples.begin(), samples.end());
+
+      size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+      return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+   }
+
+   int64_t GetTimestamp()
+   {
+      return std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+   }
+
+   double MicrosecondsSince(std::chrono::steady_clock::time_point start)
+   {
+      return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   template <typename TBuffer>
+   Result Run(const Options& options)
+   {
+      TBuffer buffer(options.SensorCount, options.Capacity);
+
+      std::atomic<bool> isRunning(true);
+      std::vector<Result> results(options.SensorCount + options.ReaderCount);
+      std::vector<std::thread> threads;
+
+      for (int sensor = 0; sensor < options.SensorCount; sensor++)
+      {
+         threads.emplace_back([&, sensor]()
+         {
+            Result& result = results[sensor];
+
+            while (isRunning)
+            {
+               //All sensors share a clock counting hundreds of nanoseconds, like the device.
+               int64_t timestamp = GetTimestamp();
+               FramePtr frame = std::make_shared<Frame>(sensor, timestamp);
+
+               auto start = std::chrono::steady_clock::now();
+               bool isPushed = buffer.Push(sensor, timestamp, frame);
+               double time = MicrosecondsSince(start);
+
+               result.PushCount++;
+               result.DroppedCount += isPushed ? 0 : 1;
+
+               if (result.PushTimes.size() < MAX_SAMPLES)
+               {
+                  result.PushTimes.push_back(time);
+               }
+            }
+         });
+      }
+
+      for (int reader = 0; reader < options.ReaderCount; reader++)
+      {
+         threads.emplace_back([&, reader]()
+         {
+            Result& result = results[options.SensorCount + reader];
+            std::vector<int64_t> latestTimestamps(options.SensorCount, 0);
+            FramePtr frame;
+
+            for (uint64_t i = 0; isRunning; i++)
+            {
+               int32_t sensor = static_cast<int32_t>(i % options.SensorCount);
+
+               auto start = std::chrono::steady_clock::now();
+               bool isFound;
+               int64_t timestamp = latestTimestamps[sensor];
+
+               //Half of the reads poll the latest frame, the others match frames by time.
+               switch (i % 4)
+               {
+               case 2:
+                  timestamp = buffer.GetTimestampForSensorPair(
+                     sensor,
+                     static_cast<int32_t>((sensor + 1) % options.SensorCount),
+                     SYNC_TOLERANCE);
+
+                  isFound = timestamp != 0 && buffer.GetFrameForTime(sensor, timestamp, SYNC_TOLERANCE, frame);
+                  break;
+
+               case 3:
+                  isFound = buffer.GetFrameForTime(sensor, timestamp, SYNC_TOLERANCE, frame);
+                  break;
+
+               default:
+                  isFound = buffer.GetLatestFrame(sensor, frame);
+                  break;
+               }
+
+               double time = MicrosecondsSince(start);
+
+               result.ReadCount++;
+
+               if (!isFound)
+               {
+                  result.MissCount++;
+               }
+               else if (frame->Sensor != sensor ||
+                  frame->Pixels.back() != static_cast<uint8_t>(frame->Timestamp))
+               {
+                  result.ErrorCount++;
+               }
+               else if (i % 4 >= 2)
+               {
+                  if (std::abs((frame->Timestamp - timestamp) * 1e-7) >= SYNC_TOLERANCE)
+                  {
+                     result.ErrorCount++;
+                  }
+               }
+               else
+               {
+                  //The latest frame of a sensor never goes back in time.
+                  if (frame->Timestamp < latestTimestamps[sensor])
+                  {
+                     result.ErrorCount++;
+                  }
+
+                  latestTimestamps[sensor] = frame->Timestamp;
+               }
+
+               if (result.ReadTimes.size() < MAX_SAMPLES)
+               {
+                  result.ReadTimes.push_back(time);
+               }
+            }
+         });
+      }
+
+      std::this_thread::sleep_for(std::chrono::duration<double>(options.Seconds));
+      isRunning = false;
+
+      for (std::thread& thread : threads)
+      {
+         thread.join();
+      }
+
+      Result total;
+
+      for (Result& result : results)
+      {
+         total.PushCount += result.PushCount;
+         total.DroppedCount += result.DroppedCount;
+         total.ReadCount += result.ReadCount;
+         total.MissCount += result.MissCount;
+         total.ErrorCount += result.ErrorCount;
+         total.PushTimes.insert(total.PushTimes.end(), result.PushTimes.begin(), result.PushTimes.end());
+         total.ReadTimes.insert(total.ReadTimes.end(), result.ReadTimes.begin(), result.ReadTimes.end());
+      }
+
+      return total;
+   }
+
+   // Microseconds per GetTimestampForSensorPair call on a full buffer, with the second
+   // sensor lagging a few frames behind the first as the slower cameras do.
+   template <typename TBuffer>
+   double MeasureSync(const Options& options)
+   {
+      const int64_t frameInterval = 333333; //30 frames per second.
+      const int64_t offset = 50000; //5ms between the two sensors.
+      const int lagFrameCount = 3;
+      const int lookupCount = 10000;
+
+      TBuffer buffer(2, options.Capacity);
+
+      for (int i = 0; i < options.Capacity + lagFrameCount; i++)
+      {
+         int64_t timestamp = (i + 1) * frameInterval;
+
+         buffer.Push(0, timestamp, std::make_shared<Frame>(0, timestamp));
+
+         if (i < options.Capacity)
+         {
+            buffer.Push(1, timestamp + offset, std::make_shared<Frame>(1, timestamp + offset));
+         }
+      }
+
+      int64_t checksum = 0;
+      auto start = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < lookupCount; i++)
+      {
+         checksum += buffer.GetTimestampForSensorPair(0, 1, 0.01f);
+      }
+
+      double time = MicrosecondsSince(start) / lookupCount;
+
+      return checksum != 0 ? time : -1;
+   }
+
+   void PrintResult(const char* name, Result& result, double seconds)
+   {
+      printf("%-12s %12.0f %12.0f %9.3f %9.3f %9.3f %9.3f %8llu %8llu\n",
+         name,
+         result.PushCount / seconds,
+         result.ReadCount / seconds,
+         Percentile(result.PushTimes, 0.50),
+         Percentile(result.PushTimes, 0.99),
+         Percentile(result.ReadTimes, 0.50),
+         Percentile(result.ReadTimes, 0.99),
+         static_cast<unsigned long long>(result.DroppedCount),
+         static_cast<unsigned long long>(result.ErrorCount));
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   printf("Sensors: %d, readers: %d, capacity: %d, %.1fs per run\n",
+      options.SensorCount,
+      options.ReaderCount,
+      options.Capacity,
+      options.Seconds);
+
+   Result mutexResult = Run<MutexFrameBuffer>(options);
+   Result ringResult = Run<Io::FrameBuffer<FramePtr>>(options);
+
+   printf("%-12s %12s %12s %9s %9s %9s %9s %8s %8s\n",
+      "Buffer", "pushes/s", "reads/s", "push p50", "push p99", "read p50", "read p99", "dropped", "errors");
+   PrintResult("Mutex", mutexResult, options.Seconds);
+   PrintResult("Ring", ringResult, options.Seconds);
+   printf("Latencies in microseconds.\n");
+
+   printf("Sensor pair sync: %.3fus with the mutex, %.3fus with the ring\n",
+      MeasureSync<MutexFrameBuffer>(options),
+      MeasureSync<Io::FrameBuffer<FramePtr>>(options));
+
+   return mutexResult.ErrorCount + ringResult.ErrorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/DepthCodec.h>
+#include <Io/FrameDeltaCodec.h>
+#include <Io/FrameSendQueue.h>
+#include <Io/FrameStreamSocket.h>
+
+//
+// Loopback throughput benchmark for the frame stream protocol. Frames are sent with
+// Io::FrameStreamServer straight from the frame memory, and with the copies made by
+// HoloLensForCV::SensorFrameStreamingServer before the frame reaches the socket: one
+// into a new Platform::Array and one into the DataWriter.
+//
+// A second run streams to several clients at once, one of which reads slowly, to
+// check that each client only loses its own frames. A third streams short throw depth
+// frames uncompressed, compressed one by one and compressed as deltas to the previous
+// frame, and checks the decoded frames.
+//
+namespace
+{
+   struct Options
+   {
+      Options()
+         :
+         Width(1280),
+         Height(720),
+         PixelStride(4),
+         FrameCount(500)
+      {}
+
+      uint32_t Width;
+      uint32_t Height;
+      uint32_t PixelStride;
+      int FrameCount;
+   };
+
+   struct Result
+   {
+      Result()
+         :
+         Seconds(0),
+         ReceivedCount(0),
+         ErrorCount(0)
+      {}
+
+      double Seconds;
+      int ReceivedCount;
+      int ErrorCount; //Frames received with the wrong size or content.
+      std::vector<double> PreparationTimes;
+   };
+
+   typedef std::vector<uint8_t> Bitmap;
+
+   const size_t BITMAP_POOL_SIZE = 4; //Bitmaps the camera cycles through.
+   const int FAN_OUT_FRAME_COUNT = 120; //Frames sent to several clients at once.
+   const int FAN_OUT_FRAME_RATE = 60; //Frames per second sent to several clients at once.
+   const uint32_t FAN_OUT_FLUSH_TIMEOUT = 60000; //Milliseconds the fan-out clients get to receive the queued frames.
+   const int SLOW_CLIENT_DELAY = 50; //Milliseconds the slow client takes to process a frame.
+   const uint32_t DEPTH_WIDTH = 450; //Short throw depth frame width.
+   const uint32_t DEPTH_HEIGHT = 448; //Short throw depth frame height.
+   const int DEPTH_SCENE_FRAME_COUNT = 30; //Depth frames of the scene, sent in a loop.
+   const uint32_t DEPTH_KEYFRAME_INTERVAL = 30; //Frames between delta compression keyframes.
+
+   struct FanOutClient
+   {
+      const char* Name;
+      Io::FrameSendPolicy Policy;
+      int Delay; //Milliseconds spent on each received frame.
+      int ReceivedCount;
+      int ErrorCount; //Frames received out of order, against the policy or with the wrong size.
+      uint64_t DroppedCount; //Frames the server dropped for the client.
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: FrameStreamBenchmark [options]\n"
+         "  --width <pixels>    Frame width.\n"
+         "  --height <pixels>   Frame height.\n"
+         "  --stride <bytes>    Bytes per pixel.\n"
+         "  --frames <count>    Frames sent per run.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--width" && hasValue)
+         {
+            options.Width = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--height" && hasValue)
+         {
+            options.Height = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--stride" && hasValue)
+         {
+            options.PixelStride = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--frames" && hasValue)
+         {
+            options.FrameCount = std::max(1, atoi(argv[++i]));
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   double Percentile(std::vector<double>& samples, double fraction)
+   {
+      if (samples.empty())
+      {
+         return 0;
+      }
+
+      std::sort(samples.begin(), samples.end());
+
+      size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+      return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+   }
+
+   // Sends the frames to a client on the loopback interface and waits until it received them all.
+   Result Run(const Options& options, bool isZeroCopy)
+   {
+      Result result;
+
+      Io::FrameStreamServer server;
+      if (!server.Listen(0))
+      {
+         return result;
+      }
+
+      const size_t rowStride = options.Width * options.PixelStride;
+      const size_t bitmapSize = options.Height * rowStride;
+
+      std::thread receiver([&]()
+      {
+         Io::FrameStreamClient client;
+         if (!client.Connect("127.0.0.1", server.GetPort()))
+         {
+            return;
+         }
+
+         Io::FrameStreamHeader header;
+         Bitmap data;
+
+         while (result.ReceivedCount < options.FrameCount && client.Receive(header, data))
+         {
+            uint8_t expected = static_cast<uint8_t>(header.Timestamp);
+
+            if (data.size() != bitmapSize || data.front() != expected || data.back() != expected)
+            {
+               result.ErrorCount++;
+            }
+
+            result.ReceivedCount++;
+         }
+      });
+
+      if (!server.Accept())
+      {
+         receiver.join();
+         return result;
+      }
+
+      std::vector<std::shared_ptr<Bitmap>> bitmaps;
+      for (size_t i = 0; i < BITMAP_POOL_SIZE; i++)
+      {
+         bitmaps.push_back(std::make_shared<Bitmap>(bitmapSize, 0));
+      }
+
+      Io::FrameStreamHeader header;
+      header.ImageWidth = options.Width;
+      header.ImageHeight = options.Height;
+      header.PixelStride = options.PixelStride;
+      header.RowStride = static_cast<uint32_t>(rowStride);
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < options.FrameCount; i++)
+      {
+         //The camera fills in the next bitmap. Only the previous frame can still be in flight.
+         Bitmap& bitmap = *bitmaps[i % BITMAP_POOL_SIZE];
+         bitmap.front() = static_cast<uint8_t>(i);
+         bitmap.back() = static_cast<uint8_t>(i);
+
+         header.Timestamp = i;
+
+         auto preparationStart = std::chrono::steady_clock::now();
+
+         const uint8_t* data = bitmap.data();
+         std::shared_ptr<const void> owner = bitmaps[i % BITMAP_POOL_SIZE];
+
+         if (!isZeroCopy)
+         {
+            auto array = std::make_shared<Bitmap>(bitmap.begin(), bitmap.end());
+            auto writerBuffer = std::make_shared<Bitmap>(array->begin(), array->end());
+
+            data = writerBuffer->data();
+            owner = writerBuffer;
+         }
+
+         result.PreparationTimes.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - preparationStart).count());
+
+         //Wait for the previous frame rather than dropping this one.
+         server.Flush();
+         server.Send(header, data, bitmapSize, owner);
+      }
+
+      server.Flush();
+      receiver.join();
+
+      result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      return result;
+   }
+
+   // A hand moving in front of a wall, with a ring of invalid pixels like a short throw depth
+   // frame. Only the hand changes from one frame to the next.
+   void MakeDepthBitmap(int index, Bitmap& bitmap)
+   {
+      bitmap.assign(DEPTH_WIDTH * DEPTH_HEIGHT * 2, 0);
+
+      float handX = 100.0f + index * 8.0f;
+      float handY = DEPTH_HEIGHT * 0.5f;
+
+      for (uint32_t y = 0; y < DEPTH_HEIGHT; y++)
+      {
+         for (uint32_t x = 0; x < DEPTH_WIDTH; x++)
+         {
+            float dx = x - DEPTH_WIDTH * 0.5f;
+            float dy = y - DEPTH_HEIGHT * 0.5f;
+
+            if (dx * dx + dy * dy < 210.0f * 210.0f)
+            {
+               float hx = x - handX;
+               float hy = y - handY;
+
+               uint32_t noise = (x * 73856093u ^ y * 19349663u) % 5;
+               uint16_t depth = static_cast<uint16_t>(
+                  hx * hx + hy * hy < 45.0f * 45.0f ? 450 + (hx + hy) * 0.5f : 900 + y + noise);
+
+               bitmap[(y * DEPTH_WIDTH + x) * 2] = static_cast<uint8_t>(depth);
+               bitmap[(y * DEPTH_WIDTH + x) * 2 + 1] = static_cast<uint8_t>(depth >> 8);
+            }
+         }
+      }
+   }
+
+   // Compresses the depth frame into the payload and sets the codec of the header.
+   void EncodeDepthFrame(const Bitmap& bitmap, Io::FrameStreamHeader& header, Bitmap& payload)
+   {
+      payload.resize(Io::GetMaxEncodedDepthImageLength(DEPTH_WIDTH, DEPTH_HEIGHT));
+      payload.resize(Io::EncodeDepthImage(bitmap.data(), DEPTH_WIDTH, DEPTH_HEIGHT, header.RowStride, payload.data()));
+
+      Io::SetFrameCodec(header, Io::FrameCodec::Depth, static_cast<uint32_t>(payload.size()));
+   }
+
+   // Streams depth frames to a client with the codec, and checks the frames it receives.
+   // Delta frames are sent between depth compressed keyframes.
+   // Returns the result and the payload bytes sent per frame.
+   Result RunDepth(const Options& options, Io::FrameCodec codec, double& payloadBytesPerFrame)
+   {
+      Result result;
+      payloadBytesPerFrame = 0;
+
+      Io::FrameStreamServer server;
+      if (!server.Listen(0))
+      {
+         return result;
+      }
+
+      std::vector<Bitmap> bitmaps(DEPTH_SCENE_FRAME_COUNT);
+      for (int i = 0; i < DEPTH_SCENE_FRAME_COUNT; i++)
+      {
+         MakeDepthBitmap(i, bitmaps[i]);
+      }
+
+      std::thread receiver([&]()
+      {
+         Io::FrameStreamClient client;
+         if (!client.Connect("127.0.0.1", server.GetPort()))
+         {
+            return;
+         }
+
+         Io::FrameStreamHeader header;
+         Bitmap data;
+
+         while (result.ReceivedCount < options.FrameCount && client.Receive(header, data))
+         {
+            if (data != bitmaps[header.Timestamp % DEPTH_SCENE_FRAME_COUNT])
+            {
+               result.ErrorCount++;
+            }
+
+            result.ReceivedCount++;
+         }
+      });
+
+      if (!server.Accept(Io::FrameSendPolicy(Io::FrameDropPolicy::Lossless, 1, 4)))
+      {
+         receiver.join();
+         return result;
+      }
+
+      Io::FrameStreamHeader header;
+      header.ImageWidth = DEPTH_WIDTH;
+      header.ImageHeight = DEPTH_HEIGHT;
+      header.PixelStride = 2;
+      header.RowStride = DEPTH_WIDTH * 2;
+
+      Io::FrameDeltaEncoder deltaEncoder(DEPTH_KEYFRAME_INTERVAL);
+
+      size_t payloadBytes = 0;
+      auto start = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < options.FrameCount; i++)
+      {
+         const Bitmap& bitmap = bitmaps[i % DEPTH_SCENE_FRAME_COUNT];
+
+         header.Timestamp = i;
+
+         auto preparationStart = std::chrono::steady_clock::now();
+
+         std::shared_ptr<Bitmap> payload = std::make_shared<Bitmap>();
+
+         if (codec == Io::FrameCodec::Delta && deltaEncoder.Encode(header, bitmap.data(), *payload))
+         {
+            Io::SetFrameCodec(header, Io::FrameCodec::Delta, static_cast<uint32_t>(payload->size()));
+         }
+         else if (codec != Io::FrameCodec::None)
+         {
+            EncodeDepthFrame(bitmap, header, *payload);
+
+            //The client keeps the keyframes of a delta stream for the delta frames that follow.
+            if (codec == Io::FrameCodec::Delta)
+            {
+               Io::SetDeltaKeyframe(header);
+            }
+         }
+         else
+         {
+            payload->assign(bitmap.begin(), bitmap.end());
+         }
+
+         result.PreparationTimes.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - preparationStart).count());
+
+         payloadBytes += payload->size();
+
+         //Wait for the previous frame rather than dropping this one.
+         server.Flush();
+         server.Send(header, payload->data(), payload->size(), payload);
+      }
+
+      server.Flush();
+      receiver.join();
+
+      result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      payloadBytesPerFrame = static_cast<double>(payloadBytes) / options.FrameCount;
+
+      return result;
+   }
+
+   // Streams to a lossless client, a client keeping every other frame and a slow client
+   // only interested in the latest frame, and returns the number of frames each received
+   // and the server dropped for it.
+   void RunFanOut(const Options& options, std::vector<FanOutClient>& clients)
+   {
+      Io::FrameStreamServer server;
+      if (!server.Listen(0))
+      {
+         return;
+      }
+
+      const size_t rowStride = options.Width * options.PixelStride;
+      const size_t bitmapSize = options.Height * rowStride;
+
+      std::vector<std::thread> receivers;
+
+      for (FanOutClient& fanOutClient : clients)
+      {
+         receivers.emplace_back([&server, &fanOutClient, bitmapSize]()
+         {
+            Io::FrameStreamClient client;
+            if (!client.Connect("127.0.0.1", server.GetPort()))
+            {
+               return;
+            }
+
+            Io::FrameStreamHeader header;
+            Bitmap data;
+            int64_t previousTimestamp = -1;
+
+            while (client.Receive(header, data))
+            {
+               const int64_t timestamp = static_cast<int64_t>(header.Timestamp);
+
+               if (timestamp <= previousTimestamp ||
+                  timestamp % fanOutClient.Policy.KeepEveryNth != 0 ||
+                  data.size() != bitmapSize)
+               {
+                  fanOutClient.ErrorCount++;
+               }
+
+               previousTimestamp = timestamp;
+               fanOutClient.ReceivedCount++;
+               std::this_thread::sleep_for(std::chrono::milliseconds(fanOutClient.Delay));
+            }
+         });
+
+         //Accept in order, so each client gets its own policy.
+         server.Accept(fanOutClient.Policy);
+      }
+
+      Io::FrameStreamHeader header;
+      header.ImageWidth = options.Width;
+      header.ImageHeight = options.Height;
+      header.PixelStride = options.PixelStride;
+      header.RowStride = static_cast<uint32_t>(rowStride);
+
+      auto bitmap = std::make_shared<Bitmap>(bitmapSize, 0);
+      auto start = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < FAN_OUT_FRAME_COUNT; i++)
+      {
+         std::this_thread::sleep_until(start + std::chrono::microseconds(i * 1000000 / FAN_OUT_FRAME_RATE));
+
+         header.Timestamp = i;
+         server.Send(header, bitmap->data(), bitmapSize, bitmap);
+      }
+
+      //Lossless delivery is checked, not how fast it is, so give the clients time to catch up.
+      server.Flush(FAN_OUT_FLUSH_TIMEOUT);
+
+      std::vector<Io::FrameStreamClientStatistics> statistics = server.GetClientStatistics();
+      for (size_t i = 0; i < clients.size(); i++)
+      {
+         //A disconnected client has no statistics, count all its frames as dropped.
+         clients[i].DroppedCount = statistics.size() == clients.size() ?
+            statistics[i].DroppedFrameCount :
+            FAN_OUT_FRAME_COUNT;
+      }
+
+      server.Close();
+
+      for (std::thread& receiver : receivers)
+      {
+         receiver.join();
+      }
+   }
+
+   void PrintResult(const char* name, Result& result, const Options& options)
+   {
+      double megabytes =
+         static_cast<double>(result.ReceivedCount) * options.Height * options.Width * options.PixelStride / 1e6;
+
+      printf("%-10s %10.1f %10.1f %12.3f %12.3f %8d\n",
+         name,
+         result.ReceivedCount / result.Seconds,
+         megabytes / result.Seconds,
+         Percentile(result.PreparationTimes, 0.50),
+         Percentile(result.PreparationTimes, 0.99),
+         result.ErrorCount + options.FrameCount - result.ReceivedCount);
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   printf("Frames: %d of %ux%u, %u bytes per pixel\n",
+      options.FrameCount,
+      options.Width,
+      options.Height,
+      options.PixelStride);
+
+   Result copyResult = Run(options, false);
+   Result zeroCopyResult = Run(options, true);
+
+   printf("%-10s %10s %10s %12s %12s %8s\n", "Path", "frames/s", "MB/s", "prep p50 ms", "prep p99 ms", "errors");
+   PrintResult("Copy", copyResult, options);
+   PrintResult("Zero-copy", zeroCopyResult, options);
+
+   std::vector<FanOutClient> clients =
+   {
+      //The queues hold every frame their clients keep, so how far a client falls behind
+      //depends on the machine and the sanitizers, but never loses it a frame.
+      { "Lossless", Io::FrameSendPolicy(Io::FrameDropPolicy::Lossless, 1, FAN_OUT_FRAME_COUNT), 0, 0, 0, 0 },
+      { "Every 2nd", Io::FrameSendPolicy(Io::FrameDropPolicy::KeepEveryNth, 2, FAN_OUT_FRAME_COUNT / 2), 0, 0, 0, 0 },
+      { "Slow", Io::FrameSendPolicy(Io::FrameDropPolicy::LatestOnly, 1, 1), SLOW_CLIENT_DELAY, 0, 0, 0 },
+   };
+
+   RunFanOut(options, clients);
+
+   printf("\nFan-out of %d frames at %d frames/s:\n", FAN_OUT_FRAME_COUNT, FAN_OUT_FRAME_RATE);
+   for (const FanOutClient& client : clients)
+   {
+      printf("%-10s %5d frames received, %3llu dropped, %d errors\n",
+         client.Name,
+         client.ReceivedCount,
+         static_cast<unsigned long long>(client.DroppedCount),
+         client.ErrorCount);
+   }
+
+   double rawBytesPerFrame = 0;
+   double compressedBytesPerFrame = 0;
+   double deltaBytesPerFrame = 0;
+   Result rawDepthResult = RunDepth(options, Io::FrameCodec::None, rawBytesPerFrame);
+   Result compressedDepthResult = RunDepth(options, Io::FrameCodec::Depth, compressedBytesPerFrame);
+   Result deltaDepthResult = RunDepth(options, Io::FrameCodec::Delta, deltaBytesPerFrame);
+
+   Options depthOptions = options;
+   depthOptions.Width = DEPTH_WIDTH;
+   depthOptions.Height = DEPTH_HEIGHT;
+   depthOptions.PixelStride = 2;
+
+   printf("\nDepth frames of %ux%u, MB/s of decoded frames:\n", DEPTH_WIDTH, DEPTH_HEIGHT);
+   printf("%-10s %10s %10s %12s %12s %8s\n", "Codec", "frames/s", "MB/s", "prep p50 ms", "prep p99 ms", "errors");
+   PrintResult("None", rawDepthResult, depthOptions);
+   PrintResult("Depth", compressedDepthResult, depthOptions);
+   PrintResult("Delta", deltaDepthResult, depthOptions);
+   printf("Payload bytes per frame: %.0f uncompressed, %.0f depth (%.2f : 1), %.0f delta (%.2f : 1)\n",
+      rawBytesPerFrame,
+      compressedBytesPerFrame,
+      compressedBytesPerFrame > 0 ? rawBytesPerFrame / compressedBytesPerFrame : 0,
+      deltaBytesPerFrame,
+      deltaBytesPerFrame > 0 ? rawBytesPerFrame / deltaBytesPerFrame : 0);
+
+   bool isValid =
+      copyResult.ErrorCount + zeroCopyResult.ErrorCount == 0 &&
+      rawDepthResult.ErrorCount + compressedDepthResult.ErrorCount + deltaDepthResult.ErrorCount == 0 &&
+      rawDepthResult.ReceivedCount == options.FrameCount &&
+      compressedDepthResult.ReceivedCount == options.FrameCount &&
+      deltaDepthResult.ReceivedCount == options.FrameCount &&
+      copyResult.ReceivedCount == options.FrameCount &&
+      zeroCopyResult.ReceivedCount == options.FrameCount &&
+      clients[0].ErrorCount + clients[1].ErrorCount + clients[2].ErrorCount == 0 &&
+      clients[0].ReceivedCount == FAN_OUT_FRAME_COUNT &&
+      clients[0].DroppedCount == 0 &&
+      clients[1].ReceivedCount == FAN_OUT_FRAME_COUNT / 2 &&
+      clients[1].DroppedCount == FAN_OUT_FRAME_COUNT / 2;
+
+   return isValid ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#include "pch.h"
+
+#include "FrameHelpers.h"
+
+#include <cctype>
+#include <cstring>
+
+using namespace HoloHands;
+
+namespace
+{
+   // Reads a whitespace separated decimal number from a PGM header.
+   bool ReadPgmNumber(const std::vector<uint8_t>& data, size_t& position, int& value)
+   {
+      while (position < data.size() && isspace(data[position]))
+      {
+         position++;
+      }
+
+      if (position >= data.size() || !isdigit(data[position]))
+      {
+         return false;
+      }
+
+      value = 0;
+      while (position < data.size() && isdigit(data[position]))
+      {
+         value = value * 10 + (data[position] - '0');
+         position++;
+      }
+
+      return true;
+   }
+}
+
+uint64_t HoloHands::GetTimestampFromFileName(const std::string& fileName)
+{
+   size_t separator = fileName.find_last_of("\\/");
+   size_t start = separator == std::string::npos ? 0 : separator + 1;
+
+   return strtoull(fileName.c_str() + start, nullptr, 10);
+}
+
+bool HoloHands::WrapPgmWithCvMat(std::vector<uint8_t>& fileData, cv::Mat& image)
+{
+   if (fileData.size() < 2 || fileData[0] != 'P' || fileData[1] != '5')
+   {
+      return false;
+   }
+
+   size_t position = 2;
+   int width = 0;
+   int height = 0;
+   int maxValue = 0;
+
+   if (!ReadPgmNumber(fileData, position, width) ||
+      !ReadPgmNumber(fileData, position, height) ||
+      !ReadPgmNumber(fileData, position, maxValue))
+   {
+      return false;
+   }
+
+   //A single whitespace character separates the header from the pixels.
+   position++;
+
+   //The recorder writes the sensor buffer as is, so 16 bit pixels are little endian.
+   int type = maxValue > 255 ? CV_16UC1 : CV_8UC1;
+   size_t pixelSize = maxValue > 255 ? 2 : 1;
+
+   if (position + static_cast<size_t>(width) * height * pixelSize > fileData.size())
+   {
+      return false;
+   }
+   uint8_t* pixels = fileData.data() + position;
+   size_t pixelBytes = static_cast<size_t>(width) * height * pixelSize;
+
+   if (reinterpret_cast<uintptr_t>(pixels) % pixelSize != 0)
+   {
+      //Move the pixels over the header's last byte, so 16 bit reads are aligned.
+      memmove(pixels - 1, pixels, pixelBytes);
+      pixels--;
+   }
+
+   image = cv::Mat(height, width, type, pixels);
+   return true;
+}
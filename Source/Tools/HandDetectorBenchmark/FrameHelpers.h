@@ -0,0 +1,12 @@
+#pragma once
+
+namespace HoloHands
+{
+   // Extracts the timestamp from a recorded frame name, such as
+   // "short_throw_depth\00000131711138130000.pgm".
+   uint64_t GetTimestampFromFileName(const std::string& fileName);
+
+   // Wraps the pixels of a binary PGM (P5) file with a cv::Mat without copying.
+   // Returns false if the data is not a valid PGM file.
+   bool WrapPgmWithCvMat(std::vector<uint8_t>& fileData, cv::Mat& image);
+}
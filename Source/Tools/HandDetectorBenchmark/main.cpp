@@ -0,0 +1,758 @@
+#include "pch.h"
+
+#include "CV/HandDetector.h"
+#include "FrameHelpers.h"
+
+#include <Debugging/All.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/FrameDeltaCodec.h>
+#include <Io/TarReader.h>
+#include <Io/FrameIndex.h>
+#include <Io/RecordedFrameReader.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <numeric>
+
+using namespace HoloHands;
+
+//
+// Counts heap allocations, so the benchmark can report allocations per frame.
+// With glibc the malloc family is interposed, which also covers OpenCV's own
+// allocations. Sanitizers bring their own malloc, which interposing would take
+// over, so under a sanitizer, and elsewhere, only the global operator new is counted.
+//
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define HOLOHANDS_WITH_SANITIZER 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define HOLOHANDS_WITH_SANITIZER 1
+#endif
+#endif
+
+namespace
+{
+   std::atomic<uint64_t> g_allocationCount(0);
+}
+
+#if defined(__GLIBC__) && !defined(HOLOHANDS_WITH_SANITIZER)
+extern "C"
+{
+   void* __libc_malloc(size_t size);
+   void* __libc_calloc(size_t count, size_t size);
+   void* __libc_realloc(void* pointer, size_t size);
+   void* __libc_memalign(size_t alignment, size_t size);
+
+   void* malloc(size_t size)
+   {
+      g_allocationCount++;
+      return __libc_malloc(size);
+   }
+
+   void* calloc(size_t count, size_t size)
+   {
+      g_allocationCount++;
+      return __libc_calloc(count, size);
+   }
+
+   void* realloc(void* pointer, size_t size)
+   {
+      g_allocationCount++;
+      return __libc_realloc(pointer, size);
+   }
+
+   void* memalign(size_t alignment, size_t size)
+   {
+      g_allocationCount++;
+      return __libc_memalign(alignment, size);
+   }
+
+   void* aligned_alloc(size_t alignment, size_t size)
+   {
+      g_allocationCount++;
+      return __libc_memalign(alignment, size);
+   }
+
+   int posix_memalign(void** pointer, size_t alignment, size_t size)
+   {
+      g_allocationCount++;
+      *pointer = __libc_memalign(alignment, size);
+      return *pointer != nullptr ? 0 : ENOMEM;
+   }
+
+   //Frees are not counted. glibc's free releases all of the above as is.
+}
+#else
+//Every form is replaced, as sanitizers supply their own for any left out.
+void* operator new(size_t size)
+{
+   g_allocationCount++;
+
+   void* pointer = std::malloc(size > 0 ? size : 1);
+   if (pointer == nullptr)
+   {
+      throw std::bad_alloc();
+   }
+
+   return pointer;
+}
+
+void* operator new[](size_t size)
+{
+   return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+   g_allocationCount++;
+   return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+   return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+   std::free(pointer);
+}
+#endif
+
+namespace
+{
+   struct Options
+   {
+      Options()
+         :
+         Tracking(false),
+         Closed(false),
+         RepeatCount(1),
+         MaxHandCount(1),
+         Tolerance(0),
+         Approximation(ContourApproximation::None),
+         ApproximationTolerance(0),
+         Segmentation(SegmentationBackend::Edges),
+         Drift(false),
+         DriftBudget(1)
+      {}
+
+      std::string TarballFileName;
+      std::string GoldenOutputFileName;
+      std::string GoldenInputFileName;
+      bool Tracking;
+      bool Closed;
+      int RepeatCount;
+      int MaxHandCount;
+      double Tolerance;
+      ContourApproximation Approximation;
+      float ApproximationTolerance;
+      SegmentationBackend Segmentation;
+      bool Drift;
+      double DriftBudget;
+   };
+
+   // Detection result of a single frame, as stored in the golden file.
+   struct Detection
+   {
+      uint64_t Timestamp;
+      int Found;
+      float X;
+      float Y;
+      float Depth;
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: HandDetectorBenchmark <short_throw_depth.tar> [options]\n"
+         "  --golden <file>     Write the detected positions and depths to a golden file.\n"
+         "  --compare <file>    Compare the detections against a golden file.\n"
+         "  --tolerance <value> Allowed position and depth difference when comparing.\n"
+         "  --tracking          Enable region of interest tracking.\n"
+         "  --closed            Process all frames as a closed hand.\n"
+         "  --repeat <count>    Replay the recording several times.\n"
+         "  --hands <count>     Search for up to this many hands in each frame.\n"
+         "  --approximation <none|simple|polygon>\n"
+         "                      How hand contours are simplified.\n"
+         "  --epsilon <pixels>  Tolerance of the polygon approximation.\n"
+         "  --segmentation <edges|components>\n"
+         "                      How hands are separated from the foreground.\n"
+         "  --drift             Compare the hand positions of every approximation setting\n"
+         "                      and segmentation backend.\n"
+         "  --budget <pixels>   95th percentile drift allowed when comparing, 1 by default.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--golden" && hasValue)
+         {
+            options.GoldenOutputFileName = argv[++i];
+         }
+         else if (argument == "--compare" && hasValue)
+         {
+            options.GoldenInputFileName = argv[++i];
+         }
+         else if (argument == "--tolerance" && hasValue)
+         {
+            options.Tolerance = atof(argv[++i]);
+         }
+         else if (argument == "--repeat" && hasValue)
+         {
+            options.RepeatCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--hands" && hasValue)
+         {
+            options.MaxHandCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--approximation" && hasValue)
+         {
+            std::string approximation = argv[++i];
+
+            if (approximation == "none")
+            {
+               options.Approximation = ContourApproximation::None;
+            }
+            else if (approximation == "simple")
+            {
+               options.Approximation = ContourApproximation::Simple;
+            }
+            else if (approximation == "polygon")
+            {
+               options.Approximation = ContourApproximation::Polygon;
+            }
+            else
+            {
+               return false;
+            }
+         }
+         else if (argument == "--segmentation" && hasValue)
+         {
+            std::string segmentation = argv[++i];
+
+            if (segmentation == "edges")
+            {
+               options.Segmentation = SegmentationBackend::Edges;
+            }
+            else if (segmentation == "components")
+            {
+               options.Segmentation = SegmentationBackend::ConnectedComponents;
+            }
+            else
+            {
+               return false;
+            }
+         }
+         else if (argument == "--epsilon" && hasValue)
+         {
+            options.ApproximationTolerance = static_cast<float>(atof(argv[++i]));
+         }
+         else if (argument == "--budget" && hasValue)
+         {
+            options.DriftBudget = atof(argv[++i]);
+         }
+         else if (argument == "--drift")
+         {
+            options.Drift = true;
+         }
+         else if (argument == "--tracking")
+         {
+            options.Tracking = true;
+         }
+         else if (argument == "--closed")
+         {
+            options.Closed = true;
+         }
+         else if (argument[0] != '-' && options.TarballFileName.empty())
+         {
+            options.TarballFileName = argument;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return !options.TarballFileName.empty();
+   }
+
+   // Returns the value below which the given fraction of samples fall.
+   double Percentile(std::vector<double>& samples, double fraction)
+   {
+      if (samples.empty())
+      {
+         return 0;
+      }
+
+      std::sort(samples.begin(), samples.end());
+
+      size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+      return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+   }
+
+   void PrintStage(const char* name, std::vector<double>& samples)
+   {
+      printf("%-14s %10.3f %10.3f %10.3f\n",
+         name,
+         Percentile(samples, 0.50),
+         Percentile(samples, 0.95),
+         Percentile(samples, 0.99));
+   }
+
+   bool ReadGoldenFile(const std::string& fileName, std::vector<Detection>& detections)
+   {
+      std::ifstream file(fileName);
+      if (!file.is_open())
+      {
+         return false;
+      }
+
+      std::string line;
+      std::getline(file, line); //Skip header.
+
+      while (std::getline(file, line))
+      {
+         Detection detection;
+         unsigned long long timestamp = 0;
+
+         if (sscanf(line.c_str(), "%llu,%d,%f,%f,%f",
+            &timestamp, &detection.Found, &detection.X, &detection.Y, &detection.Depth) == 5)
+         {
+            detection.Timestamp = timestamp;
+            detections.push_back(detection);
+         }
+      }
+
+      return true;
+   }
+
+   bool Matches(const Detection& a, const Detection& b, double tolerance)
+   {
+      //The golden file stores four decimal places.
+      tolerance += 0.00005;
+
+      if (a.Timestamp != b.Timestamp || a.Found != b.Found)
+      {
+         return false;
+      }
+
+      return
+         std::abs(a.X - b.X) <= tolerance &&
+         std::abs(a.Y - b.Y) <= tolerance &&
+         std::abs(a.Depth - b.Depth) <= tolerance;
+   }
+
+   // A contour approximation and segmentation backend compared by --drift.
+   struct ApproximationSetting
+   {
+      const char* Name;
+      ContourApproximation Approximation;
+      float Tolerance;
+      SegmentationBackend Segmentation;
+   };
+
+   // The first setting is the reference the others are compared against.
+   const ApproximationSetting DRIFT_SETTINGS[] =
+   {
+      { "none", ContourApproximation::None, 0, SegmentationBackend::Edges },
+      { "simple", ContourApproximation::Simple, 0, SegmentationBackend::Edges },
+      { "polygon 0.5", ContourApproximation::Polygon, 0.5f, SegmentationBackend::Edges },
+      { "polygon 1", ContourApproximation::Polygon, 1, SegmentationBackend::Edges },
+      { "polygon 2", ContourApproximation::Polygon, 2, SegmentationBackend::Edges },
+      { "polygon 3", ContourApproximation::Polygon, 3, SegmentationBackend::Edges },
+      { "polygon 5", ContourApproximation::Polygon, 5, SegmentationBackend::Edges },
+      { "polygon 8", ContourApproximation::Polygon, 8, SegmentationBackend::Edges },
+      { "components", ContourApproximation::None, 0, SegmentationBackend::ConnectedComponents },
+      { "comp simple", ContourApproximation::Simple, 0, SegmentationBackend::ConnectedComponents }
+   };
+
+   struct SettingResult
+   {
+      SettingResult()
+         :
+         TotalTime(0)
+      {}
+
+      std::vector<Detection> Detections; //Of the first pass.
+      std::vector<double> PoseTimes; //Contours, pose and depth stages, which the setting affects.
+      double TotalTime;
+   };
+
+   // Replays the recording through a detector using the given setting.
+   bool ReplayWithSetting(const Options& options, const ApproximationSetting& setting, SettingResult& result)
+   {
+      HandDetector handDetector;
+      handDetector.ShowDebugInfo(false);
+      handDetector.SetIsClosed(options.Closed);
+      handDetector.SetTrackingEnabled(options.Tracking);
+      handDetector.SetMaxHandCount(options.MaxHandCount);
+      handDetector.SetContourApproximation(setting.Approximation, setting.Tolerance);
+      handDetector.SetSegmentationBackend(setting.Segmentation);
+
+      std::string fileName;
+      std::vector<uint8_t> fileData;
+      cv::Mat image;
+
+      for (int pass = 0; pass < options.RepeatCount; pass++)
+      {
+         Io::RecordedFrameReader reader(options.TarballFileName);
+         if (!reader.IsOpen())
+         {
+            return false;
+         }
+
+         while (reader.ReadNext(fileName, fileData))
+         {
+            if (!WrapPgmWithCvMat(fileData, image) || image.type() != CV_16UC1)
+            {
+               continue;
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            bool found = handDetector.Process(image);
+            result.TotalTime += std::chrono::duration<double, std::milli>(
+               std::chrono::high_resolution_clock::now() - start).count();
+
+            const StageTimings& timings = handDetector.GetStageTimings();
+            result.PoseTimes.push_back(timings.Contours + timings.Pose + timings.Depth);
+
+            if (pass == 0)
+            {
+               cv::Point2f position = handDetector.GetHandPosition2D();
+
+               Detection detection;
+               detection.Timestamp = GetTimestampFromFileName(fileName);
+               detection.Found = found ? 1 : 0;
+               detection.X = found ? position.x : 0;
+               detection.Y = found ? position.y : 0;
+               detection.Depth = found ? handDetector.GetHandDepth() : 0;
+               result.Detections.push_back(detection);
+            }
+         }
+      }
+
+      return true;
+   }
+
+   // Replays the recording with every approximation setting and segmentation backend,
+   // and reports how far each moves the hand position from where it is found with
+   // edges and no approximation, so the fastest setting within a pixel budget can be picked.
+   int CompareApproximations(const Options& options)
+   {
+      std::vector<SettingResult> results;
+
+      for (const ApproximationSetting& setting : DRIFT_SETTINGS)
+      {
+         results.push_back(SettingResult());
+
+         if (!ReplayWithSetting(options, setting, results.back()))
+         {
+            std::cerr << "Cannot open " << options.TarballFileName << "\n";
+            return 2;
+         }
+      }
+
+      const std::vector<Detection>& reference = results[0].Detections;
+      if (reference.empty())
+      {
+         std::cerr << "No depth frames found in " << options.TarballFileName << "\n";
+         return 2;
+      }
+
+      printf("Frames:         %zu, hand position drift against edges without approximation, in pixels\n", reference.size());
+      printf("%-12s %8s %8s %8s %8s %8s %10s %10s\n",
+         "Setting", "found", "changed", "mean", "p95", "max", "stage ms", "total ms");
+
+      const char* fastestName = nullptr;
+      double fastestTime = 0;
+
+      for (size_t s = 0; s < results.size(); s++)
+      {
+         const std::vector<Detection>& detections = results[s].Detections;
+
+         size_t foundCount = 0;
+         size_t changedCount = 0;
+         std::vector<double> drifts;
+
+         for (size_t i = 0; i < std::min(detections.size(), reference.size()); i++)
+         {
+            foundCount += detections[i].Found;
+
+            if (detections[i].Found != reference[i].Found)
+            {
+               changedCount++;
+            }
+            else if (detections[i].Found)
+            {
+               drifts.push_back(std::hypot(detections[i].X - reference[i].X, detections[i].Y - reference[i].Y));
+            }
+         }
+
+         double meanDrift = drifts.empty() ? 0 :
+            std::accumulate(drifts.begin(), drifts.end(), 0.0) / drifts.size();
+         double p95Drift = Percentile(drifts, 0.95);
+         double maxDrift = drifts.empty() ? 0 : drifts.back();
+         double frameTime = results[s].TotalTime / results[s].PoseTimes.size();
+
+         printf("%-12s %8zu %8zu %8.2f %8.2f %8.2f %10.3f %10.3f\n",
+            DRIFT_SETTINGS[s].Name,
+            foundCount,
+            changedCount,
+            meanDrift,
+            p95Drift,
+            maxDrift,
+            Percentile(results[s].PoseTimes, 0.5),
+            frameTime);
+
+         if (changedCount == 0 && p95Drift <= options.DriftBudget &&
+            (fastestName == nullptr || frameTime < fastestTime))
+         {
+            fastestName = DRIFT_SETTINGS[s].Name;
+            fastestTime = frameTime;
+         }
+      }
+
+      printf("\nStage ms is the p50 of the contour, pose and depth stages. The fastest setting\n"
+         "with a p95 drift within %.2f pixels is %s.\n", options.DriftBudget, fastestName);
+
+      return 0;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   std::vector<Detection> golden;
+   if (!options.GoldenInputFileName.empty() &&
+      !ReadGoldenFile(options.GoldenInputFileName, golden))
+   {
+      std::cerr << "Cannot read golden file " << options.GoldenInputFileName << "\n";
+      return 2;
+   }
+
+   if (options.Drift)
+   {
+      return CompareApproximations(options);
+   }
+
+   HandDetector handDetector;
+   handDetector.ShowDebugInfo(false);
+   handDetector.SetIsClosed(options.Closed);
+   handDetector.SetTrackingEnabled(options.Tracking);
+   handDetector.SetMaxHandCount(options.MaxHandCount);
+   handDetector.SetContourApproximation(options.Approximation, options.ApproximationTolerance);
+   handDetector.SetSegmentationBackend(options.Segmentation);
+
+   std::vector<double> segmentationTimes;
+   std::vector<double> contourTimes;
+   std::vector<double> poseTimes;
+   std::vector<double> depthTimes;
+   std::vector<double> totalTimes;
+   std::vector<Detection> detections;
+
+   size_t totalHandCount = 0;
+   int maxHandId = -1;
+
+   uint64_t totalAllocations = 0;
+   uint64_t maxAllocations = 0;
+   double totalProcessingTime = 0;
+
+   std::string fileName;
+   std::vector<uint8_t> fileData;
+   cv::Mat image;
+
+   for (int pass = 0; pass < options.RepeatCount; pass++)
+   {
+      Io::RecordedFrameReader reader(options.TarballFileName);
+      if (!reader.IsOpen())
+      {
+         std::cerr << "Cannot open " << options.TarballFileName << "\n";
+         return 2;
+      }
+
+      while (reader.ReadNext(fileName, fileData))
+      {
+         if (!WrapPgmWithCvMat(fileData, image) || image.type() != CV_16UC1)
+         {
+            continue;
+         }
+
+         uint64_t allocationsBefore = g_allocationCount;
+         auto start = std::chrono::high_resolution_clock::now();
+
+         bool found = handDetector.Process(image);
+
+         auto end = std::chrono::high_resolution_clock::now();
+         uint64_t allocations = g_allocationCount - allocationsBefore;
+
+         const StageTimings& timings = handDetector.GetStageTimings();
+         double total = std::chrono::duration<double, std::milli>(end - start).count();
+
+         segmentationTimes.push_back(timings.Segmentation);
+         contourTimes.push_back(timings.Contours);
+         poseTimes.push_back(timings.Pose);
+         depthTimes.push_back(timings.Depth);
+         totalTimes.push_back(total);
+
+         totalProcessingTime += total;
+         totalAllocations += allocations;
+         maxAllocations = std::max(maxAllocations, allocations);
+
+         for (const DetectedHand& hand : handDetector.GetHands())
+         {
+            totalHandCount++;
+            maxHandId = std::max(maxHandId, hand.Id);
+         }
+
+         if (pass == 0)
+         {
+            cv::Point2f position = handDetector.GetHandPosition2D();
+
+            Detection detection;
+            detection.Timestamp = GetTimestampFromFileName(fileName);
+            detection.Found = found ? 1 : 0;
+            detection.X = found ? position.x : 0;
+            detection.Y = found ? position.y : 0;
+            detection.Depth = found ? handDetector.GetHandDepth() : 0;
+            detections.push_back(detection);
+         }
+      }
+   }
+
+   size_t frameCount = totalTimes.size();
+   if (frameCount == 0)
+   {
+      std::cerr << "No depth frames found in " << options.TarballFileName << "\n";
+      return 2;
+   }
+
+   size_t foundCount = std::count_if(detections.begin(), detections.end(),
+      [](const Detection& detection) { return detection.Found != 0; });
+
+   printf("Frames:         %zu (%zu per pass, hand found in %zu)\n", frameCount, detections.size(), foundCount);
+   printf("%-14s %10s %10s %10s\n", "Stage", "p50 ms", "p95 ms", "p99 ms");
+   PrintStage("Segmentation", segmentationTimes);
+   PrintStage("Contours", contourTimes);
+   PrintStage("Pose", poseTimes);
+   PrintStage("Depth", depthTimes);
+   PrintStage("Total", totalTimes);
+   printf("Throughput:     %.1f frames/s\n", frameCount / (totalProcessingTime / 1000.0));
+   printf("Allocations:    %.2f per frame (max %llu)\n",
+      static_cast<double>(totalAllocations) / frameCount,
+      static_cast<unsigned long long>(maxAllocations));
+
+   if (options.MaxHandCount > 1)
+   {
+      printf("Hands:          %.2f per frame, %d ids assigned\n",
+         static_cast<double>(totalHandCount) / frameCount,
+         maxHandId + 1);
+   }
+
+   if (options.Tracking)
+   {
+      const TrackingStatistics& statistics = handDetector.GetTrackingStatistics();
+      printf("Tracking:       %d tracked, %d re-acquired (%.1f%%), %d lost\n",
+         statistics.TrackedFrameCount,
+         statistics.ReacquisitionCount,
+         statistics.GetReacquisitionRate() * 100.f,
+         statistics.LostFrameCount);
+   }
+
+   if (!options.GoldenOutputFileName.empty())
+   {
+      FILE* file = fopen(options.GoldenOutputFileName.c_str(), "w");
+      if (file == nullptr)
+      {
+         std::cerr << "Cannot write golden file " << options.GoldenOutputFileName << "\n";
+         return 2;
+      }
+
+      fprintf(file, "Timestamp,Found,X,Y,Depth\n");
+      for (const Detection& detection : detections)
+      {
+         fprintf(file, "%llu,%d,%.4f,%.4f,%.4f\n",
+            static_cast<unsigned long long>(detection.Timestamp),
+            detection.Found,
+            detection.X,
+            detection.Y,
+            detection.Depth);
+      }
+
+      fclose(file);
+   }
+
+   if (!options.GoldenInputFileName.empty())
+   {
+      size_t mismatchCount = 0;
+      size_t comparedCount = std::min(golden.size(), detections.size());
+
+      for (size_t i = 0; i < comparedCount; i++)
+      {
+         if (!Matches(golden[i], detections[i], options.Tolerance))
+         {
+            if (mismatchCount < 10)
+            {
+               printf("Mismatch at %llu: expected %d %.4f %.4f %.4f, got %d %.4f %.4f %.4f\n",
+                  static_cast<unsigned long long>(detections[i].Timestamp),
+                  golden[i].Found, golden[i].X, golden[i].Y, golden[i].Depth,
+                  detections[i].Found, detections[i].X, detections[i].Y, detections[i].Depth);
+            }
+
+            mismatchCount++;
+         }
+      }
+
+      mismatchCount += std::max(golden.size(), detections.size()) - comparedCount;
+
+      printf("Golden:         %zu of %zu frames differ\n", mismatchCount, std::max(golden.size(), detections.size()));
+
+      if (mismatchCount > 0)
+      {
+         return 1;
+      }
+   }
+
+   return 0;
+}
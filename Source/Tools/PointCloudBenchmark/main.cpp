@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/CameraUnprojectionTable.h>
+#include <Io/DepthPointCloud.h>
+
+//
+// Points per second of Io::DepthPointCloudConverter on short throw depth frames, for
+// whole frames and for a hand sized region, with the rows split into 1 to --bands bands.
+// For comparison, every pixel is also converted the way HoloHands converts the hand
+// position: looked up in the unprojection table, normalized, scaled and transformed
+// one at a time. The converter's points are checked against those. The same is done
+// for the keypoints of two hands, unprojected with Io::UnprojectImagePoints.
+//
+namespace
+{
+   const uint32_t IMAGE_WIDTH = 448; //Short throw depth frames.
+   const uint32_t IMAGE_HEIGHT = 450;
+   const float MAX_DIFFERENCE = 1e-5f; //Meters, between the converter and the reference.
+   const int KEYPOINT_COUNT = 8; //Hand position, two finger tips and palm of two hands.
+   const int KEYPOINT_REPEAT_COUNT = 1000; //Keypoints are unprojected this many times per frame, to be measurable.
+
+   struct Options
+   {
+      Options()
+         :
+         FrameCount(200),
+         MaxBandCount(std::max(1u, std::thread::hardware_concurrency()))
+      {}
+
+      int FrameCount;
+      uint32_t MaxBandCount;
+      std::string TableFileName; //Recorded table, instead of a synthetic one.
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: PointCloudBenchmark [options]\n"
+         "  --frames <count>   Frames converted per run.\n"
+         "  --bands <count>    Most bands of rows to split the frames into.\n"
+         "  --table <path>     A recorded short_throw_depth_camera_space_projection.bin.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--frames" && hasValue)
+         {
+            options.FrameCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--bands" && hasValue)
+         {
+            options.MaxBandCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--table" && hasValue)
+         {
+            options.TableFileName = argv[++i];
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   //A wide angle camera with a little barrel distortion, whose corners cannot be mapped.
+   Io::CameraUnprojectionTable MakeTable()
+   {
+      Io::CameraUnprojectionTable table(IMAGE_WIDTH, IMAGE_HEIGHT);
+
+      const float focalLength = 180.0f;
+      const float centerX = IMAGE_WIDTH / 2.0f;
+      const float centerY = IMAGE_HEIGHT / 2.0f;
+
+      for (uint32_t y = 0; y < IMAGE_HEIGHT; y++)
+      {
+         for (uint32_t x = 0; x < IMAGE_WIDTH; x++)
+         {
+            float u = (x - centerX) / focalLength;
+            float v = (y - centerY) / focalLength;
+            float radius = std::sqrt(u * u + v * v);
+
+            if (radius < 1.6f)
+            {
+               float distortion = 1.0f + 0.08f * radius * radius;
+               table.Set(x, y, u * distortion, v * distortion);
+            }
+         }
+      }
+
+      return table;
+   }
+
+   //A slanted wall with a hand sized bump, noise and holes, partly out of range.
+   std::vector<uint16_t> MakeDepthImage(std::mt19937& random)
+   {
+      std::normal_distribution<float> noise(0.0f, 4.0f);
+      std::uniform_int_distribution<int> hole(0, 40);
+
+      std::vector<uint16_t> depthImage(IMAGE_WIDTH * IMAGE_HEIGHT);
+
+      for (uint32_t y = 0; y < IMAGE_HEIGHT; y++)
+      {
+         for (uint32_t x = 0; x < IMAGE_WIDTH; x++)
+         {
+            float dx = x - 224.0f;
+            float dy = y - 200.0f;
+            float depth = 400.0f + 2.0f * x + (dx * dx + dy * dy < 60 * 60 ? -150.0f : 0.0f) + noise(random);
+
+            depthImage[y * IMAGE_WIDTH + x] = hole(random) == 0 ? 0 : static_cast<uint16_t>(std::max(0.0f, depth));
+         }
+      }
+
+      return depthImage;
+   }
+
+   //Rotated 30 degrees about Y and moved, as float4x4: row major, points as row vectors.
+   void MakeTransform(float (&transform)[16])
+   {
+      const float angle = 0.5235988f;
+      const float c = std::cos(angle);
+      const float s = std::sin(angle);
+
+      const float values[16] =
+      {
+         c, 0, -s, 0,
+         0, 1, 0, 0,
+         s, 0, c, 0,
+         0.25f, 1.5f, -0.75f, 1
+      };
+
+      std::copy(values, values + 16, transform);
+   }
+
+   //As HandTrackingPipeline::GetHandPositionFromFrame, for every pixel.
+   size_t ConvertOneByOne(
+      const Io::CameraUnprojectionTable& table,
+      const Io::DepthPointCloudOptions& options,
+      const std::vector<uint16_t>& depthImage,
+      const float (&transform)[16],
+      Io::DepthPointCloud& pointCloud)
+   {
+      pointCloud.Width = IMAGE_WIDTH;
+      pointCloud.Height = IMAGE_HEIGHT;
+      pointCloud.X.assign(depthImage.size(), std::numeric_limits<float>::quiet_NaN());
+      pointCloud.Y.assign(depthImage.size(), std::numeric_limits<float>::quiet_NaN());
+      pointCloud.Z.assign(depthImage.size(), std::numeric_limits<float>::quiet_NaN());
+      pointCloud.ValidPointCount = 0;
+
+      for (uint32_t y = 0; y < IMAGE_HEIGHT; y++)
+      {
+         for (uint32_t x = 0; x < IMAGE_WIDTH; x++)
+         {
+            size_t i = y * IMAGE_WIDTH + x;
+            float depth = depthImage[i];
+            float unitPlaneX;
+            float unitPlaneY;
+
+            if (!(depth > options.MinDepth && depth < options.MaxDepth) ||
+               !table.MapImagePointToCameraUnitPlane(static_cast<float>(x), static_cast<float>(y), unitPlaneX, unitPlaneY))
+            {
+               continue;
+            }
+
+            float dx = -unitPlaneX;
+            float dy = -unitPlaneY;
+            float dz = -1.0f;
+            float scale = depth * options.DepthScale / std::sqrt(dx * dx + dy * dy + dz * dz);
+
+            dx *= scale;
+            dy *= scale;
+            dz *= scale;
+
+            pointCloud.X[i] = dx * transform[0] + dy * transform[4] + dz * transform[8] + transform[12];
+            pointCloud.Y[i] = dx * transform[1] + dy * transform[5] + dz * transform[9] + transform[13];
+            pointCloud.Z[i] = dx * transform[2] + dy * transform[6] + dz * transform[10] + transform[14];
+            pointCloud.ValidPointCount++;
+         }
+      }
+
+      return pointCloud.ValidPointCount;
+   }
+
+   //Largest distance between the points of the two clouds, or infinity if a point is
+   //valid in one but not the other.
+   float GetMaxDifference(const Io::DepthPointCloud& left, const Io::DepthPointCloud& right)
+   {
+      if (left.X.size() != right.X.size() || left.ValidPointCount != right.ValidPointCount)
+      {
+         return std::numeric_limits<float>::infinity();
+      }
+
+      float maxDifference = 0;
+
+      for (size_t i = 0; i < left.X.size(); i++)
+      {
+         if (std::isnan(left.X[i]) != std::isnan(right.X[i]))
+         {
+            return std::numeric_limits<float>::infinity();
+         }
+
+         if (!std::isnan(left.X[i]))
+         {
+            maxDifference = std::max(maxDifference, std::abs(left.X[i] - right.X[i]));
+            maxDifference = std::max(maxDifference, std::abs(left.Y[i] - right.Y[i]));
+            maxDifference = std::max(maxDifference, std::abs(left.Z[i] - right.Z[i]));
+         }
+      }
+
+      return maxDifference;
+   }
+
+   //Both hands' positions, finger tips and palms, at sub-pixel positions, some with invalid depths.
+   void MakeKeypoints(std::mt19937& random, std::vector<float>& u, std::vector<float>& v, std::vector<float>& depths)
+   {
+      std::uniform_real_distribution<float> x(0.0f, IMAGE_WIDTH - 1.0f);
+      std::uniform_real_distribution<float> y(0.0f, IMAGE_HEIGHT - 1.0f);
+      std::uniform_real_distribution<float> depth(-100.0f, 1000.0f);
+
+      for (int i = 0; i < KEYPOINT_COUNT; i++)
+      {
+         u.push_back(x(random));
+         v.push_back(y(random));
+         depths.push_back(std::max(0.0f, depth(random)));
+      }
+   }
+
+   //As HandTrackingPipeline::GetHandPositionFromFrame did, for one keypoint.
+   void UnprojectOneByOne(
+      const Io::CameraUnprojectionTable& table,
+      float u,
+      float v,
+      float depth,
+      const float (&transform)[16],
+      float& x,
+      float& y,
+      float& z)
+   {
+      float unitPlaneX;
+      float unitPlaneY;
+
+      if (depth <= 0 || !table.MapImagePointToCameraUnitPlane(u, v, unitPlaneX, unitPlaneY))
+      {
+         x = y = z = std::numeric_limits<float>::quiet_NaN();
+         return;
+      }
+
+      float dx = -unitPlaneX;
+      float dy = -unitPlaneY;
+      float dz = -1.0f;
+      float scale = depth * 0.001f / std::sqrt(dx * dx + dy * dy + dz * dz);
+
+      dx *= scale;
+      dy *= scale;
+      dz *= scale;
+
+      x = dx * transform[0] + dy * transform[4] + dz * transform[8] + transform[12];
+      y = dx * transform[1] + dy * transform[5] + dz * transform[9] + transform[13];
+      z = dx * transform[2] + dy * transform[6] + dz * transform[10] + transform[14];
+   }
+
+   float GetMaxDifference(const std::vector<float>& left, const std::vector<float>& right)
+   {
+      float maxDifference = 0;
+
+      for (size_t i = 0; i < left.size(); i++)
+      {
+         if (std::isnan(left[i]) != std::isnan(right[i]))
+         {
+            return std::numeric_limits<float>::infinity();
+         }
+
+         if (!std::isnan(left[i]))
+         {
+            maxDifference = std::max(maxDifference, std::abs(left[i] - right[i]));
+         }
+      }
+
+      return maxDifference;
+   }
+
+   void PrintResult(const char* name, uint32_t bandCount, double seconds, size_t pointCount, int frameCount)
+   {
+      printf("%-14s %6u %12.2f %16.1f\n",
+         name,
+         bandCount,
+         seconds * 1e6 / frameCount,
+         seconds > 0 ? pointCount * static_cast<double>(frameCount) / seconds / 1e6 : 0);
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   Io::CameraUnprojectionTable table = MakeTable();
+
+   if (!options.TableFileName.empty() &&
+      !Io::ReadCameraUnprojectionTable(options.TableFileName, IMAGE_WIDTH, IMAGE_HEIGHT, table))
+   {
+      std::cerr << "Cannot read a " << IMAGE_WIDTH << "x" << IMAGE_HEIGHT << " table from " << options.TableFileName << "\n";
+      return 2;
+   }
+
+   std::mt19937 random(42);
+   std::vector<std::vector<uint16_t>> depthImages;
+   for (int i = 0; i < 4; i++)
+   {
+      depthImages.push_back(MakeDepthImage(random));
+   }
+
+   float transform[16];
+   MakeTransform(transform);
+
+   Io::DepthPointCloudOptions pointCloudOptions;
+   Io::DepthPointCloud reference;
+   Io::DepthPointCloud pointCloud;
+
+   printf("Converting %d frames of %ux%u pixels\n", options.FrameCount, IMAGE_WIDTH, IMAGE_HEIGHT);
+   printf("%-14s %6s %12s %16s\n", "Conversion", "bands", "us/frame", "Mpoints/s");
+
+   auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < options.FrameCount; i++)
+   {
+      ConvertOneByOne(table, pointCloudOptions, depthImages[i % depthImages.size()], transform, reference);
+   }
+   double oneByOneSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   PrintResult("one by one", 1, oneByOneSeconds, IMAGE_WIDTH * IMAGE_HEIGHT, options.FrameCount);
+
+   Io::DepthImageRegion frame(0, 0, IMAGE_WIDTH, IMAGE_HEIGHT);
+   Io::DepthImageRegion hand(164, 140, 120, 120);
+   double fastestSeconds = std::numeric_limits<double>::max();
+
+   for (uint32_t bandCount = 1; bandCount <= options.MaxBandCount; bandCount *= 2)
+   {
+      pointCloudOptions.BandCount = bandCount;
+      Io::DepthPointCloudConverter converter(table, pointCloudOptions);
+
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < options.FrameCount; i++)
+      {
+         const std::vector<uint16_t>& depthImage = depthImages[i % depthImages.size()];
+         converter.Convert(depthImage.data(), IMAGE_WIDTH * sizeof(uint16_t), frame, transform, pointCloud);
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      fastestSeconds = std::min(fastestSeconds, seconds);
+      PrintResult("frame", bandCount, seconds, IMAGE_WIDTH * IMAGE_HEIGHT, options.FrameCount);
+
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < options.FrameCount; i++)
+      {
+         const std::vector<uint16_t>& depthImage = depthImages[i % depthImages.size()];
+         converter.Convert(depthImage.data(), IMAGE_WIDTH * sizeof(uint16_t), hand, transform, pointCloud);
+      }
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      PrintResult("hand region", bandCount, seconds, hand.Width * hand.Height, options.FrameCount);
+   }
+
+   //The last reference is of the last frame converted.
+   pointCloudOptions.BandCount = options.MaxBandCount;
+   Io::DepthPointCloudConverter converter(table, pointCloudOptions);
+   const std::vector<uint16_t>& lastImage = depthImages[(options.FrameCount - 1) % depthImages.size()];
+   converter.Convert(lastImage.data(), IMAGE_WIDTH * sizeof(uint16_t), frame, transform, pointCloud);
+
+   //Keypoints, one by one and in one call.
+   std::vector<float> u, v, depths;
+   MakeKeypoints(random, u, v, depths);
+
+   std::vector<float> referenceX(KEYPOINT_COUNT), referenceY(KEYPOINT_COUNT), referenceZ(KEYPOINT_COUNT);
+   std::vector<float> x(KEYPOINT_COUNT), y(KEYPOINT_COUNT), z(KEYPOINT_COUNT);
+   int keypointFrameCount = options.FrameCount * KEYPOINT_REPEAT_COUNT;
+
+   start = std::chrono::steady_clock::now();
+   for (int i = 0; i < keypointFrameCount; i++)
+   {
+      for (int j = 0; j < KEYPOINT_COUNT; j++)
+      {
+         UnprojectOneByOne(table, u[j], v[j], depths[j], transform, referenceX[j], referenceY[j], referenceZ[j]);
+      }
+   }
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   PrintResult("keypoints 1x1", 1, seconds, KEYPOINT_COUNT, keypointFrameCount);
+
+   start = std::chrono::steady_clock::now();
+   for (int i = 0; i < keypointFrameCount; i++)
+   {
+      Io::UnprojectImagePoints(table, u.data(), v.data(), depths.data(), KEYPOINT_COUNT, 0.001f, transform, x.data(), y.data(), z.data());
+   }
+   seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   PrintResult("keypoints", 1, seconds, KEYPOINT_COUNT, keypointFrameCount);
+
+   float maxKeypointDifference = std::max(
+      GetMaxDifference(x, referenceX),
+      std::max(GetMaxDifference(y, referenceY), GetMaxDifference(z, referenceZ)));
+
+   float maxDifference = std::max(GetMaxDifference(pointCloud, reference), maxKeypointDifference);
+   bool isValid = maxDifference <= MAX_DIFFERENCE;
+
+   printf("\n%zu of %u pixels valid. The converter is %.1fx faster than one by one, and its points are %s (%g m).\n",
+      pointCloud.ValidPointCount,
+      IMAGE_WIDTH * IMAGE_HEIGHT,
+      fastestSeconds > 0 ? oneByOneSeconds / fastestSeconds : 0,
+      isValid ? "the same" : "DIFFERENT",
+      maxDifference);
+
+   return isValid ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <Debugging/All.h>
+#include <Io/CsvWriter.h>
+#include <Io/PoseLog.h>
+
+//
+// Compares the cost of recording the per frame transforms as the recorder used to,
+// one CSV line of 50 columns formatted through CsvWriter per frame, with the binary
+// pose log it writes now. Both get the same records, with random matrices
+// at full float precision, as tracked poses have. The pose log is read back and
+// compared with what was written.
+//
+namespace
+{
+   struct Options
+   {
+      Options()
+         :
+         RecordCount(30 * 60 * 5),
+         Directory("."),
+         KeepFiles(false)
+      {}
+
+      int RecordCount; //Frames recorded per run.
+      std::string Directory;
+      bool KeepFiles;
+   };
+
+   struct Result
+   {
+      Result()
+         :
+         Seconds(0),
+         Bytes(0)
+      {}
+
+      double Seconds; //Until the file was closed and synced to disk.
+      uint64_t Bytes;
+      std::vector<double> RecordTimes; //Microseconds per record.
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: PoseLogBenchmark [options]\n"
+         "  --records <count>   Frames recorded per run.\n"
+         "  --directory <path>  Directory the files are written to.\n"
+         "  --keep              Keep the files.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--records" && hasValue)
+         {
+            options.RecordCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--directory" && hasValue)
+         {
+            options.Directory = argv[++i];
+         }
+         else if (argument == "--keep")
+         {
+            options.KeepFiles = true;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   double Percentile(std::vector<double>& samples, double fraction)
+   {
+      if (samples.empty())
+      {
+         return 0;
+      }
+
+      std::sort(samples.begin(), samples.end());
+
+      size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+      return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+   }
+
+   std::vector<Io::PoseLogRecord> MakeRecords(const Options& options)
+   {
+      std::mt19937 random(42);
+      std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+
+      std::vector<Io::PoseLogRecord> records(options.RecordCount);
+
+      for (size_t i = 0; i < records.size(); i++)
+      {
+         records[i].Timestamp = 131711138130000 + i * 333333;
+         records[i].Offset = 512 + i * 403968;
+
+         float* values = &records[i].Metadata.FrameToOrigin[0];
+         for (size_t j = 0; j < sizeof(records[i].Metadata) / sizeof(float); j++)
+         {
+            values[j] = distribution(random);
+         }
+      }
+
+      return records;
+   }
+
+   std::string GetImageFileName(const Io::PoseLogRecord& record)
+   {
+      char fileName[64];
+      snprintf(fileName, sizeof(fileName), "short_throw_depth\\%020llu.pgm",
+         static_cast<unsigned long long>(record.Timestamp));
+      return fileName;
+   }
+
+   bool SyncFile(const std::string& fileName, uint64_t& bytes)
+   {
+      int file = open(fileName.c_str(), O_RDONLY);
+      bool isSynced = file >= 0 && fsync(file) == 0;
+
+      bytes = file >= 0 ? static_cast<uint64_t>(lseek(file, 0, SEEK_END)) : 0;
+
+      if (file >= 0)
+      {
+         close(file);
+      }
+
+      return isSynced;
+   }
+
+   //As SensorFrameRecorderSink wrote the transforms before the pose log.
+   Result WriteCsv(const std::string& fileName, const std::vector<Io::PoseLogRecord>& records)
+   {
+      Result result;
+      auto start = std::chrono::steady_clock::now();
+
+      {
+         Io::CsvWriter csvWriter(fileName);
+
+         std::vector<std::string> columns = { "Timestamp", "ImageFileName" };
+         const char* transforms[] = { "FrameToOrigin", "CameraViewTransform", "CameraProjectionTransform" };
+
+         for (const char* transform : transforms)
+         {
+            for (int i = 0; i < 16; i++)
+            {
+               columns.push_back(std::string(transform) + ".m" + std::to_string(i / 4 + 1) + std::to_string(i % 4 + 1));
+            }
+         }
+
+         csvWriter.WriteHeader(columns);
+
+         for (const Io::PoseLogRecord& record : records)
+         {
+            std::string imageFileName = GetImageFileName(record);
+
+            auto recordStart = std::chrono::steady_clock::now();
+
+            bool writeComma = false;
+            csvWriter.WriteUInt64(record.Timestamp, &writeComma);
+            csvWriter.WriteText(imageFileName, &writeComma);
+
+            const float* values = &record.Metadata.FrameToOrigin[0];
+            for (size_t i = 0; i < sizeof(record.Metadata) / sizeof(float); i++)
+            {
+               csvWriter.WriteFloat(values[i], &writeComma);
+            }
+
+            csvWriter.EndLine();
+
+            result.RecordTimes.push_back(std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - recordStart).count());
+         }
+      }
+
+      SyncFile(fileName, result.Bytes);
+      result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      return result;
+   }
+
+   Result WritePoseLog(const std::string& fileName, const std::vector<Io::PoseLogRecord>& records)
+   {
+      Result result;
+      auto start = std::chrono::steady_clock::now();
+
+      {
+         Io::PoseLogWriter poseLogWriter(fileName);
+
+         for (const Io::PoseLogRecord& record : records)
+         {
+            auto recordStart = std::chrono::steady_clock::now();
+
+            poseLogWriter.Add(record);
+
+            result.RecordTimes.push_back(std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - recordStart).count());
+         }
+      }
+
+      SyncFile(fileName, result.Bytes);
+      result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      return result;
+   }
+
+   bool CheckPoseLog(const std::string& fileName, const std::vector<Io::PoseLogRecord>& expected)
+   {
+      std::vector<Io::PoseLogRecord> records;
+      if (!Io::ReadPoseLog(fileName, records) || records.size() != expected.size())
+      {
+         return false;
+      }
+
+      for (size_t i = 0; i < records.size(); i++)
+      {
+         if (records[i].Timestamp != expected[i].Timestamp ||
+            records[i].Offset != expected[i].Offset ||
+            memcmp(&records[i].Metadata, &expected[i].Metadata, sizeof(expected[i].Metadata)) != 0)
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   void PrintResult(const char* name, Result& result, size_t recordCount)
+   {
+      printf("%-10s %12.3f %12.3f %12.1f %12.1f %14.1f\n",
+         name,
+         Percentile(result.RecordTimes, 0.5),
+         Percentile(result.RecordTimes, 0.99),
+         result.Seconds * 1e6 / recordCount,
+         static_cast<double>(result.Bytes) / recordCount,
+         result.Bytes / 1024.0);
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   std::vector<Io::PoseLogRecord> records = MakeRecords(options);
+
+   std::string csvFileName = options.Directory + "/short_throw_depth.csv";
+   std::string poseLogFileName = options.Directory + "/short_throw_depth." + Io::PoseLog::FileExtension;
+
+   Result csvResult = WriteCsv(csvFileName, records);
+   Result poseLogResult = WritePoseLog(poseLogFileName, records);
+   bool isValid = CheckPoseLog(poseLogFileName, records);
+
+   printf("Recording the transforms of %zu frames to %s\n", records.size(), options.Directory.c_str());
+   printf("%-10s %12s %12s %12s %12s %14s\n", "Writer", "add p50 us", "add p99 us", "us/frame", "bytes/frame", "file KiB");
+   PrintResult("CSV", csvResult, records.size());
+   PrintResult("Pose log", poseLogResult, records.size());
+
+   printf("\nThe pose log is %.1fx smaller and %.1fx faster to write per frame, and %s\n",
+      poseLogResult.Bytes > 0 ? static_cast<double>(csvResult.Bytes) / poseLogResult.Bytes : 0,
+      poseLogResult.Seconds > 0 ? csvResult.Seconds / poseLogResult.Seconds : 0,
+      isValid ? "reads back unchanged." : "DOES NOT read back unchanged.");
+
+   if (!options.KeepFiles)
+   {
+      remove(csvFileName.c_str());
+      remove(poseLogFileName.c_str());
+   }
+
+   return isValid ? 0 : 1;
+}
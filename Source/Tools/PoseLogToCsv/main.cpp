@@ -0,0 +1,166 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/CsvWriter.h>
+#include <Io/PoseLog.h>
+#include <Io/MappedFile.h>
+
+//
+// Converts the binary pose log the recorder writes next to each tarball into the CSV
+// file it used to write: the timestamp, the name of the image in the tarball, and the
+// FrameToOrigin, CameraViewTransform and CameraProjectionTransform matrices.
+//
+namespace
+{
+   const size_t TAR_HEADER_LENGTH = 512;
+   const size_t TAR_NAME_LENGTH = 100; //Of the name field at the start of a TAR header.
+
+   struct Options
+   {
+      std::string PoseLogFileName;
+      std::string CsvFileName;
+      std::string TarballFileName;
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: PoseLogToCsv <sensor.pose> [sensor.csv] [options]\n"
+         "  --tarball <path>   Tarball the image file names are read from.\n";
+   }
+
+   std::string ReplaceExtension(const std::string& fileName, const char* extension)
+   {
+      size_t dot = fileName.find_last_of('.');
+      size_t separator = fileName.find_last_of("\\/");
+
+      if (dot == std::string::npos || (separator != std::string::npos && dot < separator))
+      {
+         dot = fileName.size();
+      }
+
+      return fileName.substr(0, dot) + "." + extension;
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--tarball" && hasValue)
+         {
+            options.TarballFileName = argv[++i];
+         }
+         else if (argument[0] != '-' && options.PoseLogFileName.empty())
+         {
+            options.PoseLogFileName = argument;
+         }
+         else if (argument[0] != '-' && options.CsvFileName.empty())
+         {
+            options.CsvFileName = argument;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      if (options.PoseLogFileName.empty())
+      {
+         return false;
+      }
+
+      if (options.CsvFileName.empty())
+      {
+         options.CsvFileName = ReplaceExtension(options.PoseLogFileName, "csv");
+      }
+
+      if (options.TarballFileName.empty())
+      {
+         options.TarballFileName = ReplaceExtension(options.PoseLogFileName, "tar");
+      }
+
+      return true;
+   }
+
+   //The name in the TAR header before the file data at the offset, or an empty name.
+   std::string GetImageFileName(const Io::MappedFile* tarball, uint64_t offset)
+   {
+      if (tarball == nullptr || offset < TAR_HEADER_LENGTH || offset > tarball->GetSize())
+      {
+         return std::string();
+      }
+
+      const char* name = reinterpret_cast<const char*>(tarball->GetData() + offset - TAR_HEADER_LENGTH);
+      return std::string(name, strnlen(name, TAR_NAME_LENGTH));
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   std::vector<Io::PoseLogRecord> records;
+   if (!Io::ReadPoseLog(options.PoseLogFileName, records))
+   {
+      std::cerr << "Cannot read pose log " << options.PoseLogFileName << "\n";
+      return 2;
+   }
+
+   //Without the tarball, the image file names are left empty.
+   std::unique_ptr<Io::MappedFile> tarball(new Io::MappedFile(options.TarballFileName));
+   if (!tarball->IsOpen())
+   {
+      std::cerr << "Cannot open " << options.TarballFileName << ", writing no image file names\n";
+      tarball.reset();
+   }
+
+   Io::CsvWriter csvWriter(options.CsvFileName);
+
+   std::vector<std::string> columns = { "Timestamp", "ImageFileName" };
+   const char* transforms[] = { "FrameToOrigin", "CameraViewTransform", "CameraProjectionTransform" };
+
+   for (const char* transform : transforms)
+   {
+      for (int i = 0; i < 16; i++)
+      {
+         columns.push_back(std::string(transform) + ".m" + std::to_string(i / 4 + 1) + std::to_string(i % 4 + 1));
+      }
+   }
+
+   csvWriter.WriteHeader(columns);
+
+   for (const Io::PoseLogRecord& record : records)
+   {
+      bool writeComma = false;
+
+      csvWriter.WriteUInt64(record.Timestamp, &writeComma);
+      csvWriter.WriteText(GetImageFileName(tarball.get(), record.Offset), &writeComma);
+
+      const float* values = &record.Metadata.FrameToOrigin[0];
+      for (size_t i = 0; i < sizeof(record.Metadata) / sizeof(float); i++)
+      {
+         csvWriter.WriteFloat(values[i], &writeComma);
+      }
+
+      csvWriter.EndLine();
+   }
+
+   printf("Wrote %zu records to %s\n", records.size(), options.CsvFileName.c_str());
+
+   return 0;
+}
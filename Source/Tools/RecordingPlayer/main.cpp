@@ -0,0 +1,650 @@
+#if defined(HOLOHANDS_WITH_CV)
+#include "pch.h"
+
+#include "CV/HandDetector.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <Debugging/All.h>
+#include <Io/Tar.h>
+#include <Io/TarReader.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/FrameDeltaCodec.h>
+#include <Io/FrameIndex.h>
+#include <Io/PoseLog.h>
+#include <Io/RecordedFrameReader.h>
+#include <Io/MappedFile.h>
+#include <Io/IndexedFrameReader.h>
+#include <Io/RecordingPlayer.h>
+
+//
+// Plays back a recording made with the HoloLensForCV recorder on a desktop, without
+// the device: in real time, as fast as possible, or one frame at a time. The frames
+// of all sensors are handed on in timestamp order; the tool counts them, checks that
+// the order is kept, and in real time measures how late each frame was handed on.
+//
+// Without a recording, a synthetic one is written the way SensorFrameRecorderSink
+// writes one: short throw depth at 30 Hz with delta frames between keyframes, and
+// long throw depth at 5 Hz, each with its pose log, and checked pixel by pixel.
+//
+namespace
+{
+   struct Options
+   {
+      Options()
+         :
+         Mode("fast"),
+         Speed(1.0),
+         StartSeconds(0),
+         Seconds(10),
+         KeyframeInterval(30),
+         Directory("."),
+         KeepFiles(false),
+         Detect(false)
+      {}
+
+      std::string RecordingFolder;
+      std::string Mode; //realtime, fast or step.
+      double Speed;
+      double StartSeconds; //Into the recording, where playback starts.
+      int Seconds; //Of the synthetic recording.
+      uint32_t KeyframeInterval;
+      std::string Directory;
+      bool KeepFiles;
+      bool Detect;
+   };
+
+   //The sensor names SensorFrameRecorder gives the tarballs.
+   const char* SENSOR_NAMES[] =
+   {
+      "pv",
+      "short_throw_depth",
+      "short_throw_reflectivity",
+      "long_throw_depth",
+      "long_throw_reflectivity",
+      "vlc_ll",
+      "vlc_lf",
+      "vlc_rf",
+      "vlc_rr",
+   };
+
+   struct SyntheticSensor
+   {
+      const char* Name;
+      uint32_t FrameRate;
+      uint64_t FirstTimestamp;
+   };
+
+   const uint32_t DEPTH_WIDTH = 448; //Width of the depth frames.
+   const uint32_t DEPTH_HEIGHT = 450; //Height of the depth frames.
+   const uint64_t START_TIMESTAMP = 131711138130000; //In 100 ns units.
+   const uint64_t TICKS_PER_SECOND = 10000000;
+
+   //The long throw frames fall between the short throw ones.
+   const SyntheticSensor SYNTHETIC_SENSORS[] =
+   {
+      { "short_throw_depth", 30, START_TIMESTAMP },
+      { "long_throw_depth", 5, START_TIMESTAMP + 111111 },
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: RecordingPlayer [recording folder] [options]\n"
+         "  --mode <realtime|fast|step>    How the frames are handed on.\n"
+         "  --speed <factor>               Playback speed in real time.\n"
+         "  --start <seconds>              Seconds into the recording to start at.\n"
+         "  --seconds <count>              Length of the synthetic recording.\n"
+         "  --keyframe-interval <frames>   Keyframe interval of the synthetic recording.\n"
+         "  --directory <path>             Directory the synthetic recording is written to.\n"
+         "  --keep                         Keep the synthetic recording.\n"
+#if defined(HOLOHANDS_WITH_CV)
+         "  --detect                       Run the hand detector on short throw depth.\n"
+#endif
+         ;
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--mode" && hasValue)
+         {
+            options.Mode = argv[++i];
+
+            if (options.Mode != "realtime" && options.Mode != "fast" && options.Mode != "step")
+            {
+               return false;
+            }
+         }
+         else if (argument == "--speed" && hasValue)
+         {
+            options.Speed = atof(argv[++i]);
+
+            if (!(options.Speed > 0))
+            {
+               return false;
+            }
+         }
+         else if (argument == "--start" && hasValue)
+         {
+            options.StartSeconds = std::max(0.0, atof(argv[++i]));
+         }
+         else if (argument == "--seconds" && hasValue)
+         {
+            options.Seconds = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--keyframe-interval" && hasValue)
+         {
+            options.KeyframeInterval = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+         }
+         else if (argument == "--directory" && hasValue)
+         {
+            options.Directory = argv[++i];
+         }
+         else if (argument == "--keep")
+         {
+            options.KeepFiles = true;
+         }
+#if defined(HOLOHANDS_WITH_CV)
+         else if (argument == "--detect")
+         {
+            options.Detect = true;
+         }
+#endif
+         else if (argument[0] != '-' && options.RecordingFolder.empty())
+         {
+            options.RecordingFolder = argument;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   double Percentile(std::vector<double>& samples, double fraction)
+   {
+      if (samples.empty())
+      {
+         return 0;
+      }
+
+      std::sort(samples.begin(), samples.end());
+
+      size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+      return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+   }
+
+   uint64_t GetFrameTimestamp(const SyntheticSensor& sensor, int frame)
+   {
+      return sensor.FirstTimestamp + frame * TICKS_PER_SECOND / sensor.FrameRate;
+   }
+
+   //A hand moving in front of a wall, with sensor noise on the hand only, so that the
+   //delta frames stay small. The sensors see it at different depths.
+   void MakeDepthImage(const SyntheticSensor& sensor, uint64_t timestamp, std::vector<uint8_t>& pixels)
+   {
+      pixels.resize(static_cast<size_t>(DEPTH_WIDTH) * DEPTH_HEIGHT * 2);
+
+      uint64_t ticks = timestamp - START_TIMESTAMP;
+      uint32_t seed = 12345 + static_cast<uint32_t>(ticks / 1000);
+      float handX = 150.0f + (ticks % (2 * TICKS_PER_SECOND)) * 75.0f / TICKS_PER_SECOND;
+      uint16_t wall = sensor.FrameRate > 5 ? 900 : 2500;
+
+      for (uint32_t y = 0; y < DEPTH_HEIGHT; ++y)
+      {
+         for (uint32_t x = 0; x < DEPTH_WIDTH; ++x)
+         {
+            float hx = x - handX;
+            float hy = y - 224.0f;
+            uint16_t depth = static_cast<uint16_t>(wall + y);
+
+            if (hx * hx + hy * hy < 45.0f * 45.0f)
+            {
+               seed = seed * 1103515245 + 12345;
+               depth = static_cast<uint16_t>(450 + (hx + hy) * 0.5f + (seed >> 16) % 5);
+            }
+
+            pixels[(y * DEPTH_WIDTH + x) * 2] = static_cast<uint8_t>(depth);
+            pixels[(y * DEPTH_WIDTH + x) * 2 + 1] = static_cast<uint8_t>(depth >> 8);
+         }
+      }
+   }
+
+   //The frame's camera moves along x, one meter per second.
+   float GetSyntheticTranslation(uint64_t timestamp)
+   {
+      return static_cast<float>(timestamp - START_TIMESTAMP) / TICKS_PER_SECOND;
+   }
+
+   //Records the frames like SensorFrameRecorderSink: keyframes as PGM files, the frames
+   //in between as delta files, a sidecar index entry and a pose log record for each.
+   void WriteSensor(const Options& options, const SyntheticSensor& sensor)
+   {
+      std::string fileName = options.Directory + "/" + sensor.Name;
+
+      Io::Tarball tarball(fileName + ".tar");
+      Io::FrameIndexWriter indexWriter(fileName + "." + Io::FrameIndex::FileExtension);
+      Io::PoseLogWriter poseLogWriter(fileName + "." + Io::PoseLog::FileExtension);
+
+      //Keyframes only at the long throw frame rate, as the recorder is configured.
+      std::unique_ptr<Io::FrameDeltaEncoder> encoder;
+      if (sensor.FrameRate > 5 && options.KeyframeInterval > 1)
+      {
+         encoder.reset(new Io::FrameDeltaEncoder(options.KeyframeInterval));
+      }
+
+      char pgmHeader[64];
+      int pgmHeaderLength = snprintf(pgmHeader, sizeof(pgmHeader), "P5\n%u %u\n65535\n", DEPTH_WIDTH, DEPTH_HEIGHT);
+
+      std::vector<uint8_t> pixels;
+      std::vector<uint8_t> delta;
+      std::vector<uint8_t> fileData;
+
+      const int frameCount = options.Seconds * static_cast<int>(sensor.FrameRate);
+
+      for (int frame = 0; frame < frameCount; frame++)
+      {
+         uint64_t timestamp = GetFrameTimestamp(sensor, frame);
+         MakeDepthImage(sensor, timestamp, pixels);
+
+         Io::FrameStreamHeader header;
+         header.Timestamp = timestamp;
+         header.ImageWidth = DEPTH_WIDTH;
+         header.ImageHeight = DEPTH_HEIGHT;
+         header.PixelStride = 2;
+         header.RowStride = DEPTH_WIDTH * 2;
+
+         Io::FrameIndexEntry entry;
+         entry.Timestamp = timestamp;
+
+         const char* extension = "pgm";
+
+         if (encoder && encoder->Encode(header, pixels.data(), delta))
+         {
+            Io::SetFrameCodec(header, Io::FrameCodec::Delta, static_cast<uint32_t>(delta.size()));
+
+            fileData.resize(Io::GetEncodedLength(header));
+            Io::EncodeFrameStreamHeader(header, fileData.data());
+            fileData.insert(fileData.end(), delta.begin(), delta.end());
+
+            extension = Io::RecordedFrameReader::DeltaFileExtension;
+            entry.Format = Io::FrameFileFormat::Delta;
+         }
+         else
+         {
+            fileData.assign(pgmHeader, pgmHeader + pgmHeaderLength);
+            fileData.insert(fileData.end(), pixels.begin(), pixels.end());
+
+            entry.Format = Io::FrameFileFormat::Gray16;
+         }
+
+         char bitmapPath[64];
+         snprintf(bitmapPath, sizeof(bitmapPath), "%s/%020llu.%s",
+            sensor.Name, static_cast<unsigned long long>(timestamp), extension);
+
+         entry.Offset = tarball.AddFile(bitmapPath, fileData.data(), fileData.size());
+         entry.Size = static_cast<uint32_t>(fileData.size());
+
+         indexWriter.Add(entry);
+
+         Io::PoseLogRecord record;
+         record.Timestamp = timestamp;
+         record.Offset = entry.Offset;
+
+         float* values = &record.Metadata.FrameToOrigin[0];
+         for (int i = 0; i < 48; i++)
+         {
+            values[i] = i % 16 % 5 == 0 ? 1.0f : 0.0f;
+         }
+
+         record.Metadata.FrameToOrigin[12] = GetSyntheticTranslation(timestamp);
+
+         poseLogWriter.Add(record);
+      }
+   }
+
+   void RemoveSensor(const Options& options, const SyntheticSensor& sensor)
+   {
+      std::string fileName = options.Directory + "/" + sensor.Name;
+
+      remove((fileName + ".tar").c_str());
+      remove((fileName + "." + Io::FrameIndex::FileExtension).c_str());
+      remove((fileName + "." + Io::PoseLog::FileExtension).c_str());
+   }
+
+   //Counts the frames of one sensor.
+   class CountingSink : public Io::RecordedFrameSink
+   {
+   public:
+      CountingSink(class PlaybackChecker& checker)
+         :
+         _checker(checker),
+         FrameCount(0),
+         MetadataCount(0),
+         ErrorCount(0),
+         Checksum(14695981039346656037ull)
+      {}
+
+      void Send(const Io::PlaybackFrame& frame) override;
+
+   private:
+      class PlaybackChecker& _checker;
+      std::vector<uint8_t> _expected;
+
+   public:
+      size_t FrameCount;
+      size_t MetadataCount;
+      size_t ErrorCount; //Frames out of order, or that differ from the synthetic ones.
+      uint64_t Checksum; //FNV-1a of the first row of every frame.
+   };
+
+   //Hands every sensor's frames to its own sink, and keeps what the sinks share: the
+   //timestamp order across sensors, and how late each frame was in real time.
+   class PlaybackChecker : public Io::RecordedFrameSinkGroup
+   {
+   public:
+      PlaybackChecker(bool isSynthetic, bool isRealTime, double speed)
+         :
+         IsSynthetic(isSynthetic),
+         IsRealTime(isRealTime),
+         Speed(speed),
+         LastTimestamp(0),
+         IsStarted(false),
+         StartTimestamp(0)
+      {}
+
+      Io::RecordedFrameSink* GetRecordedFrameSink(const std::string& sensorName) override
+      {
+         for (size_t i = 0; i < SensorNames.size(); i++)
+         {
+            if (SensorNames[i] == sensorName)
+            {
+               return Sinks[i].get();
+            }
+         }
+
+         SensorNames.push_back(sensorName);
+         Sinks.emplace_back(new CountingSink(*this));
+         return Sinks.back().get();
+      }
+
+      bool IsSynthetic;
+      bool IsRealTime;
+      double Speed;
+
+      uint64_t LastTimestamp;
+      std::string LastSensorName;
+      bool IsStarted;
+      uint64_t StartTimestamp;
+      std::chrono::steady_clock::time_point StartTime;
+      std::vector<double> Lateness; //Milliseconds after the frame was due.
+
+      std::vector<std::string> SensorNames;
+      std::vector<std::unique_ptr<CountingSink>> Sinks;
+
+#if defined(HOLOHANDS_WITH_CV)
+      std::unique_ptr<HoloHands::HandDetector> Detector;
+      std::vector<uint8_t> AlignedPixels;
+      std::vector<double> DetectionTimes;
+      size_t DetectionCount = 0;
+#endif
+   };
+
+   void CountingSink::Send(const Io::PlaybackFrame& frame)
+   {
+      auto now = std::chrono::steady_clock::now();
+
+      if (!_checker.IsStarted)
+      {
+         _checker.IsStarted = true;
+         _checker.StartTimestamp = frame.Timestamp;
+         _checker.StartTime = now;
+      }
+
+      if (_checker.IsRealTime)
+      {
+         std::chrono::duration<double, std::milli> due(
+            (frame.Timestamp - _checker.StartTimestamp) / 1e4 / _checker.Speed);
+
+         _checker.Lateness.push_back(
+            std::chrono::duration<double, std::milli>(now - _checker.StartTime).count() - due.count());
+      }
+
+      if (frame.Timestamp < _checker.LastTimestamp)
+      {
+         ErrorCount++;
+      }
+
+      _checker.LastTimestamp = frame.Timestamp;
+      _checker.LastSensorName = frame.SensorName;
+
+      FrameCount++;
+      MetadataCount += frame.Metadata != nullptr ? 1 : 0;
+
+      for (uint32_t i = 0; i < frame.RowStride; i++)
+      {
+         Checksum = (Checksum ^ frame.Pixels[i]) * 1099511628211ull;
+      }
+
+      if (_checker.IsSynthetic)
+      {
+         for (const SyntheticSensor& sensor : SYNTHETIC_SENSORS)
+         {
+            if (strcmp(sensor.Name, frame.SensorName) == 0)
+            {
+               MakeDepthImage(sensor, frame.Timestamp, _expected);
+            }
+         }
+
+         if (frame.Format != Io::FrameFileFormat::Gray16 ||
+            frame.RowStride != DEPTH_WIDTH * 2 ||
+            frame.Height != DEPTH_HEIGHT ||
+            memcmp(frame.Pixels, _expected.data(), _expected.size()) != 0 ||
+            frame.Metadata == nullptr ||
+            frame.Metadata->FrameToOrigin[12] != GetSyntheticTranslation(frame.Timestamp))
+         {
+            ErrorCount++;
+         }
+      }
+
+#if defined(HOLOHANDS_WITH_CV)
+      if (_checker.Detector && frame.Format == Io::FrameFileFormat::Gray16 &&
+         strcmp(frame.SensorName, "short_throw_depth") == 0)
+      {
+         //Keyframe pixels in the mapped tarball may be at an odd address.
+         const uint8_t* pixels = frame.Pixels;
+         if (reinterpret_cast<uintptr_t>(pixels) % 2 != 0)
+         {
+            _checker.AlignedPixels.assign(pixels, pixels + static_cast<size_t>(frame.Height) * frame.RowStride);
+            pixels = _checker.AlignedPixels.data();
+         }
+
+         cv::Mat image(frame.Height, frame.Width, CV_16UC1, const_cast<uint8_t*>(pixels), frame.RowStride);
+
+         auto start = std::chrono::steady_clock::now();
+         bool found = _checker.Detector->Process(image);
+         _checker.DetectionTimes.push_back(
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+         _checker.DetectionCount += found ? 1 : 0;
+      }
+#endif
+   }
+
+   //Steps through the recording, one frame per line read from a terminal.
+   void StepThrough(Io::RecordingPlayer& player, PlaybackChecker& checker)
+   {
+      bool isInteractive = isatty(STDIN_FILENO) != 0;
+
+      if (isInteractive)
+      {
+         std::cout << "Enter steps to the next frame, q quits.\n";
+      }
+
+      size_t frame = 0;
+
+      while (player.Step(checker))
+      {
+         printf("%8zu %20llu %s\n",
+            frame++,
+            static_cast<unsigned long long>(checker.LastTimestamp),
+            checker.LastSensorName.c_str());
+
+         std::string line;
+         if (isInteractive && (!std::getline(std::cin, line) || line == "q"))
+         {
+            break;
+         }
+      }
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   bool isSynthetic = options.RecordingFolder.empty();
+   std::string recordingFolder = isSynthetic ? options.Directory : options.RecordingFolder;
+
+   if (isSynthetic)
+   {
+      for (const SyntheticSensor& sensor : SYNTHETIC_SENSORS)
+      {
+         WriteSensor(options, sensor);
+      }
+   }
+
+   std::vector<std::string> sensorNames(std::begin(SENSOR_NAMES), std::end(SENSOR_NAMES));
+
+   auto openStart = std::chrono::steady_clock::now();
+   Io::RecordingPlayer player(recordingFolder, sensorNames);
+   double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openStart).count();
+
+   if (player.GetFrameCount() == 0)
+   {
+      std::cerr << "No recorded frames in " << recordingFolder << "\n";
+      return 2;
+   }
+
+   double recordingSeconds = static_cast<double>(player.GetEndTimestamp() - player.GetStartTimestamp()) / TICKS_PER_SECOND;
+
+   printf("Recording:   %s, %zu sensors, %zu frames, %.1f s, opened in %.3f ms\n",
+      recordingFolder.c_str(),
+      player.GetSensorCount(),
+      player.GetFrameCount(),
+      recordingSeconds,
+      openSeconds * 1000);
+
+   if (options.StartSeconds > 0)
+   {
+      player.Seek(player.GetStartTimestamp() + static_cast<uint64_t>(options.StartSeconds * TICKS_PER_SECOND));
+   }
+
+   PlaybackChecker checker(isSynthetic, options.Mode == "realtime", options.Speed);
+
+#if defined(HOLOHANDS_WITH_CV)
+   if (options.Detect)
+   {
+      checker.Detector.reset(new HoloHands::HandDetector());
+      checker.Detector->ShowDebugInfo(false);
+   }
+#endif
+
+   auto playStart = std::chrono::steady_clock::now();
+
+   if (options.Mode == "step")
+   {
+      StepThrough(player, checker);
+   }
+   else
+   {
+      player.Play(
+         checker,
+         options.Mode == "realtime" ? Io::PlaybackMode::RealTime : Io::PlaybackMode::AsFastAsPossible,
+         options.Speed);
+   }
+
+   double playSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - playStart).count();
+
+   size_t frameCount = 0;
+   size_t errorCount = 0;
+
+   printf("\n%-26s %8s %8s %8s %18s\n", "Sensor", "frames", "metadata", "errors", "checksum");
+
+   for (size_t i = 0; i < checker.SensorNames.size(); i++)
+   {
+      const CountingSink& sink = *checker.Sinks[i];
+
+      printf("%-26s %8zu %8zu %8zu %18llx\n",
+         checker.SensorNames[i].c_str(),
+         sink.FrameCount,
+         sink.MetadataCount,
+         sink.ErrorCount,
+         static_cast<unsigned long long>(sink.Checksum));
+
+      frameCount += sink.FrameCount;
+      errorCount += sink.ErrorCount;
+   }
+
+   printf("\nPlayed %zu frames in %.3f s, %.0f frames/s, %.1fx real time\n",
+      frameCount,
+      playSeconds,
+      playSeconds > 0 ? frameCount / playSeconds : 0,
+      playSeconds > 0 ? (recordingSeconds - options.StartSeconds) / playSeconds : 0);
+
+   if (checker.IsRealTime)
+   {
+      printf("Lateness:    p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+         Percentile(checker.Lateness, 0.5),
+         Percentile(checker.Lateness, 0.99),
+         Percentile(checker.Lateness, 1.0));
+   }
+
+#if defined(HOLOHANDS_WITH_CV)
+   if (checker.Detector)
+   {
+      printf("Detector:    hand found in %zu of %zu frames, p50 %.3f ms\n",
+         checker.DetectionCount,
+         checker.DetectionTimes.size(),
+         Percentile(checker.DetectionTimes, 0.5));
+   }
+#endif
+
+   if (isSynthetic && !options.KeepFiles)
+   {
+      for (const SyntheticSensor& sensor : SYNTHETIC_SENSORS)
+      {
+         RemoveSensor(options, sensor);
+      }
+   }
+
+   bool isComplete = options.Mode == "step" || options.StartSeconds > 0 || frameCount == player.GetFrameCount();
+
+   return errorCount == 0 && isComplete ? 0 : 1;
+}
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Debugging/All.h>
+#include <Io/Tar.h>
+#include <Io/TarReader.h>
+#include <Io/FrameStreamHeader.h>
+#include <Io/FrameDeltaCodec.h>
+#include <Io/FrameIndex.h>
+#include <Io/RecordedFrameReader.h>
+#include <Io/MappedFile.h>
+#include <Io/IndexedFrameReader.h>
+
+//
+// Seeks to random timestamps of a recorded tarball: by walking the archive from the
+// start, as recordings without a sidecar index must be read, with the sidecar index
+// and RecordedFrameReader, which decodes the delta frames from the keyframe before,
+// and with IndexedFrameReader, which returns the stored frame from the mapped tarball
+// without copying it.
+//
+// Without a recording, a synthetic short throw depth recording is written the way
+// SensorFrameRecorderSink writes one, with delta frames between keyframes.
+//
+namespace
+{
+   struct Options
+   {
+      Options()
+         :
+         FrameCount(3000),
+         SeekCount(200),
+         KeyframeInterval(30),
+         Directory("."),
+         KeepFiles(false)
+      {}
+
+      std::string TarballFileName;
+      int FrameCount; //Frames of the synthetic recording.
+      int SeekCount;
+      uint32_t KeyframeInterval;
+      std::string Directory;
+      bool KeepFiles;
+   };
+
+   struct Result
+   {
+      Result()
+         :
+         Seconds(0),
+         ErrorCount(0)
+      {}
+
+      double Seconds;
+      int ErrorCount; //Seeks that did not find the frame recorded at or before the timestamp.
+   };
+
+   const uint32_t DEPTH_WIDTH = 450; //Short throw depth frame width.
+   const uint32_t DEPTH_HEIGHT = 448; //Short throw depth frame height.
+   const uint64_t FRAME_DURATION = 333333; //Of a 30 Hz sensor, in 100 ns units.
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: RecordingSeekBenchmark [recording.tar] [options]\n"
+         "  --frames <count>               Frames of the synthetic recording.\n"
+         "  --seeks <count>                Random seeks per reader.\n"
+         "  --keyframe-interval <frames>   Keyframe interval of the synthetic recording.\n"
+         "  --directory <path>             Directory the synthetic recording is written to.\n"
+         "  --keep                         Keep the synthetic recording.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--frames" && hasValue)
+         {
+            options.FrameCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--seeks" && hasValue)
+         {
+            options.SeekCount = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--keyframe-interval" && hasValue)
+         {
+            options.KeyframeInterval = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+         }
+         else if (argument == "--directory" && hasValue)
+         {
+            options.Directory = argv[++i];
+         }
+         else if (argument == "--keep")
+         {
+            options.KeepFiles = true;
+         }
+         else if (argument[0] != '-' && options.TarballFileName.empty())
+         {
+            options.TarballFileName = argument;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   //A hand moving in front of a wall, with sensor noise on the hand only, so that the
+   //delta frames stay small.
+   void MakeDepthImage(int index, std::vector<uint8_t>& pixels)
+   {
+      pixels.resize(static_cast<size_t>(DEPTH_WIDTH) * DEPTH_HEIGHT * 2);
+
+      uint32_t seed = 12345 + index;
+      float handX = 150.0f + (index % 60) * 2.5f;
+
+      for (uint32_t y = 0; y < DEPTH_HEIGHT; ++y)
+      {
+         for (uint32_t x = 0; x < DEPTH_WIDTH; ++x)
+         {
+            float hx = x - handX;
+            float hy = y - 224.0f;
+            uint16_t depth = static_cast<uint16_t>(900 + y);
+
+            if (hx * hx + hy * hy < 45.0f * 45.0f)
+            {
+               seed = seed * 1103515245 + 12345;
+               depth = static_cast<uint16_t>(450 + (hx + hy) * 0.5f + (seed >> 16) % 5);
+            }
+
+            pixels[(y * DEPTH_WIDTH + x) * 2] = static_cast<uint8_t>(depth);
+            pixels[(y * DEPTH_WIDTH + x) * 2 + 1] = static_cast<uint8_t>(depth >> 8);
+         }
+      }
+   }
+
+   //Records the frames like SensorFrameRecorderSink: keyframes as PGM files, the frames
+   //in between as delta files, and a sidecar index entry for each.
+   void WriteRecording(const Options& options, const std::string& tarballFileName)
+   {
+      Io::Tarball tarball(tarballFileName);
+      Io::FrameIndexWriter indexWriter(Io::FrameIndex::GetFileName(tarballFileName));
+      Io::FrameDeltaEncoder encoder(options.KeyframeInterval);
+
+      char pgmHeader[64];
+      int pgmHeaderLength = snprintf(pgmHeader, sizeof(pgmHeader), "P5\n%u %u\n65535\n", DEPTH_WIDTH, DEPTH_HEIGHT);
+
+      std::vector<uint8_t> pixels;
+      std::vector<uint8_t> delta;
+      std::vector<uint8_t> fileData;
+
+      for (int i = 0; i < options.FrameCount; i++)
+      {
+         MakeDepthImage(i, pixels);
+
+         Io::FrameStreamHeader header;
+         header.Timestamp = (i + 1) * FRAME_DURATION;
+         header.ImageWidth = DEPTH_WIDTH;
+         header.ImageHeight = DEPTH_HEIGHT;
+         header.PixelStride = 2;
+         header.RowStride = DEPTH_WIDTH * 2;
+
+         Io::FrameIndexEntry entry;
+         entry.Timestamp = header.Timestamp;
+
+         const char* extension = "pgm";
+
+         if (encoder.Encode(header, pixels.data(), delta))
+         {
+            Io::SetFrameCodec(header, Io::FrameCodec::Delta, static_cast<uint32_t>(delta.size()));
+
+            fileData.resize(Io::GetEncodedLength(header));
+            Io::EncodeFrameStreamHeader(header, fileData.data());
+            fileData.insert(fileData.end(), delta.begin(), delta.end());
+
+            extension = Io::RecordedFrameReader::DeltaFileExtension;
+            entry.Format = Io::FrameFileFormat::Delta;
+         }
+         else
+         {
+            fileData.assign(pgmHeader, pgmHeader + pgmHeaderLength);
+            fileData.insert(fileData.end(), pixels.begin(), pixels.end());
+
+            entry.Format = Io::FrameFileFormat::Gray16;
+         }
+
+         char fileName[64];
+         snprintf(fileName, sizeof(fileName), "short_throw_depth/%020llu.%s",
+            static_cast<unsigned long long>(header.Timestamp), extension);
+
+         entry.Offset = tarball.AddFile(fileName, fileData.data(), fileData.size());
+         entry.Size = static_cast<uint32_t>(fileData.size());
+
+         indexWriter.Add(entry);
+      }
+   }
+
+   //Seeks to the keyframe before the frame and decodes the frames up to it.
+   bool ReadFrameAt(Io::RecordedFrameReader& reader, uint64_t frameTimestamp, std::vector<uint8_t>& fileData)
+   {
+      if (!reader.SeekToKeyframe(frameTimestamp))
+      {
+         return false;
+      }
+
+      std::string fileName;
+
+      while (reader.ReadNext(fileName, fileData))
+      {
+         uint64_t fileTimestamp = Io::RecordedFrameReader::GetTimestampFromFileName(fileName);
+
+         if (fileTimestamp >= frameTimestamp)
+         {
+            return fileTimestamp == frameTimestamp;
+         }
+      }
+
+      return false;
+   }
+
+   //The frame timestamps are those of the frames recorded at or before the seek timestamps.
+   Result RunRecordedFrameReader(const std::string& tarballFileName, const std::vector<uint64_t>& frameTimestamps)
+   {
+      Result result;
+      Io::RecordedFrameReader reader(tarballFileName);
+      std::vector<uint8_t> fileData;
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (uint64_t frameTimestamp : frameTimestamps)
+      {
+         if (!ReadFrameAt(reader, frameTimestamp, fileData))
+         {
+            result.ErrorCount++;
+         }
+      }
+
+      result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return result;
+   }
+
+   Result RunIndexedFrameReader(const Io::IndexedFrameReader& reader, const std::vector<uint64_t>& timestamps,
+      const std::vector<uint64_t>& frameTimestamps, uint64_t& checksum)
+   {
+      Result result;
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t i = 0; i < timestamps.size(); i++)
+      {
+         Io::RecordedFrame frame = reader.GetFrame(reader.FindFrame(timestamps[i]));
+
+         if (frame.Timestamp != frameTimestamps[i])
+         {
+            result.ErrorCount++;
+         }
+
+         //Touch the frame, so that the pages are read.
+         for (size_t i = 0; i < frame.Size; i += 4096)
+         {
+            checksum += frame.Data[i];
+         }
+      }
+
+      result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return result;
+   }
+
+   //Compares the frames of the index with the files TarReader reads.
+   int CheckIndex(const std::string& tarballFileName, const Io::IndexedFrameReader& reader)
+   {
+      Io::TarReader tarReader(tarballFileName);
+      std::string fileName;
+      std::vector<uint8_t> fileData;
+      int errorCount = 0;
+      size_t ordinal = 0;
+
+      while (tarReader.ReadNext(fileName, fileData))
+      {
+         if (ordinal >= reader.GetFrameCount())
+         {
+            return errorCount + 1;
+         }
+
+         Io::RecordedFrame frame = reader.GetFrame(ordinal++);
+
+         if (frame.Timestamp != Io::RecordedFrameReader::GetTimestampFromFileName(fileName) ||
+            frame.Format != Io::GetFrameFileFormat(fileName, fileData.data(), fileData.size()) ||
+            frame.Size != fileData.size() ||
+            memcmp(frame.Data, fileData.data(), frame.Size) != 0)
+         {
+            errorCount++;
+         }
+      }
+
+      return errorCount + static_cast<int>(reader.GetFrameCount() - ordinal);
+   }
+
+   void PrintResult(const char* name, const Result& result, size_t seekCount)
+   {
+      printf("%-28s %12.1f %8d\n", name, result.Seconds * 1e6 / seekCount, result.ErrorCount);
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   bool isSynthetic = options.TarballFileName.empty();
+   std::string tarballFileName = isSynthetic ?
+      options.Directory + "/short_throw_depth.tar" :
+      options.TarballFileName;
+   std::string indexFileName = Io::FrameIndex::GetFileName(tarballFileName);
+
+   if (isSynthetic)
+   {
+      WriteRecording(options, tarballFileName);
+   }
+
+   //
+   // The recording as it reads without a sidecar index. A synthetic one has its index
+   // moved aside meanwhile.
+   //
+   std::string movedIndexFileName = indexFileName + ".moved";
+   bool hadIndex = rename(indexFileName.c_str(), movedIndexFileName.c_str()) == 0;
+
+   auto openStart = std::chrono::steady_clock::now();
+   Io::IndexedFrameReader walkedIndex(tarballFileName);
+   double walkOpenSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openStart).count();
+
+   if (!walkedIndex.IsOpen() || walkedIndex.GetFrameCount() == 0)
+   {
+      std::cerr << "Could not read any frame from " << tarballFileName << std::endl;
+      rename(movedIndexFileName.c_str(), indexFileName.c_str());
+      return 2;
+   }
+
+   const std::vector<Io::FrameIndexEntry>& entries = walkedIndex.GetEntries();
+
+   std::mt19937_64 random(42);
+   std::uniform_int_distribution<uint64_t> distribution(entries.front().Timestamp, entries.back().Timestamp);
+   std::vector<uint64_t> timestamps(options.SeekCount);
+   std::vector<uint64_t> frameTimestamps(options.SeekCount);
+   for (size_t i = 0; i < timestamps.size(); i++)
+   {
+      timestamps[i] = distribution(random);
+      frameTimestamps[i] = walkedIndex.GetFrame(walkedIndex.FindFrame(timestamps[i])).Timestamp;
+   }
+
+   Result walkResult = RunRecordedFrameReader(tarballFileName, frameTimestamps);
+
+   //
+   // Recordings made before the recorder wrote an index get one now.
+   //
+   if (hadIndex)
+   {
+      rename(movedIndexFileName.c_str(), indexFileName.c_str());
+   }
+   else
+   {
+      Io::FrameIndexWriter indexWriter(indexFileName);
+
+      for (const Io::FrameIndexEntry& entry : entries)
+      {
+         indexWriter.Add(entry);
+      }
+
+      printf("Wrote %s\n", indexFileName.c_str());
+   }
+
+   openStart = std::chrono::steady_clock::now();
+   Io::IndexedFrameReader indexedReader(tarballFileName);
+   double indexOpenSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openStart).count();
+
+   Result indexResult = RunRecordedFrameReader(tarballFileName, frameTimestamps);
+
+   uint64_t checksum = 0;
+   Result zeroCopyResult = RunIndexedFrameReader(indexedReader, timestamps, frameTimestamps, checksum);
+
+   int indexErrorCount = CheckIndex(tarballFileName, indexedReader);
+   bool isIndexConsistent =
+      indexedReader.HasSidecarIndex() &&
+      indexedReader.GetFrameCount() == walkedIndex.GetFrameCount() &&
+      std::equal(entries.begin(), entries.end(), indexedReader.GetEntries().begin(),
+         [](const Io::FrameIndexEntry& a, const Io::FrameIndexEntry& b)
+         {
+            return a.Timestamp == b.Timestamp && a.Offset == b.Offset && a.Size == b.Size && a.Format == b.Format;
+         });
+
+   size_t keyframeCount = 0;
+   for (const Io::FrameIndexEntry& entry : entries)
+   {
+      keyframeCount += Io::IsKeyframe(entry) ? 1 : 0;
+   }
+
+   printf("Recording:        %s, %zu frames, %zu keyframes\n",
+      isSynthetic ? "synthetic" : tarballFileName.c_str(),
+      entries.size(),
+      keyframeCount);
+   printf("Open:             %.3f ms walking the tarball, %.3f ms with the sidecar index\n",
+      walkOpenSeconds * 1000.0,
+      indexOpenSeconds * 1000.0);
+   printf("\n%-28s %12s %8s\n", "Seek to a random timestamp", "us per seek", "errors");
+   PrintResult("Walk the tarball", walkResult, timestamps.size());
+   PrintResult("Sidecar index, decoded", indexResult, timestamps.size());
+   PrintResult("Sidecar index, zero copy", zeroCopyResult, timestamps.size());
+   printf("Index check:      %d frames differ from the tarball%s\n",
+      indexErrorCount,
+      isIndexConsistent ? "" : ", the sidecar index differs from the walked one");
+
+   if (isSynthetic && !options.KeepFiles)
+   {
+      remove(tarballFileName.c_str());
+      remove(indexFileName.c_str());
+   }
+
+   bool isValid =
+      walkResult.ErrorCount + indexResult.ErrorCount + zeroCopyResult.ErrorCount == 0 &&
+      indexErrorCount == 0 &&
+      isIndexConsistent;
+
+   return isValid ? 0 : 1;
+}
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <Debugging/All.h>
+#include <Io/Tar.h>
+#include <Io/TarReader.h>
+
+//
+// Sustained write throughput of Io::Tarball while recording every HoloLens sensor at
+// its full frame rate: one tarball and one writer thread per sensor, as the
+// SensorFrameRecorderSink instances do. Each run writes the same frames through the
+// file stream one header, file and padding at a time, through the staging buffer,
+// and through the staging buffer with direct I/O. Every tarball is read back and
+// checked.
+//
+namespace
+{
+   struct Options
+   {
+      Options()
+         :
+         Seconds(10),
+         Directory("."),
+         StagingBufferSize(Io::TarballOptions::DefaultStagingBufferSize),
+         KeepFiles(false)
+      {}
+
+      int Seconds; //Seconds of recording written per run.
+      std::string Directory;
+      size_t StagingBufferSize;
+      bool KeepFiles;
+   };
+
+   struct Sensor
+   {
+      const char* Name;
+      uint32_t Width; //Of the recorded PGM/PPM image, in samples.
+      uint32_t Height;
+      uint32_t BytesPerSample;
+      int FrameRate;
+   };
+
+   //The images SensorFrameRecorderSink records. The visible light cameras deliver four gray
+   //pixels per BGRA pixel, which are recorded as one row of gray samples.
+   const Sensor SENSORS[] =
+   {
+      { "PhotoVideo", 1280 * 3, 720, 1, 30 },
+      { "ShortThrowToFDepth", 448, 450, 2, 30 },
+      { "ShortThrowToFReflectivity", 448, 450, 1, 30 },
+      { "LongThrowToFDepth", 448, 450, 2, 5 },
+      { "LongThrowToFReflectivity", 448, 450, 1, 5 },
+      { "VisibleLightLeftLeft", 640, 480, 1, 30 },
+      { "VisibleLightLeftFront", 640, 480, 1, 30 },
+      { "VisibleLightRightFront", 640, 480, 1, 30 },
+      { "VisibleLightRightRight", 640, 480, 1, 30 },
+   };
+
+   const size_t SENSOR_COUNT = sizeof(SENSORS) / sizeof(SENSORS[0]);
+
+   struct Mode
+   {
+      const char* Name;
+      size_t StagingBufferSize;
+      bool UseDirectIo;
+   };
+
+   struct Result
+   {
+      Result()
+         :
+         Seconds(0),
+         Bytes(0),
+         IsDirectIo(false),
+         IsValid(true)
+      {}
+
+      double Seconds; //Until every tarball was closed and synced to disk.
+      uint64_t Bytes;
+      bool IsDirectIo;
+      bool IsValid;
+      std::vector<double> AddFileTimes; //Milliseconds per Tarball::AddFile call.
+   };
+
+   void PrintUsage()
+   {
+      std::cerr <<
+         "Usage: TarWriterBenchmark [options]\n"
+         "  --seconds <count>       Seconds of recording written per run.\n"
+         "  --directory <path>      Directory the tarballs are written to.\n"
+         "  --staging-size <bytes>  Size of the staging buffer.\n"
+         "  --keep                  Keep the tarballs of the last run.\n";
+   }
+
+   bool ParseOptions(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; i++)
+      {
+         std::string argument = argv[i];
+         bool hasValue = i + 1 < argc;
+
+         if (argument == "--seconds" && hasValue)
+         {
+            options.Seconds = std::max(1, atoi(argv[++i]));
+         }
+         else if (argument == "--directory" && hasValue)
+         {
+            options.Directory = argv[++i];
+         }
+         else if (argument == "--staging-size" && hasValue)
+         {
+            options.StagingBufferSize = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+         }
+         else if (argument == "--keep")
+         {
+            options.KeepFiles = true;
+         }
+         else
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   double Percentile(std::vector<double>& samples, double fraction)
+   {
+      if (samples.empty())
+      {
+         return 0;
+      }
+
+      std::sort(samples.begin(), samples.end());
+
+      size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+      return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+   }
+
+   std::string GetTarballPath(const Options& options, const Sensor& sensor)
+   {
+      return options.Directory + "/" + sensor.Name + ".tar";
+   }
+
+   std::string GetFileName(const Sensor& sensor, int frame)
+   {
+      char fileName[64];
+      snprintf(fileName, sizeof(fileName), "%012d_%s.pgm", frame, sensor.Name);
+      return fileName;
+   }
+
+   //A PGM/PPM file of the sensor's size. The pixels are noise, so that nothing can be
+   //saved on them, and the first bytes after the header hold the frame number.
+   void FillFile(const Sensor& sensor, int frame, std::vector<uint8_t>& file)
+   {
+      char header[64];
+      int headerLength = snprintf(header, sizeof(header), "P5\n%u %u\n%u\n",
+         sensor.Width,
+         sensor.Height,
+         sensor.BytesPerSample == 2 ? 65535u : 255u);
+
+      size_t pixelsSize = static_cast<size_t>(sensor.Width) * sensor.Height * sensor.BytesPerSample;
+      file.resize(headerLength + pixelsSize);
+      memcpy(file.data(), header, headerLength);
+
+      uint32_t state = 2463534242u + static_cast<uint32_t>(frame % 4);
+      for (size_t i = headerLength; i < file.size(); i++)
+      {
+         state ^= state << 13;
+         state ^= state >> 17;
+         state ^= state << 5;
+         file[i] = static_cast<uint8_t>(state);
+      }
+
+      memcpy(file.data() + headerLength, &frame, sizeof(frame));
+   }
+
+   //Writes the sensor's frames as fast as the tarball takes them.
+   void RecordSensor(const Options& options, const Mode& mode, const Sensor& sensor,
+      Result& result)
+   {
+      Io::TarballOptions tarballOptions;
+      tarballOptions.StagingBufferSize = mode.StagingBufferSize;
+      tarballOptions.UseDirectIo = mode.UseDirectIo;
+
+      const int frameCount = sensor.FrameRate * options.Seconds;
+
+      //The recorder converts each frame into a reused buffer before adding it.
+      std::vector<std::vector<uint8_t>> files(4);
+      for (size_t i = 0; i < files.size(); i++)
+      {
+         FillFile(sensor, static_cast<int>(i), files[i]);
+      }
+
+      Io::Tarball tarball(GetTarballPath(options, sensor), tarballOptions);
+      result.IsDirectIo = tarball.IsDirectIo();
+
+      for (int frame = 0; frame < frameCount; frame++)
+      {
+         std::vector<uint8_t>& file = files[frame % files.size()];
+         memcpy(file.data() + file.size() - sensor.Width * sensor.Height * sensor.BytesPerSample,
+            &frame, sizeof(frame));
+
+         auto start = std::chrono::steady_clock::now();
+         tarball.AddFile(GetFileName(sensor, frame), file.data(), file.size());
+         result.AddFileTimes.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+      }
+
+      tarball.Close();
+      result.Bytes = tarball.GetSize();
+
+      //Buffered writes are only on disk once the page cache was written back.
+      int file = open(GetTarballPath(options, sensor).c_str(), O_RDONLY);
+      if (file < 0 || fsync(file) != 0)
+      {
+         result.IsValid = false;
+      }
+
+      if (file >= 0)
+      {
+         close(file);
+      }
+   }
+
+   //Reads a sensor's tarball back and compares every file with what was written.
+   bool CheckSensor(const Options& options, const Sensor& sensor)
+   {
+      Io::TarReader reader(GetTarballPath(options, sensor));
+      if (!reader.IsOpen())
+      {
+         return false;
+      }
+
+      std::string fileName;
+      std::vector<uint8_t> fileData;
+      std::vector<uint8_t> expected;
+
+      const int frameCount = sensor.FrameRate * options.Seconds;
+      int frame = 0;
+
+      while (reader.ReadNext(fileName, fileData))
+      {
+         FillFile(sensor, frame, expected);
+
+         if (frame >= frameCount || fileName != GetFileName(sensor, frame) || fileData != expected)
+         {
+            return false;
+         }
+
+         frame++;
+      }
+
+      return frame == frameCount;
+   }
+
+   Result Run(const Options& options, const Mode& mode)
+   {
+      std::vector<Result> sensorResults(SENSOR_COUNT);
+      std::vector<std::thread> writers;
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t i = 0; i < SENSOR_COUNT; i++)
+      {
+         writers.emplace_back([&, i]()
+         {
+            try
+            {
+               RecordSensor(options, mode, SENSORS[i], sensorResults[i]);
+            }
+            catch (const std::exception& exception)
+            {
+               std::cerr << SENSORS[i].Name << ": " << exception.what() << "\n";
+               sensorResults[i].IsValid = false;
+            }
+         });
+      }
+
+      for (std::thread& writer : writers)
+      {
+         writer.join();
+      }
+
+      Result result;
+      result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      result.IsDirectIo = mode.UseDirectIo;
+
+      for (size_t i = 0; i < SENSOR_COUNT; i++)
+      {
+         result.Bytes += sensorResults[i].Bytes;
+         result.IsDirectIo = result.IsDirectIo && sensorResults[i].IsDirectIo;
+         result.IsValid = result.IsValid && sensorResults[i].IsValid && CheckSensor(options, SENSORS[i]);
+         result.AddFileTimes.insert(result.AddFileTimes.end(),
+            sensorResults[i].AddFileTimes.begin(),
+            sensorResults[i].AddFileTimes.end());
+      }
+
+      return result;
+   }
+
+   void PrintResult(const char* name, Result& result, double realTimeMegabytesPerSecond)
+   {
+      double megabytesPerSecond = result.Seconds > 0 ? result.Bytes / result.Seconds / 1e6 : 0;
+
+      printf("%-10s %10.1f %10.2f %12.3f %12.3f %8s\n",
+         name,
+         megabytesPerSecond,
+         megabytesPerSecond / realTimeMegabytesPerSecond,
+         Percentile(result.AddFileTimes, 0.5),
+         Percentile(result.AddFileTimes, 0.99),
+         result.IsValid ? "yes" : "NO");
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseOptions(argc, argv, options))
+   {
+      PrintUsage();
+      return 2;
+   }
+
+   double realTimeBytes = 0;
+   for (const Sensor& sensor : SENSORS)
+   {
+      realTimeBytes += static_cast<double>(sensor.Width) * sensor.Height * sensor.BytesPerSample * sensor.FrameRate;
+   }
+
+   double realTimeMegabytesPerSecond = realTimeBytes / 1e6;
+
+   printf("Recording %d s of %u sensors, %.1f MB/s at full frame rate, to %s\n",
+      options.Seconds,
+      static_cast<unsigned>(SENSOR_COUNT),
+      realTimeMegabytesPerSecond,
+      options.Directory.c_str());
+
+   const Mode modes[] =
+   {
+      { "ofstream", 0, false },
+      { "Staged", options.StagingBufferSize, false },
+      { "Direct", options.StagingBufferSize, true },
+   };
+
+   printf("%-10s %10s %10s %12s %12s %8s\n", "Writer", "MB/s", "x realtime", "add p50 ms", "add p99 ms", "valid");
+
+   bool isValid = true;
+
+   for (const Mode& mode : modes)
+   {
+      Result result = Run(options, mode);
+      PrintResult(mode.Name, result, realTimeMegabytesPerSecond);
+
+      if (mode.UseDirectIo && !result.IsDirectIo)
+      {
+         printf("%-10s direct I/O is not supported in %s, the run used buffered writes\n", "", options.Directory.c_str());
+      }
+
+      isValid = isValid && result.IsValid;
+   }
+
+   if (!options.KeepFiles)
+   {
+      for (const Sensor& sensor : SENSORS)
+      {
+         remove(GetTarballPath(options, sensor).c_str());
+      }
+   }
+
+   return isValid ? 0 : 1;
+}